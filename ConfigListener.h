@@ -0,0 +1,35 @@
+#ifndef CONFIGLISTENER_H
+#define CONFIGLISTENER_H
+
+class HWInput;
+class HWOutput;
+class Variable;
+
+// Interface for objects which want to know about the inputs, outputs and variables of the ConfigManager, e.g. the GUI
+class ConfigListener
+{
+public:
+    /**
+     * @brief onInputAdded gets called after a config has been loaded, once for every input in it
+     * @param hw
+     */
+    virtual void onInputAdded(HWInput* hw) {};
+
+    /**
+     * @brief onInputRemoved gets called before the config is cleared, once for every input in it
+     * @param hw
+     */
+    virtual void onInputRemoved(HWInput* hw) {};
+
+    virtual void onOutputAdded(HWOutput* hw) {};
+    virtual void onOutputRemoved(HWOutput* hw) {};
+
+    /**
+     * @brief onVariableAdded gets called for every variable of a script which is started
+     * @param var
+     */
+    virtual void onVariableAdded(Variable* var) {};
+    virtual void onVariableRemoved(Variable* var) {};
+};
+
+#endif // CONFIGLISTENER_H
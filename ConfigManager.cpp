@@ -2,25 +2,30 @@
 #include "ConfigManager.h"
 #include "SoundManager.h"
 #include "hw/BTThread.h"
+#include "hw/DebounceTimer.h"
 #include "hw/GPIOInterruptThread.h"
 #include "hw/I2CThread.h"
 #include "script/RuleTimerThread.h"
-#include "ui/MainWindow.h"
+#include "script/RuleExecutor.h"
+#include "script/Script.h"
 #include "util/Debug.h"
 
 #include <QDomDocument>
 #include <QFile>
 
-ConfigManager::ConfigManager(MainWindow *win)
+ConfigManager::ConfigManager(ConfigListener* listener)
 {
     m_scriptState = Inactive;
     m_activeScript = NULL;
 
-    m_mainWindow = win;
+    m_listener = listener;
 
     m_gpioThread = NULL;
+    m_debounceTimer = NULL;
     m_i2cThread = NULL;
+    m_i2cBus = NULL;
     m_ruleTimer = NULL;
+    m_ruleExecutor = NULL;
     m_soundManager = NULL;
 }
 
@@ -54,7 +59,12 @@ void ConfigManager::init()
         (*it)->start();
     }
 
-    m_ruleTimer = new RuleTimerThread();
+    // the executor runs as long as the hardware is initialized, scripts only register and unregister with it
+    m_ruleExecutor = new RuleExecutor();
+    m_ruleExecutor->start();
+
+    m_ruleTimer = new RuleTimerThread(m_ruleExecutor);
+    m_ruleTimer->start();
 
     m_soundManager = new SoundManager();
 }
@@ -77,6 +87,12 @@ void ConfigManager::deinit()
         m_ruleTimer->kill();
     }
 
+    // the timer posts to the executor, so it must be stopped first
+    if(m_ruleExecutor != NULL)
+    {
+        m_ruleExecutor->kill();
+    }
+
     if(m_gpioThread != NULL)
     {
         m_gpioThread->kill();
@@ -92,6 +108,12 @@ void ConfigManager::deinit()
         (*it)->kill();
     }
 
+    // nobody can feed the debounce timer anymore
+    if(m_debounceTimer != NULL)
+    {
+        m_debounceTimer->kill();
+    }
+
     for(std::list<HWInput*>::iterator it = m_config.m_listInput.begin(); it != m_config.m_listInput.end(); it++)
     {
         (*it)->deinit(this);
@@ -105,12 +127,18 @@ void ConfigManager::deinit()
     delete m_gpioThread;
     m_gpioThread = NULL;
 
+    delete m_debounceTimer;
+    m_debounceTimer = NULL;
+
     delete m_i2cThread;
     m_i2cThread = NULL;
 
     delete m_ruleTimer;
     m_ruleTimer = NULL;
 
+    delete m_ruleExecutor;
+    m_ruleExecutor = NULL;
+
     delete m_soundManager;
     m_soundManager = NULL;
 }
@@ -123,23 +151,29 @@ void ConfigManager::clear()
 {
     for(std::list<HWInput*>::iterator it = m_config.m_listInput.begin(); it != m_config.m_listInput.end(); it++)
     {
-        if(m_mainWindow != NULL)
-            m_mainWindow->removeInput(*it);
+        if(m_listener != NULL)
+            m_listener->onInputRemoved(*it);
     }
 
     for(std::list<HWOutput*>::iterator it = m_config.m_listOutput.begin(); it != m_config.m_listOutput.end(); it++)
     {
-        if(m_mainWindow != NULL)
-            m_mainWindow->removeOutput(*it);
+        if(m_listener != NULL)
+            m_listener->onOutputRemoved(*it);
     }
 
     for(std::list<Variable*>::iterator it = m_listVariable.begin(); it != m_listVariable.end(); it++)
     {
-        if(m_mainWindow != NULL)
-            m_mainWindow->removeVariable(*it);
+        if(m_listener != NULL)
+            m_listener->onVariableRemoved(*it);
     }
     m_listVariable.clear();
 
+    m_mapInput.clear();
+    m_mapOutput.clear();
+    m_mapVariable.clear();
+    m_mapBTThread.clear();
+    m_mapBTAddr.clear();
+
     m_config.clear();
 }
 
@@ -155,14 +189,28 @@ bool ConfigManager::load(std::string name)
 
     for(std::list<HWInput*>::iterator it = m_config.m_listInput.begin(); it != m_config.m_listInput.end(); it++)
     {
-        if(m_mainWindow != NULL)
-            m_mainWindow->addInput(*it);
+        if(!m_mapInput.insert(Symbol::intern((*it)->getName()), *it))
+            LOG_WARN(Logger::Misc, "Input name %s is not unique, only the first one is used", (*it)->getName().c_str());
+
+        if(m_listener != NULL)
+            m_listener->onInputAdded(*it);
     }
 
     for(std::list<HWOutput*>::iterator it = m_config.m_listOutput.begin(); it != m_config.m_listOutput.end(); it++)
     {
-        if(m_mainWindow != NULL)
-            m_mainWindow->addOutput(*it);
+        if(!m_mapOutput.insert(Symbol::intern((*it)->getName()), *it))
+            LOG_WARN(Logger::Misc, "Output name %s is not unique, only the first one is used", (*it)->getName().c_str());
+
+        if(m_listener != NULL)
+            m_listener->onOutputAdded(*it);
+    }
+
+    for(std::list<BTThread*>::iterator it = m_config.m_listBTThread.begin(); it != m_config.m_listBTThread.end(); it++)
+    {
+        if(!m_mapBTThread.insert(Symbol::intern((*it)->getName()), *it))
+            LOG_WARN(Logger::BT, "Bluetooth name %s is not unique, only the first one is used", (*it)->getName().c_str());
+
+        m_mapBTAddr.insert(Symbol::intern((*it)->getBTAddr()), *it);
     }
 
     return true;
@@ -170,26 +218,31 @@ bool ConfigManager::load(std::string name)
 
 bool ConfigManager::addVariable(Variable *var)
 {
-    for(std::list<Variable*>::iterator it = m_listVariable.begin(); it != m_listVariable.end(); it++)
-    {
-        if(strcasecmp((*it)->getName().c_str(), var->getName().c_str()) == 0)
-            return false;
-    }
+    if(!m_mapVariable.insert(Symbol::intern(var->getName()), var))
+        return false;
 
     m_listVariable.push_back(var);
 
-    if(m_mainWindow != NULL)
-        m_mainWindow->addVariable(var);
+    var->setExecutor(m_ruleExecutor);
+
+    if(m_listener != NULL)
+        m_listener->onVariableAdded(var);
 
     return true;
 }
 
 void ConfigManager::removeVariable(Variable *var)
 {
-    if(m_mainWindow != NULL)
-        m_mainWindow->removeVariable(var);
+    if(m_listener != NULL)
+        m_listener->onVariableRemoved(var);
 
     m_listVariable.remove(var);
+    m_mapVariable.remove(Symbol::lookup(var->getName()), var);
+
+    // process values which have already been posted for this variable
+    var->setExecutor(NULL);
+    if(m_ruleExecutor != NULL)
+        m_ruleExecutor->flush();
 }
 
 void ConfigManager::setActiveScript(Script *script)
@@ -197,10 +250,6 @@ void ConfigManager::setActiveScript(Script *script)
     // first delete old script, if any
     this->stopActiveScript();
 
-    // start timer
-    // this must be done FIRST
-    m_ruleTimer->start();
-
     // set new script and initialize it
     m_activeScript = script;
 
@@ -219,16 +268,39 @@ void ConfigManager::setActiveScript(Script *script)
     m_scriptState = Active;
 }
 
+/**
+ * @brief ConfigManager::updateActiveScript applies an edited version of the active script without stopping it.
+ * Only the rules which have changed are initialized again, see Script::update.
+ * If the script cannot be updated, it is stopped and script is started instead, in the same state.
+ * @param script the edited script, it is deleted by this method if the update succeeds,
+ * otherwise it is the active script afterwards and the caller is responsible for the old one
+ */
+void ConfigManager::updateActiveScript(Script* script)
+{
+    pi_assert(m_activeScript != NULL);
+
+    if(m_activeScript->update(script, this))
+        return;
+
+    LOG_WARN(Logger::Script, "Script %s cannot be updated while running, restarting it", script->getName().c_str());
+
+    bool paused = m_scriptState == Paused;
+
+    this->setActiveScript(script);
+
+    if(paused)
+        this->pauseActiveScript();
+}
+
 void ConfigManager::stopActiveScript()
 {
     if(m_activeScript != NULL)
     {
         if(m_scriptState == Active)
         {
-            // clear queue of timer
+            // stop timer, so that no sleep can expire while the rules are deinitialized
             // this must be done FIRST! Otherwise the process will crash
-            m_ruleTimer->kill();
-            m_ruleTimer->clear();
+            m_ruleTimer->pauseTimer();
 
             // deinitialize script, thus releasing all acquired resources
             m_activeScript->deinit();
@@ -241,6 +313,16 @@ void ConfigManager::stopActiveScript()
             }
         }
 
+        // delete the pending sleeps of the script, this also continues the timer
+        m_ruleTimer->clear();
+
+        // without pending sleeps no rule is running anymore
+        std::vector<Rule*> listRules = m_activeScript->getRuleList();
+        for(std::vector<Rule*>::iterator it = listRules.begin(); it != listRules.end(); it++)
+        {
+            (*it)->reset();
+        }
+
         m_activeScript = NULL;
         m_scriptState = Inactive;
     }
@@ -252,8 +334,8 @@ void ConfigManager::pauseActiveScript()
     {
         m_scriptState = Paused;
 
-        // stop timer
-        // this must be done FIRST! Otherwise the process will crash
+        // stop timer, the pending sleeps are kept
+        // this must be done FIRST! Otherwise deinit cancels them
         m_ruleTimer->pauseTimer();
 
         // deinitialize script, this will effectively stop events from being handled
@@ -285,20 +367,19 @@ std::list<HWOutput*> ConfigManager::getOutputList() const
     return m_config.m_listOutput;
 }
 
+std::list<BTThread*> ConfigManager::getBTThreadList() const
+{
+    return m_config.m_listBTThread;
+}
+
 /**
  * @brief ConfigManager::getInputByName Returns the HWInput object if there exists one with this name, NULL otherwise
  * @param str
  * @return
  */
-HWInput* ConfigManager::getInputByName(std::string str)
+HWInput* ConfigManager::getInputByName(const std::string& str) const
 {
-    for(std::list<HWInput*>::iterator it = m_config.m_listInput.begin(); it != m_config.m_listInput.end(); it++)
-    {
-        if(strcasecmp((*it)->getName().c_str(), str.c_str()) == 0)
-            return *it;
-    }
-
-    return NULL;
+    return m_mapInput.get(Symbol::lookup(str));
 }
 
 /**
@@ -306,40 +387,36 @@ HWInput* ConfigManager::getInputByName(std::string str)
  * @param str
  * @return
  */
-HWOutput* ConfigManager::getOutputByName(std::string str)
+HWOutput* ConfigManager::getOutputByName(const std::string& str) const
 {
-    for(std::list<HWOutput*>::iterator it = m_config.m_listOutput.begin(); it != m_config.m_listOutput.end(); it++)
-    {
-        if(strcasecmp((*it)->getName().c_str(), str.c_str()) == 0)
-            return *it;
-    }
-
-    return NULL;
+    return m_mapOutput.get(Symbol::lookup(str));
 }
 
-Variable* ConfigManager::getVariableByName(std::string str)
+Variable* ConfigManager::getVariableByName(const std::string& str) const
 {
-    for(std::list<Variable*>::iterator it = m_listVariable.begin(); it != m_listVariable.end(); it++)
-    {
-        if(strcasecmp((*it)->getName().c_str(), str.c_str()) == 0)
-            return *it;
-    }
-
-    return NULL;
+    return m_mapVariable.get(Symbol::lookup(str));
 }
 
 GPIOInterruptThread* ConfigManager::getGPIOThread()
 {
     if(m_gpioThread == NULL)
-        m_gpioThread = new GPIOInterruptThread();
+        m_gpioThread = new GPIOInterruptThread(m_config.getGPIOPriority(), m_config.getGPIOCpu());
 
     return m_gpioThread;
 }
 
+DebounceTimer* ConfigManager::getDebounceTimer()
+{
+    if(m_debounceTimer == NULL)
+        m_debounceTimer = new DebounceTimer();
+
+    return m_debounceTimer;
+}
+
 I2CThread* ConfigManager::getI2CThread()
 {
     if(m_i2cThread == NULL)
-        m_i2cThread = new I2CThread();
+        m_i2cThread = new I2CThread(m_i2cBus);
 
     return m_i2cThread;
 }
@@ -355,24 +432,12 @@ RuleTimerThread* ConfigManager::getRuleTimerThread()
  * @param str
  * @return
  */
-BTThread* ConfigManager::getBTThreadByName(std::string str)
+BTThread* ConfigManager::getBTThreadByName(const std::string& str) const
 {
-    for(std::list<BTThread*>::iterator it = m_config.m_listBTThread.begin(); it != m_config.m_listBTThread.end(); it++)
-    {
-        if(strcasecmp((*it)->getName().c_str(), str.c_str()) == 0)
-            return *it;
-    }
-
-    return NULL;
+    return m_mapBTThread.get(Symbol::lookup(str));
 }
 
-BTThread* ConfigManager::getBTThreadByAddr(std::string addr)
+BTThread* ConfigManager::getBTThreadByAddr(const std::string& addr) const
 {
-    for(std::list<BTThread*>::iterator it = m_config.m_listBTThread.begin(); it != m_config.m_listBTThread.end(); it++)
-    {
-        if(strcasecmp((*it)->getBTAddr().c_str(), addr.c_str()) == 0)
-            return *it;
-    }
-
-    return NULL;
+    return m_mapBTAddr.get(Symbol::lookup(addr));
 }
@@ -5,23 +5,26 @@
 #include "hw/HWOutput.h"
 #include "script/Variable.h"
 #include "hw/Config.h"
+#include "util/Symbol.h"
+#include "ConfigListener.h"
 
 #include <list>
-#include <QFrame>
 
-class MainWindow;
 class GPIOInterruptThread;
+class DebounceTimer;
 class I2CThread;
+class I2CBus;
 class BTThread;
 class RuleTimerThread;
+class RuleExecutor;
 class Script;
 class SoundManager;
 
 /**
  * @brief The ConfigManager class manages the configuration and hardware related stuff.
  * In addition, it controlls the currently selected script.
- * The ConfigManager class is deeply linked with MainWindow, as for example MainWindow gets called every time, an input, output or variable gets added.
- * MainWindow then creates the corresponding GUI-object and links it to the HW-object.
+ * A ConfigListener, e.g. MainWindow, gets called every time an input, output or variable gets added or removed.
+ * MainWindow then creates the corresponding GUI-object and links it to the HW-object. Without a listener the ConfigManager runs headless.
  */
 class ConfigManager
 {
@@ -33,7 +36,7 @@ public:
         Paused
     };
 
-    ConfigManager(MainWindow* win);
+    ConfigManager(ConfigListener* listener = NULL);
     ~ConfigManager();
 
     void init();
@@ -49,20 +52,29 @@ public:
     void continueActiveScript();
 
     void setActiveScript(Script* script);
+    void updateActiveScript(Script* script);
     Script* getActiveScript() const { return m_activeScript;}
 
     std::list<HWInput*> getInputList() const;
     std::list<HWOutput*> getOutputList() const;
+    std::list<BTThread*> getBTThreadList() const;
 
-    HWInput* getInputByName(std::string str);
-    HWOutput* getOutputByName(std::string str);
-    Variable* getVariableByName(std::string str);
+    HWInput* getInputByName(const std::string& str) const;
+    HWOutput* getOutputByName(const std::string& str) const;
+    Variable* getVariableByName(const std::string& str) const;
+
+    HWInput* getInput(Symbol::Id id) const { return m_mapInput.get(id);}
+    HWOutput* getOutput(Symbol::Id id) const { return m_mapOutput.get(id);}
+    Variable* getVariable(Symbol::Id id) const { return m_mapVariable.get(id);}
 
     GPIOInterruptThread* getGPIOThread();
+    DebounceTimer* getDebounceTimer();
     I2CThread* getI2CThread();
-    BTThread* getBTThreadByName(std::string str);
-    BTThread* getBTThreadByAddr(std::string addr);
+    void setI2CBus(I2CBus* bus) { m_i2cBus = bus;}
+    BTThread* getBTThreadByName(const std::string& str) const;
+    BTThread* getBTThreadByAddr(const std::string& addr) const;
     RuleTimerThread* getRuleTimerThread();
+    RuleExecutor* getRuleExecutor() const { return m_ruleExecutor;}
     SoundManager* getSoundManager() const { return m_soundManager;}
 
 private:
@@ -73,15 +85,27 @@ private:
     ScriptState m_scriptState;
     Script* m_activeScript;
 
-    MainWindow* m_mainWindow;
+    ConfigListener* m_listener;
     Config m_config;
     std::list<Variable*> m_listVariable;
 
+    // name lookup, built when the config is loaded and when variables are added
+    SymbolMap<HWInput> m_mapInput;
+    SymbolMap<HWOutput> m_mapOutput;
+    SymbolMap<Variable> m_mapVariable;
+    SymbolMap<BTThread> m_mapBTThread;
+    SymbolMap<BTThread> m_mapBTAddr;
+
     GPIOInterruptThread* m_gpioThread;
+    DebounceTimer* m_debounceTimer;
     I2CThread* m_i2cThread;
+    I2CBus* m_i2cBus; // replaces the I2C device if not NULL, must be set before the I2C thread is created
     RuleTimerThread* m_ruleTimer;
+    RuleExecutor* m_ruleExecutor;
 
     SoundManager* m_soundManager;
+
+    friend class Script;
 };
 
 #endif // CONFIGMANAGER_H
@@ -0,0 +1,107 @@
+
+#include "Defaults.h"
+#include "util/Debug.h"
+
+#include <QDomDocument>
+#include <QFile>
+
+Defaults::Defaults()
+{
+    hasLogSettings = false;
+
+    for(unsigned int i = 0; i < Logger::N_FACILITIES; i++)
+        logFacility[i] = false;
+
+    logDebug = false;
+    logWarn = false;
+    logError = false;
+}
+
+/**
+ * @brief Defaults::load reads the defaults file
+ * @param filename
+ * @return false if the file does not exist or is invalid
+ */
+bool Defaults::load(const std::string& filename)
+{
+    QFile file( filename.c_str() );
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        LOG_WARN(Logger::Misc, "Could not open defaults file. Does it exist?");
+        return false;
+    }
+
+    QDomDocument document;
+    document.setContent(&file);
+
+    file.close();
+
+    QDomElement docElem = document.documentElement();
+
+    // check if this is a valid defaults file
+    if(docElem.tagName().toLower().compare("default") != 0)
+    {
+        LOG_WARN(Logger::Misc, "Invalid defaults file: tag \"default\" is missing");
+        return false;
+    }
+
+    QDomElement elem = docElem.firstChildElement();
+    while(!elem.isNull())
+    {
+        if(elem.tagName().toLower().compare("config") == 0)
+        {
+            config = elem.text().toStdString();
+        }
+        else if(elem.tagName().toLower().compare("script") == 0)
+        {
+            script = elem.text().toStdString();
+        }
+        else if(elem.tagName().toLower().compare("error") == 0)
+        {
+            // parse all information related to error handling here
+            hasLogSettings = true;
+
+            QDomElement errorEl = elem.firstChildElement();
+            while(!errorEl.isNull())
+            {
+                if(errorEl.tagName().toLower().compare("facility") == 0)
+                {
+                    Logger::Facility facility = Logger::StringToFacility(errorEl.text().toStdString());
+                    if( facility < Logger::N_FACILITIES )
+                        logFacility[facility] = true;
+                }
+                else if(errorEl.tagName().toLower().compare("level") == 0)
+                {
+                    QString level = errorEl.text().toLower();
+
+                    if(level.compare("debug") == 0)
+                        logDebug = true;
+                    else if(level.compare("warn") == 0)
+                        logWarn = true;
+                    else if(level.compare("error") == 0)
+                        logError = true;
+                }
+                errorEl = errorEl.nextSiblingElement();
+            }
+        }
+        elem = elem.nextSiblingElement();
+    }
+
+    return true;
+}
+
+/**
+ * @brief Defaults::applyLogSettings sets the facilities and levels of the Logger, if the defaults contain them
+ */
+void Defaults::applyLogSettings() const
+{
+    if(!hasLogSettings)
+        return;
+
+    for(unsigned int i = 0; i < Logger::N_FACILITIES; i++)
+        Logger::logFacility((Logger::Facility)i, logFacility[i]);
+
+    Logger::logDebug(logDebug);
+    Logger::logWarn(logWarn);
+    Logger::logError(logError);
+}
@@ -0,0 +1,30 @@
+#ifndef DEFAULTS_H
+#define DEFAULTS_H
+
+#include "util/Logger.h"
+
+#include <string>
+
+/**
+ * @brief The Defaults struct contains the startup settings stored in defaults.xml.
+ * They are read by the GUI as well as by the headless daemon, only the GUI writes them.
+ */
+struct Defaults
+{
+    std::string config; // empty if no config should be loaded at startup
+    std::string script; // empty if no script should be started
+
+    // only valid if hasLogSettings is set, otherwise the Logger keeps its settings
+    bool hasLogSettings;
+    bool logFacility[Logger::N_FACILITIES];
+    bool logDebug;
+    bool logWarn;
+    bool logError;
+
+    Defaults();
+
+    bool load(const std::string& filename);
+    void applyLogSettings() const;
+};
+
+#endif // DEFAULTS_H
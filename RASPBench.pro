@@ -0,0 +1,22 @@
+# -------------------------------------------------
+# Benchmark, runs generated scripts against dummy inputs and outputs and measures latency and throughput of the rule engine
+# -------------------------------------------------
+TARGET = raspbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+# the core library has to come before its own dependencies from common.pri
+LIBS += -L$$OUT_PWD -lRASPCore
+PRE_TARGETDEPS += $$OUT_PWD/libRASPCore.a
+include(common.pri)
+
+SOURCES += bench/main.cpp \
+    bench/BenchI2CBus.cpp \
+    bench/BenchRunner.cpp \
+    bench/BenchScript.cpp
+
+HEADERS += bench/BenchI2CBus.h \
+    bench/BenchRunner.h \
+    bench/BenchScript.h
@@ -0,0 +1,190 @@
+# -------------------------------------------------
+# Core library: hardware, scripts and the ConfigManager, everything except the GUI
+# -------------------------------------------------
+TARGET = RASPCore
+TEMPLATE = lib
+CONFIG += staticlib
+QT -= gui
+include(common.pri)
+
+SOURCES += hw/HWInput.cpp \
+    hw/HWInputFader.cpp \
+    hw/HWInputButton.cpp \
+    hw/HWOutput.cpp \
+    util/Debug.cpp \
+    ConfigManager.cpp \
+    script/ConditionInputButton.cpp \
+    script/Script.cpp \
+    script/ScriptCache.cpp \
+    script/ScriptLibrary.cpp \
+    script/DispatchTable.cpp \
+    script/RuleExecutor.cpp \
+    script/Expression.cpp \
+    script/ConditionExpression.cpp \
+    script/Rule.cpp \
+    script/ConditionInput.cpp \
+    script/ActionOutput.cpp \
+    script/Action.cpp \
+    script/Condition.cpp \
+    hw/HWInputButtonGPIO.cpp \
+    script/ConditionInputFader.cpp \
+    hw/HWInputFaderI2C.cpp \
+    script/Variable.cpp \
+    script/ConditionVariable.cpp \
+    script/TriggerFilter.cpp \
+    hw/HWOutputDCMotor.cpp \
+    script/ActionVariable.cpp \
+    script/RuleTimerThread.cpp \
+    script/ActionSleep.cpp \
+    hw/HWOutputDCMotorI2C.cpp \
+    hw/I2CThread.cpp \
+    hw/GPIOInterruptThread.cpp \
+    hw/DebounceTimer.cpp \
+    script/ActionCallRule.cpp \
+    script/ActionOutputDCMotor.cpp \
+    hw/PCF8575I2C.cpp \
+    hw/HWInputButtonI2C.cpp \
+    hw/HWOutputLED.cpp \
+    script/ActionOutputLED.cpp \
+    hw/HWOutputLEDI2C.cpp \
+    hw/HWOutputStepper.cpp \
+    hw/HWOutputStepperI2C.cpp \
+    script/ActionOutputStepper.cpp \
+    script/ActionOutputStepperSoftStop.cpp \
+    script/ActionOutputStepperRunVelocity.cpp \
+    script/ActionOutputStepperSetParam.cpp \
+    script/ActionOutputRelay.cpp \
+    hw/HWOutputRelay.cpp \
+    hw/HWOutputRelayI2C.cpp \
+    hw/HWOutputGPO.cpp \
+    hw/HWOutputGPOI2C.cpp \
+    SoundManager.cpp \
+    script/ActionMusic.cpp \
+    script/ActionOutputStepperPositioning.cpp \
+    hw/HWInputButtonBtGPIO.cpp \
+    hw/HWOutputDCMotorBt.cpp \
+    script/ActionOutputGPO.cpp \
+    hw/HWInputFaderBt.cpp \
+    hw/HWOutputLEDBt.cpp \
+    hw/Config.cpp \
+    util/UtilConfig.cpp \
+    hw/HWInputButtonBt.cpp \
+    hw/PCF8575Bt.cpp \
+    hw/HWOutputGPOBt.cpp \
+    hw/HWOutputRelayBt.cpp \
+    hw/HWOutputStepperBt.cpp \
+    hw/BTClassicThread.cpp \
+    hw/BTThread.cpp \
+    hw/BLEThread.cpp \
+    hw/BLEMainLoop.cpp \
+    hw/BTTelemetry.cpp \
+    script/RuleProfile.cpp \
+    script/EventRecorder.cpp \
+    script/EventReplay.cpp \
+    util/Logger.cpp \
+    util/XmlElement.cpp \
+    util/Symbol.cpp \
+    util/LatencyTrace.cpp \
+    hw/ble/attrib/gattrib.c \
+    hw/ble/attrib/gatt.c \
+    hw/ble/attrib/att.c \
+    hw/ble/btio/btio.c \
+    hw/ble/attrib/gatt_helper.c \
+    Defaults.cpp
+HEADERS += hw/HWInput.h \
+    hw/HWInputFader.h \
+    hw/HWInputButton.h \
+    hw/HWInputListener.h \
+    hw/HWOutput.h \
+    hw/HWOutputListener.h \
+    util/Debug.h \
+    ConfigManager.h \
+    script/ConditionInput.h \
+    script/Script.h \
+    script/ScriptCache.h \
+    script/ScriptLibrary.h \
+    script/DispatchTable.h \
+    script/RuleExecutor.h \
+    script/Expression.h \
+    script/ConditionExpression.h \
+    script/Rule.h \
+    script/ConditionInput.h \
+    script/Condition.h \
+    script/ConditionInputButton.h \
+    script/Action.h \
+    script/ActionOutput.h \
+    hw/HWInputButtonGPIO.h \
+    script/ConditionInputFader.h \
+    hw/HWInputFaderI2C.h \
+    script/Variable.h \
+    script/VariableListener.h \
+    script/ConditionVariable.h \
+    script/TriggerFilter.h \
+    hw/HWOutputDCMotor.h \
+    script/ActionVariable.h \
+    script/RuleTimerThread.h \
+    script/ActionSleep.h \
+    hw/HWOutputDCMotorI2C.h \
+    hw/I2CThread.h \
+    hw/GPIOInterruptThread.h \
+    hw/DebounceTimer.h \
+    util/Time.h \
+    script/ActionCallRule.h \
+    util/PriorityQueue.h \
+    util/LockFreeQueue.h \
+    util/DataStream.h \
+    util/XmlElement.h \
+    util/Symbol.h \
+    util/LatencyTrace.h \
+    script/ActionOutputDCMotor.h \
+    hw/PCF8575I2C.h \
+    hw/HWInputButtonI2C.h \
+    hw/HWOutputLED.h \
+    script/ActionOutputLED.h \
+    hw/HWOutputLEDI2C.h \
+    hw/HWOutputStepper.h \
+    hw/HWOutputStepperI2C.h \
+    script/ActionOutputStepperSoftStop.h \
+    script/ActionOutputStepper.h \
+    script/ActionOutputStepperRunVelocity.h \
+    util/Config.h \
+    script/ActionOutputStepperSetParam.h \
+    script/ActionOutputRelay.h \
+    hw/HWOutputRelay.h \
+    hw/HWOutputRelayI2C.h \
+    hw/HWOutputGPO.h \
+    hw/HWOutputGPOI2C.h \
+    SoundManager.h \
+    script/ActionMusic.h \
+    script/ActionOutputStepperPositioning.h \
+    hw/HWInputButtonBtGPIO.h \
+    hw/HWOutputDCMotorBt.h \
+    script/ActionOutputGPO.h \
+    hw/HWInputFaderBt.h \
+    hw/HWOutputLEDBt.h \
+    hw/Config.h \
+    hw/HWInputButtonBt.h \
+    hw/PCF8575Bt.h \
+    hw/HWOutputGPOBt.h \
+    hw/HWOutputRelayBt.h \
+    hw/HWOutputStepperBt.h \
+    hw/BLEThread.h \
+    hw/BLEMainLoop.h \
+    hw/BTTelemetry.h \
+    script/RuleProfile.h \
+    script/EventRecorder.h \
+    script/EventReplay.h \
+    hw/BTClassicThread.h \
+    hw/BTThread.h \
+    hw/BTThreadListener.h \
+    hw/HWOutputLCD.h \
+    util/Logger.h \
+    hw/ble/attrib/gatt-service.h \
+    hw/ble/attrib/gattrib.h \
+    hw/ble/attrib/gatt.h \
+    hw/ble/attrib/att-database.h \
+    hw/ble/attrib/att.h \
+    hw/ble/btio/btio.h \
+    hw/ble/attrib/gatt_helper.h \
+    ConfigListener.h \
+    Defaults.h
@@ -0,0 +1,18 @@
+# -------------------------------------------------
+# Headless daemon, runs the startup config and script without Qt widgets
+# -------------------------------------------------
+TARGET = raspd
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+# the core library has to come before its own dependencies from common.pri
+LIBS += -L$$OUT_PWD -lRASPCore
+PRE_TARGETDEPS += $$OUT_PWD/libRASPCore.a
+include(common.pri)
+
+SOURCES += daemon/main.cpp
+
+OTHER_FILES += \
+    tools/raspd.service
@@ -0,0 +1,100 @@
+# -------------------------------------------------
+# Project created by QtCreator 2012-09-22T17:55:01
+# GUI application, links the core library
+# -------------------------------------------------
+TARGET = RASP
+TEMPLATE = app
+
+# the core library has to come before its own dependencies from common.pri
+LIBS += -L$$OUT_PWD -lRASPCore
+PRE_TARGETDEPS += $$OUT_PWD/libRASPCore.a
+include(common.pri)
+
+SOURCES += main.cpp \
+    ui/MainWindow.cpp \
+    ui/InputFaderFrame.cpp \
+    ui/ScriptsTableModel.cpp \
+    ui/ActionTableModel.cpp \
+    ui/RuleDialog.cpp \
+    ui/ScriptDialog.cpp \
+    ui/InputButtonFrame.cpp \
+    ui/InputFrame.cpp \
+    ui/OutputFrame.cpp \
+    ui/ScriptDialogTableModel.cpp \
+    ui/ConditionDialog.cpp \
+    ui/VariableFrame.cpp \
+    ui/OutputDCMotorFrame.cpp \
+    ui/ConditionTableModel.cpp \
+    ui/ActionDialog.cpp \
+    ui/OutputLEDFrame.cpp \
+    ui/OutputStepperFrame.cpp \
+    ui/OutputStepperDetailsDialog.cpp \
+    ui/VariableListDialog.cpp \
+    ui/VariableTableModel.cpp \
+    ui/VariableEditDialog.cpp \
+    ui/OutputRelayFrame.cpp \
+    ui/ScriptConfigTableModel.cpp \
+    ui/OutputGPOFrame.cpp \
+    ui/ConfigTableModel.cpp \
+    ui/ConfigDialog.cpp \
+    ui/I2CScanDialog.cpp \
+    ui/BTScanDialog.cpp \
+    ui/BTTelemetryTableModel.cpp \
+    ui/RuleProfileTableModel.cpp
+HEADERS += ui/MainWindow.h \
+    ui/InputFaderFrame.h \
+    ui/ScriptsTableModel.h \
+    ui/ActionTableModel.h \
+    ui/RuleDialog.h \
+    ui/ScriptDialog.h \
+    ui/InputButtonFrame.h \
+    ui/InputFrame.h \
+    ui/OutputFrame.h \
+    ui/ScriptDialogTableModel.h \
+    ui/ConditionDialog.h \
+    ui/VariableFrame.h \
+    ui/OutputDCMotorFrame.h \
+    ui/ConditionTableModel.h \
+    ui/ActionDialog.h \
+    ui/OutputLEDFrame.h \
+    ui/OutputStepperFrame.h \
+    ui/OutputStepperDetailsDialog.h \
+    ui/VariableListDialog.h \
+    ui/VariableTableModel.h \
+    ui/VariableEditDialog.h \
+    ui/OutputRelayFrame.h \
+    ui/ScriptConfigTableModel.h \
+    ui/OutputGPOFrame.h \
+    ui/ConfigTableModel.h \
+    ui/ConfigDialog.h \
+    ui/I2CScanDialog.h \
+    ui/BTScanDialog.h \
+    ui/BTTelemetryTableModel.h \
+    ui/RuleProfileTableModel.h
+FORMS += ui/MainWindow.ui \
+    ui/RuleDialog.ui \
+    ui/ScriptDialog.ui \
+    ui/InputFaderFrame.ui \
+    ui/InputButtonFrame.ui \
+    ui/ConditionDialog.ui \
+    ui/VariableFrame.ui \
+    ui/OutputDCMotorFrame.ui \
+    ui/ActionDialog.ui \
+    ui/OutputLEDFrame.ui \
+    ui/OutputStepperFrame.ui \
+    ui/OutputStepperDetailsDialog.ui \
+    ui/VariableListDialog.ui \
+    ui/VariableEditDialog.ui \
+    ui/OutputRelayFrame.ui \
+    ui/OutputGPOFrame.ui \
+    ui/ConfigDialog.ui \
+    ui/ConfigBTDialog.ui \
+    ui/ConfigInputDialog.ui \
+    ui/I2CScanDialog.ui \
+    ui/BTScanDialog.ui \
+    ui/ConfigOutputDialog.ui
+
+OTHER_FILES += \
+    TODO.txt
+
+RESOURCES +=
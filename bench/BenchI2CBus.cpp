@@ -0,0 +1,142 @@
+
+#include "bench/BenchI2CBus.h"
+#include "util/LatencyTrace.h"
+
+#include <chrono>
+
+// registers of the PCA9635, see HWOutputLEDI2C
+#define PCA9635_PWM0        0x02
+#define PCA9635_CHANNELS    16
+
+BenchI2CBus::BenchI2CBus(int pcfAddress, int ledAddress)
+{
+    m_pcfAddress = pcfAddress;
+    m_ledAddress = ledAddress;
+
+    m_slaveAddress = -1;
+    m_portMask = 0xFFFF;
+    m_pressed = 0;
+
+    m_lastWrite.channel = 0;
+    m_lastWrite.value = 0;
+    m_lastWrite.time = 0;
+    m_lastWrite.origin = 0;
+    m_numWrites = 0;
+    m_mark = 0;
+}
+
+/**
+ * @brief BenchI2CBus::setPressed presses or releases the button on port of the PCF8575, it is seen with the next poll.
+ * Only writes after this call are reported by BenchI2CBus::waitForLED.
+ * @param port
+ * @param pressed
+ */
+void BenchI2CBus::setPressed(unsigned int port, bool pressed)
+{
+    m_mutex.lock();
+    m_mark = m_numWrites;
+    m_mutex.unlock();
+
+    if(pressed)
+        m_pressed.fetch_or(1 << port);
+    else
+        m_pressed.fetch_and(~(1 << port));
+}
+
+/**
+ * @brief BenchI2CBus::waitForLED waits until the LED driver has been written with the given value on channel
+ * since the last call of BenchI2CBus::setPressed
+ * @param channel
+ * @param value
+ * @param timeoutMs
+ * @param write is set to the write which has been waited for
+ * @return false if the write did not happen within timeoutMs
+ */
+bool BenchI2CBus::waitForLED(unsigned int channel, unsigned char value, unsigned int timeoutMs, Write* write)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while(m_numWrites == m_mark || m_lastWrite.channel != channel || m_lastWrite.value != value)
+    {
+        if(m_cond.wait_until(lock, timeout) == std::cv_status::timeout)
+            return false;
+    }
+
+    *write = m_lastWrite;
+
+    return true;
+}
+
+/**
+ * @brief BenchI2CBus::setSlaveAddress only the two simulated devices acknowledge their address
+ * @param slaveAddress
+ * @return
+ */
+bool BenchI2CBus::setSlaveAddress(int slaveAddress)
+{
+    if(slaveAddress != m_pcfAddress && slaveAddress != m_ledAddress)
+        return false;
+
+    m_slaveAddress = slaveAddress;
+
+    return true;
+}
+
+bool BenchI2CBus::write(void* buffer, unsigned int size)
+{
+    unsigned char* buf = (unsigned char*)buffer;
+
+    if(m_slaveAddress == m_pcfAddress)
+    {
+        if(size != 2)
+            return false;
+
+        m_portMask = buf[0] | (buf[1] << 8);
+
+        return true;
+    }
+
+    if(size != 2)
+        return false;
+
+    // only the PWM registers change the brightness, mode and output state registers are accepted and ignored
+    if(buf[0] < PCA9635_PWM0 || buf[0] >= PCA9635_PWM0 + PCA9635_CHANNELS)
+        return true;
+
+    m_mutex.lock();
+
+    m_lastWrite.channel = buf[0] - PCA9635_PWM0;
+    m_lastWrite.value = buf[1];
+    m_lastWrite.time = LatencyTrace::timestamp();
+    m_lastWrite.origin = LatencyTrace::getOrigin();
+    m_numWrites++;
+
+    m_mutex.unlock();
+
+    m_cond.notify_all();
+
+    return true;
+}
+
+/**
+ * @brief BenchI2CBus::read returns the pins of the PCF8575, a pin is low if it is written as 0 or its button is pressed
+ * @param buffer
+ * @param size
+ * @return
+ */
+bool BenchI2CBus::read(void* buffer, unsigned int size)
+{
+    unsigned char* buf = (unsigned char*)buffer;
+
+    if(m_slaveAddress != m_pcfAddress || size != 2)
+        return false;
+
+    unsigned short pins = m_portMask & ~m_pressed.load();
+
+    buf[0] = pins & 0xFF;
+    buf[1] = pins >> 8;
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef BENCHI2CBUS_H
+#define BENCHI2CBUS_H
+
+#include "hw/I2CThread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief The BenchI2CBus class simulates an I2C bus with one PCF8575 port expander for buttons and one PCA9635 LED driver.
+ * It replaces the I2C device of the I2CThread, so buttons are polled by PCF8575I2C and LEDs are written by HWOutputLEDI2C
+ * through the queues of the I2C thread exactly like on a raspberry. Every write to a PWM register of the LED driver
+ * is timestamped and traced back to the input change which caused it, see LatencyTrace::getOrigin.
+ */
+class BenchI2CBus : public I2CBus
+{
+public:
+    struct Write
+    {
+        unsigned int channel;
+        unsigned char value;
+        unsigned long long time; // see LatencyTrace::timestamp
+        unsigned long long origin; // timestamp of the input change or 0
+    };
+
+    BenchI2CBus(int pcfAddress, int ledAddress);
+
+    void setPressed(unsigned int port, bool pressed);
+    bool waitForLED(unsigned int channel, unsigned char value, unsigned int timeoutMs, Write* write);
+
+    bool setSlaveAddress(int slaveAddress);
+    bool write(void* buffer, unsigned int size);
+    bool read(void* buffer, unsigned int size);
+
+private:
+    int m_pcfAddress;
+    int m_ledAddress;
+
+    // only used by the I2C thread
+    int m_slaveAddress;
+    unsigned short m_portMask; // last value written to the PCF8575, inputs are written as 1
+
+    // pins which are pulled low by a pressed button
+    std::atomic<unsigned short> m_pressed;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    Write m_lastWrite;
+    unsigned long long m_numWrites;
+    unsigned long long m_mark; // m_numWrites at the last call of setPressed
+};
+
+#endif // BENCHI2CBUS_H
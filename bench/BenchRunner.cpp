@@ -0,0 +1,220 @@
+
+#include "bench/BenchRunner.h"
+#include "bench/BenchScript.h"
+#include "ConfigManager.h"
+#include "hw/HWInputFader.h"
+#include "hw/HWOutput.h"
+#include "script/RuleExecutor.h"
+#include "script/Script.h"
+#include "util/LatencyTrace.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <time.h>
+
+// a run must post at least this fraction of the requested rate, otherwise the injecting thread is the bottleneck
+#define BENCH_MIN_ACHIEVED_FRACTION 0.95
+
+BenchRunner::BenchRunner(ConfigManager* config)
+{
+    m_config = config;
+    m_script = NULL;
+    m_nextStep = 0;
+}
+
+BenchRunner::~BenchRunner()
+{
+    this->stop();
+}
+
+/**
+ * @brief BenchRunner::start loads the script with Script::load, makes it the active script of the config
+ * and overrides all inputs, so that only the benchmark changes them
+ * @param scriptName
+ * @return false if the script could not be loaded
+ */
+bool BenchRunner::start(const std::string& scriptName)
+{
+    m_script = Script::load(scriptName);
+    if(m_script == NULL)
+    {
+        printf("raspbench: could not load script %s\n", scriptName.c_str());
+        return false;
+    }
+
+    std::list<HWInput*> listInput = m_config->getInputList();
+    for(std::list<HWInput*>::iterator it = listInput.begin(); it != listInput.end(); it++)
+    {
+        (*it)->setOverride(true);
+    }
+
+    std::list<HWOutput*> listOutput = m_config->getOutputList();
+    for(std::list<HWOutput*>::iterator it = listOutput.begin(); it != listOutput.end(); it++)
+    {
+        (*it)->registerOutputListener(this);
+    }
+
+    m_config->setActiveScript(m_script);
+
+    // the initial evaluation of the script must not be counted
+    m_config->getRuleExecutor()->flush();
+    m_latencies.clear();
+
+    return true;
+}
+
+/**
+ * @brief BenchRunner::stop stops and deletes the script and resets all faders to 0
+ */
+void BenchRunner::stop()
+{
+    if(m_script == NULL)
+        return;
+
+    m_config->stopActiveScript();
+
+    delete m_script;
+    m_script = NULL;
+
+    std::list<HWOutput*> listOutput = m_config->getOutputList();
+    for(std::list<HWOutput*>::iterator it = listOutput.begin(); it != listOutput.end(); it++)
+    {
+        (*it)->unregisterOutputListener(this);
+    }
+
+    std::list<HWInput*> listInput = m_config->getInputList();
+    for(std::list<HWInput*>::iterator it = listInput.begin(); it != listInput.end(); it++)
+    {
+        if((*it)->getType() == HWInput::Fader)
+            ((HWInputFader*)(*it))->setOverrideValue(0);
+
+        (*it)->setOverride(false);
+    }
+
+    m_steps.clear();
+    m_nextStep = 0;
+}
+
+/**
+ * @brief BenchRunner::addStep appends a change of a fader to the sequence which is injected by BenchRunner::run.
+ * The steps have to be chosen so that every step changes exactly one output, a missing write means the change has been coalesced.
+ * @param fader index of the fader, see BenchScript::faderName
+ * @param value
+ * @return false if the fader does not exist
+ */
+bool BenchRunner::addStep(unsigned int fader, unsigned int value)
+{
+    HWInput* hw = m_config->getInputByName( BenchScript::faderName(fader) );
+    if(hw == NULL || hw->getType() != HWInput::Fader)
+    {
+        printf("raspbench: fader %u does not exist\n", fader);
+        return false;
+    }
+
+    Step step;
+    step.fader = (HWInputFader*)hw;
+    step.value = value;
+
+    m_steps.push_back(step);
+
+    return true;
+}
+
+/**
+ * @brief BenchRunner::run injects the steps at the given rate for durationMs miliseconds, waits until the executor has handled all of them
+ * and calculates the latencies of the output writes
+ * @param rate input changes per second, 0 means as fast as possible
+ * @param durationMs
+ * @param p99LimitUs the run is not sustained if p99 is above this limit
+ * @return
+ */
+BenchRunner::Result BenchRunner::run(unsigned int rate, unsigned int durationMs, unsigned long long p99LimitUs)
+{
+    Result result;
+    result.rate = rate;
+    result.inputs = 0;
+
+    m_latencies.clear();
+    m_latencies.reserve( rate != 0 ? (unsigned long long)rate * durationMs / 1000 + 1 : 1000000 );
+
+    unsigned long long period = rate != 0 ? 1000000000ULL / rate : 0;
+    unsigned long long start = LatencyTrace::timestamp();
+    unsigned long long end = start + durationMs * 1000000ULL;
+    unsigned long long next = start;
+
+    while(next < end)
+    {
+        if(period != 0)
+        {
+            timespec wakeup;
+            wakeup.tv_sec = next / 1000000000ULL;
+            wakeup.tv_nsec = next % 1000000000ULL;
+
+            while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) != 0);
+
+            next += period;
+        }
+        else
+        {
+            next = LatencyTrace::timestamp();
+        }
+
+        Step& step = m_steps[m_nextStep];
+        m_nextStep = (m_nextStep + 1) % m_steps.size();
+
+        step.fader->setOverrideValue(step.value);
+        result.inputs++;
+    }
+
+    double seconds = (LatencyTrace::timestamp() - start) / 1e9;
+
+    // every write has been timestamped once the executor has handled all input changes
+    m_config->getRuleExecutor()->flush();
+
+    std::sort(m_latencies.begin(), m_latencies.end());
+
+    result.achievedRate = result.inputs / seconds;
+    result.writes = m_latencies.size();
+    result.p50Us = BenchRunner::percentile(m_latencies, 0.5) / 1000;
+    result.p99Us = BenchRunner::percentile(m_latencies, 0.99) / 1000;
+    result.p999Us = BenchRunner::percentile(m_latencies, 0.999) / 1000;
+    result.maxUs = m_latencies.empty() ? 0 : m_latencies.back() / 1000;
+
+    result.sustained = result.writes >= result.inputs && result.p99Us <= p99LimitUs
+            && (rate == 0 || result.achievedRate >= rate * BENCH_MIN_ACHIEVED_FRACTION);
+
+    return result;
+}
+
+/**
+ * @brief BenchRunner::onOutputChanged is called by the executor thread for every write to a dummy output
+ * @param hw
+ */
+void BenchRunner::onOutputChanged(HWOutput*)
+{
+    unsigned long long origin = LatencyTrace::getOrigin();
+
+    // writes which have not been caused by an input change, e.g. by a sleep, have no latency
+    if(origin == 0)
+        return;
+
+    m_latencies.push_back(LatencyTrace::timestamp() - origin);
+}
+
+/**
+ * @brief BenchRunner::percentile returns the smallest latency which is not exceeded by the given fraction of all latencies
+ * @param sorted latencies in ascending order
+ * @param fraction e.g. 0.99 for the 99th percentile
+ * @return
+ */
+unsigned long long BenchRunner::percentile(const std::vector<unsigned long long>& sorted, double fraction)
+{
+    if(sorted.empty())
+        return 0;
+
+    unsigned long long index = (unsigned long long)(sorted.size() * fraction);
+    if(index >= sorted.size())
+        index = sorted.size() - 1;
+
+    return sorted[index];
+}
@@ -0,0 +1,66 @@
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include "hw/HWOutputListener.h"
+
+#include <string>
+#include <vector>
+
+class ConfigManager;
+class HWInputFader;
+class Script;
+
+/**
+ * @brief The BenchRunner class runs a real script against the dummy faders and LEDs of the benchmark config.
+ * The faders are overridden and driven with a fixed sequence of steps at a given rate, like dummy hardware driven from the GUI.
+ * Every write to a dummy output is timestamped by the executor thread and traced back to the input change which caused it,
+ * see LatencyTrace::getOrigin, so the latencies include the time the change has been waiting in the queue of the executor.
+ */
+class BenchRunner : public HWOutputListener
+{
+public:
+    struct Result
+    {
+        unsigned int rate; // requested input changes per second, 0 means as fast as possible
+        double achievedRate; // input changes the injecting thread managed to post per second
+        unsigned long long inputs;
+        unsigned long long writes;
+        unsigned long long p50Us;
+        unsigned long long p99Us;
+        unsigned long long p999Us;
+        unsigned long long maxUs;
+        bool sustained; // every input change has been answered and p99 stayed within the limit
+    };
+
+    BenchRunner(ConfigManager* config);
+    ~BenchRunner();
+
+    bool start(const std::string& scriptName);
+    void stop();
+
+    bool addStep(unsigned int fader, unsigned int value);
+
+    Result run(unsigned int rate, unsigned int durationMs, unsigned long long p99LimitUs);
+
+    void onOutputChanged(HWOutput* hw);
+
+    static unsigned long long percentile(const std::vector<unsigned long long>& sorted, double fraction);
+
+private:
+    struct Step
+    {
+        HWInputFader* fader;
+        unsigned int value;
+    };
+
+    ConfigManager* m_config;
+    Script* m_script;
+
+    std::vector<Step> m_steps;
+    unsigned int m_nextStep;
+
+    // only written by the executor thread, read after RuleExecutor::flush
+    std::vector<unsigned long long> m_latencies; // in ns
+};
+
+#endif // BENCHRUNNER_H
@@ -0,0 +1,260 @@
+
+#include "bench/BenchScript.h"
+#include "script/ScriptCache.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+BenchScript::BenchScript(const std::string& name)
+{
+    m_name = name;
+    m_numRules = 0;
+
+    m_xml = "<script>\n";
+    m_xml.append("    <description>generated by raspbench</description>\n");
+}
+
+void BenchScript::addVariable(const std::string& name, int defaultValue)
+{
+    m_xml.append("    <variable>\n");
+    m_xml.append("        <name>" + escape(name) + "</name>\n");
+    m_xml.append("        <defaultValue>" + std::to_string(defaultValue) + "</defaultValue>\n");
+    m_xml.append("    </variable>\n");
+}
+
+void BenchScript::beginRule(const std::string& name)
+{
+    m_xml.append("    <rule>\n");
+    this->element("name", name);
+    this->element("type", "Normal");
+
+    m_numRules++;
+}
+
+void BenchScript::addFaderCondition(const std::string& fader, const std::string& trigger, int triggerValue)
+{
+    m_xml.append("        <condition>\n");
+    this->element("type", "input");
+    this->element("subtype", "Fader");
+    this->element("name", fader);
+    this->element("trigger", trigger);
+    this->element("TriggerValue", std::to_string(triggerValue));
+    m_xml.append("        </condition>\n");
+}
+
+void BenchScript::addButtonCondition(const std::string& button, const std::string& trigger)
+{
+    m_xml.append("        <condition>\n");
+    this->element("type", "input");
+    this->element("subtype", "Button");
+    this->element("name", button);
+    this->element("trigger", trigger);
+    m_xml.append("        </condition>\n");
+}
+
+void BenchScript::addVariableCondition(const std::string& var, const std::string& trigger, int value)
+{
+    m_xml.append("        <condition>\n");
+    this->element("type", "variable");
+    this->element("name", var);
+    this->element("trigger", trigger);
+    this->element("value", std::to_string(value));
+    m_xml.append("        </condition>\n");
+}
+
+void BenchScript::addExpressionCondition(const std::string& expression)
+{
+    m_xml.append("        <condition>\n");
+    this->element("type", "expression");
+    this->element("expression", expression);
+    m_xml.append("        </condition>\n");
+}
+
+void BenchScript::addLEDAction(const std::string& led, unsigned int value)
+{
+    m_xml.append("        <action>\n");
+    this->element("type", "output");
+    this->element("subtype", "LED");
+    this->element("name", led);
+    this->element("value", std::to_string(value));
+    m_xml.append("        </action>\n");
+}
+
+void BenchScript::addVariableAction(const std::string& var, const std::string& op, int operand)
+{
+    m_xml.append("        <action>\n");
+    this->element("type", "variable");
+    this->element("name", var);
+    this->element("operator", op);
+    this->element("operand", std::to_string(operand));
+    m_xml.append("        </action>\n");
+}
+
+void BenchScript::addExpressionAction(const std::string& var, const std::string& expression)
+{
+    m_xml.append("        <action>\n");
+    this->element("type", "variable");
+    this->element("name", var);
+    this->element("operator", "Expression");
+    this->element("expression", expression);
+    m_xml.append("        </action>\n");
+}
+
+void BenchScript::endRule()
+{
+    m_xml.append("    </rule>\n");
+}
+
+/**
+ * @brief BenchScript::write writes the script to scripts/<name>.xml, an existing cache of an older version is outdated afterwards
+ * @return
+ */
+bool BenchScript::write() const
+{
+    std::string filename = "scripts/" + m_name + ".xml";
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(file == NULL)
+    {
+        printf("raspbench: could not write %s\n", filename.c_str());
+        return false;
+    }
+
+    fputs(m_xml.c_str(), file);
+    fputs("</script>\n", file);
+    fclose(file);
+
+    return true;
+}
+
+/**
+ * @brief BenchScript::removeCache deletes the compiled version of the script, so the next Script::load has to parse the XML file
+ */
+void BenchScript::removeCache() const
+{
+    unlink( ScriptCache::cacheFilename("scripts/" + m_name + ".xml").c_str() );
+}
+
+/**
+ * @brief BenchScript::writeConfig writes config/<name>.xml with dummy faders and LEDs, see faderName and ledName
+ * @param name
+ * @param numFaders
+ * @param numLEDs
+ * @return
+ */
+bool BenchScript::writeConfig(const std::string& name, unsigned int numFaders, unsigned int numLEDs)
+{
+    std::string filename = "config/" + name + ".xml";
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(file == NULL)
+    {
+        printf("raspbench: could not write %s\n", filename.c_str());
+        return false;
+    }
+
+    fputs("<config>\n", file);
+
+    for(unsigned int i = 0; i < numFaders; i++)
+        fprintf(file, "    <input>\n        <name>%s</name>\n        <type>Fader</type>\n    </input>\n", faderName(i).c_str());
+
+    for(unsigned int i = 0; i < numLEDs; i++)
+        fprintf(file, "    <output>\n        <name>%s</name>\n        <type>LED</type>\n    </output>\n", ledName(i).c_str());
+
+    fputs("</config>\n", file);
+    fclose(file);
+
+    return true;
+}
+
+/**
+ * @brief BenchScript::writeI2CConfig writes config/<name>.xml with 16 buttons on a PCF8575 and 16 LEDs on a PCA9635,
+ * see i2cButtonName and i2cLEDName. The devices are simulated by BenchI2CBus.
+ * @param name
+ * @param pcfAddress
+ * @param ledAddress
+ * @return
+ */
+bool BenchScript::writeI2CConfig(const std::string& name, int pcfAddress, int ledAddress)
+{
+    std::string filename = "config/" + name + ".xml";
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(file == NULL)
+    {
+        printf("raspbench: could not write %s\n", filename.c_str());
+        return false;
+    }
+
+    fputs("<config>\n", file);
+
+    for(unsigned int i = 0; i < 16; i++)
+        fprintf(file, "    <input>\n        <name>%s</name>\n        <type>Button</type>\n        <hwtype>I2C</hwtype>\n"
+                "        <SlaveAddress>%d</SlaveAddress>\n        <Port>%u</Port>\n    </input>\n", i2cButtonName(i).c_str(), pcfAddress, i);
+
+    for(unsigned int i = 0; i < 16; i++)
+        fprintf(file, "    <output>\n        <name>%s</name>\n        <type>LED</type>\n        <hwtype>I2C</hwtype>\n"
+                "        <SlaveAddress>%d</SlaveAddress>\n        <Channel>%u</Channel>\n    </output>\n", i2cLEDName(i).c_str(), ledAddress, i);
+
+    fputs("</config>\n", file);
+    fclose(file);
+
+    return true;
+}
+
+std::string BenchScript::faderName(unsigned int index)
+{
+    return "Fader " + std::to_string(index);
+}
+
+std::string BenchScript::ledName(unsigned int index)
+{
+    return "LED " + std::to_string(index);
+}
+
+std::string BenchScript::i2cButtonName(unsigned int port)
+{
+    return "I2C Button " + std::to_string(port);
+}
+
+std::string BenchScript::i2cLEDName(unsigned int channel)
+{
+    return "I2C LED " + std::to_string(channel);
+}
+
+void BenchScript::element(const char* tag, const std::string& text)
+{
+    m_xml.append("        <");
+    m_xml.append(tag);
+    m_xml.append(">");
+    m_xml.append(escape(text));
+    m_xml.append("</");
+    m_xml.append(tag);
+    m_xml.append(">\n");
+}
+
+std::string BenchScript::escape(const std::string& text)
+{
+    std::string str;
+
+    for(std::string::const_iterator it = text.begin(); it != text.end(); it++)
+    {
+        switch(*it)
+        {
+        case '&':
+            str.append("&amp;");
+            break;
+        case '<':
+            str.append("&lt;");
+            break;
+        case '>':
+            str.append("&gt;");
+            break;
+        default:
+            str.push_back(*it);
+            break;
+        }
+    }
+
+    return str;
+}
@@ -0,0 +1,50 @@
+#ifndef BENCHSCRIPT_H
+#define BENCHSCRIPT_H
+
+#include <string>
+
+/**
+ * @brief The BenchScript class generates the XML file of a script for the benchmark.
+ * Rules are written one element at a time, the file is written to scripts/<name>.xml by BenchScript::write,
+ * so the script is loaded through Script::load exactly like a script saved by the GUI.
+ */
+class BenchScript
+{
+public:
+    BenchScript(const std::string& name);
+
+    void addVariable(const std::string& name, int defaultValue);
+
+    void beginRule(const std::string& name);
+    void addFaderCondition(const std::string& fader, const std::string& trigger, int triggerValue);
+    void addButtonCondition(const std::string& button, const std::string& trigger);
+    void addVariableCondition(const std::string& var, const std::string& trigger, int value);
+    void addExpressionCondition(const std::string& expression);
+    void addLEDAction(const std::string& led, unsigned int value);
+    void addVariableAction(const std::string& var, const std::string& op, int operand);
+    void addExpressionAction(const std::string& var, const std::string& expression);
+    void endRule();
+
+    bool write() const;
+    void removeCache() const;
+
+    std::string getName() const { return m_name;}
+    unsigned int getNumRules() const { return m_numRules;}
+
+    static bool writeConfig(const std::string& name, unsigned int numFaders, unsigned int numLEDs);
+    static bool writeI2CConfig(const std::string& name, int pcfAddress, int ledAddress);
+    static std::string faderName(unsigned int index);
+    static std::string ledName(unsigned int index);
+    static std::string i2cButtonName(unsigned int port);
+    static std::string i2cLEDName(unsigned int channel);
+
+private:
+    void element(const char* tag, const std::string& text);
+    static std::string escape(const std::string& text);
+
+    std::string m_name;
+    std::string m_xml;
+    unsigned int m_numRules;
+};
+
+#endif // BENCHSCRIPT_H
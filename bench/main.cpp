@@ -0,0 +1,1040 @@
+#include "ConfigManager.h"
+#include "bench/BenchI2CBus.h"
+#include "bench/BenchRunner.h"
+#include "bench/BenchScript.h"
+#include "script/Script.h"
+#include "script/ScriptLibrary.h"
+#include "util/Debug.h"
+#include "util/LatencyTrace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+ * raspbench runs generated scenario scripts against the dummy faders and LEDs of a generated config and prints
+ * the latency from an input change to the resulting output write (p50/p99/p99.9/max) and the highest rate of input changes
+ * the rule engine sustains. It needs neither hardware nor a display, so numbers are comparable between revisions on the same machine.
+ * The i2c_button scenario presses a button on a simulated PCF8575 and measures the time until a simulated LED driver is written,
+ * through the I2C thread like on a raspberry. It runs for the duration of one run and ignores -r and -p.
+ * The startup and load scenarios measure load times and memory of generated scripts and configs instead.
+ *
+ * usage: raspbench [-d dir] [-t ms] [-r rate] [-p us] [scenario ...]
+ *   -d  working directory for the generated config and scripts, a new directory in /tmp by default
+ *   -t  duration of every run at one rate in ms, default 2000
+ *   -r  only run at this rate instead of searching the saturation rate
+ *   -p  p99 latency in us up to which a rate counts as sustained, default 10000
+ * Without a scenario all scenarios are run.
+ */
+
+// the generated config is shared by all scenarios
+#define BENCH_CONFIG            "bench"
+#define BENCH_FADERS            100
+#define BENCH_LEDS              100
+
+#define BENCH_DEFAULT_DURATION  2000
+#define BENCH_DEFAULT_P99_LIMIT 10000
+// the saturation search starts at this rate and doubles it until a run is not sustained anymore
+#define BENCH_START_RATE        250
+#define BENCH_MAX_RATE          4000000
+// number of bisection steps between the last sustained and the first failed rate
+#define BENCH_REFINE_STEPS      3
+
+// the I2C config of the i2c_button scenario, the devices are simulated by BenchI2CBus
+#define BENCH_I2C_CONFIG        "bench_i2c"
+#define BENCH_PCF8575_ADDRESS   0x20
+#define BENCH_PCA9635_ADDRESS   0x40
+// a press has to be answered within this time, otherwise it is counted as lost
+#define BENCH_I2C_TIMEOUT       1000
+
+// size of the script library of the startup scenario
+#define BENCH_LIBRARY_SCRIPTS   100
+#define BENCH_LIBRARY_RULES     50
+// every load time is measured this often
+#define BENCH_LOAD_REPEAT       5
+
+// size of the script and the config of the load scenario
+#define BENCH_LARGE_RULES       5000
+#define BENCH_LARGE_FADERS      2000
+#define BENCH_LARGE_LEDS        2000
+
+struct Options
+{
+    unsigned int durationMs;
+    unsigned int rate;
+    unsigned long long p99LimitUs;
+};
+
+struct InputStep
+{
+    unsigned int fader;
+    unsigned int value;
+};
+
+/**
+ * @brief printResult prints one line of the result table, see printHeader
+ */
+static void printResult(const BenchRunner::Result& result)
+{
+    printf("%10u %12.0f %10llu %10llu %10llu %10llu %10llu %10llu  %s\n",
+           result.rate, result.achievedRate, result.inputs, result.writes,
+           result.p50Us, result.p99Us, result.p999Us, result.maxUs, result.sustained ? "ok" : "saturated");
+}
+
+static void printHeader()
+{
+    printf("%10s %12s %10s %10s %10s %10s %10s %10s\n",
+           "rate/s", "achieved/s", "inputs", "writes", "p50 us", "p99 us", "p99.9 us", "max us");
+}
+
+/**
+ * @brief runLatency writes the script, starts it in a fresh ConfigManager and injects the steps, either at the rate of the options
+ * or at increasing rates until the rule engine does not keep up anymore
+ * @param options
+ * @param script
+ * @param steps every step must change exactly one output
+ * @return false if the scenario could not be started
+ */
+static bool runLatency(const Options& options, const BenchScript& script, const std::vector<InputStep>& steps)
+{
+    if(!script.write())
+        return false;
+
+    ConfigManager config;
+    if(!config.load(BENCH_CONFIG))
+    {
+        printf("raspbench: could not load config %s\n", BENCH_CONFIG);
+        return false;
+    }
+
+    config.init();
+
+    BenchRunner runner(&config);
+    bool ok = runner.start(script.getName());
+
+    for(std::vector<InputStep>::const_iterator it = steps.begin(); ok && it != steps.end(); it++)
+        ok = runner.addStep((*it).fader, (*it).value);
+
+    if(ok)
+    {
+        printHeader();
+
+        if(options.rate != 0)
+        {
+            printResult( runner.run(options.rate, options.durationMs, options.p99LimitUs) );
+        }
+        else
+        {
+            double saturation = 0;
+            unsigned int good = 0;
+            unsigned int bad = 0;
+
+            for(unsigned int rate = BENCH_START_RATE; rate <= BENCH_MAX_RATE; rate *= 2)
+            {
+                BenchRunner::Result result = runner.run(rate, options.durationMs, options.p99LimitUs);
+                printResult(result);
+
+                if(!result.sustained)
+                {
+                    bad = rate;
+                    break;
+                }
+
+                good = rate;
+                saturation = result.achievedRate;
+            }
+
+            // the saturation lies between the last sustained and the first failed rate
+            for(unsigned int i = 0; i < BENCH_REFINE_STEPS && good != 0 && bad != 0; i++)
+            {
+                unsigned int rate = good + (bad - good) / 2;
+
+                BenchRunner::Result result = runner.run(rate, options.durationMs, options.p99LimitUs);
+                printResult(result);
+
+                if(result.sustained)
+                {
+                    good = rate;
+                    saturation = result.achievedRate;
+                }
+                else
+                {
+                    bad = rate;
+                }
+            }
+
+            if(good == 0)
+                printf("saturation: not even %u input changes/s are sustained\n", BENCH_START_RATE);
+            else if(bad == 0)
+                printf("saturation: above %.0f input changes/s, the highest rate tried\n", saturation);
+            else
+                printf("saturation: %.0f input changes/s with p99 <= %llu us\n", saturation, options.p99LimitUs);
+        }
+    }
+
+    runner.stop();
+
+    config.deinit();
+    config.clear();
+
+    return ok;
+}
+
+/**
+ * @brief addSwitch adds two rules which switch the LED on while the fader is above 50 and off while it is below 50
+ * @param script
+ * @param fader
+ * @param led
+ */
+static void addSwitch(BenchScript* script, unsigned int fader, unsigned int led)
+{
+    script->beginRule("on " + std::to_string(fader) + " " + std::to_string(led));
+    script->addFaderCondition(BenchScript::faderName(fader), "GreaterThan", 50);
+    script->addLEDAction(BenchScript::ledName(led), 100);
+    script->endRule();
+
+    script->beginRule("off " + std::to_string(fader) + " " + std::to_string(led));
+    script->addFaderCondition(BenchScript::faderName(fader), "LessThan", 50);
+    script->addLEDAction(BenchScript::ledName(led), 0);
+    script->endRule();
+}
+
+/**
+ * @brief addIdleRule adds a rule which depends on the fader, but is never started, as its second fader never gets above 100.
+ * The executor still has to update its condition for every change of the fader.
+ * @param script
+ * @param fader
+ * @param other
+ * @param index makes the name of the rule unique
+ */
+static void addIdleRule(BenchScript* script, unsigned int fader, unsigned int other, unsigned int index)
+{
+    script->beginRule("idle " + std::to_string(fader) + " " + std::to_string(index));
+    script->addFaderCondition(BenchScript::faderName(fader), index % 2 == 0 ? "GreaterThan" : "LessThan", 50);
+    script->addFaderCondition(BenchScript::faderName(other), "GreaterThan", 100);
+    script->addLEDAction(BenchScript::ledName(fader), 50);
+    script->endRule();
+}
+
+/**
+ * @brief scenarioPassthrough is the shortest path through the rule engine: one fader switches one LED on and off
+ */
+static bool scenarioPassthrough(const Options& options)
+{
+    BenchScript script("bench_passthrough");
+
+    addSwitch(&script, 0, 0);
+
+    std::vector<InputStep> steps;
+    InputStep on = {0, 100};
+    InputStep off = {0, 0};
+    steps.push_back(on);
+    steps.push_back(off);
+
+    return runLatency(options, script, steps);
+}
+
+/**
+ * @brief scenarioFaders switches every LED by its own fader, the faders are changed in turn, so the changes spread over all inputs
+ */
+static bool scenarioFaders(const Options& options)
+{
+    BenchScript script("bench_faders");
+    std::vector<InputStep> steps;
+
+    for(unsigned int i = 0; i < BENCH_FADERS && i < BENCH_LEDS; i++)
+    {
+        addSwitch(&script, i, i);
+
+        InputStep on = {i, 100};
+        steps.push_back(on);
+    }
+
+    for(unsigned int i = 0; i < BENCH_FADERS && i < BENCH_LEDS; i++)
+    {
+        InputStep off = {i, 0};
+        steps.push_back(off);
+    }
+
+    return runLatency(options, script, steps);
+}
+
+/**
+ * @brief scenarioRules1000 is a generated script with 1,000 rules, 10 rules on each of the 100 faders.
+ * Per fader two rules switch its LED, the other 8 have a second condition which is never fulfilled.
+ * The faders are changed in turn. Every change updates the conditions of the 10 rules of the fader and of the 8 idle rules of its neighbour.
+ */
+static bool scenarioRules1000(const Options& options)
+{
+    BenchScript script("bench_rules1000");
+    std::vector<InputStep> steps;
+
+    for(unsigned int i = 0; i < BENCH_FADERS && i < BENCH_LEDS; i++)
+    {
+        addSwitch(&script, i, i);
+
+        for(unsigned int j = 0; j < 8; j++)
+            addIdleRule(&script, i, (i + 1) % BENCH_FADERS, j);
+
+        InputStep on = {i, 100};
+        steps.push_back(on);
+    }
+
+    for(unsigned int i = 0; i < BENCH_FADERS && i < BENCH_LEDS; i++)
+    {
+        InputStep off = {i, 0};
+        steps.push_back(off);
+    }
+
+    printf("%u rules\n", script.getNumRules());
+
+    return runLatency(options, script, steps);
+}
+
+/**
+ * @brief scenarioRules1000One is a generated script with 1,000 rules which all depend on the same fader, like a large show on one input.
+ * Only two of them switch an LED, so every change updates 1,000 conditions for one output write.
+ */
+static bool scenarioRules1000One(const Options& options)
+{
+    BenchScript script("bench_rules1000_one");
+
+    addSwitch(&script, 0, 0);
+
+    for(unsigned int j = 0; j < 998; j++)
+        addIdleRule(&script, 0, 1, j);
+
+    std::vector<InputStep> steps;
+    InputStep on = {0, 100};
+    InputStep off = {0, 0};
+    steps.push_back(on);
+    steps.push_back(off);
+
+    printf("%u rules\n", script.getNumRules());
+
+    return runLatency(options, script, steps);
+}
+
+/**
+ * @brief addSpeedSwitch adds two rules which switch LED 0 on while the variable speed is above 40 and off while it is below 40
+ * @param script
+ */
+static void addSpeedSwitch(BenchScript* script)
+{
+    script->beginRule("speed on");
+    script->addVariableCondition("speed", "GreaterThan", 40);
+    script->addLEDAction(BenchScript::ledName(0), 100);
+    script->endRule();
+
+    script->beginRule("speed off");
+    script->addVariableCondition("speed", "LessThan", 40);
+    script->addLEDAction(BenchScript::ledName(0), 0);
+    script->endRule();
+}
+
+/**
+ * @brief speedSteps moves fader 0 between 0 and 100, i.e. speed = fader * 2 / 3 + offset between 0 and 66
+ * @return
+ */
+static std::vector<InputStep> speedSteps()
+{
+    std::vector<InputStep> steps;
+    InputStep on = {0, 100};
+    InputStep off = {0, 0};
+    steps.push_back(on);
+    steps.push_back(off);
+
+    return steps;
+}
+
+/**
+ * @brief scenarioExpression switches LED 0 by a condition expression on speed = fader * 2 / 3 + offset, one rule runs per change
+ */
+static bool scenarioExpression(const Options& options)
+{
+    BenchScript script("bench_expression");
+    script.addVariable("offset", 0);
+
+    script.beginRule("on");
+    script.addExpressionCondition("\"" + BenchScript::faderName(0) + "\" * 2 / 3 + offset > 40");
+    script.addLEDAction(BenchScript::ledName(0), 100);
+    script.endRule();
+
+    script.beginRule("off");
+    script.addExpressionCondition("\"" + BenchScript::faderName(0) + "\" * 2 / 3 + offset <= 40");
+    script.addLEDAction(BenchScript::ledName(0), 0);
+    script.endRule();
+
+    return runLatency(options, script, speedSteps());
+}
+
+/**
+ * @brief scenarioExpressionAction calculates speed = fader * 2 / 3 + offset with a variable action and switches LED 0 by speed,
+ * two rules run per change. The action reads the current value of the fader, so close to saturation a write may be skipped
+ * because the fader has already moved on, which counts as not sustained like a coalesced change.
+ */
+static bool scenarioExpressionAction(const Options& options)
+{
+    BenchScript script("bench_expression_action");
+    script.addVariable("offset", 0);
+    script.addVariable("speed", 0);
+
+    const char* triggers[] = {"GreaterThan", "LessThan"};
+    for(unsigned int i = 0; i < 2; i++)
+    {
+        script.beginRule(std::string("speed ") + triggers[i]);
+        script.addFaderCondition(BenchScript::faderName(0), triggers[i], 50);
+        script.addExpressionAction("speed", "\"" + BenchScript::faderName(0) + "\" * 2 / 3 + offset");
+        script.endRule();
+    }
+
+    addSpeedSwitch(&script);
+
+    return runLatency(options, script, speedSteps());
+}
+
+/**
+ * @brief scenarioChain is the same as scenarioExpressionAction written without expressions, the way scripts emulated arithmetic before:
+ * the fader sets a helper variable, the helper variable sets speed to the precalculated value. Three rules run per change.
+ */
+static bool scenarioChain(const Options& options)
+{
+    BenchScript script("bench_chain");
+    script.addVariable("helper", 0);
+    script.addVariable("speed", 0);
+
+    script.beginRule("helper on");
+    script.addFaderCondition(BenchScript::faderName(0), "GreaterThan", 50);
+    script.addVariableAction("helper", "Equal", 1);
+    script.endRule();
+
+    script.beginRule("helper off");
+    script.addFaderCondition(BenchScript::faderName(0), "LessThan", 50);
+    script.addVariableAction("helper", "Equal", 0);
+    script.endRule();
+
+    // 100 * 2 / 3 + 0 and 0 * 2 / 3 + 0
+    script.beginRule("speed high");
+    script.addVariableCondition("helper", "Equal", 1);
+    script.addVariableAction("speed", "Equal", 66);
+    script.endRule();
+
+    script.beginRule("speed low");
+    script.addVariableCondition("helper", "Equal", 0);
+    script.addVariableAction("speed", "Equal", 0);
+    script.endRule();
+
+    addSpeedSwitch(&script);
+
+    return runLatency(options, script, speedSteps());
+}
+
+/**
+ * @brief printI2CLatencies prints count and percentiles of the given latencies
+ * @param name
+ * @param latencies in ns, they are sorted by this function
+ */
+static void printI2CLatencies(const char* name, std::vector<unsigned long long>& latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%-22s %10llu %10llu %10llu %10llu\n", name, (unsigned long long)latencies.size(),
+           BenchRunner::percentile(latencies, 0.5) / 1000, BenchRunner::percentile(latencies, 0.99) / 1000,
+           latencies.empty() ? 0 : latencies.back() / 1000);
+}
+
+/**
+ * @brief scenarioI2CButton switches an I2C LED by an I2C button, both on a simulated bus, see BenchI2CBus.
+ * The path is PCF8575I2C::poll -> HWInputButtonI2C -> ConditionInputButton -> ActionOutputLED -> queue of the I2C thread -> HWOutputLEDI2C::setI2C.
+ * The button is pressed and released in turn, every change waits for its LED write. The time from the pin change to the write
+ * includes the poll interval of the PCF8575, the time from posting the input change to the write is the Bus stage of LatencyTrace.
+ */
+static bool scenarioI2CButton(const Options& options)
+{
+    BenchScript script("bench_i2c_button");
+
+    script.beginRule("press");
+    script.addButtonCondition(BenchScript::i2cButtonName(0), "Pressed");
+    script.addLEDAction(BenchScript::i2cLEDName(0), 100);
+    script.endRule();
+
+    script.beginRule("release");
+    script.addButtonCondition(BenchScript::i2cButtonName(0), "Released");
+    script.addLEDAction(BenchScript::i2cLEDName(0), 0);
+    script.endRule();
+
+    if(!script.write() || !BenchScript::writeI2CConfig(BENCH_I2C_CONFIG, BENCH_PCF8575_ADDRESS, BENCH_PCA9635_ADDRESS))
+        return false;
+
+    // the bus has to outlive the I2C thread of the config
+    BenchI2CBus bus(BENCH_PCF8575_ADDRESS, BENCH_PCA9635_ADDRESS);
+
+    ConfigManager config;
+    config.setI2CBus(&bus);
+
+    if(!config.load(BENCH_I2C_CONFIG))
+    {
+        printf("raspbench: could not load config %s\n", BENCH_I2C_CONFIG);
+        return false;
+    }
+
+    config.init();
+
+    Script* active = Script::load(script.getName());
+    if(active == NULL)
+    {
+        printf("raspbench: could not load script %s\n", script.getName().c_str());
+        config.deinit();
+        config.clear();
+        return false;
+    }
+
+    config.setActiveScript(active);
+
+    std::vector<unsigned long long> pinLatencies;
+    std::vector<unsigned long long> busLatencies;
+    unsigned int lost = 0;
+    bool pressed = false;
+
+    unsigned long long end = LatencyTrace::timestamp() + options.durationMs * 1000000ULL;
+    while(LatencyTrace::timestamp() < end)
+    {
+        pressed = !pressed;
+
+        unsigned long long start = LatencyTrace::timestamp();
+        bus.setPressed(0, pressed);
+
+        BenchI2CBus::Write write;
+        if(!bus.waitForLED(0, pressed ? 255 : 0, BENCH_I2C_TIMEOUT, &write))
+        {
+            lost++;
+            continue;
+        }
+
+        pinLatencies.push_back(write.time - start);
+
+        // the write has been queued by the executor while it handled the input change
+        if(write.origin != 0)
+            busLatencies.push_back(write.time - write.origin);
+    }
+
+    printf("%-22s %10s %10s %10s %10s\n", "", "writes", "p50 us", "p99 us", "max us");
+    printI2CLatencies("pin -> write", pinLatencies);
+    printI2CLatencies("posted -> write", busLatencies);
+
+    if(lost != 0)
+        printf("raspbench: %u button changes have not been answered within %u ms\n", lost, BENCH_I2C_TIMEOUT);
+
+    config.stopActiveScript();
+    delete active;
+
+    config.deinit();
+    config.clear();
+
+    return lost == 0;
+}
+
+static double elapsedMs(unsigned long long start)
+{
+    return (LatencyTrace::timestamp() - start) / 1e6;
+}
+
+/**
+ * @brief generateShow generates a script which looks like a typical show: rules on faders, variables and expressions
+ * which switch LEDs and count in variables
+ * @param name
+ * @param numRules
+ * @return
+ */
+static BenchScript generateShow(const std::string& name, unsigned int numRules)
+{
+    BenchScript script(name);
+    script.addVariable("counter", 0);
+    script.addVariable("mode", 0);
+
+    for(unsigned int i = 0; i < numRules; i++)
+    {
+        unsigned int fader = i % BENCH_FADERS;
+        unsigned int led = (i / 4) % BENCH_LEDS;
+
+        script.beginRule("rule " + std::to_string(i));
+
+        switch(i % 4)
+        {
+        case 0:
+            script.addFaderCondition(BenchScript::faderName(fader), "GreaterThan", 50);
+            script.addLEDAction(BenchScript::ledName(led), 100);
+            script.addVariableAction("counter", "Plus", 1);
+            break;
+        case 1:
+            script.addFaderCondition(BenchScript::faderName(fader), "LessThan", 50);
+            script.addLEDAction(BenchScript::ledName(led), 0);
+            break;
+        case 2:
+            script.addVariableCondition("mode", "Equal", i % 8);
+            script.addFaderCondition(BenchScript::faderName(fader), "GreaterThan", 20);
+            script.addLEDAction(BenchScript::ledName(led), 30);
+            break;
+        default:
+            script.addExpressionCondition("counter % 8 == " + std::to_string(i % 8) + " && \"" + BenchScript::faderName(fader) + "\" < 80");
+            script.addExpressionAction("mode", "(mode + 1) % 8");
+            break;
+        }
+
+        script.endRule();
+    }
+
+    return script;
+}
+
+/**
+ * @brief measureLibrary scans the script library and loads the first script, like the GUI does at startup
+ * @return time in ms
+ */
+static double measureLibrary()
+{
+    unsigned long long start = LatencyTrace::timestamp();
+
+    ScriptLibrary library;
+    library.scan();
+
+    if(library.size() != 0)
+        library.getScript(0);
+
+    return elapsedMs(start);
+}
+
+/**
+ * @brief measureLoadAll loads every script of the library with Script::load
+ * @param scripts
+ * @return time in ms
+ */
+static double measureLoadAll(const std::vector<BenchScript>& scripts)
+{
+    unsigned long long start = LatencyTrace::timestamp();
+
+    for(std::vector<BenchScript>::const_iterator it = scripts.begin(); it != scripts.end(); it++)
+    {
+        Script* script = Script::load((*it).getName());
+        if(script == NULL)
+            printf("raspbench: could not load script %s\n", (*it).getName().c_str());
+
+        delete script;
+    }
+
+    return elapsedMs(start);
+}
+
+static void removeCaches(const std::vector<BenchScript>& scripts)
+{
+    for(std::vector<BenchScript>::const_iterator it = scripts.begin(); it != scripts.end(); it++)
+        (*it).removeCache();
+}
+
+static void minAvg(const std::vector<double>& times, double* min, double* avg)
+{
+    double sum = 0;
+    *min = times.empty() ? 0 : times[0];
+
+    for(std::vector<double>::const_iterator it = times.begin(); it != times.end(); it++)
+    {
+        if(*it < *min)
+            *min = *it;
+        sum += *it;
+    }
+
+    *avg = times.empty() ? 0 : sum / times.size();
+}
+
+static void printTimes(const char* name, const std::vector<double>& times)
+{
+    double min;
+    double avg;
+    minAvg(times, &min, &avg);
+
+    printf("%-34s %10.2f %10.2f\n", name, min, avg);
+}
+
+/**
+ * @brief scenarioStartup measures the startup with a library of 100 scripts.
+ * Cold means without the compiled binary caches, so every XML file is parsed and its cache is written,
+ * warm means with up to date caches. The XML files themselves are in the page cache in both cases.
+ */
+static bool scenarioStartup(const Options&)
+{
+    // the library has its own scripts directory, so the scripts of other scenarios are not part of it
+    mkdir("startup", 0755);
+    if(chdir("startup") != 0)
+    {
+        printf("raspbench: could not change into startup: %s\n", strerror(errno));
+        return false;
+    }
+
+    mkdir("scripts", 0755);
+
+    bool ok = true;
+
+    std::vector<BenchScript> scripts;
+    for(unsigned int i = 0; ok && i < BENCH_LIBRARY_SCRIPTS; i++)
+    {
+        scripts.push_back( generateShow("show" + std::to_string(i), BENCH_LIBRARY_RULES) );
+        ok = scripts.back().write();
+    }
+
+    if(ok)
+    {
+        printf("%u scripts with %u rules each, %u runs\n", BENCH_LIBRARY_SCRIPTS, BENCH_LIBRARY_RULES, BENCH_LOAD_REPEAT);
+        printf("%-34s %10s %10s\n", "", "min ms", "avg ms");
+
+        std::vector<double> libraryCold;
+        std::vector<double> libraryWarm;
+        std::vector<double> loadCold;
+        std::vector<double> loadWarm;
+
+        for(unsigned int i = 0; i < BENCH_LOAD_REPEAT; i++)
+        {
+            removeCaches(scripts);
+            libraryCold.push_back( measureLibrary() );
+            libraryWarm.push_back( measureLibrary() );
+
+            removeCaches(scripts);
+            loadCold.push_back( measureLoadAll(scripts) );
+            loadWarm.push_back( measureLoadAll(scripts) );
+        }
+
+        printTimes("library scan + first script, cold", libraryCold);
+        printTimes("library scan + first script, warm", libraryWarm);
+        printTimes("load all scripts, cold", loadCold);
+        printTimes("load all scripts, warm", loadWarm);
+    }
+
+    if(chdir("..") != 0)
+        return false;
+
+    return ok;
+}
+
+/**
+ * @brief residentKb reads the resident set size of this process
+ * @return RSS in kB or 0 if it could not be read
+ */
+static unsigned long residentKb()
+{
+    FILE* file = fopen("/proc/self/statm", "r");
+    if(file == NULL)
+        return 0;
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    if(fscanf(file, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+
+    fclose(file);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * @brief resetPeakKb sets the peak resident set size of this process back to its current size
+ * @return false if the kernel does not support it
+ */
+static bool resetPeakKb()
+{
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if(file == NULL)
+        return false;
+
+    bool ok = fputs("5", file) >= 0;
+    ok = fclose(file) == 0 && ok;
+
+    return ok;
+}
+
+/**
+ * @brief peakKb reads the peak resident set size of this process since the start or the last resetPeakKb
+ * @return peak RSS in kB or 0 if it could not be read
+ */
+static unsigned long peakKb()
+{
+    FILE* file = fopen("/proc/self/status", "r");
+    if(file == NULL)
+        return 0;
+
+    unsigned long peak = 0;
+    char line[256];
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        if(sscanf(line, "VmHWM: %lu kB", &peak) == 1)
+            break;
+    }
+
+    fclose(file);
+
+    return peak;
+}
+
+/**
+ * @brief printLoad prints the load times and the memory which has been used by one load
+ * @param name
+ * @param times
+ * @param baseKb RSS before the load
+ * @param peak peak RSS during the load
+ * @param retainedKb RSS while the loaded object is kept
+ */
+static void printLoad(const char* name, const std::vector<double>& times, unsigned long baseKb, unsigned long peak, unsigned long retainedKb)
+{
+    double min;
+    double avg;
+    minAvg(times, &min, &avg);
+
+    printf("%-26s %10.2f %10.2f %12ld %12ld\n", name, min, avg,
+           peak != 0 ? (long)peak - (long)baseKb : -1L, (long)retainedKb - (long)baseKb);
+}
+
+/**
+ * @brief measureScriptLoad loads the script BENCH_LOAD_REPEAT times with Script::load
+ * @param script
+ * @param cached use the compiled cache, otherwise it is removed before every load, so the XML file is parsed and the cache is written
+ * @param name
+ * @return false if the script could not be loaded
+ */
+static bool measureScriptLoad(const BenchScript& script, bool cached, const char* name)
+{
+    std::vector<double> times;
+    unsigned long baseKb = 0;
+    unsigned long peak = 0;
+    unsigned long retainedKb = 0;
+
+    for(unsigned int i = 0; i < BENCH_LOAD_REPEAT; i++)
+    {
+        if(!cached)
+            script.removeCache();
+
+        baseKb = residentKb();
+        bool peakValid = resetPeakKb();
+
+        unsigned long long start = LatencyTrace::timestamp();
+        Script* loaded = Script::load(script.getName());
+        times.push_back( elapsedMs(start) );
+
+        if(loaded == NULL)
+        {
+            printf("raspbench: could not load script %s\n", script.getName().c_str());
+            return false;
+        }
+
+        peak = peakValid ? peakKb() : 0;
+        retainedKb = residentKb();
+
+        delete loaded;
+    }
+
+    printLoad(name, times, baseKb, peak, retainedKb);
+
+    return true;
+}
+
+/**
+ * @brief scenarioLoad measures load time and memory of a large script and a large config with the streaming loaders.
+ * Memory is given as the growth of the resident set size: the peak during the load and what is left while the object is kept.
+ * The peak needs /proc/self/clear_refs, it is printed as -1 if the kernel does not support resetting it.
+ */
+static bool scenarioLoad(const Options&)
+{
+    BenchScript script = generateShow("bench_large", BENCH_LARGE_RULES);
+    if(!script.write())
+        return false;
+
+    if(!BenchScript::writeConfig("bench_large", BENCH_LARGE_FADERS, BENCH_LARGE_LEDS))
+        return false;
+
+    printf("script with %u rules, config with %u inputs and %u outputs, %u runs\n",
+           script.getNumRules(), BENCH_LARGE_FADERS, BENCH_LARGE_LEDS, BENCH_LOAD_REPEAT);
+    printf("%-26s %10s %10s %12s %12s\n", "", "min ms", "avg ms", "peak +kB", "retained +kB");
+
+    // the first load writes the cache, so the cached loads below find it
+    if(!measureScriptLoad(script, false, "script from XML"))
+        return false;
+
+    if(!measureScriptLoad(script, true, "script from cache"))
+        return false;
+
+    std::vector<double> times;
+    unsigned long baseKb = 0;
+    unsigned long peak = 0;
+    unsigned long retainedKb = 0;
+
+    for(unsigned int i = 0; i < BENCH_LOAD_REPEAT; i++)
+    {
+        ConfigManager config;
+
+        baseKb = residentKb();
+        bool peakValid = resetPeakKb();
+
+        unsigned long long start = LatencyTrace::timestamp();
+        bool loaded = config.load("bench_large");
+        times.push_back( elapsedMs(start) );
+
+        if(!loaded)
+        {
+            printf("raspbench: could not load config bench_large\n");
+            return false;
+        }
+
+        peak = peakValid ? peakKb() : 0;
+        retainedKb = residentKb();
+
+        config.clear();
+    }
+
+    printLoad("config from XML", times, baseKb, peak, retainedKb);
+
+    return true;
+}
+
+struct Scenario
+{
+    const char* name;
+    bool (*func)(const Options& options);
+};
+
+static const Scenario g_scenarios[] = {
+    {"passthrough", scenarioPassthrough},
+    {"faders", scenarioFaders},
+    {"rules1000", scenarioRules1000},
+    {"rules1000_one", scenarioRules1000One},
+    {"expression", scenarioExpression},
+    {"expression_action", scenarioExpressionAction},
+    {"chain", scenarioChain},
+    {"i2c_button", scenarioI2CButton},
+    {"startup", scenarioStartup},
+    {"load", scenarioLoad},
+};
+
+static const unsigned int g_numScenarios = sizeof(g_scenarios) / sizeof(g_scenarios[0]);
+
+/**
+ * @brief prepareDirectory changes into the working directory and writes the config of the benchmark
+ * @param dir working directory, a new one is created in /tmp if it is empty
+ * @return
+ */
+static bool prepareDirectory(std::string dir)
+{
+    if(dir.empty())
+    {
+        char tmp[] = "/tmp/raspbench.XXXXXX";
+        if(mkdtemp(tmp) == NULL)
+        {
+            printf("raspbench: could not create a working directory: %s\n", strerror(errno));
+            return false;
+        }
+
+        dir = tmp;
+    }
+
+    if(chdir(dir.c_str()) != 0)
+    {
+        printf("raspbench: could not change into %s: %s\n", dir.c_str(), strerror(errno));
+        return false;
+    }
+
+    mkdir("config", 0755);
+    mkdir("scripts", 0755);
+
+    printf("raspbench: working directory %s\n", dir.c_str());
+
+    return BenchScript::writeConfig(BENCH_CONFIG, BENCH_FADERS, BENCH_LEDS);
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    options.durationMs = BENCH_DEFAULT_DURATION;
+    options.rate = 0;
+    options.p99LimitUs = BENCH_DEFAULT_P99_LIMIT;
+
+    std::string dir;
+
+    int opt;
+    while((opt = getopt(argc, argv, "d:t:r:p:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'd':
+            dir = optarg;
+            break;
+        case 't':
+            options.durationMs = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            options.rate = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            options.p99LimitUs = strtoull(optarg, NULL, 10);
+            break;
+        default:
+            printf("usage: raspbench [-d dir] [-t ms] [-r rate] [-p us] [scenario ...]\n");
+            return 1;
+        }
+    }
+
+    if(options.durationMs == 0)
+    {
+        printf("raspbench: the duration must not be 0\n");
+        return 1;
+    }
+
+    // stdout is unbuffered, so that every line shows up while a long run is going on
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    // debug messages would be part of the measurement
+    Logger::logDebug(false);
+
+    for(int arg = optind; arg < argc; arg++)
+    {
+        bool known = false;
+        for(unsigned int i = 0; i < g_numScenarios; i++)
+        {
+            if(strcmp(argv[arg], g_scenarios[i].name) == 0)
+                known = true;
+        }
+
+        if(!known)
+        {
+            printf("raspbench: unknown scenario %s\n", argv[arg]);
+            return 1;
+        }
+    }
+
+    if(!prepareDirectory(dir))
+        return 1;
+
+    int ret = 0;
+
+    for(unsigned int i = 0; i < g_numScenarios; i++)
+    {
+        bool selected = optind == argc;
+        for(int arg = optind; arg < argc; arg++)
+        {
+            if(strcmp(argv[arg], g_scenarios[i].name) == 0)
+                selected = true;
+        }
+
+        if(!selected)
+            continue;
+
+        printf("\nscenario %s\n", g_scenarios[i].name);
+
+        if(!g_scenarios[i].func(options))
+            ret = 1;
+    }
+
+    return ret;
+}
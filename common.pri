@@ -0,0 +1,14 @@
+# -------------------------------------------------
+# Settings shared by the core library, the GUI and the daemon
+# -------------------------------------------------
+QMAKE_CXXFLAGS += -std=c++0x
+CONFIG += link_pkgconfig
+QT += xml
+LIBS += -lbluetooth
+LIBS += -lSDL_mixer -lSDL -lrt
+PKGCONFIG += glib-2.0
+
+# every project has its own object directory, as all of them are built in the same directory
+OBJECTS_DIR = build/$$TARGET
+MOC_DIR = build/$$TARGET
+UI_DIR = build/$$TARGET
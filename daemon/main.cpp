@@ -0,0 +1,149 @@
+#include "ConfigManager.h"
+#include "Defaults.h"
+#include "script/Script.h"
+#include "util/Debug.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * raspd runs the startup config and script of defaults.xml without the GUI.
+ * It is meant to be started by systemd (see tools/raspd.service) in the working directory containing config, scripts and resources.
+ * An alternative defaults file can be given as first argument.
+ */
+
+static unsigned long long elapsedMs(timespec start)
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return (currentTime.tv_sec - start.tv_sec) * 1000ULL + (currentTime.tv_nsec - start.tv_nsec) / 1000000;
+}
+
+/**
+ * @brief residentKb reads the resident set size of this process
+ * @return RSS in kB or 0 if it could not be read
+ */
+static unsigned long residentKb()
+{
+    FILE* file = fopen("/proc/self/statm", "r");
+    if(file == NULL)
+        return 0;
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    if(fscanf(file, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+
+    fclose(file);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * @brief checkScript logs every input, output or variable the script needs, but which does not exist.
+ * Unlike the GUI there is nobody to ask, so the script is started anyway.
+ */
+static void checkScript(Script* script, ConfigManager* config)
+{
+    std::list<Rule::RequiredInput> listInput;
+    std::list<Rule::RequiredOutput> listOutput;
+    std::list<Rule::RequiredVariable> listVariable;
+
+    script->getRequiredList(&listInput, &listOutput, &listVariable);
+
+    for(std::list<Rule::RequiredInput>::iterator it = listInput.begin(); it != listInput.end(); it++)
+    {
+        HWInput* input = config->getInputByName((*it).name);
+        if(input != NULL && ((*it).type == HWInput::EINVALID || input->getType() == (*it).type))
+            continue;
+
+        // names used in expressions can be satisfied by any type of input
+        if((*it).type == HWInput::EINVALID)
+            LOG_WARN(Logger::Script, "Required input %s is missing", (*it).name.c_str());
+        else
+            LOG_WARN(Logger::Script, "Required input %s with type %s is missing",
+                     (*it).name.c_str(), HWInput::HWInputTypeToString((*it).type).c_str());
+    }
+
+    for(std::list<Rule::RequiredOutput>::iterator it = listOutput.begin(); it != listOutput.end(); it++)
+    {
+        HWOutput* output = config->getOutputByName((*it).name);
+        if(output == NULL || output->getType() != (*it).type)
+            LOG_WARN(Logger::Script, "Required output %s with type %s is missing",
+                     (*it).name.c_str(), HWOutput::HWOutputTypeToString((*it).type).c_str());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    timespec startTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    // termination signals are blocked before any thread is created, so that all threads inherit this and only sigwait below receives them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    // stdout is unbuffered, so that the journal gets every line immediately
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    std::string defaultsFile = argc > 1 ? argv[1] : "defaults.xml";
+
+    Defaults defaults;
+    if(!defaults.load(defaultsFile))
+    {
+        printf("raspd: could not read %s\n", defaultsFile.c_str());
+        return 1;
+    }
+
+    defaults.applyLogSettings();
+
+    ConfigManager config;
+
+    if(!defaults.config.empty() && !config.load(defaults.config))
+    {
+        printf("raspd: could not load config %s\n", defaults.config.c_str());
+        return 1;
+    }
+
+    config.init();
+
+    Script* script = NULL;
+    if(!defaults.script.empty())
+    {
+        script = Script::load(defaults.script);
+        if(script == NULL)
+        {
+            printf("raspd: could not load script %s\n", defaults.script.c_str());
+
+            config.deinit();
+            config.clear();
+            return 1;
+        }
+
+        checkScript(script, &config);
+
+        config.setActiveScript(script);
+    }
+
+    printf("raspd: running config %s and script %s, started in %llu ms, RSS %lu kB\n",
+           config.getName().c_str(), defaults.script.c_str(), elapsedMs(startTime), residentKb());
+
+    int sig = 0;
+    while(sigwait(&signals, &sig) != 0);
+
+    printf("raspd: received signal %d, stopping\n", sig);
+
+    config.deinit();
+    config.clear();
+
+    delete script;
+
+    return 0;
+}
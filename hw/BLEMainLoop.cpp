@@ -0,0 +1,181 @@
+
+#include "hw/BLEMainLoop.h"
+#include "util/Debug.h"
+
+#include <condition_variable>
+
+std::mutex BLEMainLoop::s_mutex;
+BLEMainLoop* BLEMainLoop::s_instance = NULL;
+unsigned int BLEMainLoop::s_refCount = 0;
+
+BLEMainLoop::BLEMainLoop()
+{
+    m_context = g_main_context_new();
+    m_loop = g_main_loop_new(m_context, FALSE);
+
+    pthread_create(&m_thread, NULL, BLEMainLoop::run_internal, (void*)this);
+}
+
+BLEMainLoop::~BLEMainLoop()
+{
+    // the loop must be quit from within its own thread
+    this->invoke(std::bind(g_main_loop_quit, m_loop));
+
+    pthread_join(m_thread, NULL);
+
+    g_main_loop_unref(m_loop);
+    g_main_context_unref(m_context);
+}
+
+/**
+ * @brief BLEMainLoop::acquire returns the shared main loop and starts it, if this is the first user.
+ * Every call to BLEMainLoop::acquire must be matched by a call to BLEMainLoop::release
+ * @return
+ */
+BLEMainLoop* BLEMainLoop::acquire()
+{
+    s_mutex.lock();
+
+    if(s_instance == NULL)
+        s_instance = new BLEMainLoop();
+
+    s_refCount++;
+
+    BLEMainLoop* instance = s_instance;
+    s_mutex.unlock();
+
+    return instance;
+}
+
+/**
+ * @brief BLEMainLoop::release stops the shared main loop, if this was the last user.
+ */
+void BLEMainLoop::release()
+{
+    s_mutex.lock();
+
+    pi_assert(s_refCount > 0);
+
+    s_refCount--;
+
+    if(s_refCount == 0)
+    {
+        delete s_instance;
+        s_instance = NULL;
+    }
+
+    s_mutex.unlock();
+}
+
+void* BLEMainLoop::run_internal(void* arg)
+{
+    BLEMainLoop* loop = (BLEMainLoop*)arg;
+    loop->run();
+
+    return NULL;
+}
+
+void BLEMainLoop::run()
+{
+    // gattrib and btio attach their sources to the thread default context
+    g_main_context_push_thread_default(m_context);
+
+    g_main_loop_run(m_loop);
+
+    g_main_context_pop_thread_default(m_context);
+}
+
+struct InvokeRequest
+{
+    std::function<void ()> func;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done;
+};
+
+static gboolean helper_invoke(gpointer user_data)
+{
+    InvokeRequest* req = (InvokeRequest*)user_data;
+
+    req->func();
+
+    req->mutex.lock();
+    req->done = true;
+    req->cond.notify_one();
+    req->mutex.unlock();
+
+    return FALSE;
+}
+
+/**
+ * @brief BLEMainLoop::invoke runs func in the thread of the main loop and waits until it has finished.
+ * If this is called from within the main loop, func is run immediately.
+ * @param func
+ */
+void BLEMainLoop::invoke(std::function<void ()> func)
+{
+    if(g_main_context_is_owner(m_context))
+    {
+        func();
+        return;
+    }
+
+    InvokeRequest req;
+    req.func = func;
+    req.done = false;
+
+    g_main_context_invoke(m_context, helper_invoke, &req);
+
+    std::unique_lock<std::mutex> lock(req.mutex);
+    while(!req.done)
+        req.cond.wait(lock);
+}
+
+guint BLEMainLoop::attach(GSource* source, GSourceFunc func, gpointer data)
+{
+    g_source_set_callback(source, func, data, NULL);
+    guint id = g_source_attach(source, m_context);
+    g_source_unref(source);
+
+    return id;
+}
+
+/**
+ * @brief BLEMainLoop::addIdle runs func in the main loop as soon as it is idle. This can be called from any thread.
+ * @return the id of the source, which can be used for BLEMainLoop::removeSource
+ */
+guint BLEMainLoop::addIdle(GSourceFunc func, gpointer data)
+{
+    return this->attach(g_idle_source_new(), func, data);
+}
+
+/**
+ * @brief BLEMainLoop::addTimeout runs func in the main loop after ms miliseconds. This can be called from any thread.
+ * @return the id of the source, which can be used for BLEMainLoop::removeSource
+ */
+guint BLEMainLoop::addTimeout(unsigned int ms, GSourceFunc func, gpointer data)
+{
+    return this->attach(g_timeout_source_new(ms), func, data);
+}
+
+/**
+ * @brief BLEMainLoop::addWatch runs func in the main loop as soon as cond is met on chan. This can be called from any thread.
+ * @return the id of the source, which can be used for BLEMainLoop::removeSource
+ */
+guint BLEMainLoop::addWatch(GIOChannel* chan, GIOCondition cond, GIOFunc func, gpointer data)
+{
+    return this->attach(g_io_create_watch(chan, cond), (GSourceFunc)func, data);
+}
+
+/**
+ * @brief BLEMainLoop::removeSource removes a source which was added to this main loop.
+ * @param id
+ */
+void BLEMainLoop::removeSource(guint id)
+{
+    GSource* source = g_main_context_find_source_by_id(m_context, id);
+
+    if(source != NULL)
+        g_source_destroy(source);
+}
@@ -0,0 +1,47 @@
+#ifndef BLEMAINLOOP_H
+#define BLEMAINLOOP_H
+
+#include <functional>
+#include <mutex>
+#include <pthread.h>
+
+#include <glib.h>
+
+/**
+ * @brief The BLEMainLoop class runs one GLib main loop in its own thread, which is shared by all BLEThread objects.
+ * Every BLE device attaches its sources (connection watches, timers and wakeups) to the context of this loop,
+ * so the number of threads does not grow with the number of BLE devices.
+ * The loop is created by the first BLEMainLoop::acquire and stopped by the last BLEMainLoop::release.
+ */
+class BLEMainLoop
+{
+public:
+    static BLEMainLoop* acquire();
+    static void release();
+
+    void invoke(std::function<void ()> func);
+
+    guint addIdle(GSourceFunc func, gpointer data);
+    guint addTimeout(unsigned int ms, GSourceFunc func, gpointer data);
+    guint addWatch(GIOChannel* chan, GIOCondition cond, GIOFunc func, gpointer data);
+    void removeSource(guint id);
+
+private:
+    BLEMainLoop();
+    ~BLEMainLoop();
+
+    static void* run_internal(void* arg);
+    void run();
+
+    guint attach(GSource* source, GSourceFunc func, gpointer data);
+
+    static std::mutex s_mutex;
+    static BLEMainLoop* s_instance;
+    static unsigned int s_refCount;
+
+    pthread_t m_thread;
+    GMainContext* m_context;
+    GMainLoop* m_loop;
+};
+
+#endif // BLEMAINLOOP_H
@@ -1,14 +1,17 @@
 
 #include "hw/BLEThread.h"
+#include "hw/BLEMainLoop.h"
 #include "hw/HWInputButtonBtGPIO.h"
 #include "util/Config.h"
 #include "util/Debug.h"
+#include "util/LatencyTrace.h"
 
 #include <QDomDocument>
 
 #include <errno.h>
 #include <glib.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <bluetooth/bluetooth.h>
@@ -22,7 +25,27 @@
 #include "hw/ble/attrib/gattrib.h"
 #include "hw/ble/attrib/att.h"
 #include "hw/ble/attrib/gatt.h"
-
+#include "util/XmlElement.h"
+
+// attribute handle of the characteristic which reports the state of the general purpose inputs
+#define BLE_GPIO_HANDLE             0x0025
+// attribute handle of the I2C bridge characteristic. Requests are written to it without response,
+// responses are sent back as notifications. Both use the same packet format as the classic bluetooth board.
+#define BLE_I2C_HANDLE              0x0028
+// the MTU we ask for, the board may choose a smaller one
+#define BLE_PREFERRED_MTU           158
+// the length of a frame of the I2C bridge, including its header, is sent in 5 bits
+#define BLE_MAX_FRAME_LENGTH        0x1F
+// maximum number of I2C requests which are not yet answered by the board
+#define BLE_MAX_OUTSTANDING         16
+// time after which an unanswered I2C request is given up
+#define BLE_RESPONSE_TIMEOUT_MS     500
+// maximum number of queued outputs while we are not connected, the oldest ones are dropped first
+#define BLE_OUTPUT_QUEUE_MAX        64
+#define BLE_POLL_SLACK_MS           5
+#define BLE_GP_CHECK_INTERVAL_MS    10000
+// attribute handle of the characteristic which selects the pin groups the board reports, one bit per pin group
+#define BLE_GPIO_SUBSCRIBE_HANDLE   0x002B
 
 /*******************************************************
  * BLEThread implementation
@@ -30,51 +53,77 @@
 
 BLEThread::BLEThread()
 {
-    m_loop = NULL;
+    m_mainLoop = NULL;
+    m_running = false;
+    m_iochan = NULL;
+    m_attrib = NULL;
+
+    m_seq = 0;
+    m_mtu = ATT_DEFAULT_LE_MTU;
+    m_mtuExchanged = false;
+
+    m_wakeupSource = 0;
+    m_timerSource = 0;
+    m_reconnectSource = 0;
+    m_watchSource = 0;
+    m_gpCheckSource = 0;
+
+    m_gpSubscription = 0;
+    for(unsigned int i = 0; i < BLE_GP_GROUPS; i++)
+    {
+        m_gpState[i] = 0;
+        m_gpValid[i] = false;
+    }
 }
 
 BLEThread::~BLEThread()
 {
-    if(m_thread != 0)
-        this->kill();
+    this->kill();
 }
 
 /**
- * @brief BTClassicThread::start starts this bluetooth thread.
- * The thread is automatically killed as soon as it is deleted, or it can be killed manually by BTClassicThread::kill
+ * @brief BLEThread::start starts connecting to the BLE board.
+ * All BLE boards share one main loop thread, see BLEMainLoop. This object is automatically stopped as soon as it is deleted,
+ * or it can be stopped manually by BLEThread::kill
  */
 void
 BLEThread::start()
 {
-    pi_assert(m_thread == 0);
+    pi_assert(m_mainLoop == NULL);
 
-    // create and run thread
-    pthread_create(&m_thread, NULL, BLEThread::run_internal, (void*)this);
+    m_mainLoop = BLEMainLoop::acquire();
+
+    m_mutex.lock();
+    m_running = true;
+    m_mutex.unlock();
+
+    m_mainLoop->invoke(std::bind(&BLEThread::bleStart, this));
 }
 
 /**
- * @brief BTClassicThread::kill kills this thread.
+ * @brief BLEThread::kill disconnects from the BLE board and removes all sources of this board from the main loop.
+ * When this method returns, the main loop does not reference this object anymore.
  */
 void
 BLEThread::kill()
 {
-    g_main_loop_quit(m_loop);
+    // only do something if we are really started
+    if(m_mainLoop == NULL)
+        return;
 
-    pthread_join(m_thread, NULL);
-    m_thread = 0;
-}
+    // no more wakeups from other threads from now on
+    m_mutex.lock();
+    m_running = false;
+    m_mutex.unlock();
 
-void*
-BLEThread::run_internal(void* arg)
-{
-    BLEThread* thread = (BLEThread*)arg;
-    thread->run();
+    m_mainLoop->invoke(std::bind(&BLEThread::bleStop, this));
 
-    return NULL;
+    BLEMainLoop::release();
+    m_mainLoop = NULL;
 }
 
 BTThread*
-BLEThread::load(QDomElement *root)
+BLEThread::load(XmlElement* root)
 {
     return new BLEThread();
 }
@@ -91,42 +140,196 @@ BLEThread::save(QDomElement *root, QDomDocument *document)
     return output;
 }
 
+/**
+ * @brief BLEThread::addGPInput adds a general purpose input of the board.
+ * If it is the first input of its pin group, the board is told to report the state of this pin group from now on.
+ * @param hw
+ */
 void
 BLEThread::addGPInput(HWInputButtonBtGPIO* hw)
 {
-    GPInput gp;
-    gp.hw = hw;
-    gp.pin = hw->getPin();
-    gp.pinGroup = hw->getPinGroup();
+    unsigned int pinGroup = hw->getPinGroup();
+    unsigned int pin = hw->getPin();
 
-    // we cannot handle other pins then those in pingroup 2 and only pins from 0 to 3
-    if(gp.pinGroup != 2 || gp.pin > 3)
+    if(pinGroup >= BLE_GP_GROUPS || pin >= BLE_GP_PINS)
+    {
+        LOG_WARN(Logger::BT, "Invalid pin %u in pin group %u", pin, pinGroup);
         return;
+    }
 
-    m_listGPInput.push_back(gp);
+    m_mutexGP.lock();
+    m_gpIndex[pinGroup][pin].push_back(hw);
+
+    bool subscribe = (m_gpSubscription & (1 << pinGroup)) == 0;
+    m_gpSubscription |= 1 << pinGroup;
+
+    // if we already know the state of this pin, the input should know it as well
+    bool valid = m_gpValid[pinGroup];
+    bool value = (m_gpState[pinGroup] & (1 << pin)) != 0;
+    m_mutexGP.unlock();
+
+    if(valid)
+        hw->setValue(value);
+
+    if(subscribe)
+        this->addOutput(std::bind(&BLEThread::bleWriteSubscription, this, std::placeholders::_1), &m_gpSubscription);
 }
 
+/**
+ * @brief BLEThread::removeGPInput removes a general purpose input.
+ * If it was the last input of its pin group, the board is told to stop reporting this pin group.
+ * @param hw
+ */
 void
 BLEThread::removeGPInput(HWInputButtonBtGPIO* hw)
 {
-    for(std::list<GPInput>::iterator it = m_listGPInput.begin(); it != m_listGPInput.end(); it++)
+    unsigned int pinGroup = hw->getPinGroup();
+    unsigned int pin = hw->getPin();
+
+    if(pinGroup >= BLE_GP_GROUPS || pin >= BLE_GP_PINS)
+        return;
+
+    m_mutexGP.lock();
+    m_gpIndex[pinGroup][pin].remove(hw);
+
+    bool used = false;
+    for(unsigned int i = 0; i < BLE_GP_PINS; i++)
     {
-        if( (*it).hw == hw)
-        {
-            m_listGPInput.erase(it);
-            break;
-        }
+        if(!m_gpIndex[pinGroup][i].empty())
+            used = true;
+    }
+
+    bool unsubscribe = !used && (m_gpSubscription & (1 << pinGroup)) != 0;
+    if(unsubscribe)
+    {
+        m_gpSubscription &= ~(1 << pinGroup);
+        m_gpValid[pinGroup] = false;
     }
+    m_mutexGP.unlock();
+
+    if(unsubscribe)
+        this->addOutput(std::bind(&BLEThread::bleWriteSubscription, this, std::placeholders::_1), &m_gpSubscription);
 }
 
+static void helper_subscription_cb(guint8 status, const guint8 *pdu, guint16 plen,
+                                   gpointer user_data)
+{
+    if(status != 0)
+        LOG_WARN(Logger::BT, "Writing pin group subscription failed: %s", att_ecode2str(status));
+}
+
+/**
+ * @brief BLEThread::bleWriteSubscription tells the board which pin groups are used, the board only reports those.
+ * ATTENTION: Only call this from the main loop of this thread
+ */
 void
-BLEThread::setState(unsigned char state)
+BLEThread::bleWriteSubscription(BTThread*)
 {
-    for(std::list<GPInput>::iterator it = m_listGPInput.begin(); it != m_listGPInput.end(); it++)
+    if(m_attrib == NULL)
+        return;
+
+    m_mutexGP.lock();
+    uint8_t subscription = m_gpSubscription;
+    m_mutexGP.unlock();
+
+    gatt_write_char(m_attrib, BLE_GPIO_SUBSCRIBE_HANDLE, &subscription, 1, helper_subscription_cb, this);
+}
+
+/**
+ * @brief BLEThread::bleGPHandler decodes a state report of the general purpose inputs.
+ * The report consists of pairs of bytes, the first one is the pin group, the second one the state of its pins.
+ * Boards with an older firmware only send one byte, which is the state of pin group 2.
+ * Only inputs whose pin has changed since the last report are updated.
+ * @param buffer
+ * @param length
+ * @param resync true if we have read the state ourselves, false if the board has notified us about a change
+ */
+void
+BLEThread::bleGPHandler(const uint8_t* buffer, unsigned int length, bool resync)
+{
+    m_telemetry.bytesReceived(length);
+
+    if(length == 1)
     {
-        if( (*it).pinGroup == 2 )
+        this->bleGPUpdate(2, buffer[0], resync);
+    }
+    else
+    {
+        if(length % 2 != 0)
+            LOG_WARN(Logger::BT, "Invalid length of pin group report");
+
+        for(unsigned int i = 0; i + 1 < length; i += 2)
+            this->bleGPUpdate(buffer[i] & 0x1F, buffer[i + 1], resync);
+    }
+
+    this->bleCheckInputsValid();
+}
+
+/**
+ * @brief BLEThread::bleCheckInputsValid reports the time since the link-up, once all subscribed pin groups are known
+ */
+void
+BLEThread::bleCheckInputsValid()
+{
+    m_mutexGP.lock();
+
+    bool valid = true;
+    for(unsigned int i = 0; i < BLE_GP_GROUPS; i++)
+    {
+        if( (m_gpSubscription & (1 << i)) != 0 && !m_gpValid[i] )
+            valid = false;
+    }
+
+    m_mutexGP.unlock();
+
+    unsigned int ms;
+    if(valid && m_telemetry.inputsValid(&ms))
+        LOG_DEBUG(Logger::BT, "All inputs of bluetooth board %s are valid %u ms after link-up", m_name.c_str(), ms);
+}
+
+/**
+ * @brief BLEThread::bleGPUpdate updates the cached state of a pin group and informs all inputs whose pin has changed.
+ * If this is a resync and the state differs from what we knew, we have missed a notification.
+ * @param pinGroup
+ * @param state
+ * @param resync
+ */
+void
+BLEThread::bleGPUpdate(unsigned int pinGroup, unsigned char state, bool resync)
+{
+    if(pinGroup >= BLE_GP_GROUPS)
+    {
+        LOG_WARN(Logger::BT, "Invalid pin group %u", pinGroup);
+        return;
+    }
+
+    std::list<HWInputButtonBtGPIO*> listChanged[BLE_GP_PINS];
+
+    m_mutexGP.lock();
+
+    // after (re)connecting every pin counts as changed
+    unsigned char changed = m_gpValid[pinGroup] ? m_gpState[pinGroup] ^ state : 0xFF;
+
+    if(resync && m_gpValid[pinGroup] && changed != 0)
+        m_telemetry.gpCorrected();
+
+    m_gpState[pinGroup] = state;
+    m_gpValid[pinGroup] = true;
+
+    // we must not call setValue while holding the lock, as listeners may add or remove inputs
+    for(unsigned int pin = 0; pin < BLE_GP_PINS; pin++)
+    {
+        if(changed & (1 << pin))
+            listChanged[pin] = m_gpIndex[pinGroup][pin];
+    }
+
+    m_mutexGP.unlock();
+
+    for(unsigned int pin = 0; pin < BLE_GP_PINS; pin++)
+    {
+        for(std::list<HWInputButtonBtGPIO*>::iterator it = listChanged[pin].begin(); it != listChanged[pin].end(); it++)
         {
-            (*it).hw->setValue( (state & (1 << (*it).pin)) != 0);
+            (*it)->setValue( (state & (1 << pin)) != 0 );
         }
     }
 }
@@ -143,6 +346,8 @@ static gboolean helper_channel_watcher(GIOChannel *chan, GIOCondition cond,
 
 void BLEThread::bleChannelWatcher(GIOChannel *chan, GIOCondition cond)
 {
+    // the watch is destroyed as soon as we return
+    m_watchSource = 0;
 
     LOG_DEBUG(Logger::BT, "Channel_watcher called");
 
@@ -173,9 +378,7 @@ void BLEThread::bleChannelWatcher(GIOChannel *chan, GIOCondition cond)
     if(cond == G_IO_HUP)
     {
         // we have lost connection and have to reconnect to the BT module
-        g_io_channel_shutdown(m_iochan, FALSE, NULL);
-        g_io_channel_unref(m_iochan);
-        m_iochan = NULL;
+        this->bleDisconnect();
 
         this->bleConnect();
     }
@@ -189,9 +392,11 @@ static void helper_events_handler(const uint8_t *pdu, uint16_t len, gpointer use
     uint16_t handle, i, olen = 0;
     size_t plen;
 
+    if(len < 3)
+        return;
+
     handle = att_get_u16(&pdu[1]);
 
-    // TODO: Forward new state to BLEThread
     switch (pdu[0])
     {
     case ATT_OP_HANDLE_NOTIFY:
@@ -205,11 +410,18 @@ static void helper_events_handler(const uint8_t *pdu, uint16_t len, gpointer use
         return;
     }
 
-    for (i = 3; i < len; i++)
-        LOG_DEBUG(Logger::BT, "%02x ", pdu[i]);
+    if(handle == BLE_I2C_HANDLE)
+    {
+        thread->bleI2CHandler(&pdu[3], len - 3);
+    }
+    else
+    {
+        for (i = 3; i < len; i++)
+            LOG_DEBUG(Logger::BT, "%02x ", pdu[i]);
 
-    if(len >= 3)
-        thread->setState(pdu[3]);
+        if(handle == BLE_GPIO_HANDLE && len > 3)
+            thread->bleGPHandler(&pdu[3], len - 3, false);
+    }
 
     if (pdu[0] == ATT_OP_HANDLE_NOTIFY)
         return;
@@ -245,13 +457,34 @@ static void helper_char_read_cb(guint8 status, const guint8 *pdu, guint16 plen,
         return;
     }
 
-    if(vlen != 1)
+    if(vlen == 0)
     {
         LOG_WARN(Logger::BT, "Invalid length of response");
         return;
     }
 
-    thread->setState(value[0]);
+    // we have explicitly asked for the state, so this is a resync
+    thread->bleGPHandler(value, vlen, true);
+}
+
+static gboolean helper_gp_check(gpointer user_data)
+{
+    BLEThread* thread = (BLEThread*)user_data;
+
+    thread->bleGPCheckCb();
+
+    return TRUE;
+}
+
+/**
+ * @brief BLEThread::bleGPCheckCb reads the state of all pin groups from time to time, in case we have missed a notification
+ */
+void BLEThread::bleGPCheckCb()
+{
+    if(m_attrib == NULL)
+        return;
+
+    gatt_read_char(m_attrib, BLE_GPIO_HANDLE, helper_char_read_cb, this);
 }
 
 
@@ -262,33 +495,173 @@ static void helper_connect_cb(GIOChannel *io, GError *err, gpointer user_data)
     thread->bleConnectCb(io, err);
 }
 
-void BLEThread::bleConnectCb(GIOChannel* io, GError* err)
+static void helper_mtu_cb(guint8 status, const guint8 *pdu, guint16 plen,
+                          gpointer user_data)
 {
-    GAttrib *attrib;
+    BLEThread* thread = (BLEThread*)user_data;
 
+    thread->bleMtuExchanged(status, pdu, plen);
+}
+
+void BLEThread::bleConnectCb(GIOChannel* io, GError* err)
+{
     if(err)
     {
-        // Connecting has failed
+        // Connecting has failed, release the channel and try again later
         LOG_WARN(Logger::BT, "%s", err->message);
-        g_main_loop_quit(m_loop);
+
+        // the HUP watch of this channel must not fire after the channel is gone, see BLEThread::bleDisconnect
+        if(m_watchSource != 0)
+            m_mainLoop->removeSource(m_watchSource);
+        m_watchSource = 0;
+
+        if(m_iochan != NULL)
+        {
+            g_io_channel_shutdown(m_iochan, FALSE, NULL);
+            g_io_channel_unref(m_iochan);
+            m_iochan = NULL;
+        }
+
+        this->bleScheduleReconnect();
 
         return;
     }
 
     LOG_DEBUG(Logger::BT, "Connected successfully");
 
-    attrib = g_attrib_new(m_iochan);
+    m_attrib = g_attrib_new(m_iochan);
+    m_mtu = ATT_DEFAULT_LE_MTU;
+    m_mtuExchanged = false;
 
     // we have successfully connected and are now ready to receive events
 
-    g_attrib_register(attrib, ATT_OP_HANDLE_NOTIFY, GATTRIB_ALL_HANDLES,
+    g_attrib_register(m_attrib, ATT_OP_HANDLE_NOTIFY, GATTRIB_ALL_HANDLES,
                         helper_events_handler, this, NULL);
-    g_attrib_register(attrib, ATT_OP_HANDLE_IND, GATTRIB_ALL_HANDLES,
+    g_attrib_register(m_attrib, ATT_OP_HANDLE_IND, GATTRIB_ALL_HANDLES,
                         helper_events_handler, this, NULL);
 
-    // additionally update the key state
-    int opt_handle = 0x0025;
-    gatt_read_char(attrib, opt_handle, helper_char_read_cb, this);
+    // a bigger MTU allows us to put more I2C requests into one write
+    gatt_exchange_mtu(m_attrib, BLE_PREFERRED_MTU, helper_mtu_cb, this);
+
+    // the board may have been restarted, so tell it again which pin groups we need and update their state
+    m_mutexGP.lock();
+    for(unsigned int i = 0; i < BLE_GP_GROUPS; i++)
+        m_gpValid[i] = false;
+    m_mutexGP.unlock();
+
+    m_telemetry.linkUp();
+
+    this->bleWriteSubscription(this);
+    gatt_read_char(m_attrib, BLE_GPIO_HANDLE, helper_char_read_cb, this);
+
+    // from time to time we check if our general purpose inputs are still consistent with the board
+    m_gpCheckSource = m_mainLoop->addTimeout(BLE_GP_CHECK_INTERVAL_MS, helper_gp_check, this);
+
+    this->resetBackoff();
+    this->setConnectionState(Connected);
+
+    // if no pin group is used, there is nothing to wait for
+    this->bleCheckInputsValid();
+
+    // outputs may have been queued while we were not connected
+    this->bleWakeup();
+}
+
+/**
+ * @brief BLEThread::bleMtuExchanged is called as soon as the board has answered our MTU request.
+ * @param status
+ * @param pdu
+ * @param plen
+ */
+void BLEThread::bleMtuExchanged(guint8 status, const guint8* pdu, guint16 plen)
+{
+    uint16_t mtu;
+
+    if(status != 0)
+    {
+        LOG_WARN(Logger::BT, "MTU exchange failed: %s", att_ecode2str(status));
+    }
+    else if(dec_mtu_resp(pdu, plen, &mtu) == 0)
+    {
+        LOG_WARN(Logger::BT, "Protocol error");
+    }
+    else
+    {
+        mtu = MIN(mtu, BLE_PREFERRED_MTU);
+
+        // the ATT MTU must not be smaller than the default
+        if(mtu >= ATT_DEFAULT_LE_MTU && m_attrib != NULL && g_attrib_set_mtu(m_attrib, mtu))
+        {
+            m_mtu = mtu;
+
+            LOG_DEBUG(Logger::BT, "Using MTU %u for bluetooth board %s", m_mtu, m_name.c_str());
+        }
+    }
+
+    // the default MTU stays in use if the exchange failed, either way the held frames can be sent now
+    m_mtuExchanged = true;
+
+    // frames which have been queued before the MTU was known may not fit into one write.
+    // They are answered after the queue has been cleaned up, as their callbacks may queue new frames
+    std::vector<PendingFrame> listRefused;
+    std::deque<PendingFrame>::iterator it = m_pendingFrames.begin();
+    while(it != m_pendingFrames.end())
+    {
+        if(it->data.size() > this->bleMaxFrameLength())
+        {
+            LOG_WARN(Logger::BT, "I2C packet of %u bytes does not fit into one write to bluetooth board %s, refusing it",
+                     (unsigned int)it->data.size(), m_name.c_str());
+
+            listRefused.push_back(*it);
+            it = m_pendingFrames.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    for(std::vector<PendingFrame>::iterator refusedIt = listRefused.begin(); refusedIt != listRefused.end(); refusedIt++)
+    {
+        this->bleRefuse(refusedIt->data, refusedIt->callbackFunc);
+    }
+
+    this->bleFlush();
+}
+
+/**
+ * @brief BLEThread::bleDisconnect releases the GATT connection and forgets about all outstanding requests.
+ */
+void BLEThread::bleDisconnect()
+{
+    if(m_watchSource != 0)
+        m_mainLoop->removeSource(m_watchSource);
+    m_watchSource = 0;
+
+    if(m_gpCheckSource != 0)
+        m_mainLoop->removeSource(m_gpCheckSource);
+    m_gpCheckSource = 0;
+
+    if(m_attrib != NULL)
+    {
+        g_attrib_unref(m_attrib);
+        m_attrib = NULL;
+    }
+
+    if(m_iochan != NULL)
+    {
+        g_io_channel_shutdown(m_iochan, FALSE, NULL);
+        g_io_channel_unref(m_iochan);
+        m_iochan = NULL;
+    }
+
+    // nobody is going to answer the outstanding requests anymore
+    m_telemetry.requestsLost(m_listSeq.size());
+    m_listSeq.clear();
+    m_pendingFrames.clear();
+    m_mtuExchanged = false;
+
+    this->setConnectionState(Disconnected);
 }
 
 // helper function
@@ -296,14 +669,39 @@ static gboolean helper_ble_connect(gpointer user_data)
 {
     BLEThread* thread = (BLEThread*)user_data;
 
-    thread->bleConnect();
+    thread->bleReconnectCb();
 
     return FALSE;
 }
 
+void BLEThread::bleReconnectCb()
+{
+    // the timeout source is destroyed as soon as we return
+    m_reconnectSource = 0;
+
+    this->bleConnect();
+}
+
+/**
+ * @brief BLEThread::bleScheduleReconnect schedules the next connection attempt, the wait time grows exponentially with every failed attempt.
+ */
+void BLEThread::bleScheduleReconnect()
+{
+    unsigned int waitMs = this->nextBackoffMs();
+
+    this->setConnectionState(Backoff);
+
+    LOG_DEBUG(Logger::BT, "Retrying to connect to bluetooth board %s in %u ms", m_name.c_str(), waitMs);
+
+    m_reconnectSource = m_mainLoop->addTimeout(waitMs, helper_ble_connect, this);
+}
+
 void BLEThread::bleConnect()
 {
     GError *gerr = NULL;
+
+    this->setConnectionState(Connecting);
+
     // connect to gatt, this functions returns NULL on errors
     m_iochan = gatt_connect(NULL, // OPT_SRC
                             m_opt_dst,
@@ -318,21 +716,24 @@ void BLEThread::bleConnect()
     if(m_iochan == NULL)
     {
         // could not connet
-        g_printerr("Could not connect: %s", gerr->message);
+        LOG_DEBUG(Logger::BT, "Could not connect: %s", gerr->message);
         g_clear_error(&gerr);
 
         // schedule a retry
-        g_timeout_add(500, helper_ble_connect, this);
+        this->bleScheduleReconnect();
     }
     else
     {
         LOG_DEBUG(Logger::BT, "Connecting...");
-        g_io_add_watch(m_iochan, G_IO_HUP, helper_channel_watcher, this);
+        m_watchSource = m_mainLoop->addWatch(m_iochan, G_IO_HUP, helper_channel_watcher, this);
     }
 }
 
+/**
+ * @brief BLEThread::bleStart is called in the main loop as soon as this board is started and makes the first connection attempt.
+ */
 void
-BLEThread::run()
+BLEThread::bleStart()
 {
     m_opt_dst = g_strdup(m_btaddr.c_str());
 
@@ -341,15 +742,29 @@ BLEThread::run()
 
     // Connect now
     this->bleConnect();
+}
 
+/**
+ * @brief BLEThread::bleStop is called in the main loop when this board is stopped. It removes all our sources from the main loop and disconnects.
+ */
+void
+BLEThread::bleStop()
+{
+    m_mutex.lock();
+    if(m_wakeupSource != 0)
+        m_mainLoop->removeSource(m_wakeupSource);
+    m_wakeupSource = 0;
+    m_mutex.unlock();
 
-    m_loop = g_main_loop_new(NULL, FALSE);
+    if(m_timerSource != 0)
+        m_mainLoop->removeSource(m_timerSource);
+    m_timerSource = 0;
 
-    // run main loop, this method does not return until finished
-    g_main_loop_run(m_loop);
+    if(m_reconnectSource != 0)
+        m_mainLoop->removeSource(m_reconnectSource);
+    m_reconnectSource = 0;
 
-    // main loop has ended, we can now kill everything
-    g_main_loop_unref(m_loop);
+    this->bleDisconnect();
 
     // cleanup
     g_free(m_opt_dst);
@@ -358,54 +773,478 @@ BLEThread::run()
 }
 
 /*******************************************************
- * Virtual methods, not yet implemented
+ * I2C bridge
  *******************************************************/
 
+/**
+ * @brief BLEThread::addInput adds an input to this thread which is polled with frequency freq.
+ * @param hw
+ * @param freq
+ */
 void
 BLEThread::addInput(BTI2CPolling* hw, unsigned int freq)
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    InputElement element;
+    element.freq = freq;
+    clock_gettime(CLOCK_MONOTONIC, &element.time);
+    element.hw = hw;
+
+    m_mutex.lock();
+    m_inputQueue.push(element);
+    m_mutex.unlock();
+
+    this->bleWakeup();
 }
 
+/**
+ * @brief BLEThread::removeInput removes an input from this thread which is then no longer polled.
+ * @param hw
+ */
 void
 BLEThread::removeInput(BTI2CPolling* hw)
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    // we only use this element to remove the corresponding element from the queue
+    InputElement element;
+    element.hw = hw;
+
+    m_mutex.lock();
+    m_inputQueue.remove(element);
+    m_mutex.unlock();
 }
 
+/**
+ * @brief BLEThread::addOutput adds an output to this thread.
+ * The function specified by func will be executed in the main loop of this thread as soon as possible.
+ * If coalesceKey is not NULL and there is already an output with the same key in the queue, this output replaces the queued one.
+ * While we are not connected the queue is bounded, if it is full the oldest output is dropped.
+ * @param func
+ * @param coalesceKey
+ */
 void
-BLEThread::addOutput(std::function<void (BTThread*)> func)
+BLEThread::addOutput(std::function<void (BTThread*)> func, const void* coalesceKey)
+{
+    OutputElement el;
+    el.func = func;
+    el.coalesceKey = coalesceKey;
+    el.origin = LatencyTrace::getOrigin();
+
+    m_mutex.lock();
+
+    bool coalesced = false;
+    if(coalesceKey != NULL)
+    {
+        for(std::deque<OutputElement>::iterator it = m_outputQueue.begin(); it != m_outputQueue.end(); it++)
+        {
+            if(it->coalesceKey == coalesceKey)
+            {
+                it->func = func;
+                // the latency is measured from the oldest change which is contained in this output
+                if(it->origin == 0)
+                    it->origin = el.origin;
+                coalesced = true;
+                break;
+            }
+        }
+    }
+
+    if(!coalesced)
+    {
+        if(this->getConnectionState() != Connected && m_outputQueue.size() >= BLE_OUTPUT_QUEUE_MAX)
+        {
+            m_outputQueue.pop_front();
+            unsigned int dropped = m_telemetry.outputDropped();
+
+            LOG_WARN(Logger::BT, "Bluetooth board %s is not connected, dropped oldest output (%u so far)", m_name.c_str(), dropped);
+        }
+
+        m_outputQueue.push_back(el);
+        m_telemetry.outputQueued(m_outputQueue.size());
+    }
+
+    m_mutex.unlock();
+
+    this->bleWakeup();
+}
+
+static gboolean helper_wakeup(gpointer user_data)
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    BLEThread* thread = (BLEThread*)user_data;
+
+    thread->bleWakeupCb();
+
+    return FALSE;
 }
 
+static gboolean helper_timer(gpointer user_data)
+{
+    BLEThread* thread = (BLEThread*)user_data;
+
+    thread->bleTimerCb();
+
+    return FALSE;
+}
+
+/**
+ * @brief BLEThread::bleWakeup makes sure that BLEThread::bleProcess runs soon in the main loop of this thread.
+ * This method can be called from any thread, it only adds an idle source to the shared main loop.
+ */
 void
-BLEThread::addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port)
+BLEThread::bleWakeup()
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    m_mutex.lock();
+    if(m_wakeupSource == 0 && m_running)
+        m_wakeupSource = m_mainLoop->addIdle(helper_wakeup, this);
+    m_mutex.unlock();
 }
 
 void
-BLEThread::removeInputPCF8575(HWInput* hw, int slaveAddress)
+BLEThread::bleWakeupCb()
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    // the idle source is destroyed as soon as we return
+    m_mutex.lock();
+    m_wakeupSource = 0;
+    m_mutex.unlock();
+
+    this->bleProcess();
 }
 
 void
-BLEThread::addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port)
+BLEThread::bleTimerCb()
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    // the timeout source is destroyed as soon as we return
+    m_timerSource = 0;
+
+    this->bleProcess();
 }
 
+/**
+ * @brief BLEThread::bleProcess runs all queued outputs and all polls which are due and then sends the resulting I2C requests.
+ * All requests of one round are collected first, so that they can be packed into as few writes as possible.
+ * ATTENTION: Only call this from the main loop of this thread
+ */
 void
-BLEThread::removeOutputPCF8575(HWOutput* hw, int slaveAddress)
+BLEThread::bleProcess()
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    // the timer is armed again at the end
+    if(m_timerSource != 0)
+        m_mainLoop->removeSource(m_timerSource);
+    m_timerSource = 0;
+
+    // while we are not connected the outputs stay queued, bleConnectCb wakes us up again
+    if(m_attrib == NULL || this->getConnectionState() != Connected)
+        return;
+
+    this->bleExpireRequests();
+
+    // run all outputs
+    while(true)
+    {
+        m_mutex.lock();
+        if(m_outputQueue.empty())
+        {
+            m_mutex.unlock();
+            break;
+        }
+
+        OutputElement element = m_outputQueue.front();
+        m_outputQueue.pop_front();
+        m_mutex.unlock();
+
+        element.func(this);
+
+        LatencyTrace::record(LatencyTrace::Bus, element.origin);
+    }
+
+    // run all polls which are due, polls which are due shortly are taken along so that they share the frames of this round
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+    timespec limit = timspecAddMiliseconds(currentTime, BLE_POLL_SLACK_MS);
+
+    while(true)
+    {
+        m_mutex.lock();
+        if(m_inputQueue.empty() || timespecGreaterThan(m_inputQueue.top().time, limit))
+        {
+            m_mutex.unlock();
+            break;
+        }
+
+        InputElement element = m_inputQueue.top();
+        m_mutex.unlock();
+
+        // if the board cannot keep up, we skip this poll instead of piling up requests
+        if(m_pendingFrames.size() < BLE_MAX_OUTSTANDING)
+            element.hw->poll(this);
+
+        pi_assert(element.freq > 0);
+        element.time = timspecAddMiliseconds(currentTime, 1000 / element.freq);
+
+        m_mutex.lock();
+        // If the element is already removed from the queue, the following call does nothing
+        m_inputQueue.modify(element);
+        m_mutex.unlock();
+    }
+
+    this->bleFlush();
+    this->bleArmTimer();
 }
 
-// ATTENTION: USE ONLY IN BTTHREAD!!!!
+/**
+ * @brief BLEThread::bleArmTimer schedules BLEThread::bleProcess for the next poll which is due,
+ * or for the next request which may time out.
+ */
+void
+BLEThread::bleArmTimer()
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    bool arm = false;
+    timespec next;
+
+    m_mutex.lock();
+    if(!m_inputQueue.empty())
+    {
+        next = m_inputQueue.top().time;
+        arm = true;
+    }
+    m_mutex.unlock();
+
+    if(!m_listSeq.empty())
+    {
+        timespec timeout = timspecAddMiliseconds(m_listSeq.front().sent, BLE_RESPONSE_TIMEOUT_MS);
+        if(!arm || timespecGreaterThan(next, timeout))
+            next = timeout;
+        arm = true;
+    }
+
+    if(!arm)
+        return;
+
+    unsigned int waitMs = 0;
+    if(timespecGreaterThan(next, currentTime))
+    {
+        timespec wait = timespecSub(next, currentTime);
+        // round up, otherwise we would wake up too early and do nothing
+        waitMs = wait.tv_sec * 1000 + (wait.tv_nsec + 999999) / 1000000;
+    }
+
+    m_timerSource = m_mainLoop->addTimeout(waitMs, helper_timer, this);
+}
+
+/**
+ * @brief BLEThread::bleExpireRequests gives up on requests which have not been answered in time, so that the request window does not stall.
+ */
+void
+BLEThread::bleExpireRequests()
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    while(!m_listSeq.empty())
+    {
+        timespec timeout = timspecAddMiliseconds(m_listSeq.front().sent, BLE_RESPONSE_TIMEOUT_MS);
+        if(timespecGreaterThan(timeout, currentTime))
+            break;
+
+        LOG_WARN(Logger::BT, "Bluetooth board %s did not answer request %u", m_name.c_str(), m_listSeq.front().seq);
+        m_listSeq.pop_front();
+
+        m_telemetry.requestsLost(1);
+    }
+}
+
+/**
+ * @brief BLEThread::sendI2CPackets assembles the packets given by packets and queues them for sending.
+ * Attention: This method can only be called by the Bluetooth thread. If it is called by any other thread undefined behaviour may result!
+ * The packets are not sent immediately, BLEThread::bleFlush packs all queued packets into as few writes as the MTU allows.
+ * This happens at the end of BLEThread::bleProcess and BLEThread::bleI2CHandler, which are the only places where polls, outputs and callbacks run.
+ * An I2C packet cannot be split over several frames, a packet which does not fit into one write is refused,
+ * its callback is called with an error response immediately, see BLEThread::bleRefuse.
+ * @param packets
+ * @param num
+ */
 void
 BLEThread::sendI2CPackets(BTI2CPacket* packets, unsigned int num)
 {
-    LOG_WARN(Logger::BT, "Not yet implemented");
+    if(m_attrib == NULL)
+        return;
+
+    for(unsigned int i = 0; i < num; i++)
+    {
+        unsigned int size = packets[i].size();
+
+        if(size + 3 > this->bleMaxFrameLength())
+        {
+            LOG_WARN(Logger::BT, "I2C packet of %u bytes does not fit into one write to bluetooth board %s, refusing it",
+                     size + 3, m_name.c_str());
+
+            std::vector<uint8_t> data(size + 3);
+            packets[i].assemble((char*)&data[3], size);
+
+            this->bleRefuse(data, packets[i].callbackFunc);
+            continue;
+        }
+
+        PendingFrame frame;
+        frame.data.resize(size + 3);
+        frame.data[0] = BTPacketType::I2C << 5 | (size + 3);
+        frame.data[1] = 0; // the sequence number is set as soon as the frame is sent
+        frame.data[2] = 0xFF;
+
+        packets[i].assemble((char*)&frame.data[3], size);
+
+        frame.callbackFunc = packets[i].callbackFunc;
+        frame.type = packets[i].read ? BTTelemetry::I2CRead : BTTelemetry::I2CWrite;
+
+        m_pendingFrames.push_back(frame);
+    }
+}
+
+/**
+ * @brief BLEThread::bleMaxFrameLength returns the size of the largest frame which can be sent.
+ * As long as the MTU has not been exchanged, this is the largest frame which fits into the MTU we ask for.
+ * @return
+ */
+unsigned int
+BLEThread::bleMaxFrameLength() const
+{
+    // the ATT header of a write command needs 3 bytes
+    unsigned int maxLength = (m_mtuExchanged ? m_mtu : BLE_PREFERRED_MTU) - 3;
+
+    return MIN(maxLength, BLE_MAX_FRAME_LENGTH);
+}
+
+/**
+ * @brief BLEThread::bleRefuse answers a frame which cannot be sent with an error response, so that its sender does not wait for it
+ * @param data the assembled frame, the I2C packet starts at offset 3
+ * @param callbackFunc
+ */
+void
+BLEThread::bleRefuse(const std::vector<uint8_t>& data, std::function<void (BTThread*, BTI2CPacket*)> callbackFunc)
+{
+    if(!callbackFunc)
+        return;
+
+    BTI2CPacket packet;
+    packet.read = (data[3] & 0x80) != 0;
+    packet.slaveAddress = data[3] & 0x7F;
+    packet.request = false;
+    packet.error = true;
+
+    callbackFunc(this, &packet);
+}
+
+/**
+ * @brief BLEThread::bleFlush sends as many pending frames as the request window allows.
+ * Frames are packed back to back into one write without response, up to the negotiated MTU.
+ * Nothing is sent until the MTU exchange has completed, the frames are held in m_pendingFrames until then.
+ */
+void
+BLEThread::bleFlush()
+{
+    if(!m_mtuExchanged)
+        return;
+
+    // the ATT header of a write command needs 3 bytes
+    unsigned int maxLength = m_mtu - 3;
+    uint8_t value[BLE_PREFERRED_MTU];
+
+    while(m_attrib != NULL && !m_pendingFrames.empty() && m_listSeq.size() < BLE_MAX_OUTSTANDING)
+    {
+        unsigned int length = 0;
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+        while(!m_pendingFrames.empty() && m_listSeq.size() < BLE_MAX_OUTSTANDING)
+        {
+            PendingFrame& frame = m_pendingFrames.front();
+
+            if(length + frame.data.size() > maxLength)
+                break;
+
+            PacketSeq seqCallback;
+            seqCallback.seq = m_seq = (m_seq + 1) % 0xFF;
+            seqCallback.sent = currentTime;
+            seqCallback.callbackFunc = frame.callbackFunc;
+            seqCallback.type = frame.type;
+
+            m_listSeq.push_back(seqCallback);
+
+            m_telemetry.requestSent(frame.data.size(), m_listSeq.size());
+
+            frame.data[1] = seqCallback.seq;
+            memcpy(value + length, &frame.data[0], frame.data.size());
+            length += frame.data.size();
+
+            m_pendingFrames.pop_front();
+        }
+
+        // frames larger than the MTU are refused by sendI2CPackets and bleMtuExchanged, so at least one frame fits
+        pi_assert(length != 0);
+        if(length == 0)
+            break;
+
+        gatt_write_cmd(m_attrib, BLE_I2C_HANDLE, value, length, NULL, NULL);
+    }
+}
+
+/**
+ * @brief BLEThread::bleI2CHandler parses a notification of the I2C bridge characteristic, which may contain several responses.
+ * @param buffer
+ * @param length
+ */
+void
+BLEThread::bleI2CHandler(const uint8_t* buffer, unsigned int length)
+{
+    m_telemetry.bytesReceived(length);
+
+    while(length >= 3)
+    {
+        unsigned char type = (buffer[0] & 0xE0) >> 5;
+        unsigned char packetLength = (buffer[0] & 0x1F);
+
+        if(packetLength < 3 || packetLength > length)
+        {
+            LOG_WARN(Logger::BT, "Invalid packet length");
+            break;
+        }
+
+        unsigned char seqAck = buffer[2];
+
+        if(type == BTPacketType::I2C)
+        {
+            BTI2CPacket packet;
+
+            // the request is answered, even if the answer is invalid, so it frees its slot in any case
+            bool matched = false;
+            for(std::list<PacketSeq>::iterator it = m_listSeq.begin(); it != m_listSeq.end(); it++)
+            {
+                if(it->seq == seqAck)
+                {
+                    packet.callbackFunc = it->callbackFunc;
+
+                    m_telemetry.responseMatched(it->type, it->sent);
+                    matched = true;
+
+                    m_listSeq.erase(it);
+                    break;
+                }
+            }
+
+            if(!matched)
+                m_telemetry.responseOrphaned();
+
+            if( !packet.parse((char*)buffer + 3, packetLength - 3) )
+                LOG_WARN(Logger::BT, "Parsing packet failed");
+            else if(packet.callbackFunc)
+                packet.callbackFunc(this, &packet);
+        }
+
+        buffer += packetLength;
+        length -= packetLength;
+    }
+
+    // the window has some space again
+    this->bleFlush();
 }
@@ -3,10 +3,19 @@
 
 #include "hw/BTThread.h"
 
+#include <deque>
+#include <vector>
 #include <glib.h>
 #include <gio/gio.h>
 
 #include "hw/ble/attrib/gattrib.h"
+
+class BLEMainLoop;
+
+// number of pin groups of the board and number of pins per pin group
+#define BLE_GP_GROUPS   5
+#define BLE_GP_PINS     8
+
 static void helper_events_handler(const uint8_t *pdu, uint16_t len, gpointer user_data);
 
 class BLEThread : public BTThread
@@ -18,7 +27,7 @@ public:
     void start();
     void kill();
 
-    static BTThread* load(QDomElement* root);
+    static BTThread* load(XmlElement* root);
     QDomElement save(QDomElement* root, QDomDocument* document);
 
     void addGPInput(HWInputButtonBtGPIO* hw);
@@ -29,42 +38,108 @@ public:
     void setBTAddr(std::string addr);
     std::string getBTAddr() const { return m_btaddr;}
 
-
-    // the following functions are not implemented
     void addInput(BTI2CPolling* hw, unsigned int freq);
     void removeInput(BTI2CPolling* hw);
 
-    void addOutput(std::function<void (BTThread*)> func);
-
-    void addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port);
-    void removeInputPCF8575(HWInput* hw, int slaveAddress);
-    void addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port);
-    void removeOutputPCF8575(HWOutput* hw, int slaveAddress);
+    void addOutput(std::function<void (BTThread*)> func, const void* coalesceKey = NULL);
 
     // ATTENTION: USE ONLY IN BTTHREAD!!!!
     void sendI2CPackets(BTI2CPacket* packets, unsigned int num);
 
-
-    // TODO: should be private, does this make sense?
-    void setState(unsigned char state);
+    void bleGPHandler(const uint8_t* buffer, unsigned int length, bool resync);
+    void bleGPCheckCb();
 
     void bleConnect();
+    void bleScheduleReconnect();
     void bleConnectCb(GIOChannel* io, GError* err);
     void bleChannelWatcher(GIOChannel *chan, GIOCondition cond);
+    void bleMtuExchanged(guint8 status, const guint8* pdu, guint16 plen);
+    void bleWakeupCb();
+    void bleTimerCb();
+    void bleReconnectCb();
 private:
-    static void* run_internal(void* arg);
-    void run();
+    void bleStart();
+    void bleStop();
+
+    void bleWakeup();
+    void bleProcess();
+    void bleDisconnect();
+    void bleArmTimer();
+    void bleFlush();
+    void bleRefuse(const std::vector<uint8_t>& data, std::function<void (BTThread*, BTI2CPacket*)> callbackFunc);
+    unsigned int bleMaxFrameLength() const;
+    void bleExpireRequests();
+    void bleI2CHandler(const uint8_t* buffer, unsigned int length);
+    void bleGPUpdate(unsigned int pinGroup, unsigned char state, bool resync);
+    void bleCheckInputsValid();
+    void bleWriteSubscription(BTThread*);
+
+    struct InputElement
+    {
+        unsigned int freq;
+        timespec time;
+        BTI2CPolling* hw;
+
+        bool operator< (const InputElement& rhs)
+        {
+            return timespecGreaterThan(this->time, rhs.time);
+        }
+
+        bool operator == (const InputElement& rhs)
+        {
+            // return true if hw objects match
+            return this->hw == rhs.hw;
+        }
+    };
+    struct OutputElement
+    {
+        std::function<void (BTThread*)> func;
+        const void* coalesceKey; // outputs with the same key replace each other while queued, NULL means never coalesce
+        unsigned long long origin; // see LatencyTrace
+    };
 
-    struct GPInput
+    // an assembled I2C bridge packet which waits for a free slot in the request window
+    struct PendingFrame
     {
-        HWInputButtonBtGPIO* hw;
-        unsigned int pinGroup;
-        unsigned int pin;
+        std::vector<uint8_t> data;
+        std::function<void (BTThread*, BTI2CPacket*)> callbackFunc;
+        BTTelemetry::RequestType type;
     };
 
-    std::list<GPInput> m_listGPInput;
+    struct PacketSeq
+    {
+        unsigned char seq;
+        timespec sent;
+        std::function<void (BTThread*, BTI2CPacket*)> callbackFunc;
+        BTTelemetry::RequestType type;
+    };
 
-    GMainLoop* m_loop;
+    PriorityQueue<InputElement> m_inputQueue;
+    std::deque<OutputElement> m_outputQueue;
+
+    std::deque<PendingFrame> m_pendingFrames;
+    std::list<PacketSeq> m_listSeq;
+    unsigned char m_seq;
+    unsigned int m_mtu;
+    bool m_mtuExchanged; // frames are held in m_pendingFrames until the MTU of the connection is known
+
+    // sources of this board in the shared main loop
+    guint m_wakeupSource; // protected by m_mutex
+    guint m_timerSource;
+    guint m_reconnectSource;
+    guint m_watchSource;
+    guint m_gpCheckSource;
+
+    // inputs indexed by pin group and pin, the cached state of every pin group
+    // and the pin groups the board should report. All protected by m_mutexGP
+    std::mutex m_mutexGP;
+    std::list<HWInputButtonBtGPIO*> m_gpIndex[BLE_GP_GROUPS][BLE_GP_PINS];
+    unsigned char m_gpState[BLE_GP_GROUPS];
+    bool m_gpValid[BLE_GP_GROUPS];
+    unsigned char m_gpSubscription;
+
+    BLEMainLoop* m_mainLoop;
+    bool m_running; // protected by m_mutex
     GIOChannel* m_iochan;
 
     char* m_opt_dst;
@@ -1,11 +1,15 @@
 
 #include "hw/BTClassicThread.h"
 #include "hw/HWInputButtonBtGPIO.h"
-#include "hw/PCF8575Bt.h"
 #include "util/Config.h"
 #include "util/Debug.h"
+#include "util/LatencyTrace.h"
+#include "util/XmlElement.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/l2cap.h>
@@ -14,15 +18,55 @@
 
 #include <QDomDocument>
 
+// time after which a connection attempt is given up
+#define BT_CONNECT_TIMEOUT_MS   5000
+// maximum time this thread sleeps without checking if it should stop
+#define BT_WAIT_SLICE_MS        100
+// maximum number of queued outputs while we are not connected, the oldest ones are dropped first
+#define BT_OUTPUT_QUEUE_MAX     64
+// maximum number of requests which have been sent but not yet answered
+#define BT_MAX_OUTSTANDING      5
+// time after which a request which has not been answered is given up
+#define BT_RESPONSE_TIMEOUT_MS  500
+// polls which are due within this time are issued together with the poll which is due now
+#define BT_POLL_SLACK_MS        5
+// maximum size of an aggregated frame, must fit into the receive buffer of the board
+#define BT_AGGREGATE_MAX_SIZE   128
+// interval in which the state of all general purpose inputs is requested again, in case we have missed a report
+#define BT_GP_CHECK_INTERVAL_MS 10000
+// number of pin groups which fit into the masks of requested and valid pin groups
+#define BT_GP_GROUPS            32
+
 static void dummy_handler(int)
 {
     // nothing here
 }
 
+/**
+ * @brief sliceWait limits the given wait time to BT_WAIT_SLICE_MS
+ * @param wait
+ * @return
+ */
+static timespec sliceWait(timespec wait)
+{
+    timespec slice;
+    slice.tv_sec = 0;
+    slice.tv_nsec = BT_WAIT_SLICE_MS * 1000000;
+
+    if(timespecGreaterThan(wait, slice))
+        return slice;
+
+    return wait;
+}
+
 BTClassicThread::BTClassicThread()
 {
     m_socket = -1;
     m_seq = 0;
+    m_burst = false;
+    m_aggregate = false;
+    m_gpPending = 0;
+    m_gpValid = 0;
 
     // specify a dummy handler for SIGUSR1
     struct sigaction sa;
@@ -57,6 +101,10 @@ void BTClassicThread::start()
  */
 void BTClassicThread::kill()
 {
+    // only do something if this thread is really started
+    if(m_thread == 0)
+        return;
+
     // set stop to true, so the thread should exit soon
     m_mutex.lock();
     m_bStop = true;
@@ -76,13 +124,41 @@ void BTClassicThread::kill()
  * @param root
  * @return returns NULL if an error occurred or an instance of BTClassicThread
  */
-BTThread* BTClassicThread::load(QDomElement* root)
+BTThread* BTClassicThread::load(XmlElement* root)
 {
     BTClassicThread* btthread = new BTClassicThread();
 
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
+    {
+        if(elem->tag == XmlTag::Aggregate)
+        {
+            btthread->m_aggregate = true;
+        }
+    }
+
     return btthread;
 }
 
+/**
+ * @brief BTClassicThread::save saves this instance of BTClassicThread to an XML file.
+ * @param root
+ * @param document
+ * @return
+ */
+QDomElement BTClassicThread::save(QDomElement* root, QDomDocument* document)
+{
+    QDomElement output = BTThread::save(root, document);
+
+    if(m_aggregate)
+    {
+        QDomElement aggregate = document->createElement("Aggregate");
+
+        output.appendChild(aggregate);
+    }
+
+    return output;
+}
+
 /**
  * @brief BTClassicThread::addInput adds an input to this thread which is polled with frequency freq.
  * @param hw
@@ -117,191 +193,226 @@ void BTClassicThread::removeInput(BTI2CPolling *hw)
 
     m_mutex.lock();
     m_inputQueue.remove(element);
+
+    // the input may be part of the burst which is currently polled, it must not be scheduled again
+    for(std::vector<InputElement>::iterator it = m_burstDue.begin(); it != m_burstDue.end(); it++)
+    {
+        if(*it == element)
+        {
+            m_burstDue.erase(it);
+            break;
+        }
+    }
+
     m_mutex.unlock();
 }
 
-void BTClassicThread::connectBt()
+/**
+ * @brief BTClassicThread::isStopped
+ * @return returns true if BTClassicThread::kill has been called and this thread should exit
+ */
+bool BTClassicThread::isStopped()
+{
+    m_mutex.lock();
+    bool stop = m_bStop;
+    m_mutex.unlock();
+
+    return stop;
+}
+
+/**
+ * @brief BTClassicThread::connectBt makes one attempt to connect to the bluetooth board.
+ * The socket is connected in non-blocking mode, so that the attempt can be aborted by BTClassicThread::kill at any time.
+ * @return true if we are connected now, false if the attempt has failed or this thread should stop
+ */
+bool BTClassicThread::connectBt()
 {
-    // try to connect until it succeeds
-    int status;
-    do
+    this->setConnectionState(Connecting);
+
+    m_socket = socket(AF_BLUETOOTH, SOCK_SEQPACKET, BTPROTO_L2CAP);
+
+    if(m_socket == -1)
     {
-        // If we want to exit this thread
-        if(m_bStop)
-        {
-            pthread_exit(0);
-        }
+        LOG_WARN(Logger::BT, "Could not open bluetooth socket");
+        return false;
+    }
 
-        // open socket
-        struct sockaddr_l2 addr;
+    // switch to non-blocking mode, so that connect returns immediately
+    int flags = fcntl(m_socket, F_GETFL, 0);
+    fcntl(m_socket, F_SETFL, flags | O_NONBLOCK);
 
-        m_socket = socket(AF_BLUETOOTH, SOCK_SEQPACKET, BTPROTO_L2CAP);
+    // set the connection parameters (who to connect to)
+    struct sockaddr_l2 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.l2_family = AF_BLUETOOTH;
+    addr.l2_psm = htobs(0x1001);
+    addr.l2_cid = 0;
 
-        if(m_socket == -1)
-        {
-            LOG_WARN(Logger::BT, "Could not open bluetooth socket");
-            return;
-        }
+    str2ba(m_btaddr.c_str(), &addr.l2_bdaddr);
 
-        // set the connection parameters (who to connect to)
-        addr.l2_family = AF_BLUETOOTH;
-        addr.l2_psm = htobs(0x1001);
-        addr.l2_cid = 0;
+    // connect to target
+    int status = connect(m_socket, (struct sockaddr*)&addr, sizeof(addr));
+    if(status == -1 && errno != EINPROGRESS)
+    {
+        LOG_DEBUG(Logger::BT, "Could not connect to bluetooth board %s: %s", m_name.c_str(), strerror(errno));
+        this->disconnectBt();
+        return false;
+    }
 
-        str2ba(m_btaddr.c_str(), &addr.l2_bdaddr);
+    if(status == -1)
+    {
+        // the connection is in progress, wait until the socket gets writable, the attempt times out or we should stop
+        timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline = timspecAddMiliseconds(deadline, BT_CONNECT_TIMEOUT_MS);
 
-        // connect to target
-        // maybe wo should do this in the run loop, as we may loose our connection to the board or it is not yet available
-        status = connect(m_socket, (struct sockaddr*)&addr, sizeof(addr));
-        if(status == -1)
+        while(true)
         {
-            perror("Could not connect to bt-board, retrying");
+            if(this->isStopped())
+            {
+                this->disconnectBt();
+                return false;
+            }
 
-            // wait for some time before trying to reconnect
-            sleep(1);
+            timespec currentTime;
+            clock_gettime(CLOCK_MONOTONIC, &currentTime);
 
-            // close and release all resoureces associated with m_socket, so that it can be reused
-            close(m_socket);
+            if( !timespecGreaterThan(deadline, currentTime) )
+            {
+                LOG_DEBUG(Logger::BT, "Connecting to bluetooth board %s has timed out", m_name.c_str());
+                this->disconnectBt();
+                return false;
+            }
+
+            struct pollfd fd;
+            fd.fd = m_socket;
+            fd.events = POLLOUT;
+            fd.revents = 0;
+
+            timespec waitTime = sliceWait(timespecSub(deadline, currentTime));
+            if(ppoll(&fd, 1, &waitTime, NULL) == 1)
+                break;
+        }
+
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if(getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0)
+        {
+            LOG_DEBUG(Logger::BT, "Could not connect to bluetooth board %s: %s", m_name.c_str(), strerror(err));
+            this->disconnectBt();
+            return false;
         }
     }
-    while(status == -1);
+
+    // the rest of this thread expects a blocking socket
+    fcntl(m_socket, F_SETFL, flags);
 
     LOG_DEBUG(Logger::BT, "Connected to bluetooth board %s\n", m_name.c_str());
 
     // clean lists as the information in them is most likely invalid now
     m_listSeq.clear();
 
-    // do a status update for pin group 2
-    // TODO: check all registered pins for their pin groups and send a status update for each
-    this->addOutput(std::bind(&BTClassicThread::sendGPUpdateRequest, this, 2, std::placeholders::_1));
-}
+    this->resetBackoff();
+    this->setConnectionState(Connected);
 
-void BTClassicThread::disconnectBt()
-{
-    close(m_socket);
-}
+    // the board may have changed its pins while we were away, so nothing we know is valid anymore
+    m_gpPending = 0;
+    m_gpValid = 0;
+    m_telemetry.linkUp();
 
-void BTClassicThread::reconnectBt()
-{
-    LOG_DEBUG(Logger::BT, "Lost connection to bluetooth board %s\nTrying to reconnect\n", m_name.c_str());
+    clock_gettime(CLOCK_MONOTONIC, &m_gpCheckTime);
+    m_gpCheckTime = timspecAddMiliseconds(m_gpCheckTime, BT_GP_CHECK_INTERVAL_MS);
 
-    this->disconnectBt();
-    this->connectBt();
-}
+    this->addOutput(std::bind(&BTClassicThread::sendGPUpdateRequests, this, std::placeholders::_1), &m_listGPInput);
 
+    return true;
+}
 
-void BTClassicThread::addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port)
+/**
+ * @brief BTClassicThread::disconnectBt closes the socket and forgets about all outstanding requests.
+ */
+void BTClassicThread::disconnectBt()
 {
-    // first check if we already have an Object for this slave address
-    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
+    if(m_socket != -1)
     {
-        if( (*it)->getSlaveAddress() == slaveAddress )
-        {
-            // we found it
-            (*it)->addInput((HWInputButtonBt*)hw, port);
-            return;
-        }
+        close(m_socket);
+        m_socket = -1;
     }
 
-    // we did not found an object for this slave address, so create a new one
-    PCF8575Bt* pcf = new PCF8575Bt(slaveAddress);
-    m_listPCF8575.push_back(pcf);
-
-    pcf->init(this);
+    // nobody is going to answer the outstanding requests anymore
+    m_telemetry.requestsLost(m_listSeq.size());
+    m_listSeq.clear();
+    m_burstBuffer.clear();
 
-    pcf->addInput((HWInputButtonBt*)hw, port);
+    this->setConnectionState(Disconnected);
 }
 
-void BTClassicThread::removeInputPCF8575(HWInput* hw, int slaveAddress)
+/**
+ * @brief BTClassicThread::linkLost is called when we detect that the connection to the board has been lost.
+ * We only disconnect here, reconnecting is done by the run loop so that nobody blocks in here.
+ */
+void BTClassicThread::linkLost()
 {
-    // search for the corresponding pcf object
-    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
-    {
-        if( (*it)->getSlaveAddress() == slaveAddress )
-        {
-            // we found it
-            (*it)->removeInput((HWInputButtonBt*)hw);
-
-            // check if the pcf object is empty now
-            if((*it)->empty())
-            {
-                (*it)->deinit();
-                delete *it;
+    LOG_DEBUG(Logger::BT, "Lost connection to bluetooth board %s\n", m_name.c_str());
 
-                m_listPCF8575.erase(it);
-            }
-
-            return;
-        }
-    }
+    this->disconnectBt();
 }
 
-void BTClassicThread::addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port)
+/**
+ * @brief BTClassicThread::waitBackoff waits before the next connection attempt is made.
+ * The wait time grows exponentially with every failed attempt. BTClassicThread::kill aborts the wait.
+ */
+void BTClassicThread::waitBackoff()
 {
-    // first check if we already have an Object for this slave address
-    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
-    {
-        if( (*it)->getSlaveAddress() == slaveAddress )
-        {
-            // we found it
-            (*it)->addOutput((HWOutputGPO*)hw, port);
-            return;
-        }
-    }
+    unsigned int waitMs = this->nextBackoffMs();
 
-    // we did not found an object for this slave address, so create a new one
-    PCF8575Bt* pcf = new PCF8575Bt(slaveAddress);
-    m_listPCF8575.push_back(pcf);
+    this->setConnectionState(Backoff);
 
-    pcf->init(this);
+    LOG_DEBUG(Logger::BT, "Retrying to connect to bluetooth board %s in %u ms", m_name.c_str(), waitMs);
 
-    pcf->addOutput((HWOutputGPO*)hw, port);
-}
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline = timspecAddMiliseconds(deadline, waitMs);
 
-void BTClassicThread::removeOutputPCF8575(HWOutput* hw, int slaveAddress)
-{
-    // search for the corresponding pcf object
-    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
+    while( !this->isStopped() )
     {
-        if( (*it)->getSlaveAddress() == slaveAddress )
-        {
-            // we found it
-            (*it)->removeOutput((HWOutputGPO*)hw);
-
-            // check if the pcf object is empty now
-            if((*it)->empty())
-            {
-                (*it)->deinit();
-                delete *it;
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
 
-                m_listPCF8575.erase(it);
-            }
+        if( !timespecGreaterThan(deadline, currentTime) )
+            break;
 
-            return;
-        }
+        // we may be woken up by a signal, this is fine as we check again
+        timespec waitTime = sliceWait(timespecSub(deadline, currentTime));
+        nanosleep(&waitTime, NULL);
     }
 }
 
+
 void BTClassicThread::readBlocking()
 {
     char buffer[256];
     memset(buffer, 0, sizeof(buffer));
     int readBytes = recv(m_socket, buffer, sizeof(buffer), 0);
 
-    // TODO: check if this is enough error checking
     if(readBytes == 0)
     {
         // if read returns 0 this means end of file => we have lost connection and need to reconnect
-        this->reconnectBt();
+        this->linkLost();
     }
     else if(readBytes == -1)
     {
-        perror("Error occurred while doing read");
-        if(errno == ENOTCONN)
-            this->reconnectBt();
+        // being interrupted by a signal is fine, everything else means that our connection is broken
+        if(errno != EINTR && errno != EAGAIN)
+        {
+            LOG_WARN(Logger::BT, "Error occurred while doing read: %s", strerror(errno));
+            this->linkLost();
+        }
     }
     else
     {
+        m_telemetry.bytesReceived(readBytes);
+
         // we have received the packet, now we have to parse it and call the appropriate functions
         this->packetHandler(buffer, readBytes);
     }
@@ -310,16 +421,22 @@ void BTClassicThread::readBlocking()
 void BTClassicThread::run()
 {
 #ifdef USE_BLUETOOTH
-    // connect to bluetooth board
-    this->connectBt();
-
-
-    // now we are connected and can enter the run loop
-
     timespec currentTime;
     timespec waitTime;
     while(true)
     {
+        if(this->isStopped())
+            break;
+
+        // (re)connect to the bluetooth board, if this fails we wait a bit and try again
+        if(m_socket == -1)
+        {
+            if( !this->connectBt() )
+                this->waitBackoff();
+
+            continue;
+        }
+
         // Priorities:
         // 1. Incoming data
         // 2. Outputs
@@ -340,8 +457,23 @@ void BTClassicThread::run()
         {
             // there is data ready to be read, so read it!
             this->readBlocking();
+
+            // reading may have detected that we lost our connection
+            if(m_socket == -1)
+                continue;
         }
 
+        this->expireRequests();
+
+
+        // from time to time we check if our general purpose inputs are still consistent with the board
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+        if( !timespecGreaterThan(m_gpCheckTime, currentTime) )
+        {
+            m_gpCheckTime = timspecAddMiliseconds(currentTime, BT_GP_CHECK_INTERVAL_MS);
+
+            this->addOutput(std::bind(&BTClassicThread::sendGPUpdateRequests, this, std::placeholders::_1), &m_listGPInput);
+        }
 
         m_mutex.lock();
 
@@ -356,11 +488,13 @@ void BTClassicThread::run()
         if( !m_outputQueue.empty() )
         {
             OutputElement element = m_outputQueue.front();
-            m_outputQueue.pop();
+            m_outputQueue.pop_front();
             m_mutex.unlock();
 
             // run function
             element.func(this);
+
+            LatencyTrace::record(LatencyTrace::Bus, element.origin);
             continue;
         }
 
@@ -401,32 +535,7 @@ void BTClassicThread::run()
         }
 
         // now we should do something as the timer has expired
-        element.hw->poll(this);
-
-
-        // preperation for next poll
-        pi_assert(element.freq > 0);
-        element.time.tv_nsec = currentTime.tv_nsec + 1000000000 / element.freq;
-        if( element.time.tv_nsec > 1000000000 )
-        {
-            // we have to increase seconds by one
-            element.time.tv_sec = currentTime.tv_sec + 1;
-            element.time.tv_nsec = element.time.tv_nsec % 1000000000;
-        }
-        else
-        {
-            // otherwise just set seconds
-            element.time.tv_sec = currentTime.tv_sec;
-        }
-
-
-        m_mutex.lock();
-
-        // modified element will replace original one
-        // If the element is already removed from the list, the following call does nothing
-        m_inputQueue.modify(element);
-
-        m_mutex.unlock();
+        this->pollBurst();
     }
 
     this->disconnectBt();
@@ -495,6 +604,7 @@ void BTClassicThread::packetHandler(char* buffer, unsigned int length)
             }
 
             // now lets see if there is a callback function for this sequence number
+            bool matched = false;
             for(std::list<PacketSeq>::iterator it = m_listSeq.begin(); it != m_listSeq.end(); it++)
             {
                 if(it->seq == seqAck)
@@ -502,12 +612,18 @@ void BTClassicThread::packetHandler(char* buffer, unsigned int length)
                     // we have found our callback function
                     packet.callbackFunc = it->callbackFunc;
 
+                    m_telemetry.responseMatched(it->type, it->sent);
+                    matched = true;
+
                     m_listSeq.erase(it);
 
                     break;
                 }
             }
 
+            if(!matched)
+                m_telemetry.responseOrphaned();
+
             // if we have found a valid callback function, execute it
             if(packet.callbackFunc)
                 packet.callbackFunc(this, &packet);
@@ -523,14 +639,36 @@ void BTClassicThread::packetHandler(char* buffer, unsigned int length)
                 return;
             // TODO: the lines above have to be removed
 
-            // now lets see if anything has changed, and if yes, inform the respective object
+            // if we have asked for this pin group and already knew its state, a difference means we have missed a report
+            unsigned int mask = 1u << pinGroup;
+            bool check = (m_gpPending & mask) != 0 && (m_gpValid & mask) != 0;
+
+            m_gpPending &= ~mask;
+            m_gpValid |= mask;
+
+            // we must not call setValue while holding the lock, as listeners may add or remove inputs
+            std::vector<GPInput> listGroup;
+
+            m_mutex.lock();
             for(std::list<GPInput>::iterator it = m_listGPInput.begin(); it != m_listGPInput.end(); it++)
             {
                 if( (*it).pinGroup == pinGroup)
-                {
-                    (*it).hw->setValue( (buffer[4] & (1 << (*it).pin)) != 0);
-                }
+                    listGroup.push_back(*it);
+            }
+            m_mutex.unlock();
+
+            // now lets see if anything has changed, and if yes, inform the respective object
+            for(std::vector<GPInput>::iterator it = listGroup.begin(); it != listGroup.end(); it++)
+            {
+                bool value = (buffer[4] & (1u << (*it).pin)) != 0;
+
+                if(check && (*it).hw->getValue() != value)
+                    m_telemetry.gpCorrected();
+
+                (*it).hw->setValue(value);
             }
+
+            this->checkInputsValid();
         }
 
         buffer += packetLength;
@@ -538,16 +676,77 @@ void BTClassicThread::packetHandler(char* buffer, unsigned int length)
     }
 }
 
-void BTClassicThread::sendGPUpdateRequest(unsigned int pinGroup, BTThread*)
+/**
+ * @brief BTClassicThread::gpGroups returns all pin groups which have at least one input registered
+ * @return bit mask of the pin groups
+ */
+unsigned int BTClassicThread::gpGroups()
 {
-    char buffer[5];
-    buffer[0] = 1 << 5 | 5;
-    buffer[1] = this->seqInc();
-    buffer[2] = 0xFF;
-    buffer[3] = 1 << 7 | pinGroup;
-    buffer[4] = 0xFF;
+    unsigned int groups = 0;
 
-    this->send(buffer, 5);
+    m_mutex.lock();
+    for(std::list<GPInput>::iterator it = m_listGPInput.begin(); it != m_listGPInput.end(); it++)
+        groups |= 1u << (*it).pinGroup;
+    m_mutex.unlock();
+
+    return groups;
+}
+
+/**
+ * @brief BTClassicThread::checkInputsValid reports the time since the link-up, once all pin groups are known
+ */
+void BTClassicThread::checkInputsValid()
+{
+    if( (this->gpGroups() & ~m_gpValid) != 0 )
+        return;
+
+    unsigned int ms;
+    if(m_telemetry.inputsValid(&ms))
+        LOG_DEBUG(Logger::BT, "All inputs of bluetooth board %s are valid %u ms after link-up", m_name.c_str(), ms);
+}
+
+/**
+ * @brief BTClassicThread::sendGPUpdateRequests requests the state of every pin group which is used by at least one input.
+ * Each pin group is only requested once. If the board supports aggregated frames, all requests are sent in one l2cap packet.
+ */
+void BTClassicThread::sendGPUpdateRequests(BTThread*)
+{
+    unsigned int groups = this->gpGroups();
+
+    // maybe there is nothing to wait for
+    this->checkInputsValid();
+
+    if(groups == 0)
+        return;
+
+    m_gpPending |= groups;
+
+    char buffer[BT_GP_GROUPS * 5];
+    unsigned int length = 0;
+
+    for(unsigned int pinGroup = 0; pinGroup < BT_GP_GROUPS; pinGroup++)
+    {
+        if( (groups & (1u << pinGroup)) == 0 )
+            continue;
+
+        buffer[length + 0] = BTPacketType::GPIO << 5 | 5;
+        buffer[length + 1] = this->seqInc();
+        buffer[length + 2] = 0xFF;
+        buffer[length + 3] = 1 << 7 | pinGroup;
+        buffer[length + 4] = 0xFF;
+
+        if(m_aggregate)
+        {
+            length += 5;
+        }
+        else
+        {
+            this->send(buffer, 5);
+        }
+    }
+
+    if(length != 0)
+        this->send(buffer, length);
 }
 
 void BTClassicThread::addGPInput(HWInputButtonBtGPIO *hw)
@@ -557,14 +756,25 @@ void BTClassicThread::addGPInput(HWInputButtonBtGPIO *hw)
     gp.pin = hw->getPin();
     gp.pinGroup = hw->getPinGroup();
 
+    // the pin groups are kept in bit masks, a pin group outside of them could never be requested
+    if(gp.pinGroup >= BT_GP_GROUPS || gp.pin > 7)
+    {
+        LOG_WARN(Logger::BT, "Invalid pin %u in pin group %u", gp.pin, gp.pinGroup);
+        return;
+    }
+
+    m_mutex.lock();
     m_listGPInput.push_back(gp);
+    m_mutex.unlock();
 
     // As we have a new general purpose input we should request a status update so that our inputs are consistent
-    this->addOutput(std::bind(&BTClassicThread::sendGPUpdateRequest, this, gp.pinGroup, std::placeholders::_1));
+    // If this is done for many inputs at once, the queued requests are merged
+    this->addOutput(std::bind(&BTClassicThread::sendGPUpdateRequests, this, std::placeholders::_1), &m_listGPInput);
 }
 
 void BTClassicThread::removeGPInput(HWInputButtonBtGPIO *hw)
 {
+    m_mutex.lock();
     for(std::list<GPInput>::iterator it = m_listGPInput.begin(); it != m_listGPInput.end(); it++)
     {
         if( (*it).hw == hw)
@@ -573,21 +783,59 @@ void BTClassicThread::removeGPInput(HWInputButtonBtGPIO *hw)
             break;
         }
     }
+    m_mutex.unlock();
 }
 
 /**
  * @brief BTClassicThread::addOutput adds an output to this thread.
  * The function specified by func will be executed as soon as it is on top of the queue.
  * So there might be a little delay between this function call and the execution of the function.
+ * If coalesceKey is not NULL and there is already an output with the same key in the queue, this output replaces the queued one.
+ * This should only be used for functions which write the current state of an object, e.g. the port mask of a PCF8575.
+ * While we are not connected the queue is bounded, if it is full the oldest output is dropped.
  * @param func
+ * @param coalesceKey
  */
-void BTClassicThread::addOutput(std::function<void (BTThread*)> func)
+void BTClassicThread::addOutput(std::function<void (BTThread*)> func, const void* coalesceKey)
 {
     OutputElement el;
     el.func = func;
+    el.coalesceKey = coalesceKey;
+    el.origin = LatencyTrace::getOrigin();
 
     m_mutex.lock();
-    m_outputQueue.push(el);
+
+    bool coalesced = false;
+    if(coalesceKey != NULL)
+    {
+        for(std::deque<OutputElement>::iterator it = m_outputQueue.begin(); it != m_outputQueue.end(); it++)
+        {
+            if(it->coalesceKey == coalesceKey)
+            {
+                it->func = func;
+                // the latency is measured from the oldest change which is contained in this output
+                if(it->origin == 0)
+                    it->origin = el.origin;
+                coalesced = true;
+                break;
+            }
+        }
+    }
+
+    if(!coalesced)
+    {
+        if(this->getConnectionState() != Connected && m_outputQueue.size() >= BT_OUTPUT_QUEUE_MAX)
+        {
+            m_outputQueue.pop_front();
+            unsigned int dropped = m_telemetry.outputDropped();
+
+            LOG_WARN(Logger::BT, "Bluetooth board %s is not connected, dropped oldest output (%u so far)", m_name.c_str(), dropped);
+        }
+
+        m_outputQueue.push_back(el);
+        m_telemetry.outputQueued(m_outputQueue.size());
+    }
+
     m_mutex.unlock();
 
     // deliver signal to thread to wake it up
@@ -598,66 +846,13 @@ void BTClassicThread::addOutput(std::function<void (BTThread*)> func)
 /**
  * @brief BTClassicThread::sendI2CPackets actually sends the amount of packets given by num over Bluetooth.
  * Attention: This method can only be called by the Bluetooth thread. If it is called by any other thread undefined behaviour may result!
- * Each packet given by packets is sent in a seperate bluetooth packet,
- * altough it would be possible to send more than one packet in one bluetooth packet, we do not use it right now.
+ * Each packet given by packets is sent in a seperate bluetooth packet, unless we are in a poll burst and the board
+ * supports aggregated frames. In this case the packets are collected and sent together by BTClassicThread::flushBurst.
  * @param packets
  * @param num
  */
 void BTClassicThread::sendI2CPackets(BTI2CPacket *packets, unsigned int num)
 {
-    // the following code sends multiple i2c packets in one big l2cap packet. Our bluetooth board currently does not support this
-
-    //    unsigned int totalSize = 0;
-
-    //    // first calculate the size of the whole packet
-    //    for(unsigned int i = 0; i < num; i++)
-    //    {
-    //        totalSize = packets[i].size() + 3;
-    //    }
-
-    //    // now allocate a buffer of the required size
-    //    char* buffer = (char*)malloc(totalSize * sizeof(char));
-
-    //    char* runningBuffer = buffer;
-    //    unsigned int runningSize = totalSize;
-    //    for(unsigned int i = 0; i < num; i++)
-    //    {
-    //        unsigned short size = packets[i].size();
-    //        unsigned char seq = this->seqInc();
-
-    //        runningBuffer[0] = BTPacketType::I2C << 5 | (size + 3);
-    //        runningBuffer[1] = seq;
-    //        runningBuffer[2] = 0xFF;
-
-    //        runningBuffer += 3;
-    //        runningSize -= 3;
-
-    //        packets[i].assemble(runningBuffer, runningSize);
-
-    //        runningBuffer += size;
-    //        runningSize -= size;
-
-    //        // add the callback function (if any) to the list of callback functions for later matching of the response
-    //        if(packets[i].callbackFunc)
-    //        {
-    //            PacketSeq seqCallback;
-    //            seqCallback.seq = seq;
-    //            seqCallback.callbackFunc = packets[i].callbackFunc;
-
-    //            m_listSeq.push_back(seqCallback);
-    //        }
-    //    }
-
-    //    pi_assert(runningSize == 0);
-
-    //    // send the buffer
-    //    this->send(buffer, totalSize);
-
-    //    // we dont need it anymore, free it
-    //    free(buffer);
-
-
-    // the following code sends each i2c packet on a seperate l2cap packet
     for(unsigned int i = 0; i < num; i++)
     {
         unsigned int totalSize = packets[i].size() + 3;
@@ -675,13 +870,25 @@ void BTClassicThread::sendI2CPackets(BTI2CPacket *packets, unsigned int num)
 
         PacketSeq seqCallback;
         seqCallback.seq = seq;
+        seqCallback.type = packets[i].read ? BTTelemetry::I2CRead : BTTelemetry::I2CWrite;
+        clock_gettime(CLOCK_MONOTONIC, &seqCallback.sent);
 
         // add the callback function (if any) to the list of callback functions for later matching of the response
         if(packets[i].callbackFunc)
             seqCallback.callbackFunc = packets[i].callbackFunc;
 
+        if(m_burst && m_aggregate)
+        {
+            this->appendBurst(buffer, totalSize, seqCallback);
+
+            free(buffer);
+            continue;
+        }
+
         m_listSeq.push_back(seqCallback);
 
+        m_telemetry.requestSent(totalSize, m_listSeq.size());
+
         this->send(buffer, totalSize);
 
         // we dont need it anymore, free it
@@ -690,26 +897,192 @@ void BTClassicThread::sendI2CPackets(BTI2CPacket *packets, unsigned int num)
 }
 
 /**
- * @brief BTClassicThread::send sends the packet given by buffer over bluetooth
+ * @brief BTClassicThread::send sends the packet given by buffer over bluetooth.
+ * If too many requests are outstanding, this blocks until the board has answered some of them or they have been given up.
  * @param buffer
  * @param length
  */
 void BTClassicThread::send(char *buffer, unsigned int length)
 {
-    while(m_listSeq.size() > 5)
-        readBlocking();
+    this->waitOutstanding(BT_MAX_OUTSTANDING + 1);
+
+    this->sendRaw(buffer, length);
+}
+
+/**
+ * @brief BTClassicThread::waitOutstanding reads the answers of the board until less than max requests are outstanding.
+ * Requests which have not been answered within BT_RESPONSE_TIMEOUT_MS are given up, see BTClassicThread::expireRequests,
+ * so this does not block forever if the board has lost some of them.
+ * @param max
+ */
+void BTClassicThread::waitOutstanding(unsigned int max)
+{
+    while(m_socket != -1 && !this->isStopped())
+    {
+        this->expireRequests();
+
+        if(m_listSeq.size() < max)
+            break;
+
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+        timespec timeout = timspecAddMiliseconds(m_listSeq.front().sent, BT_RESPONSE_TIMEOUT_MS);
+        if( !timespecGreaterThan(timeout, currentTime) )
+            continue;
+
+        struct pollfd fd;
+        fd.fd = m_socket;
+        fd.events = POLLIN;
+        fd.revents = 0;
+
+        // only read if there is something, being interrupted by a signal must not make us block in recv
+        timespec waitTime = sliceWait(timespecSub(timeout, currentTime));
+        if(ppoll(&fd, 1, &waitTime, NULL) == 1)
+            this->readBlocking();
+    }
+}
+
+/**
+ * @brief BTClassicThread::expireRequests gives up on requests which have not been answered in time, so that the request window does not stall.
+ */
+void BTClassicThread::expireRequests()
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    while(!m_listSeq.empty())
+    {
+        timespec timeout = timspecAddMiliseconds(m_listSeq.front().sent, BT_RESPONSE_TIMEOUT_MS);
+        if(timespecGreaterThan(timeout, currentTime))
+            break;
+
+        LOG_WARN(Logger::BT, "Bluetooth board %s did not answer request %u", m_name.c_str(), m_listSeq.front().seq);
+        m_listSeq.pop_front();
+
+        m_telemetry.requestsLost(1);
+    }
+}
+
+/**
+ * @brief BTClassicThread::sendRaw writes buffer to the socket without looking at the number of outstanding requests
+ * @param buffer
+ * @param length
+ */
+void BTClassicThread::sendRaw(char *buffer, unsigned int length)
+{
+    // if we have lost the connection in the meantime, this packet is lost as well
+    if(m_socket == -1 || this->isStopped())
+        return;
 
     int ret = write(m_socket, buffer, length);
-    if(ret != length)
+    if(ret != (int)length)
     {
-        // TODO: check if we need to reconnect
-        perror("Write to bluetooth socket has failed");
+        LOG_WARN(Logger::BT, "Write to bluetooth socket has failed: %s", strerror(errno));
 
-        if(errno == ENOTCONN)
-        {
-            this->reconnectBt();
-        }
+        if(errno != EINTR && errno != EAGAIN)
+            this->linkLost();
+    }
+}
+
+/**
+ * @brief BTClassicThread::pollBurst polls all inputs which are due now or within BT_POLL_SLACK_MS.
+ * The requests of all devices are sent back to back, so that the board can answer them in one go,
+ * instead of paying one round trip per device. The responses are delivered to the devices by their sequence numbers.
+ * The due inputs are taken out of the queue for the burst and are pushed back once it has been sent.
+ */
+void BTClassicThread::pollBurst()
+{
+    // we may have waited for the first input to get due, so the time has to be read again
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    timespec limit = timspecAddMiliseconds(currentTime, BT_POLL_SLACK_MS);
+
+    m_mutex.lock();
+
+    while( !m_inputQueue.empty() && !timespecGreaterThan(m_inputQueue.top().time, limit) )
+    {
+        m_burstDue.push_back(m_inputQueue.top());
+        m_inputQueue.pop();
     }
+
+    // removeInput may change m_burstDue while we are polling
+    std::vector<InputElement> due = m_burstDue;
+
+    m_mutex.unlock();
+
+    m_burst = true;
+
+    for(std::vector<InputElement>::iterator it = due.begin(); it != due.end(); it++)
+    {
+        // no need to continue if we have lost the connection
+        if(m_socket == -1)
+            break;
+
+        it->hw->poll(this);
+    }
+
+    this->flushBurst();
+
+    m_burst = false;
+
+    // all elements of this burst are rescheduled relative to the same point in time,
+    // this way devices with the same frequency stay together in one burst
+    m_mutex.lock();
+
+    // inputs which have been removed in the meantime are not part of m_burstDue anymore
+    for(std::vector<InputElement>::iterator it = m_burstDue.begin(); it != m_burstDue.end(); it++)
+    {
+        pi_assert(it->freq > 0);
+        it->time = timspecAddMiliseconds(currentTime, 1000 / it->freq);
+
+        m_inputQueue.push(*it);
+    }
+
+    m_burstDue.clear();
+
+    m_mutex.unlock();
+}
+
+/**
+ * @brief BTClassicThread::appendBurst adds one assembled i2c packet to the aggregated frame of the current burst.
+ * The frame is sent if it is full or if it already contains as many requests as may be outstanding.
+ * @param buffer
+ * @param length
+ * @param seqCallback
+ */
+void BTClassicThread::appendBurst(char* buffer, unsigned int length, const PacketSeq& seqCallback)
+{
+    if( !m_burstBuffer.empty() && (m_burstBuffer.size() + length > BT_AGGREGATE_MAX_SIZE || m_listSeq.size() >= BT_MAX_OUTSTANDING) )
+        this->flushBurst();
+
+    // the frame is empty now, so all requests in m_listSeq have actually been sent and we can wait for them
+    this->waitOutstanding(BT_MAX_OUTSTANDING);
+
+    // if we have lost the connection in the meantime, this packet is lost as well
+    if(m_socket == -1 || this->isStopped())
+        return;
+
+    m_burstBuffer.insert(m_burstBuffer.end(), buffer, buffer + length);
+    m_listSeq.push_back(seqCallback);
+
+    m_telemetry.requestSent(length, m_listSeq.size());
+}
+
+/**
+ * @brief BTClassicThread::flushBurst sends the aggregated frame of the current burst, if there is any
+ */
+void BTClassicThread::flushBurst()
+{
+    if(m_burstBuffer.empty())
+        return;
+
+    // copy it, as sendRaw may clear m_burstBuffer if the connection is lost
+    std::vector<char> frame;
+    frame.swap(m_burstBuffer);
+
+    this->sendRaw(&frame[0], frame.size());
 }
 
 
@@ -3,6 +3,9 @@
 
 #include "hw/BTThread.h"
 
+#include <deque>
+#include <vector>
+
 /**
  * @brief The BTThread class does the actual communication with the devices on the Bluetooth boarrd.
  * A HWInput or HWOutput object uses an BTThread object to read or write to/from devices on Bluetooth.
@@ -17,17 +20,13 @@ public:
     void start();
     void kill();
 
-    static BTThread* load(QDomElement* root);
+    static BTThread* load(XmlElement* root);
+    QDomElement save(QDomElement* root, QDomDocument* document);
 
     void addInput(BTI2CPolling* hw, unsigned int freq);
     void removeInput(BTI2CPolling* hw);
 
-    void addOutput(std::function<void (BTThread*)> func);
-
-    void addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port);
-    void removeInputPCF8575(HWInput* hw, int slaveAddress);
-    void addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port);
-    void removeOutputPCF8575(HWOutput* hw, int slaveAddress);
+    void addOutput(std::function<void (BTThread*)> func, const void* coalesceKey = NULL);
 
     void addGPInput(HWInputButtonBtGPIO* hw);
     void removeGPInput(HWInputButtonBtGPIO* hw);
@@ -57,14 +56,18 @@ private:
     struct OutputElement
     {
         std::function<void (BTThread*)> func;
+        const void* coalesceKey; // outputs with the same key replace each other while queued, NULL means never coalesce
+        unsigned long long origin; // see LatencyTrace
     };
 
     static void* run_internal(void* arg);
     void run();
 
-    void connectBt();
+    bool connectBt();
     void disconnectBt();
-    void reconnectBt();
+    void linkLost();
+    void waitBackoff();
+    bool isStopped();
 
     void readBlocking();
 
@@ -72,16 +75,19 @@ private:
     void packetHandler(char* buffer, unsigned int length);
     unsigned short seqInc() { m_seq = (m_seq + 1) % 0xFF; return m_seq;}
     void send(char* buffer, unsigned int length);
-    void sendGPUpdateRequest(unsigned int pinGroup, BTThread*);
+    void sendRaw(char* buffer, unsigned int length);
+    void waitOutstanding(unsigned int max);
+    void expireRequests();
+    void sendGPUpdateRequests(BTThread*);
+    unsigned int gpGroups();
+    void checkInputsValid();
 
 
     int m_socket;
 
     unsigned short m_seq;
     PriorityQueue<InputElement> m_inputQueue;
-    std::queue<OutputElement> m_outputQueue;
-
-    std::list<PCF8575Bt*> m_listPCF8575;
+    std::deque<OutputElement> m_outputQueue;
 
     struct GPInput
     {
@@ -90,15 +96,30 @@ private:
         unsigned int pin;
     };
 
-    std::list<GPInput> m_listGPInput;
+    std::list<GPInput> m_listGPInput; // changed by the threads adding and removing inputs, protected by m_mutex
+    unsigned int m_gpPending; // pin groups we have requested but not yet received
+    unsigned int m_gpValid; // pin groups whose state we have received since the last link-up
+    timespec m_gpCheckTime; // next time all pin groups are requested again
 
     struct PacketSeq
     {
         unsigned char seq;
         std::function<void (BTThread*, BTI2CPacket*)> callbackFunc;
 
+        // only used for telemetry
+        BTTelemetry::RequestType type;
+        timespec sent;
     };
 
     std::list<PacketSeq> m_listSeq;
+
+    void pollBurst();
+    void appendBurst(char* buffer, unsigned int length, const PacketSeq& seqCallback);
+    void flushBurst();
+
+    std::vector<InputElement> m_burstDue; // inputs which have been taken out of m_inputQueue for the current burst, protected by m_mutex
+    bool m_burst; // true while the polls of one tick are issued
+    bool m_aggregate; // true if the board accepts more than one i2c packet per l2cap packet
+    std::vector<char> m_burstBuffer;
 };
 #endif // BTCLASSICTHREAD_H
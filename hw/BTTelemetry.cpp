@@ -0,0 +1,281 @@
+
+#include "hw/BTTelemetry.h"
+#include "util/Debug.h"
+#include "util/Time.h"
+
+#include <QDomDocument>
+
+#include <string.h>
+
+const unsigned int BTTelemetry::RttBucketLimits[BTTelemetry::RttBucketCount - 1] = {2, 5, 10, 20, 50, 100, 200, 500};
+
+BTTelemetry::BTTelemetry()
+{
+    memset(&m_data, 0, sizeof(m_data));
+
+    clock_gettime(CLOCK_MONOTONIC, &m_rateTime);
+    m_rateBytes = 0;
+
+    m_waitInputsValid = false;
+}
+
+/**
+ * @brief BTTelemetry::requestSent is called for every request which has been sent to the board.
+ * @param bytes size of the request
+ * @param outstanding number of requests which have not yet been answered, including this one
+ */
+void BTTelemetry::requestSent(unsigned int bytes, unsigned int outstanding)
+{
+    m_mutex.lock();
+    m_data.bytesSent += bytes;
+    m_data.outstanding = outstanding;
+    if(outstanding > m_data.outstandingHighWater)
+        m_data.outstandingHighWater = outstanding;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief BTTelemetry::responseMatched is called for every response for which the request has been found.
+ * @param type
+ * @param sent the time the request has been sent, on CLOCK_MONOTONIC
+ */
+void BTTelemetry::responseMatched(RequestType type, timespec sent)
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    timespec rtt = timespecSub(currentTime, sent);
+    unsigned long long rttUs = rtt.tv_sec * 1000000ULL + rtt.tv_nsec / 1000;
+    unsigned int rttMs = rttUs / 1000;
+
+    unsigned int bucket = 0;
+    while(bucket < RttBucketCount - 1 && rttMs >= RttBucketLimits[bucket])
+        bucket++;
+
+    m_mutex.lock();
+    m_data.matched++;
+    if(m_data.outstanding > 0)
+        m_data.outstanding--;
+
+    m_data.rttHistogram[type][bucket]++;
+    m_data.rttSumUs[type] += rttUs;
+    if(rttMs > m_data.rttMaxMs[type])
+        m_data.rttMaxMs[type] = rttMs;
+    m_mutex.unlock();
+}
+
+void BTTelemetry::responseOrphaned()
+{
+    m_mutex.lock();
+    m_data.orphaned++;
+    m_mutex.unlock();
+}
+
+void BTTelemetry::bytesReceived(unsigned int bytes)
+{
+    m_mutex.lock();
+    m_data.bytesReceived += bytes;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief BTTelemetry::requestsLost is called if requests are given up, because they timed out or the connection was lost.
+ * @param num
+ */
+void BTTelemetry::requestsLost(unsigned int num)
+{
+    if(num == 0)
+        return;
+
+    m_mutex.lock();
+    m_data.lost += num;
+    m_data.outstanding = m_data.outstanding > num ? m_data.outstanding - num : 0;
+    m_mutex.unlock();
+}
+
+void BTTelemetry::reconnected()
+{
+    m_mutex.lock();
+    m_data.reconnects++;
+    m_mutex.unlock();
+}
+
+void BTTelemetry::outputQueued(unsigned int queueSize)
+{
+    m_mutex.lock();
+    if(queueSize > m_data.outputQueueHighWater)
+        m_data.outputQueueHighWater = queueSize;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief BTTelemetry::outputDropped is called if an output had to be dropped, because the output queue was full.
+ * @return the number of outputs dropped so far
+ */
+unsigned int BTTelemetry::outputDropped()
+{
+    m_mutex.lock();
+    unsigned int dropped = ++m_data.outputsDropped;
+    m_mutex.unlock();
+
+    return dropped;
+}
+
+/**
+ * @brief BTTelemetry::linkUp is called as soon as the connection to the board is established.
+ * From now on we measure the time until BTTelemetry::inputsValid is called.
+ */
+void BTTelemetry::linkUp()
+{
+    m_mutex.lock();
+    clock_gettime(CLOCK_MONOTONIC, &m_linkUpTime);
+    m_waitInputsValid = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief BTTelemetry::inputsValid is called when the state of all general purpose inputs is known.
+ * Only the first call after BTTelemetry::linkUp is taken into account.
+ * @param ms is set to the time since the link-up
+ * @return true if this was the first call after the link-up
+ */
+bool BTTelemetry::inputsValid(unsigned int* ms)
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    m_mutex.lock();
+
+    if(!m_waitInputsValid)
+    {
+        m_mutex.unlock();
+        return false;
+    }
+
+    timespec diff = timespecSub(currentTime, m_linkUpTime);
+    *ms = diff.tv_sec * 1000 + diff.tv_nsec / 1000000;
+
+    m_waitInputsValid = false;
+    m_data.inputsValidMs = *ms;
+    if(*ms > m_data.inputsValidMaxMs)
+        m_data.inputsValidMaxMs = *ms;
+
+    m_mutex.unlock();
+
+    return true;
+}
+
+/**
+ * @brief BTTelemetry::gpCorrected is called if a periodic check has found a general purpose input with a wrong value.
+ * This means that we have missed a report of the board.
+ */
+void BTTelemetry::gpCorrected()
+{
+    m_mutex.lock();
+    m_data.gpCorrections++;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief BTTelemetry::updateRate recalculates the throughput, if at least one second has passed since the last time.
+ * Must be called with m_mutex held
+ * @param now
+ */
+void BTTelemetry::updateRate(timespec now)
+{
+    timespec diff = timespecSub(now, m_rateTime);
+    unsigned long long diffMs = diff.tv_sec * 1000ULL + diff.tv_nsec / 1000000;
+
+    if(diffMs < 1000)
+        return;
+
+    unsigned long long bytes = m_data.bytesSent + m_data.bytesReceived;
+
+    m_data.bytesPerSecond = (bytes - m_rateBytes) * 1000 / diffMs;
+
+    m_rateBytes = bytes;
+    m_rateTime = now;
+}
+
+/**
+ * @brief BTTelemetry::get returns a consistent copy of all counters
+ * @return
+ */
+BTTelemetry::Snapshot BTTelemetry::get()
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    m_mutex.lock();
+    this->updateRate(currentTime);
+    Snapshot snapshot = m_data;
+    m_mutex.unlock();
+
+    return snapshot;
+}
+
+/**
+ * @brief BTTelemetry::save appends all counters as XML to root, so that they can be processed by other tools.
+ * @param root
+ * @param document
+ */
+void BTTelemetry::save(QDomElement* root, QDomDocument* document)
+{
+    Snapshot snapshot = this->get();
+
+    QDomElement telemetry = document->createElement("telemetry");
+
+    telemetry.setAttribute("matched", snapshot.matched);
+    telemetry.setAttribute("orphaned", snapshot.orphaned);
+    telemetry.setAttribute("lost", snapshot.lost);
+    telemetry.setAttribute("reconnects", snapshot.reconnects);
+    telemetry.setAttribute("outstanding", snapshot.outstanding);
+    telemetry.setAttribute("outstandingHighWater", snapshot.outstandingHighWater);
+    telemetry.setAttribute("outputQueueHighWater", snapshot.outputQueueHighWater);
+    telemetry.setAttribute("outputsDropped", snapshot.outputsDropped);
+    telemetry.setAttribute("inputsValidMs", snapshot.inputsValidMs);
+    telemetry.setAttribute("inputsValidMaxMs", snapshot.inputsValidMaxMs);
+    telemetry.setAttribute("gpCorrections", snapshot.gpCorrections);
+    telemetry.setAttribute("bytesSent", QString::number(snapshot.bytesSent));
+    telemetry.setAttribute("bytesReceived", QString::number(snapshot.bytesReceived));
+    telemetry.setAttribute("bytesPerSecond", snapshot.bytesPerSecond);
+
+    for(unsigned int type = 0; type < RequestTypeCount; type++)
+    {
+        QDomElement rtt = document->createElement("rtt");
+        rtt.setAttribute("type", QString::fromStdString( RequestTypeToString((RequestType)type) ));
+        rtt.setAttribute("maxMs", snapshot.rttMaxMs[type]);
+        rtt.setAttribute("sumUs", QString::number(snapshot.rttSumUs[type]));
+
+        for(unsigned int bucket = 0; bucket < RttBucketCount; bucket++)
+        {
+            QDomElement bucketElem = document->createElement("bucket");
+
+            // the last bucket has no upper bound
+            if(bucket < RttBucketCount - 1)
+                bucketElem.setAttribute("lessThanMs", RttBucketLimits[bucket]);
+
+            bucketElem.setAttribute("count", snapshot.rttHistogram[type][bucket]);
+
+            rtt.appendChild(bucketElem);
+        }
+
+        telemetry.appendChild(rtt);
+    }
+
+    root->appendChild(telemetry);
+}
+
+std::string BTTelemetry::RequestTypeToString(RequestType type)
+{
+    switch(type)
+    {
+    case I2CWrite:
+        return "I2CWrite";
+    case I2CRead:
+        return "I2CRead";
+    default:
+        LOG_WARN(Logger::BT, "Invalid request type");
+        return "";
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef BTTELEMETRY_H
+#define BTTELEMETRY_H
+
+#include <mutex>
+#include <string>
+#include <time.h>
+
+class QDomElement;
+class QDomDocument;
+
+/**
+ * @brief The BTTelemetry class collects statistics about the link to one bluetooth board.
+ * The counters are updated by the bluetooth thread and can be read from any thread by BTTelemetry::get
+ */
+class BTTelemetry
+{
+public:
+    enum RequestType
+    {
+        I2CWrite = 0,
+        I2CRead = 1,
+        RequestTypeCount = 2
+    };
+    static std::string RequestTypeToString(RequestType type);
+
+    // upper bounds of the round trip time histogram buckets in miliseconds, the last bucket has no upper bound
+    static const unsigned int RttBucketCount = 9;
+    static const unsigned int RttBucketLimits[RttBucketCount - 1];
+
+    struct Snapshot
+    {
+        unsigned int rttHistogram[RequestTypeCount][RttBucketCount];
+        unsigned int rttMaxMs[RequestTypeCount];
+        unsigned long long rttSumUs[RequestTypeCount];
+
+        unsigned int matched; // responses for which we have found the request
+        unsigned int orphaned; // responses for which we have not found a request
+        unsigned int lost; // requests which never got a response
+        unsigned int reconnects;
+
+        unsigned int outstanding;
+        unsigned int outstandingHighWater;
+        unsigned int outputQueueHighWater;
+        unsigned int outputsDropped;
+
+        unsigned int inputsValidMs; // time from the last link-up until all general purpose inputs were known
+        unsigned int inputsValidMaxMs;
+        unsigned int gpCorrections; // general purpose inputs which were wrong when they were checked
+
+        unsigned long long bytesSent;
+        unsigned long long bytesReceived;
+        unsigned int bytesPerSecond; // sent and received during the last second
+    };
+
+    BTTelemetry();
+
+    void requestSent(unsigned int bytes, unsigned int outstanding);
+    void responseMatched(RequestType type, timespec sent);
+    void responseOrphaned();
+    void bytesReceived(unsigned int bytes);
+    void requestsLost(unsigned int num);
+    void reconnected();
+    void outputQueued(unsigned int queueSize);
+    unsigned int outputDropped();
+    void linkUp();
+    bool inputsValid(unsigned int* ms);
+    void gpCorrected();
+
+    Snapshot get();
+    void save(QDomElement* root, QDomDocument* document);
+
+private:
+    void updateRate(timespec now);
+
+    std::mutex m_mutex;
+    Snapshot m_data;
+
+    timespec m_linkUpTime;
+    bool m_waitInputsValid;
+
+    timespec m_rateTime;
+    unsigned long long m_rateBytes;
+};
+
+#endif // BTTELEMETRY_H
@@ -1,18 +1,32 @@
 
 #include "hw/BTThread.h"
+#include "hw/BTThreadListener.h"
+#include "hw/PCF8575Bt.h"
 #include "util/Config.h"
 #include "util/Debug.h"
 
 #include <QDomDocument>
 
+#include <stdlib.h>
+
 #include "hw/BTClassicThread.h"
 #include "hw/BLEThread.h"
+#include "util/XmlElement.h"
+
+// the time we wait before retrying to connect starts at BT_BACKOFF_MIN_MS and is doubled after every failed attempt
+#define BT_BACKOFF_MIN_MS   250
+#define BT_BACKOFF_MAX_MS   16000
 
 BTThread::BTThread()
 {
     m_bStop = false;
     m_thread = 0;
     m_btaddr = "11:22:33:44:55:66";
+
+    m_connState = Disconnected;
+    m_wasConnected = false;
+    m_backoffMs = BT_BACKOFF_MIN_MS;
+    m_backoffSeed = (unsigned int)time(NULL) ^ (unsigned int)(unsigned long)this;
 }
 
 BTThread::~BTThread()
@@ -26,29 +40,26 @@ BTThread::~BTThread()
  * @param root
  * @return returns NULL if an error occurred or an instance of BTClassicThread
  */
-BTThread* BTThread::load(QDomElement* root)
+BTThread* BTThread::load(XmlElement* root)
 {
     std::string name;
     std::string btaddr;
     bool is_lowEnergy = false;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("name") == 0)
+        if(elem->tag == XmlTag::Name)
         {
-            name = elem.text().toStdString();
+            name = elem->text.toStdString();
         }
-        else if(elem.tagName().toLower().compare("btaddress") == 0)
+        else if(elem->tag == XmlTag::BTAddress)
         {
-            btaddr = elem.text().toStdString();
+            btaddr = elem->text.toStdString();
         }
-        else if(elem.tagName().toLower().compare("lowenergy") == 0)
+        else if(elem->tag == XmlTag::LowEnergy)
         {
             is_lowEnergy = true;
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     BTThread* btthread;
@@ -136,3 +147,190 @@ void BTThread::setBTAddr(std::string addr)
 
     m_btaddr = addr;
 }
+
+void BTThread::addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port)
+{
+    // first check if we already have an Object for this slave address
+    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
+    {
+        if( (*it)->getSlaveAddress() == slaveAddress )
+        {
+            // we found it
+            (*it)->addInput((HWInputButtonBt*)hw, port);
+            return;
+        }
+    }
+
+    // we did not found an object for this slave address, so create a new one
+    PCF8575Bt* pcf = new PCF8575Bt(slaveAddress);
+    m_listPCF8575.push_back(pcf);
+
+    pcf->init(this);
+
+    pcf->addInput((HWInputButtonBt*)hw, port);
+}
+
+void BTThread::removeInputPCF8575(HWInput* hw, int slaveAddress)
+{
+    // search for the corresponding pcf object
+    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
+    {
+        if( (*it)->getSlaveAddress() == slaveAddress )
+        {
+            // we found it
+            (*it)->removeInput((HWInputButtonBt*)hw);
+
+            // check if the pcf object is empty now
+            if((*it)->empty())
+            {
+                (*it)->deinit();
+                delete *it;
+
+                m_listPCF8575.erase(it);
+            }
+
+            return;
+        }
+    }
+}
+
+void BTThread::addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port)
+{
+    // first check if we already have an Object for this slave address
+    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
+    {
+        if( (*it)->getSlaveAddress() == slaveAddress )
+        {
+            // we found it
+            (*it)->addOutput((HWOutputGPO*)hw, port);
+            return;
+        }
+    }
+
+    // we did not found an object for this slave address, so create a new one
+    PCF8575Bt* pcf = new PCF8575Bt(slaveAddress);
+    m_listPCF8575.push_back(pcf);
+
+    pcf->init(this);
+
+    pcf->addOutput((HWOutputGPO*)hw, port);
+}
+
+void BTThread::removeOutputPCF8575(HWOutput* hw, int slaveAddress)
+{
+    // search for the corresponding pcf object
+    for(std::list<PCF8575Bt*>::iterator it = m_listPCF8575.begin(); it != m_listPCF8575.end(); it++)
+    {
+        if( (*it)->getSlaveAddress() == slaveAddress )
+        {
+            // we found it
+            (*it)->removeOutput((HWOutputGPO*)hw);
+
+            // check if the pcf object is empty now
+            if((*it)->empty())
+            {
+                (*it)->deinit();
+                delete *it;
+
+                m_listPCF8575.erase(it);
+            }
+
+            return;
+        }
+    }
+}
+
+/**
+ * @brief BTThread::registerBTListener registers the object listener for the onBTStateChanged event.
+ * This method calls the event handler immediately once after registration
+ * @param listener
+ */
+void BTThread::registerBTListener(BTThreadListener* listener)
+{
+    m_mutexListeners.lock();
+    m_listListeners.push_back(listener);
+    m_mutexListeners.unlock();
+
+    listener->onBTStateChanged(this);
+}
+
+/**
+ * @brief BTThread::unregisterBTListener unregisters an object for the onBTStateChanged event.
+ * @param listener
+ */
+void BTThread::unregisterBTListener(BTThreadListener* listener)
+{
+    m_mutexListeners.lock();
+    m_listListeners.remove(listener);
+    m_mutexListeners.unlock();
+}
+
+/**
+ * @brief BTThread::setConnectionState sets the new connection state and informs all registered listeners if it has changed.
+ * @param state
+ */
+void BTThread::setConnectionState(ConnectionState state)
+{
+    if(m_connState.exchange(state) == state)
+        return;
+
+    LOG_DEBUG(Logger::BT, "Bluetooth board %s is now %s", m_name.c_str(), ConnectionStateToString(state).c_str());
+
+    if(state == Connected)
+    {
+        if(m_wasConnected)
+            m_telemetry.reconnected();
+
+        m_wasConnected = true;
+    }
+
+    m_mutexListeners.lock();
+    for(std::list<BTThreadListener*>::iterator it = m_listListeners.begin(); it != m_listListeners.end(); it++)
+    {
+        (*it)->onBTStateChanged(this);
+    }
+    m_mutexListeners.unlock();
+}
+
+/**
+ * @brief BTThread::nextBackoffMs returns the time to wait before the next connection attempt and doubles the backoff for the one after.
+ * The returned time is randomly chosen between half and the full current backoff,
+ * so that several boards which lost their connection at the same time do not retry in lockstep.
+ * @return time in miliseconds
+ */
+unsigned int BTThread::nextBackoffMs()
+{
+    unsigned int backoff = m_backoffMs;
+
+    m_backoffMs = m_backoffMs * 2;
+    if(m_backoffMs > BT_BACKOFF_MAX_MS)
+        m_backoffMs = BT_BACKOFF_MAX_MS;
+
+    return backoff / 2 + rand_r(&m_backoffSeed) % (backoff / 2 + 1);
+}
+
+/**
+ * @brief BTThread::resetBackoff resets the backoff to its minimum, this should be called as soon as a connection has been established.
+ */
+void BTThread::resetBackoff()
+{
+    m_backoffMs = BT_BACKOFF_MIN_MS;
+}
+
+std::string BTThread::ConnectionStateToString(ConnectionState state)
+{
+    switch(state)
+    {
+    case Disconnected:
+        return "Disconnected";
+    case Connecting:
+        return "Connecting";
+    case Connected:
+        return "Connected";
+    case Backoff:
+        return "Backoff";
+    default:
+        LOG_WARN(Logger::BT, "Invalid connection state");
+        return "";
+    }
+}
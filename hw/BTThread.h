@@ -1,12 +1,14 @@
 #ifndef BTTHREAD_H
 #define BTTHREAD_H
 
+#include <atomic>
 #include <mutex>
 #include <pthread.h>
 #include <queue>
 #include <list>
 #include <functional>
 
+#include "hw/BTTelemetry.h"
 #include "util/Time.h"
 #include "util/PriorityQueue.h"
 
@@ -14,9 +16,11 @@ class HWInput;
 class HWInputButtonBtGPIO;
 class HWOutput;
 class BTThread;
+class BTThreadListener;
 class PCF8575Bt;
 class QDomElement;
 class QDomDocument;
+class XmlElement;
 
 
 enum BTPacketType
@@ -66,24 +70,39 @@ public:
 class BTThread
 {
 public:
+    /**
+     * @brief The ConnectionState enum describes the state of the link to the bluetooth board.
+     * Disconnected -> Connecting -> Connected, a failed attempt goes to Backoff and then back to Connecting.
+     * A lost link goes from Connected to Disconnected.
+     */
+    enum ConnectionState
+    {
+        Disconnected = 0,
+        Connecting = 1,
+        Connected = 2,
+        Backoff = 3
+    };
+    static std::string ConnectionStateToString(ConnectionState state);
+
     BTThread();
     virtual ~BTThread();
 
     virtual void start() = 0;
     virtual void kill() = 0;
 
-    static BTThread* load(QDomElement* root);
+    static BTThread* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     virtual void addInput(BTI2CPolling* hw, unsigned int freq) = 0;
     virtual void removeInput(BTI2CPolling* hw) = 0;
 
-    virtual void addOutput(std::function<void (BTThread*)> func) = 0;
+    virtual void addOutput(std::function<void (BTThread*)> func, const void* coalesceKey = NULL) = 0;
 
-    virtual void addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port) = 0;
-    virtual void removeInputPCF8575(HWInput* hw, int slaveAddress) = 0;
-    virtual void addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port) = 0;
-    virtual void removeOutputPCF8575(HWOutput* hw, int slaveAddress) = 0;
+    // the PCF8575 handling only needs addInput, addOutput and sendI2CPackets, so it is the same for all bluetooth threads
+    void addInputPCF8575(HWInput* hw, int slaveAddress, unsigned int port);
+    void removeInputPCF8575(HWInput* hw, int slaveAddress);
+    void addOutputPCF8575(HWOutput* hw, int slaveAddress, unsigned int port);
+    void removeOutputPCF8575(HWOutput* hw, int slaveAddress);
 
     virtual void addGPInput(HWInputButtonBtGPIO* hw) = 0;
     virtual void removeGPInput(HWInputButtonBtGPIO* hw) = 0;
@@ -93,16 +112,40 @@ public:
     void setBTAddr(std::string addr);
     std::string getBTAddr() const { return m_btaddr;}
 
+    ConnectionState getConnectionState() const { return (ConnectionState)m_connState.load();}
+    BTTelemetry* getTelemetry() { return &m_telemetry;}
+
+    void registerBTListener(BTThreadListener* listener);
+    void unregisterBTListener(BTThreadListener* listener);
+
 
     // ATTENTION: USE ONLY IN BTTHREAD!!!!
     virtual void sendI2CPackets(BTI2CPacket* packets, unsigned int num) = 0;
 
 protected:
+    void setConnectionState(ConnectionState state);
+
+    unsigned int nextBackoffMs();
+    void resetBackoff();
+
     pthread_t m_thread;
     std::mutex m_mutex;
     bool m_bStop;
     std::string m_name;
     std::string m_btaddr; // must be in format 11:22:33:44:55:66
+
+    std::list<PCF8575Bt*> m_listPCF8575;
+
+    BTTelemetry m_telemetry;
+
+private:
+    std::atomic<int> m_connState;
+    bool m_wasConnected;
+    unsigned int m_backoffMs;
+    unsigned int m_backoffSeed;
+
+    std::mutex m_mutexListeners;
+    std::list<BTThreadListener*> m_listListeners;
 };
 
 #endif // BTTHREAD_H
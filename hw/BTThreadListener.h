@@ -0,0 +1,18 @@
+#ifndef BTTHREADLISTENER_H
+#define BTTHREADLISTENER_H
+
+class BTThread;
+
+// Interface for bluetooth connection events
+class BTThreadListener
+{
+public:
+    /**
+     * @brief onBTStateChanged gets called from the bluetooth thread, if its connection state has changed.
+     * Attention: This is called from within the bluetooth thread, not from the GUI thread!
+     * @param bt the bluetooth thread which generated the event
+     */
+    virtual void onBTStateChanged(BTThread* bt) {};
+};
+
+#endif // BTTHREADLISTENER_H
@@ -4,9 +4,17 @@
 #include "hw/HWOutput.h"
 #include "hw/BTThread.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomDocument>
 #include <QFile>
+#include <QXmlStreamReader>
+
+Config::Config()
+{
+    m_gpioPriority = 0;
+    m_gpioCpu = -1;
+}
 
 Config::~Config()
 {
@@ -31,53 +39,107 @@ bool Config::load(std::string name)
         return false;
     }
 
-    QDomDocument document;
-    document.setContent(&file);
-
-    QDomElement docElem = document.documentElement();
+    QXmlStreamReader reader(&file);
 
     // check if this is a valid configuration file
-    if(docElem.tagName().toLower().compare("config") != 0)
+    if(!reader.readNextStartElement() || XmlTag::lookup(reader.name()) != XmlTag::Config)
     {
         LOG_WARN(Logger::Misc, "Invalid configuration file: tag \"config\" is missing");
         return false;
     }
 
-    // now set the filename
-    m_name = name;
-
-    // load xml data
-    QDomElement elem = docElem.firstChildElement();
+    // everything is read into temporary lists first, so that nothing is added if the file turns out to be broken
+    std::list<HWInput*> listInput;
+    std::list<HWOutput*> listOutput;
+    std::list<BTThread*> listBTThread;
+    XmlElement elem;
 
-    while(!elem.isNull())
+    while(reader.readNextStartElement())
     {
-        if(elem.tagName().toLower().compare("input") == 0)
+        XmlTag::Id tag = XmlTag::lookup(reader.name());
+
+        if(tag == XmlTag::Input)
         {
+            elem.read(&reader);
+
             HWInput* hw = HWInput::load(&elem);
             if(hw != NULL)
-                m_listInput.push_back(hw);
+                listInput.push_back(hw);
         }
-        else if(elem.tagName().toLower().compare("output") == 0)
+        else if(tag == XmlTag::Output)
         {
+            elem.read(&reader);
+
             HWOutput* hw = HWOutput::load(&elem);
             if(hw != NULL)
-                m_listOutput.push_back(hw);
+                listOutput.push_back(hw);
         }
-        else if(elem.tagName().toLower().compare("bluetooth") == 0)
+        else if(tag == XmlTag::Bluetooth)
         {
+            elem.read(&reader);
+
             BTThread* bt = BTThread::load(&elem);
             if(bt != NULL)
-                m_listBTThread.push_back(bt);
+                listBTThread.push_back(bt);
         }
+        else if(tag == XmlTag::GPIO)
+        {
+            elem.read(&reader);
 
-        elem = elem.nextSiblingElement();
+            this->loadGPIO(&elem);
+        }
+        else
+        {
+            reader.skipCurrentElement();
+        }
     }
 
     file.close();
 
+    if(reader.hasError())
+    {
+        LOG_WARN(Logger::Misc, "Invalid configuration file: %s in line %lld",
+                 reader.errorString().toStdString().c_str(), reader.lineNumber());
+
+        for(std::list<HWInput*>::iterator it = listInput.begin(); it != listInput.end(); it++)
+            delete (*it);
+        for(std::list<HWOutput*>::iterator it = listOutput.begin(); it != listOutput.end(); it++)
+            delete (*it);
+        for(std::list<BTThread*>::iterator it = listBTThread.begin(); it != listBTThread.end(); it++)
+            delete (*it);
+
+        return false;
+    }
+
+    // now set the filename
+    m_name = name;
+
+    m_listInput.splice(m_listInput.end(), listInput);
+    m_listOutput.splice(m_listOutput.end(), listOutput);
+    m_listBTThread.splice(m_listBTThread.end(), listBTThread);
+
     return true;
 }
 
+/**
+ * @brief Config::loadGPIO loads the scheduling parameters of the GPIO thread
+ * @param root
+ */
+void Config::loadGPIO(XmlElement* root)
+{
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
+    {
+        if(elem->tag == XmlTag::Priority)
+        {
+            m_gpioPriority = elem->text.toInt();
+        }
+        else if(elem->tag == XmlTag::CPU)
+        {
+            m_gpioCpu = elem->text.toInt();
+        }
+    }
+}
+
 /**
  * @brief Config::save saves the configuration
  * @return
@@ -119,6 +181,24 @@ bool Config::save()
         (*it)->save(&config, &document);
     }
 
+    // save GPIO Parameters, only if they are not the default ones
+    if(m_gpioPriority != 0 || m_gpioCpu != -1)
+    {
+        QDomElement gpio = document.createElement("gpio");
+
+        QDomElement priority = document.createElement("priority");
+        QDomText priorityText = document.createTextNode(QString::number(m_gpioPriority));
+        priority.appendChild(priorityText);
+        gpio.appendChild(priority);
+
+        QDomElement cpu = document.createElement("cpu");
+        QDomText cpuText = document.createTextNode(QString::number(m_gpioCpu));
+        cpu.appendChild(cpuText);
+        gpio.appendChild(cpu);
+
+        config.appendChild(gpio);
+    }
+
 
     file.write(document.toByteArray(4));
 
@@ -152,4 +232,7 @@ void Config::clear()
         delete (*it);
     }
     m_listBTThread.clear();
+
+    m_gpioPriority = 0;
+    m_gpioCpu = -1;
 }
@@ -7,10 +7,12 @@
 class HWInput;
 class HWOutput;
 class BTThread;
+class XmlElement;
 
 class Config
 {
 public:
+    Config();
     ~Config();
 
     bool load(std::string name);
@@ -21,11 +23,20 @@ public:
     void setName(std::string name) { m_name = name;}
     std::string getName() const { return m_name;}
 
+    // scheduling of the GPIOInterruptThread, a priority of 0 means normal scheduling and a cpu of -1 means any cpu
+    int getGPIOPriority() const { return m_gpioPriority;}
+    int getGPIOCpu() const { return m_gpioCpu;}
+
     std::list<HWInput*> m_listInput;
     std::list<HWOutput*> m_listOutput;
     std::list<BTThread*> m_listBTThread;
 private:
+    void loadGPIO(XmlElement* root);
+
     std::string m_name;
+
+    int m_gpioPriority;
+    int m_gpioCpu;
 };
 
 #endif // HW_CONFIG_H
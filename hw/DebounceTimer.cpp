@@ -0,0 +1,113 @@
+
+#include "hw/DebounceTimer.h"
+#include "hw/HWInputButton.h"
+#include "util/Debug.h"
+
+#include <chrono>
+
+DebounceTimer::DebounceTimer()
+{
+    m_bStop = false;
+
+    pthread_create(&m_thread, NULL, DebounceTimer::run_internal, (void*)this);
+}
+
+DebounceTimer::~DebounceTimer()
+{
+    if(m_thread != 0)
+        this->kill();
+}
+
+/**
+ * @brief DebounceTimer::kill stops this thread. Inputs which are still scheduled are not called anymore.
+ */
+void DebounceTimer::kill()
+{
+    if(m_thread == 0)
+        return;
+
+    m_mutex.lock();
+    m_bStop = true;
+    m_cond.notify_one();
+    m_mutex.unlock();
+
+    pthread_join(m_thread, NULL);
+    m_thread = 0;
+}
+
+/**
+ * @brief DebounceTimer::schedule calls HWInputButton::debounceExpired of hw as soon as time has been reached.
+ * If hw is already scheduled, the old time is replaced.
+ * @param hw
+ * @param time on CLOCK_MONOTONIC
+ */
+void DebounceTimer::schedule(HWInputButton* hw, timespec time)
+{
+    Element element;
+    element.hw = hw;
+    element.time = time;
+
+    m_mutex.lock();
+
+    if( !m_queue.modify(element) )
+        m_queue.push(element);
+
+    m_cond.notify_one();
+    m_mutex.unlock();
+}
+
+/**
+ * @brief DebounceTimer::cancel removes hw from the queue, so that it is not called anymore
+ * @param hw
+ */
+void DebounceTimer::cancel(HWInputButton* hw)
+{
+    Element element;
+    element.hw = hw;
+
+    m_mutex.lock();
+    m_queue.remove(element);
+    m_mutex.unlock();
+}
+
+void DebounceTimer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while(!m_bStop)
+    {
+        if(m_queue.empty())
+        {
+            m_cond.wait(lock);
+            continue;
+        }
+
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+        Element element = m_queue.top();
+
+        // if this is true we have to sleep first, we might get woken up earlier by a new element
+        if( timespecGreaterThan(element.time, currentTime) )
+        {
+            timespec waitTime = timespecSub(element.time, currentTime);
+            m_cond.wait_for(lock, std::chrono::seconds(waitTime.tv_sec) + std::chrono::nanoseconds(waitTime.tv_nsec));
+            continue;
+        }
+
+        m_queue.pop();
+
+        // the input may schedule itself again while it is called
+        lock.unlock();
+        element.hw->debounceExpired();
+        lock.lock();
+    }
+}
+
+void* DebounceTimer::run_internal(void* arg)
+{
+    DebounceTimer* thread = (DebounceTimer*)arg;
+    thread->run();
+
+    return NULL;
+}
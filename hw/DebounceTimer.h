@@ -0,0 +1,56 @@
+#ifndef DEBOUNCETIMER_H
+#define DEBOUNCETIMER_H
+
+#include <pthread.h>
+#include <mutex>
+#include <condition_variable>
+#include <util/Time.h>
+#include <util/PriorityQueue.h>
+
+class HWInputButton;
+
+/**
+ * @brief The DebounceTimer class is shared by all inputs which are debounced.
+ * An input schedules itself every time its raw value changes, and is called back by DebounceTimer
+ * as soon as the raw value has been stable for the configured time.
+ */
+class DebounceTimer
+{
+public:
+    DebounceTimer();
+    ~DebounceTimer();
+
+    void kill();
+
+    void schedule(HWInputButton* hw, timespec time);
+    void cancel(HWInputButton* hw);
+
+private:
+    struct Element
+    {
+        HWInputButton* hw;
+        timespec time;
+
+        bool operator< (const Element& rhs)
+        {
+            return timespecGreaterThan(this->time, rhs.time);
+        }
+
+        bool operator == (const Element& rhs)
+        {
+            // every input can only be scheduled once
+            return this->hw == rhs.hw;
+        }
+    };
+
+    static void* run_internal(void* arg);
+    void run();
+
+    pthread_t m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_bStop;
+    PriorityQueue<Element> m_queue;
+};
+
+#endif // DEBOUNCETIMER_H
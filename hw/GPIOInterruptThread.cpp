@@ -1,29 +1,124 @@
 
 #include "hw/GPIOInterruptThread.h"
 #include "hw/HWInputButtonGPIO.h"
+#include "util/Config.h"
 #include "util/Debug.h"
+#include "util/Time.h"
 
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
 
-GPIOInterruptThread::GPIOInterruptThread()
+#ifdef USE_GPIO_CHARDEV
+#include <linux/gpio.h>
+
+// the v2 interface is only available since linux 5.10
+#ifndef GPIO_V2_GET_LINE_IOCTL
+#undef USE_GPIO_CHARDEV
+#endif
+#endif
+
+// the GPIO pins of the raspberry are all on the first chip, their offsets are the BCM numbers
+#define GPIO_CHIP_PATH      "/dev/gpiochip0"
+#define GPIO_CONSUMER       "RaspExt"
+// maximum number of edge events which are read at once from one line request
+#define GPIO_EVENT_BATCH    16
+// maximum number of ready file descriptors handled per wakeup
+#define GPIO_MAX_EVENTS     16
+// the lines are requested again this long after the last input has been added or removed,
+// so that all inputs added during initialization end up in one request
+#define GPIO_REBUILD_DELAY_MS   20
+
+/**
+ * @brief GPIOInterruptThread::GPIOInterruptThread creates and starts the thread
+ * @param priority if greater than 0, the thread runs with SCHED_FIFO and this priority
+ * @param cpu if not -1, the thread only runs on this cpu
+ */
+GPIOInterruptThread::GPIOInterruptThread(int priority, int cpu)
 {
     m_epfd = epoll_create(2);
 
     if(m_epfd < 0)
         LOG_ERROR(Logger::Misc, "epoll_create has failed");
 
+    m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if(m_eventFd < 0)
+        LOG_ERROR(Logger::Misc, "eventfd has failed");
+
+    // the eventfd is the only file descriptor without a pointer
+    struct epoll_event event;
+    event.data.ptr = NULL;
+    event.events = EPOLLIN;
+
+    if(epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_eventFd, &event) != 0)
+        LOG_ERROR(Logger::Misc, "epoll_ctl has failed");
+
     m_bStop = false;
+    m_chipFd = -1;
+    m_linesDirty = false;
+
+#ifdef USE_GPIO_CHARDEV
+    m_chipFd = open(GPIO_CHIP_PATH, O_RDONLY | O_CLOEXEC);
+
+    if(m_chipFd >= 0)
+    {
+        // check if the kernel knows the v2 interface, otherwise we use sysfs
+        struct gpio_v2_line_info info;
+        memset(&info, 0, sizeof(info));
+        info.offset = 0;
+
+        if(ioctl(m_chipFd, GPIO_V2_GET_LINEINFO_IOCTL, &info) != 0)
+        {
+            close(m_chipFd);
+            m_chipFd = -1;
+        }
+    }
+
+    if(m_chipFd < 0)
+        LOG_WARN(Logger::Misc, "GPIO character device is not available, falling back to sysfs");
+#endif
 
     pthread_mutex_init(&m_mutex, NULL);
 
     pthread_create(&m_thread, NULL, GPIOInterruptThread::run_internal, (void*)this);
+
+    if(priority > 0)
+    {
+        struct sched_param param;
+        param.sched_priority = priority;
+
+        int ret = pthread_setschedparam(m_thread, SCHED_FIFO, &param);
+        if(ret != 0)
+            LOG_WARN(Logger::Misc, "Could not set priority of GPIO thread: %s", strerror(ret));
+    }
+
+    if(cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+
+        int ret = pthread_setaffinity_np(m_thread, sizeof(set), &set);
+        if(ret != 0)
+            LOG_WARN(Logger::Misc, "Could not set cpu of GPIO thread: %s", strerror(ret));
+    }
 }
 
 GPIOInterruptThread::~GPIOInterruptThread()
 {
+    this->releaseLineRequests();
+
+    if(m_chipFd >= 0)
+        close(m_chipFd);
+
+    close(m_eventFd);
     close(this->m_epfd);
     pthread_mutex_destroy(&m_mutex);
 }
@@ -35,11 +130,40 @@ void GPIOInterruptThread::kill()
     m_bStop = true;
     pthread_mutex_unlock(&m_mutex);
 
+    this->wakeup();
+
     pthread_join(m_thread, NULL);
 }
 
+/**
+ * @brief GPIOInterruptThread::wakeup wakes the thread up, so that it checks if it should stop or has to request its lines again
+ */
+void GPIOInterruptThread::wakeup()
+{
+    if(eventfd_write(m_eventFd, 1) != 0)
+        LOG_WARN(Logger::Misc, "Could not wake up GPIO thread");
+}
+
+/**
+ * @brief GPIOInterruptThread::addGPIOInterrupt adds an input which is informed about edges on its pin.
+ * When using the character device, the line is requested by the thread shortly after, together with all other inputs
+ * which were added in the meantime. The input then gets its initial value.
+ * @param hw
+ */
 void GPIOInterruptThread::addGPIOInterrupt(HWInputButtonGPIO *hw)
 {
+    if(this->useChardev())
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_listChardev.push_back(hw);
+        m_linesDirty = true;
+        clock_gettime(CLOCK_MONOTONIC, &m_dirtyTime);
+        pthread_mutex_unlock(&m_mutex);
+
+        this->wakeup();
+        return;
+    }
+
     int fd = hw->getFileHandle();
 
     // invalid file handle
@@ -49,8 +173,11 @@ void GPIOInterruptThread::addGPIOInterrupt(HWInputButtonGPIO *hw)
         return;
     }
 
+    pthread_mutex_lock(&m_mutex);
+    m_listSysfs.push_back(hw);
+    pthread_mutex_unlock(&m_mutex);
+
     struct epoll_event event;
-    event.data.fd = fd;
     event.data.ptr = hw;
     event.events = EPOLLPRI;
 
@@ -59,8 +186,32 @@ void GPIOInterruptThread::addGPIOInterrupt(HWInputButtonGPIO *hw)
         LOG_ERROR(Logger::Misc, "epoll_ctl has failed");
 }
 
+/**
+ * @brief GPIOInterruptThread::removeGPIOInterrupt removes an input. After this call, the input is not used by this thread anymore.
+ * @param hw
+ */
 void GPIOInterruptThread::removeGPIOInterrupt(HWInputButtonGPIO *hw)
 {
+    if(this->useChardev())
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_listChardev.remove(hw);
+
+        // the line itself is released by the thread, until then its events are ignored
+        for(std::list<LineRequest*>::iterator it = m_listLineRequests.begin(); it != m_listLineRequests.end(); it++)
+        {
+            for(unsigned int i = 0; i < (*it)->lines.size(); i++)
+                (*it)->lines[i].remove(hw);
+        }
+
+        m_linesDirty = true;
+        clock_gettime(CLOCK_MONOTONIC, &m_dirtyTime);
+        pthread_mutex_unlock(&m_mutex);
+
+        this->wakeup();
+        return;
+    }
+
     int fd = hw->getFileHandle();
 
     // invalid file handle
@@ -70,35 +221,283 @@ void GPIOInterruptThread::removeGPIOInterrupt(HWInputButtonGPIO *hw)
         return;
     }
 
+    // events which have already been returned by epoll_wait are ignored by the thread, as hw is not in the list anymore
+    pthread_mutex_lock(&m_mutex);
+    m_listSysfs.remove(hw);
+    pthread_mutex_unlock(&m_mutex);
+
     int ret = epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, NULL);
     if(ret != 0)
         LOG_ERROR(Logger::Misc, "epoll_ctl has failed");
 }
 
+/**
+ * @brief GPIOInterruptThread::releaseLineRequests releases all lines of the character device.
+ * Must be called with m_mutex held
+ */
+void GPIOInterruptThread::releaseLineRequests()
+{
+    for(std::list<LineRequest*>::iterator it = m_listLineRequests.begin(); it != m_listLineRequests.end(); it++)
+    {
+        // closing the file descriptor removes it from epoll as well
+        close((*it)->fd);
+        delete (*it);
+    }
+
+    m_listLineRequests.clear();
+}
+
+/**
+ * @brief GPIOInterruptThread::rebuildLineRequests requests all lines which are currently used.
+ * A line request is fixed once it has been made, so all requests are released and made again.
+ * Inputs sharing a pin share one line. As one request can only contain a limited number of lines, more than one may be needed.
+ * Must be called with m_mutex held
+ */
+void GPIOInterruptThread::rebuildLineRequests()
+{
+#ifdef USE_GPIO_CHARDEV
+    this->releaseLineRequests();
+    m_linesDirty = false;
+
+    LineRequest* req = NULL;
+
+    for(std::list<HWInputButtonGPIO*>::iterator it = m_listChardev.begin(); it != m_listChardev.end(); it++)
+    {
+        unsigned int offset = (*it)->getPin();
+
+        // check if there is already a request containing this line
+        bool found = false;
+        for(std::list<LineRequest*>::iterator itReq = m_listLineRequests.begin(); itReq != m_listLineRequests.end() && !found; itReq++)
+        {
+            for(unsigned int i = 0; i < (*itReq)->offsets.size(); i++)
+            {
+                if((*itReq)->offsets[i] == offset)
+                {
+                    (*itReq)->lines[i].push_back(*it);
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if(found)
+            continue;
+
+        if(req == NULL || req->offsets.size() >= GPIO_V2_LINES_MAX)
+        {
+            req = new LineRequest();
+            req->fd = -1;
+            m_listLineRequests.push_back(req);
+        }
+
+        req->offsets.push_back(offset);
+        req->lines.push_back(std::list<HWInputButtonGPIO*>(1, *it));
+    }
+
+    std::list<LineRequest*>::iterator it = m_listLineRequests.begin();
+    while(it != m_listLineRequests.end())
+    {
+        struct gpio_v2_line_request request;
+        memset(&request, 0, sizeof(request));
+
+        for(unsigned int i = 0; i < (*it)->offsets.size(); i++)
+            request.offsets[i] = (*it)->offsets[i];
+
+        strncpy(request.consumer, GPIO_CONSUMER, sizeof(request.consumer) - 1);
+        request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        request.num_lines = (*it)->offsets.size();
+
+        if(ioctl(m_chipFd, GPIO_V2_GET_LINE_IOCTL, &request) != 0)
+        {
+            LOG_WARN(Logger::Misc, "Could not request %u GPIO lines: %s", request.num_lines, strerror(errno));
+
+            delete (*it);
+            it = m_listLineRequests.erase(it);
+            continue;
+        }
+
+        (*it)->fd = request.fd;
+
+        struct epoll_event event;
+        event.data.ptr = (*it);
+        event.events = EPOLLIN;
+
+        if(epoll_ctl(m_epfd, EPOLL_CTL_ADD, (*it)->fd, &event) != 0)
+            LOG_ERROR(Logger::Misc, "epoll_ctl has failed");
+
+        // edges before this point in time are lost, so read the current state
+        this->readLineValues(*it);
+
+        it++;
+    }
+#endif
+}
+
+/**
+ * @brief GPIOInterruptThread::readLineValues reads the current value of all lines of a request and updates the inputs.
+ * Must be called with m_mutex held
+ * @param req
+ */
+void GPIOInterruptThread::readLineValues(LineRequest* req)
+{
+#ifdef USE_GPIO_CHARDEV
+    struct gpio_v2_line_values values;
+    memset(&values, 0, sizeof(values));
+
+    if(req->offsets.size() >= 64)
+        values.mask = ~0ULL;
+    else
+        values.mask = (1ULL << req->offsets.size()) - 1;
+
+    if(ioctl(req->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) != 0)
+    {
+        LOG_WARN(Logger::Misc, "Could not read GPIO values: %s", strerror(errno));
+        return;
+    }
+
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    for(unsigned int i = 0; i < req->offsets.size(); i++)
+    {
+        bool value = (values.bits & (1ULL << i)) != 0;
+
+        for(std::list<HWInputButtonGPIO*>::iterator it = req->lines[i].begin(); it != req->lines[i].end(); it++)
+            (*it)->setGPIOValue(value, currentTime);
+    }
+#endif
+}
+
+/**
+ * @brief GPIOInterruptThread::handleLineEvents reads all pending edge events of a line request at once
+ * and informs the inputs of their pins. The kernel timestamp of the edge is passed on to the input.
+ * Must be called with m_mutex held
+ * @param req
+ */
+void GPIOInterruptThread::handleLineEvents(LineRequest* req)
+{
+#ifdef USE_GPIO_CHARDEV
+    struct gpio_v2_line_event events[GPIO_EVENT_BATCH];
+
+    ssize_t ret = read(req->fd, events, sizeof(events));
+    if(ret < 0)
+    {
+        if(errno != EAGAIN && errno != EINTR)
+            LOG_WARN(Logger::Misc, "Could not read GPIO events: %s", strerror(errno));
+
+        return;
+    }
+
+    unsigned int num = ret / sizeof(struct gpio_v2_line_event);
+
+    for(unsigned int e = 0; e < num; e++)
+    {
+        bool value = events[e].id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+
+        // the timestamp is taken from CLOCK_MONOTONIC by default
+        timespec time;
+        time.tv_sec = events[e].timestamp_ns / 1000000000ULL;
+        time.tv_nsec = events[e].timestamp_ns % 1000000000ULL;
+
+        for(unsigned int i = 0; i < req->offsets.size(); i++)
+        {
+            if(req->offsets[i] != events[e].offset)
+                continue;
+
+            for(std::list<HWInputButtonGPIO*>::iterator it = req->lines[i].begin(); it != req->lines[i].end(); it++)
+                (*it)->setGPIOValue(value, time);
+
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief GPIOInterruptThread::dispatch handles one ready file descriptor of epoll.
+ * Must be called with m_mutex held
+ * @param ptr the pointer which was given to epoll for this file descriptor
+ */
+void GPIOInterruptThread::dispatch(void* ptr)
+{
+    if(ptr == NULL)
+    {
+        // we have been woken up, the reason is checked by the caller
+        eventfd_t value;
+        eventfd_read(m_eventFd, &value);
+        return;
+    }
+
+    if(this->useChardev())
+    {
+        this->handleLineEvents((LineRequest*)ptr);
+        return;
+    }
+
+    HWInputButtonGPIO* hw = (HWInputButtonGPIO*)ptr;
+
+    // the input may have been removed after epoll_wait has returned
+    for(std::list<HWInputButtonGPIO*>::iterator it = m_listSysfs.begin(); it != m_listSysfs.end(); it++)
+    {
+        if((*it) == hw)
+        {
+            hw->handleInterrupt();
+            break;
+        }
+    }
+}
+
 void GPIOInterruptThread::run()
 {
-#define MAX_EVENTS  1
-    struct epoll_event* events = new struct epoll_event[MAX_EVENTS];
+    struct epoll_event events[GPIO_MAX_EVENTS];
+
+    // as long as nothing happens, we sleep
+    int timeout = -1;
 
     while(1)
     {
-        // wait for 50 miliseconds
-        int no = epoll_wait(this->m_epfd, events, MAX_EVENTS, 50);
+        int no = epoll_wait(this->m_epfd, events, GPIO_MAX_EVENTS, timeout);
+
+        if(no < 0)
+        {
+            if(errno != EINTR)
+                LOG_ERROR(Logger::Misc, "epoll_wait has failed: %s", strerror(errno));
 
-        if(no != 0)
-            ((HWInputButtonGPIO*)events[0].data.ptr)->handleInterrupt();
+            continue;
+        }
 
         pthread_mutex_lock(&m_mutex);
+
+        for(int i = 0; i < no; i++)
+            this->dispatch(events[i].data.ptr);
+
         // we want to stop
         if(m_bStop)
         {
-            // we clean up and exit the loop
-            delete events;
-
             pthread_mutex_unlock(&m_mutex);
             break;
         }
 
+        // inputs have been added or removed, wait a bit for more before we request the lines again
+        timeout = -1;
+        if(m_linesDirty)
+        {
+            timespec currentTime;
+            clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+            timespec rebuildTime = timspecAddMiliseconds(m_dirtyTime, GPIO_REBUILD_DELAY_MS);
+
+            if(timespecGreaterThan(rebuildTime, currentTime))
+            {
+                timespec wait = timespecSub(rebuildTime, currentTime);
+                timeout = wait.tv_sec * 1000 + (wait.tv_nsec + 999999) / 1000000;
+            }
+            else
+            {
+                this->rebuildLineRequests();
+            }
+        }
+
         pthread_mutex_unlock(&m_mutex);
     }
 }
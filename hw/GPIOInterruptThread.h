@@ -2,18 +2,29 @@
 #define GPIOINTERRUPTTHREAD_H
 
 #include <pthread.h>
+#include <time.h>
+#include <list>
+#include <vector>
 
 class HWInputButtonGPIO;
 
+/**
+ * @brief The GPIOInterruptThread class waits for edges on the GPIO inputs of the raspberry.
+ * If the kernel supports the GPIO character device, all inputs are requested in as few line requests as possible
+ * and the edge events are read in batches including their kernel timestamp.
+ * Otherwise the sysfs interface is used, where every input has its own file.
+ */
 class GPIOInterruptThread
 {
 public:
-    GPIOInterruptThread();
+    GPIOInterruptThread(int priority = 0, int cpu = -1);
     ~GPIOInterruptThread();
 
     void addGPIOInterrupt(HWInputButtonGPIO* hw);
     void removeGPIOInterrupt(HWInputButtonGPIO *hw);
 
+    bool useChardev() const { return m_chipFd >= 0;}
+
     void kill();
 
 private:
@@ -21,11 +32,37 @@ private:
 
     void run();
 
+    struct LineRequest
+    {
+        int fd;
+        std::vector<unsigned int> offsets;
+        std::vector< std::list<HWInputButtonGPIO*> > lines; // inputs of each line, same order as offsets
+    };
+
+    void wakeup();
+    void dispatch(void* ptr);
+
+    void rebuildLineRequests();
+    void releaseLineRequests();
+    void readLineValues(LineRequest* req);
+    void handleLineEvents(LineRequest* req);
+
     pthread_t m_thread;
     pthread_mutex_t m_mutex;
     bool m_bStop;
 
     int m_epfd;
+    int m_eventFd; // wakes the thread up for shutdown and reconfiguration
+
+    // only used for sysfs, protected by m_mutex
+    std::list<HWInputButtonGPIO*> m_listSysfs;
+
+    // only used for the character device, all protected by m_mutex
+    int m_chipFd;
+    std::list<HWInputButtonGPIO*> m_listChardev;
+    std::list<LineRequest*> m_listLineRequests;
+    bool m_linesDirty;
+    timespec m_dirtyTime; // last time an input has been added or removed
 };
 
 #endif // GPIOINTERRUPTTHREAD_H
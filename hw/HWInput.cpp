@@ -6,6 +6,7 @@
 #include "hw/HWInputFader.h"
 
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomDocument>
 
@@ -29,20 +30,18 @@ void HWInput::deinit(ConfigManager *config)
 
 }
 
-HWInput* HWInput::load(QDomElement *root)
+HWInput* HWInput::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     HWInput* hw = NULL;
     std::string name;
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("type") == 0)
+        if(elem->tag == XmlTag::Type)
         {
             pi_assert(hw == NULL);
 
-            HWInputType type = StringToHWInputType(elem.text().toStdString());
+            HWInputType type = StringToHWInputType(elem->text.toStdString());
 
             switch(type)
             {
@@ -54,12 +53,10 @@ HWInput* HWInput::load(QDomElement *root)
                 break;
             }
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
+        else if(elem->tag == XmlTag::Name)
         {
-            name = elem.text().toStdString();
+            name = elem->text.toStdString();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     if(hw != NULL)
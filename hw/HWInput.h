@@ -9,6 +9,7 @@ class HWInputListener;
 
 class QDomElement;
 class QDomDocument;
+class XmlElement;
 
 
 /**
@@ -48,7 +49,7 @@ public:
     virtual bool init(ConfigManager* config);
     virtual void deinit(ConfigManager* config);
 
-    static HWInput* load(QDomElement* root);
+    static HWInput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     virtual HWInputType getType() const = 0;
@@ -4,48 +4,96 @@
 #include "hw/HWInputButtonI2C.h"
 #include "hw/HWInputButtonBtGPIO.h"
 #include "hw/HWInputButtonBt.h"
+#include "hw/DebounceTimer.h"
+#include "ConfigManager.h"
 
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
 HWInputButton::HWInputButton()
 {
     m_value = false;
+
+    m_debounceMs = 0;
+    m_debounceTimer = NULL;
+    m_rawValue = false;
+    m_pendingEdges = 0;
+    m_suppressedEdges = 0;
+}
+
+/**
+ * @brief HWInputButton::init must be called by all subclasses, it sets up debouncing if it is enabled for this input.
+ * @param config
+ * @return
+ */
+bool HWInputButton::init(ConfigManager* config)
+{
+    m_rawValue = m_value;
+    m_pendingEdges = 0;
+
+    if(m_debounceMs != 0)
+        m_debounceTimer = config->getDebounceTimer();
+
+    return true;
+}
+
+void HWInputButton::deinit(ConfigManager* config)
+{
+    if(m_debounceTimer != NULL)
+    {
+        m_debounceTimer->cancel(this);
+        m_debounceTimer = NULL;
+    }
+
+    m_mutexDebounce.lock();
+    unsigned int suppressed = m_suppressedEdges;
+    m_mutexDebounce.unlock();
+
+    if(suppressed != 0)
+        LOG_DEBUG(Logger::Misc, "Input %s has suppressed %u edges while debouncing", m_name.c_str(), suppressed);
 }
 
-HWInput* HWInputButton::load(QDomElement* root)
+HWInput* HWInputButton::load(XmlElement* root)
 {
     HWInputButton* hw = NULL;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("hwtype") == 0)
+        if(elem->tag == XmlTag::HWType)
         {
-            if(elem.text().toLower().compare("gpio") == 0)
+            if(elem->text.compare("gpio", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWInputButton*)HWInputButtonGPIO::load(root);
             }
-            else if(elem.text().toLower().compare("i2c") == 0)
+            else if(elem->text.compare("i2c", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWInputButton*)HWInputButtonI2C::load(root);
             }
-            else if(elem.text().toLower().compare("btgpio") == 0)
+            else if(elem->text.compare("btgpio", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWInputButton*)HWInputButtonBtGPIO::load(root);
             }
-            else if(elem.text().toLower().compare("bt") == 0)
+            else if(elem->text.compare("bt", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWInputButton*)HWInputButtonBt::load(root);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
     if(hw == NULL)
         hw =  new HWInputButton();
 
+    // debouncing is the same for all kinds of buttons
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
+    {
+        if(elem->tag == XmlTag::Debounce)
+        {
+            hw->m_debounceMs = elem->text.toInt();
+        }
+    }
+
     return hw;
 }
 
@@ -59,6 +107,15 @@ QDomElement HWInputButton::save(QDomElement* root, QDomDocument* document)
 
     input.appendChild(type);
 
+    if(m_debounceMs != 0)
+    {
+        QDomElement debounce = document->createElement("debounce");
+        QDomText debounceText = document->createTextNode(QString::number(m_debounceMs));
+        debounce.appendChild(debounceText);
+
+        input.appendChild(debounce);
+    }
+
     return input;
 }
 
@@ -80,3 +137,75 @@ bool HWInputButton::getValue() const
 {
     return m_value;
 }
+
+/**
+ * @brief HWInputButton::setRawValue is called by subclasses with the value read from the hardware.
+ * If debouncing is enabled, the value is only taken over after it has been stable for the configured time,
+ * otherwise listeners are informed immediately if the value has changed.
+ * @param value
+ */
+void HWInputButton::setRawValue(bool value)
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    this->setRawValue(value, currentTime);
+}
+
+/**
+ * @brief HWInputButton::setRawValue see HWInputButton::setRawValue
+ * @param value
+ * @param time the time at which the hardware has changed, on CLOCK_MONOTONIC
+ */
+void HWInputButton::setRawValue(bool value, timespec time)
+{
+    if(m_debounceTimer == NULL)
+    {
+        if(m_value != value)
+        {
+            m_value = value;
+            this->inputChanged();
+        }
+
+        return;
+    }
+
+    m_mutexDebounce.lock();
+
+    // polled inputs report the same value over and over again
+    if(m_rawValue == value)
+    {
+        m_mutexDebounce.unlock();
+        return;
+    }
+
+    m_rawValue = value;
+    m_pendingEdges++;
+
+    m_mutexDebounce.unlock();
+
+    // every edge restarts the timer
+    m_debounceTimer->schedule(this, timspecAddMiliseconds(time, m_debounceMs));
+}
+
+/**
+ * @brief HWInputButton::debounceExpired is called by the DebounceTimer as soon as the raw value has been stable long enough.
+ */
+void HWInputButton::debounceExpired()
+{
+    m_mutexDebounce.lock();
+
+    bool changed = m_rawValue != m_value && !m_bOverride;
+
+    // all edges which did not make it are suppressed, e.g. if the button has bounced back to its old value
+    m_suppressedEdges += changed ? m_pendingEdges - 1 : m_pendingEdges;
+    m_pendingEdges = 0;
+
+    if(changed)
+        m_value = m_rawValue;
+
+    m_mutexDebounce.unlock();
+
+    if(changed)
+        this->inputChanged();
+}
@@ -3,20 +3,46 @@
 
 #include "hw/HWInput.h"
 
+#include <mutex>
+#include <time.h>
+
+class DebounceTimer;
+
 class HWInputButton : public HWInput
 {
 public:
     HWInputButton();
 
-    static HWInput* load(QDomElement* root);
+    virtual bool init(ConfigManager* config);
+    virtual void deinit(ConfigManager* config);
+
+    static HWInput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     bool getValue() const;
     bool setOverrideValue(bool v);
 
     HWInputType getType() const { return Button;}
+
+    unsigned int getDebounceMs() const { return m_debounceMs;}
+    void setDebounceMs(unsigned int ms) { m_debounceMs = ms;}
+
+    void debounceExpired();
 protected:
+    void setRawValue(bool value);
+    void setRawValue(bool value, timespec time);
+
     bool m_value;
+
+private:
+    // a new value is only taken over, if the raw value has been stable for this time. 0 means no debouncing
+    unsigned int m_debounceMs;
+    DebounceTimer* m_debounceTimer;
+
+    std::mutex m_mutexDebounce;
+    bool m_rawValue;
+    unsigned int m_pendingEdges; // raw edges since the timer was started
+    unsigned int m_suppressedEdges; // raw edges which did not lead to a change of the value
 };
 
 #endif // HWINPUTBUTTON_H
@@ -3,6 +3,7 @@
 #include "ConfigManager.h"
 #include "hw/BTThread.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -12,26 +13,24 @@ HWInputButtonBt::HWInputButtonBt()
     this->m_port = -1;
 }
 
-HWInput* HWInputButtonBt::load(QDomElement *root)
+HWInput* HWInputButtonBt::load(XmlElement* root)
 {
     HWInputButtonBt* hw = new HWInputButtonBt();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("port") == 0 )
+        else if( elem->tag == XmlTag::Port )
         {
-            hw->m_port = elem.text().toInt();
+            hw->m_port = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("btboard") == 0 )
+        else if( elem->tag == XmlTag::BTBoard )
         {
-            hw->m_btName = elem.text().toStdString();
+            hw->m_btName = elem->text.toStdString();
         }
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -77,6 +76,8 @@ QDomElement HWInputButtonBt::save(QDomElement* root, QDomDocument* document)
 
 bool HWInputButtonBt::init(ConfigManager* config)
 {
+    HWInputButton::init(config);
+
     BTThread* btThread = config->getBTThreadByName(m_btName);
 
     // if we cannot find the bluetooth board, it does not exist and we should fail
@@ -98,6 +99,8 @@ void HWInputButtonBt::deinit(ConfigManager* config)
 
     if(btThread != NULL)
         btThread->removeInputPCF8575(this, m_slaveAddress);
+
+    HWInputButton::deinit(config);
 }
 
 void HWInputButtonBt::onInputPolled(bool state)
@@ -106,10 +109,5 @@ void HWInputButtonBt::onInputPolled(bool state)
     if(this->m_bOverride)
         return;
 
-    // only to something, if the input has changed
-    if( m_value != state )
-    {
-        m_value = state;
-        this->inputChanged();
-    }
+    this->setRawValue(state);
 }
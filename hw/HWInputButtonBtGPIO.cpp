@@ -3,6 +3,7 @@
 #include "ConfigManager.h"
 #include "hw/BTThread.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -13,27 +14,24 @@ HWInputButtonBtGPIO::HWInputButtonBtGPIO()
     m_btThread = NULL;
 }
 
-HWInput* HWInputButtonBtGPIO::load(QDomElement *root)
+HWInput* HWInputButtonBtGPIO::load(XmlElement* root)
 {
     HWInputButtonBtGPIO* hw = new HWInputButtonBtGPIO();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("pingroup") == 0 )
+        if( elem->tag == XmlTag::PinGroup )
         {
-            hw->m_pinGroup = elem.text().toInt();
+            hw->m_pinGroup = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("pin") == 0 )
+        else if( elem->tag == XmlTag::Pin )
         {
-            hw->m_pin = elem.text().toInt();
+            hw->m_pin = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("btboard") == 0 )
+        else if( elem->tag == XmlTag::BTBoard )
         {
-            hw->m_btName = elem.text().toStdString();
+            hw->m_btName = elem->text.toStdString();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -79,6 +77,8 @@ QDomElement HWInputButtonBtGPIO::save(QDomElement* root, QDomDocument* document)
 
 bool HWInputButtonBtGPIO::init(ConfigManager* config)
 {
+    HWInputButton::init(config);
+
     m_btThread = config->getBTThreadByName(m_btName);
 
     // if we cannot find the bluetooth board, it does not exist and we should fail
@@ -102,14 +102,11 @@ void HWInputButtonBtGPIO::deinit(ConfigManager* config)
 
         m_btThread = NULL;
     }
+
+    HWInputButton::deinit(config);
 }
 
 void HWInputButtonBtGPIO::setValue(bool value)
 {
-    // only do something if the value has really changed
-    if(m_value != value)
-    {
-        m_value = value;
-        this->inputChanged();
-    }
+    this->setRawValue(value);
 }
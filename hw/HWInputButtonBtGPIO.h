@@ -16,7 +16,7 @@ public:
     bool init(ConfigManager* config);
     void deinit(ConfigManager* config);
 
-    static HWInput* load(QDomElement* root);
+    static HWInput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     void setValue(bool value);
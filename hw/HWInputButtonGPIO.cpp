@@ -13,6 +13,7 @@
 #include <stdlib.h>
 
 #include "util/Config.h"
+#include "util/XmlElement.h"
 
 HWInputButtonGPIO::HWInputButtonGPIO()
 {
@@ -26,6 +27,32 @@ bool HWInputButtonGPIO::init(ConfigManager* config)
     // if the pin number is still -1, we do not have a valid pin number
     pi_assert(m_pin != -1);
 
+    HWInputButton::init(config);
+
+    GPIOInterruptThread* thread = config->getGPIOThread();
+
+    // with the character device, the thread requests the line itself
+    if( !thread->useChardev() )
+    {
+        if( !this->initSysfs() )
+            return false;
+
+        this->handleInterrupt();
+    }
+
+    thread->addGPIOInterrupt(this);
+#endif
+
+    return true;
+}
+
+/**
+ * @brief HWInputButtonGPIO::initSysfs exports our pin to sysfs and opens its value file
+ * @return
+ */
+bool HWInputButtonGPIO::initSysfs()
+{
+#ifdef USE_GPIO
     // export it to sysfs
     int fd = open("/sys/class/gpio/export", O_WRONLY);
     if(fd < 0)
@@ -88,10 +115,6 @@ bool HWInputButtonGPIO::init(ConfigManager* config)
         LOG_WARN(Logger::Misc, "Could not open sysfs");
         return false;
     }
-
-    this->handleInterrupt();
-
-    config->getGPIOThread()->addGPIOInterrupt(this);
 #endif
 
     return true;
@@ -100,13 +123,16 @@ bool HWInputButtonGPIO::init(ConfigManager* config)
 void HWInputButtonGPIO::deinit(ConfigManager* config)
 {
 #ifdef USE_GPIO
-    pi_assert(m_fd >= 0);
-
     config->getGPIOThread()->removeGPIOInterrupt(this);
 
-    close(m_fd);
-    m_fd = -1;
+    if(m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
 #endif
+
+    HWInputButton::deinit(config);
 }
 
 bool HWInputButtonGPIO::handleInterrupt()
@@ -117,30 +143,33 @@ bool HWInputButtonGPIO::handleInterrupt()
     read(m_fd, buf, 3);
     lseek(m_fd, 0, SEEK_SET);
 
-    if(buf[0] == '0')
-        m_value = 0;
-    else
-        m_value = 1;
-
-    this->inputChanged();
+    this->setRawValue(buf[0] != '0');
 #endif
 
     return true;
 }
 
-HWInput* HWInputButtonGPIO::load(QDomElement* root)
+/**
+ * @brief HWInputButtonGPIO::setGPIOValue is called by the GPIOInterruptThread if the character device is used.
+ * As we know the exact time of the edge, debouncing starts from there and not from the time the event was read.
+ * @param value
+ * @param time the time of the edge
+ */
+void HWInputButtonGPIO::setGPIOValue(bool value, timespec time)
+{
+    this->setRawValue(value, time);
+}
+
+HWInput* HWInputButtonGPIO::load(XmlElement* root)
 {
     HWInputButtonGPIO* hw = new HWInputButtonGPIO();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("gpiopin") == 0)
+        if(elem->tag == XmlTag::GPIOPin)
         {
-            hw->m_pin = elem.text().toInt();
+            hw->m_pin = elem->text.toInt();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     if(hw->m_pin == -1)
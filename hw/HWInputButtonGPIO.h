@@ -3,6 +3,8 @@
 
 #include "hw/HWInputButton.h"
 
+#include <time.h>
+
 class HWInputButtonGPIO : public HWInputButton
 {
 public:
@@ -11,14 +13,18 @@ public:
     bool init(ConfigManager* config);
     void deinit(ConfigManager* config);
 
-    static HWInput* load(QDomElement* root);
+    static HWInput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     bool handleInterrupt();
+    void setGPIOValue(bool value, timespec time);
 
     int getFileHandle() const { return m_fd;}
+    int getPin() const { return m_pin;}
 
 private:
+    bool initSysfs();
+
     int m_fd;
     int m_pin;
 };
@@ -3,6 +3,7 @@
 #include "ConfigManager.h"
 #include "hw/I2CThread.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -12,22 +13,20 @@ HWInputButtonI2C::HWInputButtonI2C()
     this->m_port = -1;
 }
 
-HWInput* HWInputButtonI2C::load(QDomElement *root)
+HWInput* HWInputButtonI2C::load(XmlElement* root)
 {
     HWInputButtonI2C* hw = new HWInputButtonI2C();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("port") == 0 )
+        else if( elem->tag == XmlTag::Port )
         {
-            hw->m_port = elem.text().toInt();
+            hw->m_port = elem->text.toInt();
         }
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -67,6 +66,8 @@ QDomElement HWInputButtonI2C::save(QDomElement* root, QDomDocument* document)
 
 bool HWInputButtonI2C::init(ConfigManager* config)
 {
+    HWInputButton::init(config);
+
     I2CThread* i2c = config->getI2CThread();
     i2c->addInputPCF8575(this, m_slaveAddress, m_port);
 
@@ -77,6 +78,8 @@ void HWInputButtonI2C::deinit(ConfigManager* config)
 {
     I2CThread* i2c = config->getI2CThread();
     i2c->removeInputPCF8575(this, m_slaveAddress);
+
+    HWInputButton::deinit(config);
 }
 
 void HWInputButtonI2C::onInputPolled(bool state)
@@ -85,12 +88,7 @@ void HWInputButtonI2C::onInputPolled(bool state)
     if(this->m_bOverride)
         return;
 
-    // only to something, if the input has changed
-    if( m_value != state )
-    {
-        m_value = state;
-        this->inputChanged();
-    }
+    this->setRawValue(state);
 }
 
 void HWInputButtonI2C::handleError(bool errorOccurred, bool catastrophic)
@@ -4,6 +4,7 @@
 #include "hw/HWInputFaderBt.h"
 
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -12,25 +13,23 @@ HWInputFader::HWInputFader()
     m_value = 0;
 }
 
-HWInput* HWInputFader::load(QDomElement* root)
+HWInput* HWInputFader::load(XmlElement* root)
 {
     HWInputFader* hw = NULL;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("hwtype") == 0)
+        if(elem->tag == XmlTag::HWType)
         {
-            if(elem.text().toLower().compare("i2c") == 0)
+            if(elem->text.compare("i2c", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWInputFader*)HWInputFaderI2C::load(root);
             }
-            else if(elem.text().toLower().compare("bt") == 0)
+            else if(elem->text.compare("bt", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWInputFader*)HWInputFaderBt::load(root);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
     if(hw == NULL)
@@ -8,7 +8,7 @@ class HWInputFader : public HWInput
 public:
     HWInputFader();
 
-    static HWInput* load(QDomElement* root);
+    static HWInput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     unsigned int getValue() const;
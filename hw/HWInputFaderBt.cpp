@@ -2,6 +2,7 @@
 #include "hw/HWInputFaderBt.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -12,27 +13,24 @@ HWInputFaderBt::HWInputFaderBt()
     m_btThread = NULL;
 }
 
-HWInput* HWInputFaderBt::load(QDomElement *root)
+HWInput* HWInputFaderBt::load(XmlElement* root)
 {
     HWInputFaderBt* hw = new HWInputFaderBt();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->setSlaveAddress( elem.text().toInt() );
+            hw->setSlaveAddress( elem->text.toInt() );
         }
-        else if( elem.tagName().toLower().compare("channel") == 0 )
+        else if( elem->tag == XmlTag::Channel )
         {
-            hw->setChannel( elem.text().toInt() );
+            hw->setChannel( elem->text.toInt() );
         }
-        else if( elem.tagName().toLower().compare("btboard") == 0 )
+        else if( elem->tag == XmlTag::BTBoard )
         {
-            hw->setBTName( elem.text().toStdString() );
+            hw->setBTName( elem->text.toStdString() );
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
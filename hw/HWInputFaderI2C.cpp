@@ -3,6 +3,7 @@
 #include "hw/I2CThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -12,22 +13,20 @@ HWInputFaderI2C::HWInputFaderI2C()
     this->m_channel = -1;
 }
 
-HWInput* HWInputFaderI2C::load(QDomElement *root)
+HWInput* HWInputFaderI2C::load(XmlElement* root)
 {
     HWInputFaderI2C* hw = new HWInputFaderI2C();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->setSlaveAddress( elem.text().toInt() );
+            hw->setSlaveAddress( elem->text.toInt() );
         }
-        else if( elem.tagName().toLower().compare("channel") == 0 )
+        else if( elem->tag == XmlTag::Channel )
         {
-            hw->setChannel( elem.text().toInt() );
+            hw->setChannel( elem->text.toInt() );
         }
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -14,7 +14,7 @@ public:
     virtual bool init(ConfigManager* config);
     virtual void deinit(ConfigManager* config);
 
-    static HWInput* load(QDomElement* root);
+    static HWInput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     int getChannel() const { return m_channel;}
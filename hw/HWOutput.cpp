@@ -8,7 +8,10 @@
 #include "hw/HWOutputDCMotor.h"
 #include "hw/HWOutputStepper.h"
 
+#include "script/EventRecorder.h"
 #include "util/Debug.h"
+#include "util/LatencyTrace.h"
+#include "util/XmlElement.h"
 
 #include <QDomDocument>
 
@@ -32,17 +35,16 @@ void HWOutput::deinit(ConfigManager *config)
 
 }
 
-HWOutput* HWOutput::load(QDomElement *root)
+HWOutput* HWOutput::load(XmlElement* root)
 {
     HWOutput* hw = NULL;
     std::string name;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("type") == 0)
+        if(elem->tag == XmlTag::Type)
         {
-            HWOutputType type = StringToHWOutputType(elem.text().toStdString());
+            HWOutputType type = StringToHWOutputType(elem->text.toStdString());
             switch(type)
             {
             case Relay:
@@ -65,13 +67,10 @@ HWOutput* HWOutput::load(QDomElement *root)
                 break;
             }
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
+        else if(elem->tag == XmlTag::Name)
         {
-            name = elem.text().toStdString();
+            name = elem->text.toStdString();
         }
-
-
-        elem = elem.nextSiblingElement();
     }
 
     if(hw != NULL)
@@ -142,9 +141,13 @@ void HWOutput::unregisterOutputListener(HWOutputListener *listener)
 
 /**
  * @brief HWOutput::outputChanged calls all registered outputListener, so that they can detect that this output has changed.
+ * If the change has been caused by an input change, its latency is recorded.
  */
 void HWOutput::outputChanged()
 {
+    LatencyTrace::record(LatencyTrace::Output, LatencyTrace::getOrigin());
+    EventRecorder::output(this);
+
     for(std::list<HWOutputListener*>::iterator it = m_listListeners.begin(); it != m_listListeners.end(); it++)
     {
         (*it)->onOutputChanged(this);
@@ -8,6 +8,7 @@ class HWOutputListener;
 class ConfigManager;
 class QDomElement;
 class QDomDocument;
+class XmlElement;
 
 /**
  * @brief The HWOuptut class implements all important methods to load, save, initialize, deinitialize and use an output object.
@@ -49,7 +50,7 @@ public:
     virtual void init(ConfigManager* config);
     virtual void deinit(ConfigManager* config);
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     HWOutputType getType() const { return m_type;}
@@ -4,6 +4,7 @@
 #include "hw/HWOutputDCMotorBt.h"
 
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -15,25 +16,23 @@ HWOutputDCMotor::HWOutputDCMotor()
     m_speed = 0;
 }
 
-HWOutput* HWOutputDCMotor::load(QDomElement* root)
+HWOutput* HWOutputDCMotor::load(XmlElement* root)
 {
     HWOutputDCMotor* hw = NULL;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("hwtype") == 0)
+        if(elem->tag == XmlTag::HWType)
         {
-            if(elem.text().toLower().compare("i2c") == 0)
+            if(elem->text.compare("i2c", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputDCMotor*)HWOutputDCMotorI2C::load(root);
             }
-            else if(elem.text().toLower().compare("bt") == 0)
+            else if(elem->text.compare("bt", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputDCMotor*)HWOutputDCMotorBt::load(root);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
     if(hw == NULL)
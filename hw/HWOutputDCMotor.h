@@ -18,7 +18,7 @@ public:
 
     HWOutputDCMotor();
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     void setOverrideMotorState(MotorState state);
@@ -3,6 +3,7 @@
 #include "hw/BTThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 HWOutputDCMotorBt::HWOutputDCMotorBt()
 {
@@ -10,23 +11,20 @@ HWOutputDCMotorBt::HWOutputDCMotorBt()
     m_btThread = NULL;
 }
 
-HWOutput* HWOutputDCMotorBt::load(QDomElement *root)
+HWOutput* HWOutputDCMotorBt::load(XmlElement* root)
 {
     HWOutputDCMotorBt* hw = new HWOutputDCMotorBt();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("btboard") == 0 )
+        else if( elem->tag == XmlTag::BTBoard )
         {
-            hw->m_btName = elem.text().toStdString();
+            hw->m_btName = elem->text.toStdString();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -102,6 +100,7 @@ void HWOutputDCMotorBt::outputChanged()
 {
     HWOutputDCMotor::outputChanged();
 
+    // setI2CBt always writes the current state, so a pending write can be replaced by this one
     if(m_btThread != NULL)
-        m_btThread->addOutput( std::bind(&HWOutputDCMotorBt::setI2CBt, this, std::placeholders::_1) );
+        m_btThread->addOutput( std::bind(&HWOutputDCMotorBt::setI2CBt, this, std::placeholders::_1), this );
 }
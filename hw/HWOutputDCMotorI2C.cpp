@@ -3,6 +3,7 @@
 #include "hw/I2CThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 HWOutputDCMotorI2C::HWOutputDCMotorI2C()
 {
@@ -10,18 +11,16 @@ HWOutputDCMotorI2C::HWOutputDCMotorI2C()
     m_i2cThread = NULL;
 }
 
-HWOutput* HWOutputDCMotorI2C::load(QDomElement *root)
+HWOutput* HWOutputDCMotorI2C::load(XmlElement* root)
 {
     HWOutputDCMotorI2C* hw = new HWOutputDCMotorI2C();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -4,6 +4,7 @@
 #include "hw/HWOutputGPOBt.h"
 
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -13,25 +14,23 @@ HWOutputGPO::HWOutputGPO()
     m_value = false;
 }
 
-HWOutput* HWOutputGPO::load(QDomElement* root)
+HWOutput* HWOutputGPO::load(XmlElement* root)
 {
     HWOutputGPO* hw = NULL;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("hwtype") == 0)
+        if(elem->tag == XmlTag::HWType)
         {
-            if(elem.text().toLower().compare("i2c") == 0)
+            if(elem->text.compare("i2c", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputGPO*)HWOutputGPOI2C::load(root);
             }
-            else if(elem.text().toLower().compare("bt") == 0)
+            else if(elem->text.compare("bt", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputGPO*)HWOutputGPOBt::load(root);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
     if(hw == NULL)
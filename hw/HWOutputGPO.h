@@ -8,7 +8,7 @@ class HWOutputGPO : public HWOutput
 public:
     HWOutputGPO();
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     bool getValue() const;
@@ -3,6 +3,7 @@
 #include "hw/BTThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 HWOutputGPOBt::HWOutputGPOBt()
 {
@@ -10,27 +11,24 @@ HWOutputGPOBt::HWOutputGPOBt()
     m_port = -1;
 }
 
-HWOutput* HWOutputGPOBt::load(QDomElement *root)
+HWOutput* HWOutputGPOBt::load(XmlElement* root)
 {
     HWOutputGPOBt* hw = new HWOutputGPOBt();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("port") == 0 )
+        else if( elem->tag == XmlTag::Port )
         {
-            hw->m_port = elem.text().toInt();
+            hw->m_port = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("btboard") == 0 )
+        else if( elem->tag == XmlTag::BTBoard )
         {
-            hw->m_btName = elem.text().toStdString();
+            hw->m_btName = elem->text.toStdString();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
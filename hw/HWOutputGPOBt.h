@@ -19,7 +19,7 @@ public:
     virtual void init(ConfigManager* config);
     virtual void deinit(ConfigManager* config);
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     unsigned int getPort() const { return m_port;}
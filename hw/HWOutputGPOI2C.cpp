@@ -3,6 +3,7 @@
 #include "hw/I2CThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 HWOutputGPOI2C::HWOutputGPOI2C()
 {
@@ -11,23 +12,20 @@ HWOutputGPOI2C::HWOutputGPOI2C()
     m_i2cThread = NULL;
 }
 
-HWOutput* HWOutputGPOI2C::load(QDomElement *root)
+HWOutput* HWOutputGPOI2C::load(XmlElement* root)
 {
     HWOutputGPOI2C* hw = new HWOutputGPOI2C();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("port") == 0 )
+        else if( elem->tag == XmlTag::Port )
         {
-            hw->m_port = elem.text().toInt();
+            hw->m_port = elem->text.toInt();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -8,7 +8,7 @@ class HWOutputLED : public HWOutput
 public:
     HWOutputLED();
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     unsigned int getValue() const { return m_value;}
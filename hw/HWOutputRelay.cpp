@@ -4,6 +4,7 @@
 #include "hw/HWOutputRelayBt.h"
 
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -13,25 +14,23 @@ HWOutputRelay::HWOutputRelay()
     m_value = false;
 }
 
-HWOutput* HWOutputRelay::load(QDomElement* root)
+HWOutput* HWOutputRelay::load(XmlElement* root)
 {
     HWOutputRelay* hw = NULL;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("hwtype") == 0)
+        if(elem->tag == XmlTag::HWType)
         {
-            if(elem.text().toLower().compare("i2c") == 0)
+            if(elem->text.compare("i2c", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputRelay*)HWOutputRelayI2C::load(root);
             }
-            else if(elem.text().toLower().compare("bt") == 0)
+            else if(elem->text.compare("bt", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputRelay*)HWOutputRelayBt::load(root);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
     if(hw == NULL)
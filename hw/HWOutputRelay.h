@@ -8,7 +8,7 @@ class HWOutputRelay : public HWOutput
 public:
     HWOutputRelay();
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     bool getValue() const;
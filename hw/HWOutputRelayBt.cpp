@@ -3,6 +3,7 @@
 #include "hw/BTThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 HWOutputRelayBt::HWOutputRelayBt()
 {
@@ -11,27 +12,24 @@ HWOutputRelayBt::HWOutputRelayBt()
     m_btThread = NULL;
 }
 
-HWOutput* HWOutputRelayBt::load(QDomElement *root)
+HWOutput* HWOutputRelayBt::load(XmlElement* root)
 {
     HWOutputRelayBt* hw = new HWOutputRelayBt();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("channel") == 0 )
+        else if( elem->tag == XmlTag::Channel )
         {
-            hw->m_channel = elem.text().toInt();
+            hw->m_channel = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("btboard") == 0 )
+        else if( elem->tag == XmlTag::BTBoard )
         {
-            hw->m_btName = elem.text().toStdString();
+            hw->m_btName = elem->text.toStdString();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
@@ -157,6 +155,7 @@ void HWOutputRelayBt::outputChanged()
 {
     HWOutputRelay::outputChanged();
 
+    // setI2CBt always writes the current state, so a pending write can be replaced by this one
     if(m_btThread != NULL)
-        m_btThread->addOutput(std::bind(&HWOutputRelayBt::setI2CBt, this, std::placeholders::_1));
+        m_btThread->addOutput(std::bind(&HWOutputRelayBt::setI2CBt, this, std::placeholders::_1), this);
 }
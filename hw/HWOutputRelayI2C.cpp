@@ -3,6 +3,7 @@
 #include "hw/I2CThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 HWOutputRelayI2C::HWOutputRelayI2C()
 {
@@ -11,23 +12,20 @@ HWOutputRelayI2C::HWOutputRelayI2C()
     m_i2cThread = NULL;
 }
 
-HWOutput* HWOutputRelayI2C::load(QDomElement *root)
+HWOutput* HWOutputRelayI2C::load(XmlElement* root)
 {
     HWOutputRelayI2C* hw = new HWOutputRelayI2C();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        else if( elem.tagName().toLower().compare("channel") == 0 )
+        else if( elem->tag == XmlTag::Channel )
         {
-            hw->m_channel = elem.text().toInt();
+            hw->m_channel = elem->text.toInt();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
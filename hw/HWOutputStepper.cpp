@@ -3,6 +3,7 @@
 #include "hw/HWOutputStepperI2C.h"
 #include "hw/HWOutputStepperBt.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
 #include <QDomElement>
 
@@ -11,25 +12,23 @@ HWOutputStepper::HWOutputStepper()
     m_type = Stepper;
 }
 
-HWOutput* HWOutputStepper::load(QDomElement* root)
+HWOutput* HWOutputStepper::load(XmlElement* root)
 {
     HWOutputStepper* hw = NULL;
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("hwtype") == 0)
+        if(elem->tag == XmlTag::HWType)
         {
-            if(elem.text().toLower().compare("i2c") == 0)
+            if(elem->text.compare("i2c", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputStepper*)HWOutputStepperI2C::load(root);
             }
-            else if(elem.text().toLower().compare("bt") == 0)
+            else if(elem->text.compare("bt", Qt::CaseInsensitive) == 0)
             {
                 hw = (HWOutputStepper*)HWOutputStepperBt::load(root);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
     if(hw == NULL)
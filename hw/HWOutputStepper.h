@@ -111,7 +111,7 @@ public:
 
     HWOutputStepper();
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     FullStatus getFullStatus() const { return m_fullStatus;}
@@ -3,19 +3,18 @@
 #include "hw/I2CThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/XmlElement.h"
 
-HWOutput* HWOutputStepperI2C::load(QDomElement *root)
+HWOutput* HWOutputStepperI2C::load(XmlElement* root)
 {
     HWOutputStepperI2C* hw = new HWOutputStepperI2C();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if( elem.tagName().toLower().compare("slaveaddress") == 0 )
+        if( elem->tag == XmlTag::SlaveAddress )
         {
-            hw->m_slaveAddress = elem.text().toInt();
+            hw->m_slaveAddress = elem->text.toInt();
         }
-        elem = elem.nextSiblingElement();
     }
 
     // check for invalid parameters
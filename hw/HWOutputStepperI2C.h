@@ -13,7 +13,7 @@ public:
     void init(ConfigManager* config);
     void deinit(ConfigManager* config);
 
-    static HWOutput* load(QDomElement* root);
+    static HWOutput* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
 
     void testBemf();
@@ -3,6 +3,7 @@
 #include "hw/PCF8575I2C.h"
 
 #include "util/Debug.h"
+#include "util/LatencyTrace.h"
 
 #include <sys/ioctl.h>
 #include <fcntl.h>
@@ -17,10 +18,15 @@ static void dummy_handler(int)
     // nothing here
 }
 
-I2CThread::I2CThread()
+/**
+ * @brief I2CThread::I2CThread starts the thread
+ * @param bus if not NULL, all transfers go to this bus instead of the I2C device, which is not opened then
+ */
+I2CThread::I2CThread(I2CBus* bus)
 {
     // set m_handle to invalid value, so we can detect if we have to close it later
     m_handle = -1;
+    m_bus = bus;
     m_bStop = false;
     m_thread = 0;
 
@@ -102,6 +108,7 @@ void I2CThread::addOutput(std::function<void (I2CThread*)> func)
 {
     OutputElement element;
     element.func = func;
+    element.origin = LatencyTrace::getOrigin();
 
     m_mutex.lock();
     m_outputQueue.push(element);
@@ -203,7 +210,11 @@ void I2CThread::removeOutputPCF8575(HWOutput* hw, int slaveAddress)
     }
 }
 
-void I2CThread::run()
+/**
+ * @brief I2CThread::openDevice opens the I2C device of the raspberry
+ * @return false if there is no I2C device, the thread exits then
+ */
+bool I2CThread::openDevice()
 {
 #ifdef USE_I2C
     RPiRevision revision = getRPiRevision();
@@ -218,15 +229,27 @@ void I2CThread::run()
         break;
     default:
         LOG_WARN(Logger::I2C, "Unkown raspberry revision, aborting i2c");
-        return;
+        return false;
     }
 
     if(m_handle < 0)
     {
         LOG_WARN(Logger::I2C, "Could not open i2c-interface");
-        return;
+        return false;
     }
 
+    return true;
+#else
+    return false;
+#endif
+}
+
+void I2CThread::run()
+{
+    // a simulated bus does not need the device
+    if(m_bus == NULL && !this->openDevice())
+        return;
+
     timespec currentTime;
     timespec waitTime;
     while(true)
@@ -251,8 +274,12 @@ void I2CThread::run()
             m_outputQueue.pop();
             m_mutex.unlock();
 
-            // run function
+            // run function, the origin is set so that a simulated bus can trace its writes back to the input change
+            LatencyTrace::setOrigin(element.origin);
             element.func(this);
+            LatencyTrace::setOrigin(0);
+
+            LatencyTrace::record(LatencyTrace::Bus, element.origin);
             continue;
         }
 
@@ -326,8 +353,8 @@ void I2CThread::run()
         m_mutex.unlock();
     }
 
-    close(m_handle);
-#endif
+    if(m_handle >= 0)
+        close(m_handle);
 }
 
 void* I2CThread::run_internal(void* arg)
@@ -351,6 +378,9 @@ void* I2CThread::run_internal(void* arg)
  */
 bool I2CThread::write(void *buffer, unsigned int size)
 {
+    if(m_bus != NULL)
+        return m_bus->write(buffer, size);
+
     int ret = 0;
 
     for(unsigned int i = 0; i <= I2C_WRITE_REPEATCOUNT; i++)
@@ -374,6 +404,9 @@ bool I2CThread::write(void *buffer, unsigned int size)
  */
 bool I2CThread::read(void *buffer, unsigned int size)
 {
+    if(m_bus != NULL)
+        return m_bus->read(buffer, size);
+
     int ret = 0;
 
     for(unsigned int i = 0; i <= I2C_READ_REPEATCOUNT; i++)
@@ -395,6 +428,9 @@ bool I2CThread::read(void *buffer, unsigned int size)
  */
 bool I2CThread::setSlaveAddress(int slaveAddress)
 {
+    if(m_bus != NULL)
+        return m_bus->setSlaveAddress(slaveAddress);
+
     if( ioctl(m_handle, I2C_SLAVE, slaveAddress) < 0)
         return false;
 
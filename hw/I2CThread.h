@@ -25,6 +25,18 @@ public:
     virtual void poll(I2CThread* i2cThread) = 0;
 };
 
+/**
+ * @brief The I2CBus class replaces the I2C device of the raspberry, e.g. by simulated devices in the benchmark.
+ * Its methods are only called by the I2C thread, with the same meaning as I2CThread::setSlaveAddress, I2CThread::write and I2CThread::read.
+ */
+class I2CBus
+{
+public:
+    virtual bool setSlaveAddress(int slaveAddress) = 0;
+    virtual bool write(void* buffer, unsigned int size) = 0;
+    virtual bool read(void* buffer, unsigned int size) = 0;
+};
+
 /**
  * @brief The I2CThread class does the actual communication with the devices on the I2C bus.
  * A HWInput or HWOutput object uses an I2CThread object to read or write to/from devices on the bus.
@@ -32,7 +44,7 @@ public:
 class I2CThread
 {
 public:
-    I2CThread();
+    I2CThread(I2CBus* bus = NULL);
     ~I2CThread();
 
     void kill();
@@ -73,16 +85,19 @@ private:
     struct OutputElement
     {
         std::function<void (I2CThread*)> func;
+        unsigned long long origin; // see LatencyTrace
     };
 
     static void* run_internal(void* arg);
     void run();
+    bool openDevice();
 
     pthread_t m_thread;
     std::mutex m_mutex;
     bool m_bStop;
 
     int m_handle;
+    I2CBus* m_bus; // used instead of the device if not NULL
     PriorityQueue<InputElement> m_inputQueue;
     std::queue<OutputElement> m_outputQueue;
 
@@ -119,7 +119,8 @@ void PCF8575Bt::updateI2C()
 {
     pi_assert(m_btThread != NULL);
 
-    m_btThread->addOutput( std::bind(&PCF8575Bt::setI2C, this, std::placeholders::_1) );
+    // setI2C always writes the current port mask, so a pending write can be replaced by this one
+    m_btThread->addOutput( std::bind(&PCF8575Bt::setI2C, this, std::placeholders::_1), this );
 }
 
 void PCF8575Bt::init(BTThread* btThread)
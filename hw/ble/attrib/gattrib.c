@@ -42,6 +42,45 @@
 
 #define GATT_TIMEOUT 30
 
+/* All sources are attached to the thread default main context, so that the
+ * caller decides which main loop dispatches them */
+static guint attrib_add_source(GSource *source, GSourceFunc func,
+				gpointer user_data, GDestroyNotify notify)
+{
+	guint id;
+
+	g_source_set_callback(source, func, user_data, notify);
+	id = g_source_attach(source, g_main_context_get_thread_default());
+	g_source_unref(source);
+
+	return id;
+}
+
+static guint attrib_io_add_watch(GIOChannel *io, GIOCondition cond,
+				GIOFunc func, gpointer user_data,
+				GDestroyNotify notify)
+{
+	return attrib_add_source(g_io_create_watch(io, cond),
+				(GSourceFunc) func, user_data, notify);
+}
+
+static guint attrib_timeout_add_seconds(guint interval, GSourceFunc func,
+						gpointer user_data)
+{
+	return attrib_add_source(g_timeout_source_new_seconds(interval),
+						func, user_data, NULL);
+}
+
+static void attrib_source_remove(guint id)
+{
+	GSource *source;
+
+	source = g_main_context_find_source_by_id(
+				g_main_context_get_thread_default(), id);
+	if (source)
+		g_source_destroy(source);
+}
+
 struct _GAttrib {
 	GIOChannel *io;
 	int refs;
@@ -200,13 +239,13 @@ static void attrib_destroy(GAttrib *attrib)
 	attrib->events = NULL;
 
 	if (attrib->timeout_watch > 0)
-		g_source_remove(attrib->timeout_watch);
+		attrib_source_remove(attrib->timeout_watch);
 
 	if (attrib->write_watch > 0)
-		g_source_remove(attrib->write_watch);
+		attrib_source_remove(attrib->write_watch);
 
 	if (attrib->read_watch > 0)
-		g_source_remove(attrib->read_watch);
+		attrib_source_remove(attrib->read_watch);
 
 	if (attrib->io)
 		g_io_channel_unref(attrib->io);
@@ -339,7 +378,7 @@ static gboolean can_write_data(GIOChannel *io, GIOCondition cond,
 	cmd->sent = true;
 
 	if (attrib->timeout_watch == 0)
-		attrib->timeout_watch = g_timeout_add_seconds(GATT_TIMEOUT,
+		attrib->timeout_watch = attrib_timeout_add_seconds(GATT_TIMEOUT,
 						disconnect_timeout, attrib);
 
 	return FALSE;
@@ -359,8 +398,7 @@ static void wake_up_sender(struct _GAttrib *attrib)
 		return;
 
 	attrib = g_attrib_ref(attrib);
-	attrib->write_watch = g_io_add_watch_full(attrib->io,
-				G_PRIORITY_DEFAULT, G_IO_OUT,
+	attrib->write_watch = attrib_io_add_watch(attrib->io, G_IO_OUT,
 				can_write_data, attrib, destroy_sender);
 }
 
@@ -425,7 +463,7 @@ static gboolean received_data(GIOChannel *io, GIOCondition cond, gpointer data)
 		return TRUE;
 
 	if (attrib->timeout_watch > 0) {
-		g_source_remove(attrib->timeout_watch);
+		attrib_source_remove(attrib->timeout_watch);
 		attrib->timeout_watch = 0;
 	}
 
@@ -494,9 +532,9 @@ GAttrib *g_attrib_new(GIOChannel *io)
 	attrib->requests = g_queue_new();
 	attrib->responses = g_queue_new();
 
-	attrib->read_watch = g_io_add_watch(attrib->io,
+	attrib->read_watch = attrib_io_add_watch(attrib->io,
 			G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-			received_data, attrib);
+			received_data, attrib, NULL);
 
 	return g_attrib_ref(attrib);
 }
@@ -47,6 +47,24 @@
 #define BT_FLUSHABLE	8
 #endif
 
+/* Attach watches to the thread default main context, so that the caller decides
+ * which main loop dispatches them */
+static guint io_add_watch_full(GIOChannel *io, gint priority,
+				GIOCondition cond, GIOFunc func,
+				gpointer user_data, GDestroyNotify notify)
+{
+	GSource *source;
+	guint id;
+
+	source = g_io_create_watch(io, cond);
+	g_source_set_priority(source, priority);
+	g_source_set_callback(source, (GSourceFunc) func, user_data, notify);
+	id = g_source_attach(source, g_main_context_get_thread_default());
+	g_source_unref(source);
+
+	return id;
+}
+
 #define ERROR_FAILED(gerr, str, err) \
 		g_set_error(gerr, BT_IO_ERROR, err, \
 				str ": %s (%d)", strerror(err), err)
@@ -280,7 +298,7 @@ static void server_add(GIOChannel *io, BtIOConnect connect,
 	server->destroy = destroy;
 
 	cond = G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL;
-	g_io_add_watch_full(io, G_PRIORITY_DEFAULT, cond, server_cb, server,
+	io_add_watch_full(io, G_PRIORITY_DEFAULT, cond, server_cb, server,
 					(GDestroyNotify) server_remove);
 }
 
@@ -296,7 +314,7 @@ static void connect_add(GIOChannel *io, BtIOConnect connect,
 	conn->destroy = destroy;
 
 	cond = G_IO_OUT | G_IO_ERR | G_IO_HUP | G_IO_NVAL;
-	g_io_add_watch_full(io, G_PRIORITY_DEFAULT, cond, connect_cb, conn,
+	io_add_watch_full(io, G_PRIORITY_DEFAULT, cond, connect_cb, conn,
 					(GDestroyNotify) connect_remove);
 }
 
@@ -312,7 +330,7 @@ static void accept_add(GIOChannel *io, BtIOConnect connect, gpointer user_data,
 	accept->destroy = destroy;
 
 	cond = G_IO_OUT | G_IO_ERR | G_IO_HUP | G_IO_NVAL;
-	g_io_add_watch_full(io, G_PRIORITY_DEFAULT, cond, accept_cb, accept,
+	io_add_watch_full(io, G_PRIORITY_DEFAULT, cond, accept_cb, accept,
 					(GDestroyNotify) accept_remove);
 }
 
@@ -5,28 +5,26 @@
 #include "script/ActionSleep.h"
 #include "script/ActionCallRule.h"
 #include "script/ActionMusic.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* Action::load(QDomElement* root)
+Action* Action::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("type") == 0)
+        if(elem->tag == XmlTag::Type)
         {
-            if(elem.text().toLower().compare("output") == 0)
+            if(elem->text.compare("output", Qt::CaseInsensitive) == 0)
                 return ActionOutput::load(root);
-            else if(elem.text().toLower().compare("variable") == 0)
+            else if(elem->text.compare("variable", Qt::CaseInsensitive) == 0)
                 return ActionVariable::load(root);
-            else if(elem.text().toLower().compare("sleep") == 0)
+            else if(elem->text.compare("sleep", Qt::CaseInsensitive) == 0)
                 return ActionSleep::load(root);
-            else if(elem.text().toLower().compare("callrule") == 0)
+            else if(elem->text.compare("callrule", Qt::CaseInsensitive) == 0)
                 return ActionCallRule::load(root);
-            else if(elem.text().toLower().compare("music") == 0)
+            else if(elem->text.compare("music", Qt::CaseInsensitive) == 0)
                 return ActionMusic::load(root);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return NULL;
@@ -40,3 +38,36 @@ QDomElement Action::save(QDomElement* root, QDomDocument* document)
 
     return action;
 }
+
+/**
+ * @brief Action::loadBinary is the counterpart of Action::saveBinary, it is used by the ScriptCache
+ * @param in
+ * @return the action or NULL if it could not be read
+ */
+Action* Action::loadBinary(QDataStream& in)
+{
+    quint8 type = 0;
+    in >> type;
+
+    switch(type)
+    {
+    case Output:
+        return ActionOutput::loadBinary(in);
+    case Var:
+        return ActionVariable::loadBinary(in);
+    case Sleep:
+        return ActionSleep::loadBinary(in);
+    case CallRule:
+        return ActionCallRule::loadBinary(in);
+    case Music:
+        return ActionMusic::loadBinary(in);
+    default:
+        in.setStatus(QDataStream::ReadCorruptData);
+        return NULL;
+    }
+}
+
+void Action::saveBinary(QDataStream& out)
+{
+    out << (quint8)this->getType();
+}
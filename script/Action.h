@@ -25,13 +25,18 @@ public:
 
     void setRule(Rule* rule) { m_rule = rule;}
 
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     virtual void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
                                  std::list<Rule::RequiredVariable>* listVariable) const {};
 
+    // true if init resolves one of these variable or rule names
+    virtual bool dependsOn(__attribute__((unused)) const std::set<Symbol::Id>& names) const { return false;}
+
     virtual bool execute(__attribute__((unused)) unsigned int step) = 0; // return value specifies if Rule should continue executing
     virtual std::string getDescription() const = 0;
     virtual Type getType() const = 0;
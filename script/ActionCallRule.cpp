@@ -3,25 +3,25 @@
 #include "script/Script.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionCallRule::ActionCallRule()
 {
     m_callRule = NULL;
+    m_ruleId = Symbol::Invalid;
 }
 
-Action* ActionCallRule::load(QDomElement* root)
+Action* ActionCallRule::load(XmlElement* root)
 {
     ActionCallRule* action = new ActionCallRule();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("name") == 0)
+        if(elem->tag == XmlTag::Name)
         {
-            action->setRuleName( elem.text().toStdString() );
+            action->setRuleName( elem->text.toStdString() );
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     if(action->getRuleName().empty())
@@ -52,25 +52,46 @@ QDomElement ActionCallRule::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionCallRule::loadBinary(QDataStream& in)
+{
+    std::string name;
+    in >> name;
+
+    if(name.empty())
+        return NULL;
+
+    ActionCallRule* action = new ActionCallRule();
+    action->setRuleName(name);
+
+    return action;
+}
+
+void ActionCallRule::saveBinary(QDataStream& out)
+{
+    Action::saveBinary(out);
+
+    out << m_ruleName;
+}
+
 void ActionCallRule::init(ConfigManager *config)
 {
     Script* script = config->getActiveScript();
 
     pi_assert(script != NULL);
 
-    m_rule = script->getRuleByName(m_ruleName);
+    m_callRule = script->getRule(m_ruleId);
 }
 
 void ActionCallRule::deinit()
 {
-    m_rule = NULL;
+    m_callRule = NULL;
 }
 
 bool ActionCallRule::execute(unsigned int start)
 {
-    pi_assert(m_rule != NULL);
+    pi_assert(m_callRule != NULL);
 
-    m_rule->call();
+    m_callRule->call();
 
     return true;
 }
@@ -2,27 +2,32 @@
 #define ACTIONCALLRULE_H
 
 #include "script/Action.h"
+#include "util/Symbol.h"
 
 class ActionCallRule : public Action
 {
 public:
     ActionCallRule();
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void init(ConfigManager* config);
     void deinit();
+    bool dependsOn(const std::set<Symbol::Id>& names) const { return names.count(m_ruleId) != 0;}
 
     bool execute(unsigned int step);
 
     Type getType() const { return CallRule;}
     std::string getDescription() const;
 
-    void setRuleName(std::string str) { m_ruleName = str;}
+    void setRuleName(std::string str) { m_ruleName = str; m_ruleId = Symbol::intern(str);}
     std::string getRuleName() const { return m_ruleName;}
 
 private:
     std::string m_ruleName;
+    Symbol::Id m_ruleId;
     Rule* m_callRule;
 };
 
@@ -3,27 +3,26 @@
 #include "ConfigManager.h"
 #include "SoundManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* ActionMusic::load(QDomElement* root)
+Action* ActionMusic::load(XmlElement* root)
 {
     ActionMusic* action = new ActionMusic();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("filename") == 0)
+        if(elem->tag == XmlTag::Filename)
         {
-            action->m_filename = elem.text().toStdString();
+            action->m_filename = elem->text.toStdString();
         }
-        if(elem.tagName().toLower().compare("musicaction") == 0)
+        if(elem->tag == XmlTag::MusicAction)
         {
-            if( elem.text().toLower().compare("play") == 0)
+            if( elem->text.compare("play", Qt::CaseInsensitive) == 0)
                 action->m_action = Play;
-            else if( elem.text().toLower().compare("stop") == 0)
+            else if( elem->text.compare("stop", Qt::CaseInsensitive) == 0)
                 action->m_action = Stop;
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     if(action->m_action == Play && action->m_filename.empty())
@@ -60,6 +59,26 @@ QDomElement ActionMusic::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionMusic::loadBinary(QDataStream& in)
+{
+    quint8 musicAction = 0;
+    std::string filename;
+    in >> musicAction >> filename;
+
+    ActionMusic* action = new ActionMusic();
+    action->m_action = (MusicAction)musicAction;
+    action->m_filename = filename;
+
+    return action;
+}
+
+void ActionMusic::saveBinary(QDataStream& out)
+{
+    Action::saveBinary(out);
+
+    out << (quint8)m_action << m_filename;
+}
+
 void ActionMusic::init(ConfigManager *config)
 {
     m_soundManager = config->getSoundManager();
@@ -7,32 +7,31 @@
 #include "ConfigManager.h"
 
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* ActionOutput::load(QDomElement* root)
+Action* ActionOutput::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
     std::string name;
     ActionOutput* action = NULL;
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("subtype") == 0)
+        if(elem->tag == XmlTag::Subtype)
         {
-            if(elem.text().toLower().compare("relay") == 0)
+            if(elem->text.compare("relay", Qt::CaseInsensitive) == 0)
                 action = (ActionOutput*)ActionOutputRelay::load(root);
-            else if(elem.text().toLower().compare("led") == 0)
+            else if(elem->text.compare("led", Qt::CaseInsensitive) == 0)
                 action = (ActionOutput*)ActionOutputLED::load(root);
-            else if(elem.text().toLower().compare("dcmotor") == 0)
+            else if(elem->text.compare("dcmotor", Qt::CaseInsensitive) == 0)
                 action = (ActionOutput*)ActionOutputDCMotor::load(root);
-            else if(elem.text().toLower().compare("stepper") == 0)
+            else if(elem->text.compare("stepper", Qt::CaseInsensitive) == 0)
                 action = (ActionOutput*)ActionOutputStepper::load(root);
-            else if(elem.text().toLower().compare("gpo") == 0)
+            else if(elem->text.compare("gpo", Qt::CaseInsensitive) == 0)
                 action = (ActionOutput*)ActionOutputGPO::load(root);
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
-            name = elem.text().toStdString();
-
-        elem = elem.nextSiblingElement();
+        else if(elem->tag == XmlTag::Name)
+            name = elem->text.toStdString();
     }
 
     if(action != NULL)
@@ -69,9 +68,52 @@ QDomElement ActionOutput::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionOutput::loadBinary(QDataStream& in)
+{
+    std::string name;
+    quint8 subtype = 0;
+    ActionOutput* action = NULL;
+
+    in >> name >> subtype;
+
+    switch(subtype)
+    {
+    case HWOutput::Relay:
+        action = (ActionOutput*)ActionOutputRelay::loadBinary(in);
+        break;
+    case HWOutput::LED:
+        action = (ActionOutput*)ActionOutputLED::loadBinary(in);
+        break;
+    case HWOutput::DCMotor:
+        action = (ActionOutput*)ActionOutputDCMotor::loadBinary(in);
+        break;
+    case HWOutput::Stepper:
+        action = (ActionOutput*)ActionOutputStepper::loadBinary(in);
+        break;
+    case HWOutput::GPO:
+        action = (ActionOutput*)ActionOutputGPO::loadBinary(in);
+        break;
+    default:
+        in.setStatus(QDataStream::ReadCorruptData);
+        return NULL;
+    }
+
+    if(action != NULL)
+        action->setHWName(name);
+
+    return action;
+}
+
+void ActionOutput::saveBinary(QDataStream& out)
+{
+    Action::saveBinary(out);
+
+    out << m_HWName;
+}
+
 void ActionOutput::init(ConfigManager *config)
 {
-    m_hw = config->getOutputByName(m_HWName);
+    m_hw = config->getOutput(m_HWId);
 }
 
 void ActionOutput::deinit()
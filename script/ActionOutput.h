@@ -4,14 +4,19 @@
 #include "script/Action.h"
 
 #include "hw/HWOutput.h"
+#include "util/Symbol.h"
 
 class ActionOutput : public Action
 {
 public:
-    static Action* load(QDomElement* root);
+    ActionOutput() { m_hw = NULL; m_HWId = Symbol::Invalid;}
+
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
-    void setHWName(std::string str) { m_HWName = str;}
+    void setHWName(std::string str) { m_HWName = str; m_HWId = Symbol::intern(str);}
     std::string getHWName() const { return m_HWName;}
 
     void init(ConfigManager* config);
@@ -21,6 +26,7 @@ public:
 
 protected:
     std::string m_HWName;
+    Symbol::Id m_HWId;
     HWOutput* m_hw;
 };
 
@@ -3,6 +3,8 @@
 #include "hw/HWInputFader.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionOutputDCMotor::ActionOutputDCMotor()
 {
@@ -10,30 +12,27 @@ ActionOutputDCMotor::ActionOutputDCMotor()
     m_speed = 0;
 
     m_hwInput = NULL;
+    m_inputId = Symbol::Invalid;
 }
 
-Action* ActionOutputDCMotor::load(QDomElement* root)
+Action* ActionOutputDCMotor::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ActionOutputDCMotor* action = new ActionOutputDCMotor();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("state") == 0)
+        if(elem->tag == XmlTag::State)
         {
-            action->setState( HWOutputDCMotor::StringToMotorState( elem.text().toStdString() ) );
+            action->setState( HWOutputDCMotor::StringToMotorState( elem->text.toStdString() ) );
         }
-        else if(elem.tagName().toLower().compare("speed") == 0)
+        else if(elem->tag == XmlTag::Speed)
         {
-            action->setSpeed( elem.text().toInt() );
+            action->setSpeed( elem->text.toInt() );
         }
-        else if(elem.tagName().toLower().compare("inputname") == 0)
+        else if(elem->tag == XmlTag::InputName)
         {
-            action->setInputName( elem.text().toStdString() );
+            action->setInputName( elem->text.toStdString() );
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -78,6 +77,28 @@ QDomElement ActionOutputDCMotor::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionOutputDCMotor::loadBinary(QDataStream& in)
+{
+    quint8 state = 0;
+    quint32 speed = 0;
+    std::string inputName;
+    in >> state >> speed >> inputName;
+
+    ActionOutputDCMotor* action = new ActionOutputDCMotor();
+    action->setState((HWOutputDCMotor::MotorState)state);
+    action->setSpeed(speed);
+    action->setInputName(inputName);
+
+    return action;
+}
+
+void ActionOutputDCMotor::saveBinary(QDataStream& out)
+{
+    ActionOutput::saveBinary(out);
+
+    out << (quint8)HWOutput::DCMotor << (quint8)m_state << (quint32)m_speed << m_inputName;
+}
+
 
 void ActionOutputDCMotor::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
@@ -110,7 +131,7 @@ void ActionOutputDCMotor::init(ConfigManager *config)
 
     if(!m_inputName.empty())
     {
-        m_hwInput = config->getInputByName(m_inputName);
+        m_hwInput = config->getInput(m_inputId);
 
         pi_assert(m_hwInput != NULL && m_hwInput->getType() == HWInput::Fader);
     }
@@ -10,8 +10,10 @@ class ActionOutputDCMotor : public ActionOutput
 {
 public:
     ActionOutputDCMotor();
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
@@ -27,7 +29,7 @@ public:
     void setSpeed(unsigned int speed) { m_speed = speed;}
     unsigned int getSpeed() const { return m_speed;}
 
-    void setInputName(std::string str) { m_inputName = str;}
+    void setInputName(std::string str) { m_inputName = str; m_inputId = Symbol::intern(str);}
     std::string getInputName() const { return m_inputName;}
 
     void setState(HWOutputDCMotor::MotorState state) { m_state = state;}
@@ -36,6 +38,7 @@ private:
     unsigned int m_speed;
     HWOutputDCMotor::MotorState m_state;
     std::string m_inputName;
+    Symbol::Id m_inputId;
     HWInput* m_hwInput;
 };
 
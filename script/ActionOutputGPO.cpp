@@ -2,31 +2,29 @@
 #include "script/ActionOutputGPO.h"
 #include "hw/HWOutputGPO.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionOutputGPO::ActionOutputGPO()
 {
     m_state = Low;
 }
 
-Action* ActionOutputGPO::load(QDomElement* root)
+Action* ActionOutputGPO::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ActionOutputGPO* action = new ActionOutputGPO();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("state") == 0)
+        if(elem->tag == XmlTag::State)
         {
-            if(elem.text().toLower().compare("high") == 0)
+            if(elem->text.compare("high", Qt::CaseInsensitive) == 0)
                 action->setState(High);
-            else if(elem.text().toLower().compare("low") == 0)
+            else if(elem->text.compare("low", Qt::CaseInsensitive) == 0)
                 action->setState(Low);
-            else if(elem.text().toLower().compare("toggle") == 0)
+            else if(elem->text.compare("toggle", Qt::CaseInsensitive) == 0)
                 action->setState(Toggle);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -65,6 +63,24 @@ QDomElement ActionOutputGPO::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionOutputGPO::loadBinary(QDataStream& in)
+{
+    quint8 state = 0;
+    in >> state;
+
+    ActionOutputGPO* action = new ActionOutputGPO();
+    action->setState((State)state);
+
+    return action;
+}
+
+void ActionOutputGPO::saveBinary(QDataStream& out)
+{
+    ActionOutput::saveBinary(out);
+
+    out << (quint8)HWOutput::GPO << (quint8)m_state;
+}
+
 
 void ActionOutputGPO::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
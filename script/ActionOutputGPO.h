@@ -14,8 +14,10 @@ public:
     };
 
     ActionOutputGPO();
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
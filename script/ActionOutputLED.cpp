@@ -2,26 +2,24 @@
 #include "script/ActionOutputLED.h"
 #include "hw/HWOutputLED.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionOutputLED::ActionOutputLED()
 {
     m_value = 0;
 }
 
-Action* ActionOutputLED::load(QDomElement* root)
+Action* ActionOutputLED::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ActionOutputLED* action = new ActionOutputLED();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("value") == 0)
+        if(elem->tag == XmlTag::Value)
         {
-            action->m_value = elem.text().toInt();
+            action->m_value = elem->text.toInt();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -46,6 +44,24 @@ QDomElement ActionOutputLED::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionOutputLED::loadBinary(QDataStream& in)
+{
+    quint32 value = 0;
+    in >> value;
+
+    ActionOutputLED* action = new ActionOutputLED();
+    action->m_value = value;
+
+    return action;
+}
+
+void ActionOutputLED::saveBinary(QDataStream& out)
+{
+    ActionOutput::saveBinary(out);
+
+    out << (quint8)HWOutput::LED << (quint32)m_value;
+}
+
 void ActionOutputLED::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
                                      std::list<Rule::RequiredVariable>* listVariable) const
@@ -2,31 +2,29 @@
 #include "script/ActionOutputRelay.h"
 #include "hw/HWOutputRelay.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionOutputRelay::ActionOutputRelay()
 {
     m_state = Off;
 }
 
-Action* ActionOutputRelay::load(QDomElement* root)
+Action* ActionOutputRelay::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ActionOutputRelay* action = new ActionOutputRelay();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("state") == 0)
+        if(elem->tag == XmlTag::State)
         {
-            if(elem.text().toLower().compare("on") == 0)
+            if(elem->text.compare("on", Qt::CaseInsensitive) == 0)
                 action->setState(On);
-            else if(elem.text().toLower().compare("off") == 0)
+            else if(elem->text.compare("off", Qt::CaseInsensitive) == 0)
                 action->setState(Off);
-            else if(elem.text().toLower().compare("toggle") == 0)
+            else if(elem->text.compare("toggle", Qt::CaseInsensitive) == 0)
                 action->setState(Toggle);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -65,6 +63,24 @@ QDomElement ActionOutputRelay::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionOutputRelay::loadBinary(QDataStream& in)
+{
+    quint8 state = 0;
+    in >> state;
+
+    ActionOutputRelay* action = new ActionOutputRelay();
+    action->setState((State)state);
+
+    return action;
+}
+
+void ActionOutputRelay::saveBinary(QDataStream& out)
+{
+    ActionOutput::saveBinary(out);
+
+    out << (quint8)HWOutput::Relay << (quint8)m_state;
+}
+
 
 void ActionOutputRelay::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
@@ -5,27 +5,26 @@
 #include "script/ActionOutputStepperPositioning.h"
 #include "script/ActionOutputStepperSetParam.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* ActionOutputStepper::load(QDomElement* root)
+Action* ActionOutputStepper::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
     ActionOutputStepper* action = NULL;
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("steppertype") == 0)
+        if(elem->tag == XmlTag::StepperType)
         {
-            if(elem.text().toLower().compare("softstop") == 0)
+            if(elem->text.compare("softstop", Qt::CaseInsensitive) == 0)
                 action = (ActionOutputStepper*)ActionOutputStepperSoftStop::load(root);
-            else if(elem.text().toLower().compare("runvelocity") == 0)
+            else if(elem->text.compare("runvelocity", Qt::CaseInsensitive) == 0)
                     action = (ActionOutputStepper*)ActionOutputStepperRunVelocity::load(root);
-            else if(elem.text().toLower().compare("positioning") == 0)
+            else if(elem->text.compare("positioning", Qt::CaseInsensitive) == 0)
                     action = (ActionOutputStepper*)ActionOutputStepperPositioning::load(root);
-            else if(elem.text().toLower().compare("setparam") == 0)
+            else if(elem->text.compare("setparam", Qt::CaseInsensitive) == 0)
                     action = (ActionOutputStepper*)ActionOutputStepperSetParam::load(root);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -44,6 +43,34 @@ QDomElement ActionOutputStepper::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionOutputStepper::loadBinary(QDataStream& in)
+{
+    quint8 stepperType = 0;
+    in >> stepperType;
+
+    switch(stepperType)
+    {
+    case SoftStop:
+        return ActionOutputStepperSoftStop::loadBinary(in);
+    case RunVelocity:
+        return ActionOutputStepperRunVelocity::loadBinary(in);
+    case Positioning:
+        return ActionOutputStepperPositioning::loadBinary(in);
+    case SetParam:
+        return ActionOutputStepperSetParam::loadBinary(in);
+    default:
+        in.setStatus(QDataStream::ReadCorruptData);
+        return NULL;
+    }
+}
+
+void ActionOutputStepper::saveBinary(QDataStream& out)
+{
+    ActionOutput::saveBinary(out);
+
+    out << (quint8)HWOutput::Stepper << (quint8)this->getStepperType();
+}
+
 
 void ActionOutputStepper::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
@@ -2,6 +2,8 @@
 #include "script/ActionOutputStepperPositioning.h"
 #include "hw/HWOutputStepper.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionOutputStepperPositioning::ActionOutputStepperPositioning()
 {
@@ -12,40 +14,37 @@ ActionOutputStepperPositioning::ActionOutputStepperPositioning()
     m_vmax = 0;
 }
 
-Action* ActionOutputStepperPositioning::load(QDomElement* root)
+Action* ActionOutputStepperPositioning::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
     ActionOutputStepperPositioning* action = new ActionOutputStepperPositioning();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("position") == 0)
+        if(elem->tag == XmlTag::Position)
         {
-            action->setPosition( elem.text().toShort() );
+            action->setPosition( elem->text.toShort() );
         }
-        else if(elem.tagName().toLower().compare("position2") == 0)
+        else if(elem->tag == XmlTag::Position2)
         {
-            action->m_position2 = elem.text().toShort();
+            action->m_position2 = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("vmin") == 0)
+        else if(elem->tag == XmlTag::VMin)
         {
-            action->m_vmin = elem.text().toShort();
+            action->m_vmin = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("vmax") == 0)
+        else if(elem->tag == XmlTag::VMax)
         {
-            action->m_vmax = elem.text().toShort();
+            action->m_vmax = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("positioningtype") == 0)
+        else if(elem->tag == XmlTag::PositioningType)
         {
-            if(elem.text().toLower().compare("setposition") == 0)
+            if(elem->text.compare("setposition", Qt::CaseInsensitive) == 0)
                 action->setPositioningType(SetPosition);
-            else if(elem.text().toLower().compare("setdualposition") == 0)
+            else if(elem->text.compare("setdualposition", Qt::CaseInsensitive) == 0)
                 action->setPositioningType(SetDualPosition);
-            else if(elem.text().toLower().compare("resetposition") == 0)
+            else if(elem->text.compare("resetposition", Qt::CaseInsensitive) == 0)
                 action->setPositioningType(ResetPosition);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -114,6 +113,32 @@ QDomElement ActionOutputStepperPositioning::save(QDomElement* root, QDomDocument
     return action;
 }
 
+Action* ActionOutputStepperPositioning::loadBinary(QDataStream& in)
+{
+    quint8 posType = 0;
+    qint16 position = 0;
+    qint16 position2 = 0;
+    quint8 vmin = 0;
+    quint8 vmax = 0;
+    in >> posType >> position >> position2 >> vmin >> vmax;
+
+    ActionOutputStepperPositioning* action = new ActionOutputStepperPositioning();
+    action->m_posType = (PositioningType)posType;
+    action->m_position = position;
+    action->m_position2 = position2;
+    action->m_vmin = vmin;
+    action->m_vmax = vmax;
+
+    return action;
+}
+
+void ActionOutputStepperPositioning::saveBinary(QDataStream& out)
+{
+    ActionOutputStepper::saveBinary(out);
+
+    out << (quint8)m_posType << (qint16)m_position << (qint16)m_position2 << (quint8)m_vmin << (quint8)m_vmax;
+}
+
 bool ActionOutputStepperPositioning::execute(unsigned int)
 {
     if(m_hw == NULL)
@@ -2,8 +2,10 @@
 #include "script/ActionOutputStepperRunVelocity.h"
 #include "hw/HWOutputStepper.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* ActionOutputStepperRunVelocity::load(QDomElement* root)
+Action* ActionOutputStepperRunVelocity::load(XmlElement* root)
 {
     return new ActionOutputStepperRunVelocity();
 }
@@ -21,6 +23,16 @@ QDomElement ActionOutputStepperRunVelocity::save(QDomElement* root, QDomDocument
     return action;
 }
 
+Action* ActionOutputStepperRunVelocity::loadBinary(QDataStream& in)
+{
+    return new ActionOutputStepperRunVelocity();
+}
+
+void ActionOutputStepperRunVelocity::saveBinary(QDataStream& out)
+{
+    ActionOutputStepper::saveBinary(out);
+}
+
 bool ActionOutputStepperRunVelocity::execute(unsigned int)
 {
     if(m_hw == NULL)
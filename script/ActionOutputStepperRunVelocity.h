@@ -6,8 +6,10 @@
 class ActionOutputStepperRunVelocity : public ActionOutputStepper
 {
 public:
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     StepperType getStepperType() const { return RunVelocity;}
 
@@ -1,100 +1,99 @@
 
 #include "script/ActionOutputStepperSetParam.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionOutputStepperSetParam::ActionOutputStepperSetParam()
 {
 }
 
-Action* ActionOutputStepperSetParam::load(QDomElement* root)
+Action* ActionOutputStepperSetParam::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
     ActionOutputStepperSetParam* action = new ActionOutputStepperSetParam();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("irun") == 0)
+        if(elem->tag == XmlTag::IRun)
         {
             action->m_param.irunSet = true;
-            action->m_param.irun = elem.text().toShort();
+            action->m_param.irun = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("ihold") == 0)
+        else if(elem->tag == XmlTag::IHold)
         {
             action->m_param.iholdSet = true;
-            action->m_param.ihold = elem.text().toShort();
+            action->m_param.ihold = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("vmax") == 0)
+        else if(elem->tag == XmlTag::VMax)
         {
             action->m_param.vmaxSet = true;
-            action->m_param.vmax = elem.text().toShort();
+            action->m_param.vmax = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("vmin") == 0)
+        else if(elem->tag == XmlTag::VMin)
         {
             action->m_param.vminSet = true;
-            action->m_param.vmin = elem.text().toShort();
+            action->m_param.vmin = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("accShape") == 0)
+        else if(elem->tag == XmlTag::AccShape)
         {
             action->m_param.accShapeSet = true;
-            action->m_param.accShape = elem.text().toShort();
+            action->m_param.accShape = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("stepMode") == 0)
+        else if(elem->tag == XmlTag::StepMode)
         {
             action->m_param.stepModeSet = true;
-            action->m_param.stepMode = elem.text().toShort();
+            action->m_param.stepMode = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("shaft") == 0)
+        else if(elem->tag == XmlTag::Shaft)
         {
             action->m_param.shaftSet = true;
-            action->m_param.shaft = elem.text().toShort();
+            action->m_param.shaft = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("acc") == 0)
+        else if(elem->tag == XmlTag::Acc)
         {
             action->m_param.accSet = true;
-            action->m_param.acc = elem.text().toShort();
+            action->m_param.acc = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("absolutThreshold") == 0)
+        else if(elem->tag == XmlTag::AbsolutThreshold)
         {
             action->m_param.absoluteThresholdSet = true;
-            action->m_param.absoluteThreshold = elem.text().toShort();
+            action->m_param.absoluteThreshold = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("deltaThreshold") == 0)
+        else if(elem->tag == XmlTag::DeltaThreshold)
         {
             action->m_param.deltaThresholdSet = true;
-            action->m_param.deltaThreshold = elem.text().toShort();
+            action->m_param.deltaThreshold = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("securePosition") == 0)
+        else if(elem->tag == XmlTag::SecurePosition)
         {
             action->m_param.securePositionSet = true;
-            action->m_param.securePosition = elem.text().toShort();
+            action->m_param.securePosition = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("fs2StallEnabled") == 0)
+        else if(elem->tag == XmlTag::FS2StallEnabled)
         {
             action->m_param.fs2StallEnabledSet = true;
-            action->m_param.fs2StallEnabled = elem.text().toShort();
+            action->m_param.fs2StallEnabled = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("minSamples") == 0)
+        else if(elem->tag == XmlTag::MinSamples)
         {
             action->m_param.minSamplesSet = true;
-            action->m_param.minSamples = elem.text().toShort();
+            action->m_param.minSamples = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("dc100StallEnable") == 0)
+        else if(elem->tag == XmlTag::DC100StallEnable)
         {
             action->m_param.dc100StallEnableSet = true;
-            action->m_param.dc100StallEnable = elem.text().toShort();
+            action->m_param.dc100StallEnable = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("PWMJitterEnable") == 0)
+        else if(elem->tag == XmlTag::PWMJitterEnable)
         {
             action->m_param.PWMJitterEnableSet = true;
-            action->m_param.PWMJitterEnable = elem.text().toShort();
+            action->m_param.PWMJitterEnable = elem->text.toShort();
         }
-        else if(elem.tagName().toLower().compare("PWMfreq") == 0)
+        else if(elem->tag == XmlTag::PWMFreq)
         {
             action->m_param.PWMfreqSet = true;
-            action->m_param.PWMfreq = elem.text().toShort();
+            action->m_param.PWMfreq = elem->text.toShort();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return action;
@@ -205,6 +204,69 @@ QDomElement ActionOutputStepperSetParam::save(QDomElement* root, QDomDocument* d
     return action;
 }
 
+template <typename T>
+static void readParam(QDataStream& in, bool* set, T* value)
+{
+    bool isSet = false;
+    qint16 v = 0;
+    in >> isSet >> v;
+
+    *set = isSet;
+    *value = (T)v;
+}
+
+/**
+ * @brief ActionOutputStepperSetParam::loadBinary reads every parameter together with its enabled flag,
+ * so the order has to be exactly the same as in ActionOutputStepperSetParam::saveBinary
+ * @param in
+ * @return
+ */
+Action* ActionOutputStepperSetParam::loadBinary(QDataStream& in)
+{
+    ActionOutputStepperSetParam* action = new ActionOutputStepperSetParam();
+
+    readParam(in, &action->m_param.irunSet, &action->m_param.irun);
+    readParam(in, &action->m_param.iholdSet, &action->m_param.ihold);
+    readParam(in, &action->m_param.vmaxSet, &action->m_param.vmax);
+    readParam(in, &action->m_param.vminSet, &action->m_param.vmin);
+    readParam(in, &action->m_param.accShapeSet, &action->m_param.accShape);
+    readParam(in, &action->m_param.stepModeSet, &action->m_param.stepMode);
+    readParam(in, &action->m_param.shaftSet, &action->m_param.shaft);
+    readParam(in, &action->m_param.accSet, &action->m_param.acc);
+    readParam(in, &action->m_param.absoluteThresholdSet, &action->m_param.absoluteThreshold);
+    readParam(in, &action->m_param.deltaThresholdSet, &action->m_param.deltaThreshold);
+    readParam(in, &action->m_param.securePositionSet, &action->m_param.securePosition);
+    readParam(in, &action->m_param.fs2StallEnabledSet, &action->m_param.fs2StallEnabled);
+    readParam(in, &action->m_param.minSamplesSet, &action->m_param.minSamples);
+    readParam(in, &action->m_param.dc100StallEnableSet, &action->m_param.dc100StallEnable);
+    readParam(in, &action->m_param.PWMJitterEnableSet, &action->m_param.PWMJitterEnable);
+    readParam(in, &action->m_param.PWMfreqSet, &action->m_param.PWMfreq);
+
+    return action;
+}
+
+void ActionOutputStepperSetParam::saveBinary(QDataStream& out)
+{
+    ActionOutputStepper::saveBinary(out);
+
+    out << m_param.irunSet << (qint16)m_param.irun;
+    out << m_param.iholdSet << (qint16)m_param.ihold;
+    out << m_param.vmaxSet << (qint16)m_param.vmax;
+    out << m_param.vminSet << (qint16)m_param.vmin;
+    out << m_param.accShapeSet << (qint16)m_param.accShape;
+    out << m_param.stepModeSet << (qint16)m_param.stepMode;
+    out << m_param.shaftSet << (qint16)m_param.shaft;
+    out << m_param.accSet << (qint16)m_param.acc;
+    out << m_param.absoluteThresholdSet << (qint16)m_param.absoluteThreshold;
+    out << m_param.deltaThresholdSet << (qint16)m_param.deltaThreshold;
+    out << m_param.securePositionSet << (qint16)m_param.securePosition;
+    out << m_param.fs2StallEnabledSet << (qint16)m_param.fs2StallEnabled;
+    out << m_param.minSamplesSet << (qint16)m_param.minSamples;
+    out << m_param.dc100StallEnableSet << (qint16)m_param.dc100StallEnable;
+    out << m_param.PWMJitterEnableSet << (qint16)m_param.PWMJitterEnable;
+    out << m_param.PWMfreqSet << (qint16)m_param.PWMfreq;
+}
+
 bool ActionOutputStepperSetParam::execute(unsigned int)
 {
     if(m_hw == NULL)
@@ -8,8 +8,10 @@ class ActionOutputStepperSetParam : public ActionOutputStepper
 {
 public:
     ActionOutputStepperSetParam();
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     StepperType getStepperType() const { return SetParam;}
 
@@ -2,8 +2,10 @@
 #include "script/ActionOutputStepperSoftStop.h"
 #include "hw/HWOutputStepper.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* ActionOutputStepperSoftStop::load(QDomElement* root)
+Action* ActionOutputStepperSoftStop::load(XmlElement* root)
 {
     return new ActionOutputStepperSoftStop();
 }
@@ -21,6 +23,16 @@ QDomElement ActionOutputStepperSoftStop::save(QDomElement* root, QDomDocument* d
     return action;
 }
 
+Action* ActionOutputStepperSoftStop::loadBinary(QDataStream& in)
+{
+    return new ActionOutputStepperSoftStop();
+}
+
+void ActionOutputStepperSoftStop::saveBinary(QDataStream& out)
+{
+    ActionOutputStepper::saveBinary(out);
+}
+
 bool ActionOutputStepperSoftStop::execute(unsigned int)
 {
     if(m_hw == NULL)
@@ -3,6 +3,8 @@
 #include "script/RuleTimerThread.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ActionSleep::ActionSleep()
 {
@@ -10,19 +12,16 @@ ActionSleep::ActionSleep()
     m_waitMs = 0;
 }
 
-Action* ActionSleep::load(QDomElement* root)
+Action* ActionSleep::load(XmlElement* root)
 {
     ActionSleep* action = new ActionSleep();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("waitms") == 0)
+        if(elem->tag == XmlTag::WaitMs)
         {
-            action->setWaitMs( elem.text().toInt() );
+            action->setWaitMs( elem->text.toInt() );
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     if(action->getWaitMs() == 0)
@@ -53,6 +52,27 @@ QDomElement ActionSleep::save(QDomElement* root, QDomDocument* document)
     return action;
 }
 
+Action* ActionSleep::loadBinary(QDataStream& in)
+{
+    quint32 waitMs = 0;
+    in >> waitMs;
+
+    if(waitMs == 0)
+        return NULL;
+
+    ActionSleep* action = new ActionSleep();
+    action->setWaitMs(waitMs);
+
+    return action;
+}
+
+void ActionSleep::saveBinary(QDataStream& out)
+{
+    Action::saveBinary(out);
+
+    out << (quint32)m_waitMs;
+}
+
 void ActionSleep::init(ConfigManager *config)
 {
     m_timerThread = config->getRuleTimerThread();
@@ -62,6 +82,10 @@ void ActionSleep::init(ConfigManager *config)
 
 void ActionSleep::deinit()
 {
+    // a paused script keeps its pending sleeps, they are continued together with the script
+    if(m_timerThread != NULL && !m_timerThread->isPaused())
+        m_timerThread->cancelRule(m_rule);
+
     m_timerThread = NULL;
 }
 
@@ -12,8 +12,10 @@ class ActionSleep : public Action
 {
 public:
     ActionSleep();
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void init(ConfigManager* config);
     void deinit();
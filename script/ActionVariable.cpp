@@ -3,32 +3,40 @@
 #include "ConfigManager.h"
 
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Action* ActionVariable::load(QDomElement* root)
+Action* ActionVariable::load(XmlElement* root)
 {
     ActionVariable* action = new ActionVariable();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("name") == 0)
+        if(elem->tag == XmlTag::Name)
         {
-            action->setVarName( elem.text().toStdString() );
+            action->setVarName( elem->text.toStdString() );
         }
-        else if(elem.tagName().toLower().compare("operand") == 0)
+        else if(elem->tag == XmlTag::Operand)
         {
-            action->setOperand( elem.text().toInt() );
+            action->setOperand( elem->text.toInt() );
         }
-        else if(elem.tagName().toLower().compare("operator") == 0)
+        else if(elem->tag == XmlTag::Operator)
         {
-            Operator op = StringToOperator(elem.text().toStdString() );
+            Operator op = StringToOperator(elem->text.toStdString() );
             action->setOperator( op );
         }
-
-        elem = elem.nextSiblingElement();
+        else if(elem->tag == XmlTag::Expression)
+        {
+            if(!action->setExpression( elem->text.toStdString() ))
+            {
+                LOG_WARN(Logger::Script, "Invalid expression %s: %s",
+                         elem->text.toStdString().c_str(), action->getExpressionError().c_str());
+            }
+        }
     }
 
-    if(action->getVarName().empty())
+    // an action without a valid expression would silently set the variable to 0
+    if(action->getVarName().empty() || (action->getOperator() == Expr && !action->isExpressionValid()))
     {
         delete action;
         return NULL;
@@ -65,9 +73,47 @@ QDomElement ActionVariable::save(QDomElement* root, QDomDocument* document)
 
     action.appendChild(op);
 
+    if(m_operator == Expr)
+    {
+        QDomElement expression = document->createElement("expression");
+        QDomText expressionText = document->createTextNode( QString::fromStdString( m_expression.getString() ) );
+        expression.appendChild(expressionText);
+
+        action.appendChild(expression);
+    }
+
+    return action;
+}
+
+Action* ActionVariable::loadBinary(QDataStream& in)
+{
+    std::string name;
+    qint32 operand = 0;
+    quint8 op = 0;
+    std::string expression;
+    in >> name >> operand >> op >> expression;
+
+    ActionVariable* action = new ActionVariable();
+    action->setVarName(name);
+    action->setOperand(operand);
+    action->setOperator((Operator)op);
+
+    if(op == Expr && !action->setExpression(expression))
+    {
+        delete action;
+        return NULL;
+    }
+
     return action;
 }
 
+void ActionVariable::saveBinary(QDataStream& out)
+{
+    Action::saveBinary(out);
+
+    out << m_varName << (qint32)m_operand << (quint8)m_operator << m_expression.getString();
+}
+
 void ActionVariable::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
                                      std::list<Rule::RequiredVariable>* listVariable) const
@@ -80,16 +126,43 @@ void ActionVariable::getRequiredList(std::list<Rule::RequiredInput>* listInput,
 
         listVariable->push_back(req);
     }
+
+    if(listInput != NULL && m_operator == Expr)
+    {
+        std::vector<std::string> names = m_expression.getNames();
+        for(std::vector<std::string>::iterator it = names.begin(); it != names.end(); it++)
+        {
+            Rule::RequiredInput req;
+            req.name = *it;
+            req.type = HWInput::EINVALID;
+            req.exists = false;
+
+            listInput->push_back(req);
+        }
+    }
 }
 
 void ActionVariable::init(ConfigManager *config)
 {
-    m_var = config->getVariableByName(m_varName);
+    m_var = config->getVariable(m_varId);
+
+    if(m_operator == Expr)
+        m_expression.init(config);
+}
+
+bool ActionVariable::dependsOn(const std::set<Symbol::Id>& names) const
+{
+    if(names.count(m_varId) != 0)
+        return true;
+
+    return m_operator == Expr && m_expression.dependsOn(names);
 }
 
 void ActionVariable::deinit()
 {
     m_var = NULL;
+
+    m_expression.deinit();
 }
 
 std::string ActionVariable::getDescription() const
@@ -107,6 +180,9 @@ std::string ActionVariable::getDescription() const
     case Minus:
         str.append(" -= ");
         break;
+    case Expr:
+        str.append(" = ").append( m_expression.getString() );
+        return str;
     }
 
     str.append( std::to_string( m_operand ) );
@@ -130,6 +206,9 @@ bool ActionVariable::execute(unsigned int)
     case Minus:
         m_var->setValue( m_var->getValue() - m_operand );
         break;
+    case Expr:
+        m_var->setValue( m_expression.evaluate() );
+        break;
     }
 
     return true;
@@ -146,6 +225,8 @@ std::string ActionVariable::OperatorToString(Operator op)
         return "Plus";
     case Minus:
         return "Minus";
+    case Expr:
+        return "Expression";
     default:
         LOG_WARN(Logger::Script, "Received invalid operator");
         return "";
@@ -162,6 +243,8 @@ ActionVariable::Operator ActionVariable::StringToOperator(std::string str)
         return Plus;
     else if( strcasecmp(cstr, "minus") == 0)
         return Minus;
+    else if( strcasecmp(cstr, "expression") == 0)
+        return Expr;
     else
         return EINVALID;
 }
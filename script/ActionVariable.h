@@ -3,30 +3,38 @@
 
 #include "script/Action.h"
 #include "script/Variable.h"
+#include "script/Expression.h"
+#include "util/Symbol.h"
 
 class ActionVariable : public Action
 {
 public:
+    ActionVariable() { m_var = NULL; m_varId = Symbol::Invalid; m_operand = 0; m_operator = Equal;}
+
     enum Operator
     {
         Equal = 0,
         Plus = 1,
         Minus = 2,
+        Expr = 3, // the variable is set to the value of the expression
         EINVALID
     };
 
-    static Action* load(QDomElement* root);
+    static Action* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Action* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
                                  std::list<Rule::RequiredVariable>* listVariable) const;
 
-    void setVarName(std::string str) { m_varName = str;}
+    void setVarName(std::string str) { m_varName = str; m_varId = Symbol::intern(str);}
     std::string getVarName() const { return m_varName;}
 
     void init(ConfigManager* config);
     void deinit();
+    bool dependsOn(const std::set<Symbol::Id>& names) const;
 
     bool execute(unsigned int step);
 
@@ -39,12 +47,19 @@ public:
     void setOperand(int value) { m_operand = value;}
     int getOperand() const { return m_operand;}
 
+    bool setExpression(std::string str) { return m_expression.setString(str);}
+    std::string getExpression() const { return m_expression.getString();}
+    std::string getExpressionError() const { return m_expression.getError();}
+    bool isExpressionValid() const { return m_expression.isValid();}
+
     static std::string OperatorToString(Operator op);
     static Operator StringToOperator(std::string str);
 protected:
     std::string m_varName;
+    Symbol::Id m_varId;
     int m_operand;
     Operator m_operator;
+    Expression m_expression;
     Variable* m_var;
 };
 
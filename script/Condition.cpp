@@ -2,27 +2,44 @@
 #include "script/Condition.h"
 #include "script/ConditionInput.h"
 #include "script/ConditionVariable.h"
+#include "script/ConditionExpression.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Condition* Condition::load(QDomElement* root)
+Condition* Condition::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("type") == 0)
+        if(elem->tag == XmlTag::Type)
         {
-            if(elem.text().toLower().compare("input") == 0)
+            if(elem->text.compare("input", Qt::CaseInsensitive) == 0)
                 return ConditionInput::load(root);
-            else if(elem.text().toLower().compare("variable") == 0)
+            else if(elem->text.compare("variable", Qt::CaseInsensitive) == 0)
                 return ConditionVariable::load(root);
+            else if(elem->text.compare("expression", Qt::CaseInsensitive) == 0)
+                return ConditionExpression::load(root);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return NULL;
 }
 
+/**
+ * @brief Condition::setFulfilled stores the new state of this condition and keeps the counter of satisfied conditions
+ * in the rule up to date, so that the rule does not have to ask every condition when it is evaluated.
+ * @param fulfilled
+ */
+void Condition::setFulfilled(bool fulfilled)
+{
+    if(m_isFulfilled == fulfilled)
+        return;
+
+    m_isFulfilled = fulfilled;
+
+    if(m_rule != NULL)
+        m_rule->conditionFulfilledChanged(fulfilled);
+}
+
 QDomElement Condition::save(QDomElement* root, QDomDocument* document)
 {
     QDomElement condition = document->createElement("condition");
@@ -31,3 +48,32 @@ QDomElement Condition::save(QDomElement* root, QDomDocument* document)
 
     return condition;
 }
+
+/**
+ * @brief Condition::loadBinary is the counterpart of Condition::saveBinary, it is used by the ScriptCache
+ * @param in
+ * @return the condition or NULL if it could not be read
+ */
+Condition* Condition::loadBinary(QDataStream& in)
+{
+    quint8 type = 0;
+    in >> type;
+
+    switch(type)
+    {
+    case Input:
+        return ConditionInput::loadBinary(in);
+    case Var:
+        return ConditionVariable::loadBinary(in);
+    case Expr:
+        return ConditionExpression::loadBinary(in);
+    default:
+        in.setStatus(QDataStream::ReadCorruptData);
+        return NULL;
+    }
+}
+
+void Condition::saveBinary(QDataStream& out)
+{
+    out << (quint8)this->getType();
+}
@@ -15,29 +15,43 @@ public:
     {
         Input = 0,
         Var = 1, // cannot be named Variable as this leads to conflict with the class
+        Expr = 2,
     };
 
+    Condition() { m_rule = NULL; m_isFulfilled = false;}
+
     void setRule(Rule* rule) { m_rule = rule;}
+    Rule* getRule() const { return m_rule;}
 
-    static Condition* load(QDomElement* root);
+    static Condition* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Condition* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     virtual void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
                                  std::list<Rule::RequiredVariable>* listVariable) const {};
 
+    // true if init resolves one of these variable or rule names
+    virtual bool dependsOn(__attribute__((unused)) const std::set<Symbol::Id>& names) const { return false;}
+
     virtual void init(ConfigManager* config) = 0;
     virtual void deinit() = 0;
 
-    virtual bool isFulfilled() const = 0;
+    // called by the RuleExecutor if a trigger of this condition had been suppressed, see TriggerFilter::allowed
+    virtual void recheck() {}
+
+    bool isFulfilled() const { return m_isFulfilled;}
     virtual Type getType() const = 0;
     virtual std::string getDescription() const = 0;
 
 protected:
     void conditionChanged() { m_rule->conditionChanged(this);}
+    void setFulfilled(bool fulfilled);
 
 private:
     Rule* m_rule;
+    bool m_isFulfilled;
 };
 
 #endif // CONDITION_H
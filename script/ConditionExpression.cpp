@@ -0,0 +1,129 @@
+
+#include "script/ConditionExpression.h"
+#include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
+
+Condition* ConditionExpression::load(XmlElement* root)
+{
+    ConditionExpression* condition = new ConditionExpression();
+
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
+    {
+        if(elem->tag == XmlTag::Expression)
+        {
+            if(!condition->setExpression( elem->text.toStdString() ))
+            {
+                LOG_WARN(Logger::Script, "Invalid expression %s: %s",
+                         elem->text.toStdString().c_str(), condition->getError().c_str());
+            }
+        }
+    }
+
+    if(!condition->m_expression.isValid())
+    {
+        delete condition;
+        return NULL;
+    }
+
+    return condition;
+}
+
+QDomElement ConditionExpression::save(QDomElement* root, QDomDocument* document)
+{
+    QDomElement condition = Condition::save(root, document);
+
+    QDomElement type = document->createElement("type");
+    QDomText typeText = document->createTextNode("expression");
+    type.appendChild(typeText);
+
+    condition.appendChild(type);
+
+    QDomElement expression = document->createElement("expression");
+    QDomText expressionText = document->createTextNode( QString::fromStdString( m_expression.getString() ) );
+    expression.appendChild(expressionText);
+
+    condition.appendChild(expression);
+
+    return condition;
+}
+
+/**
+ * @brief ConditionExpression::loadBinary reads the source of the expression, compiling it again is cheap
+ * @param in
+ * @return
+ */
+Condition* ConditionExpression::loadBinary(QDataStream& in)
+{
+    std::string str;
+    in >> str;
+
+    ConditionExpression* condition = new ConditionExpression();
+
+    if(!condition->setExpression(str))
+    {
+        delete condition;
+        return NULL;
+    }
+
+    return condition;
+}
+
+void ConditionExpression::saveBinary(QDataStream& out)
+{
+    Condition::saveBinary(out);
+
+    out << m_expression.getString();
+}
+
+void ConditionExpression::getRequiredList(std::list<Rule::RequiredInput>* listInput,
+                                          std::list<Rule::RequiredOutput>* listOutput,
+                                          std::list<Rule::RequiredVariable>* listVariable) const
+{
+    if(listInput != NULL)
+    {
+        std::vector<std::string> names = m_expression.getNames();
+        for(std::vector<std::string>::iterator it = names.begin(); it != names.end(); it++)
+        {
+            Rule::RequiredInput req;
+            req.name = *it;
+            req.type = HWInput::EINVALID;
+            req.exists = false;
+
+            listInput->push_back(req);
+        }
+    }
+}
+
+void ConditionExpression::init(ConfigManager *config)
+{
+    m_expression.init(config);
+}
+
+void ConditionExpression::deinit()
+{
+    m_expression.deinit();
+}
+
+/**
+ * @brief ConditionExpression::update is called by the DispatchTable every time a variable or input of the expression has changed
+ * @param changed input which has changed, its value is taken from the event instead of the input, see Expression::evaluate
+ * @param value
+ */
+void ConditionExpression::update(const HWInput* changed, int value)
+{
+    bool isFulfilled = m_expression.evaluate(changed, value) != 0;
+
+    if(this->isFulfilled() != isFulfilled)
+    {
+        this->setFulfilled(isFulfilled);
+
+        if(isFulfilled)
+            this->conditionChanged();
+    }
+}
+
+std::string ConditionExpression::getDescription() const
+{
+    return std::string("If ").append( m_expression.getString() );
+}
@@ -0,0 +1,43 @@
+#ifndef CONDITIONEXPRESSION_H
+#define CONDITIONEXPRESSION_H
+
+#include "script/Condition.h"
+#include "script/Expression.h"
+
+/**
+ * @brief The ConditionExpression class is fulfilled as long as its expression is not 0.
+ * It depends on every variable and input used in the expression.
+ */
+class ConditionExpression : public Condition
+{
+public:
+    static Condition* load(XmlElement* root);
+    virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Condition* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
+
+    void getRequiredList(std::list<Rule::RequiredInput>* listInput,
+                                 std::list<Rule::RequiredOutput>* listOutput,
+                                 std::list<Rule::RequiredVariable>* listVariable) const;
+
+    void init(ConfigManager* config);
+    void deinit();
+    bool dependsOn(const std::set<Symbol::Id>& names) const { return m_expression.dependsOn(names);}
+
+    Type getType() const { return Expr;}
+    std::string getDescription() const;
+
+    bool setExpression(std::string str) { return m_expression.setString(str);}
+    std::string getExpression() const { return m_expression.getString();}
+    std::string getError() const { return m_expression.getError();}
+
+    std::vector<Variable*> getVariables() const { return m_expression.getVariables();}
+    std::vector<HWInput*> getInputs() const { return m_expression.getInputs();}
+
+    void update(const HWInput* changed = NULL, int value = 0);
+
+private:
+    Expression m_expression;
+};
+
+#endif // CONDITIONEXPRESSION_H
@@ -4,22 +4,20 @@
 #include "script/ConditionInputFader.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Condition* ConditionInput::load(QDomElement* root)
+Condition* ConditionInput::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("subtype") == 0)
+        if(elem->tag == XmlTag::Subtype)
         {
-            if(elem.text().toLower().compare("button") == 0)
+            if(elem->text.compare("button", Qt::CaseInsensitive) == 0)
                 return ConditionInputButton::load(root);
-            else if(elem.text().toLower().compare("fader") == 0)
+            else if(elem->text.compare("fader", Qt::CaseInsensitive) == 0)
                 return ConditionInputFader::load(root);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return NULL;
@@ -44,16 +42,46 @@ QDomElement ConditionInput::save(QDomElement* root, QDomDocument* document)
     return condition;
 }
 
-void ConditionInput::init(ConfigManager *config)
+Condition* ConditionInput::loadBinary(QDataStream& in)
 {
-    m_hw = config->getInputByName(m_HWName);
+    std::string name;
+    quint8 subtype = 0;
+    ConditionInput* condition = NULL;
 
-    if(m_hw != NULL)
-        m_hw->registerInputListener(this);
+    in >> name >> subtype;
+
+    switch(subtype)
+    {
+    case HWInput::Button:
+        condition = (ConditionInput*)ConditionInputButton::loadBinary(in);
+        break;
+    case HWInput::Fader:
+        condition = (ConditionInput*)ConditionInputFader::loadBinary(in);
+        break;
+    default:
+        in.setStatus(QDataStream::ReadCorruptData);
+        return NULL;
+    }
+
+    if(condition != NULL)
+        condition->setHWName(name);
+
+    return condition;
+}
+
+void ConditionInput::saveBinary(QDataStream& out)
+{
+    Condition::saveBinary(out);
+
+    out << m_HWName << (quint8)this->getInputType();
+}
+
+void ConditionInput::init(ConfigManager *config)
+{
+    m_hw = config->getInput(m_HWId);
 }
 
 void ConditionInput::deinit()
 {
-    if(m_hw != NULL)
-        m_hw->unregisterInputListener(this);
+    m_hw = NULL;
 }
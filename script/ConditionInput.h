@@ -2,26 +2,37 @@
 #define CONDITIONINPUT_H
 
 #include "script/Condition.h"
-#include "hw/HWInputListener.h"
-
-class ConditionInput : public Condition, public HWInputListener
+#include "hw/HWInput.h"
+#include "util/Symbol.h"
+
+/**
+ * @brief The ConditionInput class is the base class for all conditions on hardware inputs.
+ * The conditions do not listen to their input themselves, the DispatchTable of the script does this for them.
+ */
+class ConditionInput : public Condition
 {
 public:
-    static Condition* load(QDomElement* root);
+    ConditionInput() { m_hw = NULL; m_HWId = Symbol::Invalid;}
+
+    static Condition* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Condition* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     Type getType() const { return Input;}
 
     void init(ConfigManager* config);
     void deinit();    
 
-    void setHWName(std::string str) { m_HWName = str;}
+    void setHWName(std::string str) { m_HWName = str; m_HWId = Symbol::intern(str);}
     std::string getHWName() const { return m_HWName;}
 
-protected:
-    virtual void onInputChanged(HWInput *hw) = 0;
+    HWInput* getHW() const { return m_hw;}
+    virtual HWInput::HWInputType getInputType() const = 0;
 
+protected:
     std::string m_HWName;
+    Symbol::Id m_HWId;
     HWInput* m_hw;
 };
 
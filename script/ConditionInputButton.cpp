@@ -4,23 +4,21 @@
 #include "hw/HWInputButton.h"
 
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Condition* ConditionInputButton::load(QDomElement* root)
+Condition* ConditionInputButton::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ConditionInputButton* condition = new ConditionInputButton();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("trigger") == 0)
+        if(elem->tag == XmlTag::Trigger)
         {
-            condition->setTrigger( StringToTrigger( elem.text().toStdString() ) );
+            condition->setTrigger( StringToTrigger( elem->text.toStdString() ) );
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
-            condition->setHWName(elem.text().toStdString());
-
-        elem = elem.nextSiblingElement();
+        else if(elem->tag == XmlTag::Name)
+            condition->setHWName(elem->text.toStdString());
     }
 
     if(condition->getHWName().empty())
@@ -52,6 +50,24 @@ QDomElement ConditionInputButton::save(QDomElement* root, QDomDocument* document
     return condition;
 }
 
+Condition* ConditionInputButton::loadBinary(QDataStream& in)
+{
+    quint8 trigger = 0;
+    in >> trigger;
+
+    ConditionInputButton* condition = new ConditionInputButton();
+    condition->setTrigger((Trigger)trigger);
+
+    return condition;
+}
+
+void ConditionInputButton::saveBinary(QDataStream& out)
+{
+    ConditionInput::saveBinary(out);
+
+    out << (quint8)m_trigger;
+}
+
 void ConditionInputButton::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
                                      std::list<Rule::RequiredVariable>* listVariable) const
@@ -67,33 +83,35 @@ void ConditionInputButton::getRequiredList(std::list<Rule::RequiredInput>* listI
     }
 }
 
-void ConditionInputButton::onInputChanged(HWInput* hw)
+/**
+ * @brief ConditionInputButton::update is called by the DispatchTable every time the button has changed
+ * @param value new value of the button
+ */
+void ConditionInputButton::update(bool value)
 {
-    pi_assert(m_hw == hw && m_hw->getType() == HWInput::Button);
-
     bool isFulfilled = false;
 
     if(m_trigger == Pressed)
     {
-        if(((HWInputButton*)hw)->getValue() == true)
+        if(value == true)
             isFulfilled = true;
     }
     else if(m_trigger == Released)
     {
-        if(((HWInputButton*)hw)->getValue() == false)
+        if(value == false)
             isFulfilled = true;
     }
-    else // m_trigger == Toggle
+    else // m_trigger == Changed
     {
-        // we have to trick here, so that we do not have to change the part below
-        // todo: find a better way to do this
-        m_isFulfilled = false;
-        isFulfilled = true; // we cannot compare with earlier values, so we have to believe that something has indeed changed
+        // we cannot compare with earlier values, so we have to believe that something has indeed changed
+        this->setFulfilled(true);
+        this->conditionChanged();
+        return;
     }
 
-    if(m_isFulfilled != isFulfilled)
+    if(this->isFulfilled() != isFulfilled)
     {
-        m_isFulfilled = isFulfilled;
+        this->setFulfilled(isFulfilled);
 
         // only call conditionChanged if there is the possibility that all conditons are true
         // if this conditon is not true there is no point in telling anyone
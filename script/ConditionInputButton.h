@@ -17,10 +17,12 @@ public:
     static std::string TriggerToString(Trigger trigger);
     static Trigger StringToTrigger(std::string str);
 
-    ConditionInputButton() { m_trigger = Pressed; m_isFulfilled = false;}
+    ConditionInputButton() { m_trigger = Pressed;}
 
-    static Condition* load(QDomElement* root);
+    static Condition* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Condition* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
@@ -28,16 +30,15 @@ public:
 
     std::string getDescription() const;
 
-    bool isFulfilled() const { return m_isFulfilled;}
+    HWInput::HWInputType getInputType() const { return HWInput::Button;}
 
-    void setTrigger(Trigger trig) { m_isFulfilled = false; m_trigger = trig;}
+    void setTrigger(Trigger trig) { this->setFulfilled(false); m_trigger = trig;}
     Trigger getTrigger() const { return m_trigger;}
 
-private:
-    void onInputChanged(HWInput *hw);
+    void update(bool value);
 
+private:
     Trigger m_trigger;
-    bool m_isFulfilled;
 };
 
 #endif // CONDITIONINPUTBUTTON_H
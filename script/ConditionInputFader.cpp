@@ -5,27 +5,27 @@
 #include "hw/HWInputFader.h"
 
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
-Condition* ConditionInputFader::load(QDomElement* root)
+Condition* ConditionInputFader::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ConditionInputFader* condition = new ConditionInputFader();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("trigger") == 0)
+        if(elem->tag == XmlTag::Trigger)
         {
-            condition->setTrigger( StringToTrigger( elem.text().toStdString() ) );
+            condition->setTrigger( StringToTrigger( elem->text.toStdString() ) );
         }
-        else if(elem.tagName().toLower().compare("triggervalue") == 0)
+        else if(elem->tag == XmlTag::TriggerValue)
         {
-            condition->m_triggerValue = elem.text().toInt();
+            condition->m_triggerValue = elem->text.toInt();
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
-            condition->setHWName(elem.text().toStdString());
-
-        elem = elem.nextSiblingElement();
+        else if(elem->tag == XmlTag::Name)
+            condition->setHWName(elem->text.toStdString());
+        else
+            condition->m_filter.load(*elem);
     }
 
     if(condition->getHWName().empty())
@@ -61,9 +61,33 @@ QDomElement ConditionInputFader::save(QDomElement* root, QDomDocument* document)
 
     condition.appendChild(triggerValue);
 
+    m_filter.save(&condition, document);
+
+    return condition;
+}
+
+Condition* ConditionInputFader::loadBinary(QDataStream& in)
+{
+    quint8 trigger = 0;
+    quint32 triggerValue = 0;
+    in >> trigger >> triggerValue;
+
+    ConditionInputFader* condition = new ConditionInputFader();
+    condition->setTrigger((Trigger)trigger);
+    condition->m_triggerValue = triggerValue;
+    condition->m_filter.loadBinary(in);
+
     return condition;
 }
 
+void ConditionInputFader::saveBinary(QDataStream& out)
+{
+    ConditionInput::saveBinary(out);
+
+    out << (quint8)m_trigger << (quint32)m_triggerValue;
+    m_filter.saveBinary(out);
+}
+
 void ConditionInputFader::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
                                      std::list<Rule::RequiredVariable>* listVariable) const
@@ -79,39 +103,65 @@ void ConditionInputFader::getRequiredList(std::list<Rule::RequiredInput>* listIn
     }
 }
 
-void ConditionInputFader::onInputChanged(HWInput* hw)
+void ConditionInputFader::init(ConfigManager* config)
 {
-    pi_assert(m_hw == hw && m_hw->getType() == HWInput::Fader);
+    ConditionInput::init(config);
+    m_filter.init(config);
+}
+
+void ConditionInputFader::deinit()
+{
+    ConditionInput::deinit();
+    m_filter.deinit();
+}
 
+/**
+ * @brief ConditionInputFader::update is called by the DispatchTable every time the fader has changed
+ * @param value new value of the fader
+ */
+void ConditionInputFader::update(unsigned int value)
+{
     bool isFulfilled = false;
-    HWInputFader* fader = (HWInputFader*) hw;
 
     if(m_trigger == GreaterThan)
     {
-        if( fader->getValue() > m_triggerValue )
-            isFulfilled = true;
+        isFulfilled = m_filter.greaterThan(this->isFulfilled(), value, m_triggerValue);
     }
     else if(m_trigger == LessThan)
     {
-        if( fader->getValue() < m_triggerValue )
-            isFulfilled = true;
+        isFulfilled = m_filter.lessThan(this->isFulfilled(), value, m_triggerValue);
     }
     else if(m_trigger == Equal)
     {
-        if( fader->getValue() == m_triggerValue )
-            isFulfilled = true;
+        isFulfilled = m_filter.equal(this->isFulfilled(), value, m_triggerValue);
     }
-    else // m_trigger == Changed
+    else
     {
-        // we have to trick here, so that we do not have to change the part below
-        // todo: find a better way to do this
-        m_isFulfilled = false;
-        isFulfilled = true; // we cannot compare with earlier values, so we have to believe that something has indeed changed
+        bool fired = false;
+        if(m_trigger == Changed)
+            fired = m_filter.changed(value);
+        else if(m_trigger == Rising)
+            fired = m_filter.edge(value, m_triggerValue) == TriggerFilter::Rising;
+        else // m_trigger == Falling
+            fired = m_filter.edge(value, m_triggerValue) == TriggerFilter::Falling;
+
+        // edges are only fulfilled for the moment they happen, so they start the rule if all other conditions are true right now
+        if(fired && m_filter.allowed())
+        {
+            this->setFulfilled(true);
+            this->conditionChanged();
+            this->setFulfilled(false);
+        }
+        return;
     }
 
-    if(m_isFulfilled != isFulfilled)
+    if(this->isFulfilled() != isFulfilled)
     {
-        m_isFulfilled = isFulfilled;
+        // a suppressed trigger leaves the condition unfulfilled, it is evaluated again when the minimum interval has expired
+        if(isFulfilled && !m_filter.allowed(this))
+            return;
+
+        this->setFulfilled(isFulfilled);
 
         // only call conditionChanged if there is the possibility that all conditons are true
         // if this conditon is not true there is no point in telling anyone
@@ -121,6 +171,17 @@ void ConditionInputFader::onInputChanged(HWInput* hw)
     }
 }
 
+/**
+ * @brief ConditionInputFader::recheck evaluates the current value of the fader again after a suppressed trigger
+ */
+void ConditionInputFader::recheck()
+{
+    m_filter.rechecked();
+
+    if(m_hw != NULL)
+        this->update(((HWInputFader*)m_hw)->getValue());
+}
+
 std::string ConditionInputFader::getDescription() const
 {
     std::string str = std::string("If ").append(m_HWName);
@@ -139,6 +200,14 @@ std::string ConditionInputFader::getDescription() const
     case Changed:
         str.append(" has changed");
         break;
+    case Rising:
+        str.append(" rises above ");
+        break;
+    case Falling:
+        str.append(" falls to or below ");
+        break;
+    default:
+        break;
     }
 
     if( m_trigger != Changed)
@@ -146,6 +215,8 @@ std::string ConditionInputFader::getDescription() const
         str.append( std::to_string(m_triggerValue) );
     }
 
+    str.append( m_filter.getDescription() );
+
     return str;
 }
 
@@ -167,6 +238,14 @@ std::string ConditionInputFader::TriggerToString(Trigger trigger)
     case Changed:
         return "changed";
         break;
+    case Rising:
+        return "rising";
+        break;
+    case Falling:
+        return "falling";
+        break;
+    default:
+        break;
     }
 
     LOG_WARN(Logger::Script, "Received invalid trigger");
@@ -185,6 +264,10 @@ ConditionInputFader::Trigger ConditionInputFader::StringToTrigger(std::string st
         return Equal;
     else if( strcasecmp(cstr, "changed") == 0)
         return Changed;
+    else if( strcasecmp(cstr, "rising") == 0)
+        return Rising;
+    else if( strcasecmp(cstr, "falling") == 0)
+        return Falling;
     else
         return EINVALID;
 }
@@ -2,6 +2,7 @@
 #define CONDITIONINPUTFADER_H
 
 #include "script/ConditionInput.h"
+#include "script/TriggerFilter.h"
 
 class ConditionInputFader : public ConditionInput
 {
@@ -12,16 +13,20 @@ public:
         LessThan,
         Equal,
         Changed,
+        Rising,
+        Falling,
 
         EINVALID,
     };
     static std::string TriggerToString(Trigger trigger);
     static Trigger StringToTrigger(std::string str);
 
-    ConditionInputFader() { m_trigger = Equal; m_triggerValue = 100; m_isFulfilled = false;}
+    ConditionInputFader() { m_trigger = Equal; m_triggerValue = 100;}
 
-    static Condition* load(QDomElement* root);
+    static Condition* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Condition* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
@@ -29,21 +34,26 @@ public:
 
     std::string getDescription() const;
 
-    bool isFulfilled() const { return m_isFulfilled;}
+    HWInput::HWInputType getInputType() const { return HWInput::Fader;}
 
-    void setTrigger(Trigger trig) { m_isFulfilled = false; m_trigger = trig;}
+    void init(ConfigManager* config);
+    void deinit();
+
+    void setTrigger(Trigger trig) { this->setFulfilled(false); m_trigger = trig;}
     Trigger getTrigger() const { return m_trigger;}
 
     void setTriggerValue(unsigned int value) { m_triggerValue = value;}
     unsigned int getTriggerValue() const { return m_triggerValue;}
 
-private:
-    void onInputChanged(HWInput *hw);
+    TriggerFilter* getFilter() { return &m_filter;}
+
+    void update(unsigned int value);
+    void recheck();
 
+private:
     Trigger m_trigger;
     unsigned int m_triggerValue;
-
-    bool m_isFulfilled;
+    TriggerFilter m_filter;
 };
 
 #endif // CONDITIONINPUTFADER_H
@@ -3,44 +3,53 @@
 #include "script/Variable.h"
 #include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 ConditionVariable::ConditionVariable()
 {
     m_triggerValue = -1;
     m_trigger = Equal;
-    m_isFulfilled = false;
+    m_var = NULL;
+    m_varId = Symbol::Invalid;
 }
 
-Condition* ConditionVariable::load(QDomElement* root)
+Condition* ConditionVariable::load(XmlElement* root)
 {
-    QDomElement elem = root->firstChildElement();
-
     ConditionVariable* condition = new ConditionVariable();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("name") == 0)
+        if(elem->tag == XmlTag::Name)
         {
-            condition->setVarName( elem.text().toStdString() );
+            condition->setVarName( elem->text.toStdString() );
         }
-        else if(elem.tagName().toLower().compare("value") == 0)
+        else if(elem->tag == XmlTag::Value)
         {
-            condition->setTriggerValue( elem.text().toInt() );
+            condition->setTriggerValue( elem->text.toInt() );
         }
-        else if(elem.tagName().toLower().compare("trigger") == 0)
+        else if(elem->tag == XmlTag::Trigger)
         {
-            QString trigger = elem.text().toLower();
-            if( trigger.compare("equal") == 0)
+            const QString& trigger = elem->text;
+            if( trigger.compare("equal", Qt::CaseInsensitive) == 0)
                 condition->setTrigger(Equal);
-            else if( trigger.compare("nolongerequal") == 0)
+            else if( trigger.compare("nolongerequal", Qt::CaseInsensitive) == 0)
                 condition->setTrigger(NoLongerEqual);
-            else if( trigger.compare("greaterthan") == 0)
+            else if( trigger.compare("greaterthan", Qt::CaseInsensitive) == 0)
                 condition->setTrigger(GreaterThan);
-            else if( trigger.compare("lessthan") == 0)
+            else if( trigger.compare("lessthan", Qt::CaseInsensitive) == 0)
                 condition->setTrigger(LessThan);
+            else if( trigger.compare("rising", Qt::CaseInsensitive) == 0)
+                condition->setTrigger(Rising);
+            else if( trigger.compare("falling", Qt::CaseInsensitive) == 0)
+                condition->setTrigger(Falling);
+            else if( trigger.compare("changed", Qt::CaseInsensitive) == 0)
+                condition->setTrigger(Changed);
+        }
+        else
+        {
+            condition->m_filter.load(*elem);
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return condition;
@@ -86,15 +95,52 @@ QDomElement ConditionVariable::save(QDomElement* root, QDomDocument* document)
     case LessThan:
         triggerValue.setNodeValue("LessThan");
         break;
+    case Rising:
+        triggerValue.setNodeValue("Rising");
+        break;
+    case Falling:
+        triggerValue.setNodeValue("Falling");
+        break;
+    case Changed:
+        triggerValue.setNodeValue("Changed");
+        break;
+    default:
+        break;
     }
 
     trigger.appendChild(triggerValue);
 
     condition.appendChild(trigger);
 
+    m_filter.save(&condition, document);
+
     return condition;
 }
 
+Condition* ConditionVariable::loadBinary(QDataStream& in)
+{
+    std::string name;
+    quint8 trigger = 0;
+    qint32 triggerValue = 0;
+    in >> name >> trigger >> triggerValue;
+
+    ConditionVariable* condition = new ConditionVariable();
+    condition->setVarName(name);
+    condition->setTrigger((Trigger)trigger);
+    condition->setTriggerValue(triggerValue);
+    condition->m_filter.loadBinary(in);
+
+    return condition;
+}
+
+void ConditionVariable::saveBinary(QDataStream& out)
+{
+    Condition::saveBinary(out);
+
+    out << m_varName << (quint8)m_trigger << (qint32)m_triggerValue;
+    m_filter.saveBinary(out);
+}
+
 void ConditionVariable::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                      std::list<Rule::RequiredOutput>* listOutput,
                                      std::list<Rule::RequiredVariable>* listVariable) const
@@ -111,42 +157,76 @@ void ConditionVariable::getRequiredList(std::list<Rule::RequiredInput>* listInpu
 
 void ConditionVariable::init(ConfigManager *config)
 {
-    m_var = config->getVariableByName(m_varName);
-
-    if(m_var != NULL)
-        m_var->registerVariableListener(this);
+    m_var = config->getVariable(m_varId);
+    m_filter.init(config);
 }
 
 void ConditionVariable::deinit()
 {
-    if(m_var != NULL)
-        m_var->unregisterVariableListener(this);
+    m_var = NULL;
+    m_filter.deinit();
 }
 
-void ConditionVariable::onVariableChanged(Variable *var)
+/**
+ * @brief ConditionVariable::update is called by the DispatchTable every time the variable has changed
+ * @param value new value of the variable
+ */
+void ConditionVariable::update(int value)
 {
-    pi_assert(m_var == var);
-
     bool isFulfilled = false;
 
     if(m_trigger == Equal)
-        isFulfilled = var->getValue() == m_triggerValue;
+        isFulfilled = m_filter.equal(this->isFulfilled(), value, m_triggerValue);
     else if(m_trigger == NoLongerEqual)
-        isFulfilled = var->getValue() != m_triggerValue;
+        isFulfilled = !m_filter.equal(!this->isFulfilled(), value, m_triggerValue);
     else if(m_trigger == GreaterThan)
-        isFulfilled = var->getValue() > m_triggerValue;
+        isFulfilled = m_filter.greaterThan(this->isFulfilled(), value, m_triggerValue);
     else if(m_trigger == LessThan)
-        isFulfilled = var->getValue() < m_triggerValue;
+        isFulfilled = m_filter.lessThan(this->isFulfilled(), value, m_triggerValue);
+    else
+    {
+        bool fired = false;
+        if(m_trigger == Changed)
+            fired = m_filter.changed(value);
+        else if(m_trigger == Rising)
+            fired = m_filter.edge(value, m_triggerValue) == TriggerFilter::Rising;
+        else // m_trigger == Falling
+            fired = m_filter.edge(value, m_triggerValue) == TriggerFilter::Falling;
+
+        // edges are only fulfilled for the moment they happen, see ConditionInputFader::update
+        if(fired && m_filter.allowed())
+        {
+            this->setFulfilled(true);
+            this->conditionChanged();
+            this->setFulfilled(false);
+        }
+        return;
+    }
 
-    if(m_isFulfilled != isFulfilled)
+    if(this->isFulfilled() != isFulfilled)
     {
-        m_isFulfilled = isFulfilled;
+        // a suppressed trigger leaves the condition unfulfilled, it is evaluated again when the minimum interval has expired
+        if(isFulfilled && !m_filter.allowed(this))
+            return;
+
+        this->setFulfilled(isFulfilled);
 
-        if(m_isFulfilled)
+        if(isFulfilled)
             this->conditionChanged();
     }
 }
 
+/**
+ * @brief ConditionVariable::recheck evaluates the current value of the variable again after a suppressed trigger
+ */
+void ConditionVariable::recheck()
+{
+    m_filter.rechecked();
+
+    if(m_var != NULL)
+        this->update(m_var->getValue());
+}
+
 std::string ConditionVariable::getDescription() const
 {
     std::string str = "If ";
@@ -157,9 +237,19 @@ std::string ConditionVariable::getDescription() const
         str.append(" is greater than ");
     else if(m_trigger == LessThan)
         str.append(" is less than ");
+    else if(m_trigger == Rising)
+        str.append(" rises above ");
+    else if(m_trigger == Falling)
+        str.append(" falls to or below ");
+    else if(m_trigger == Changed)
+        str.append(" has changed");
     else // m_trigger == NoLongerEqual
         str.append(" is no longer equal to ");
-    str.append( std::to_string(m_triggerValue) );
+
+    if(m_trigger != Changed)
+        str.append( std::to_string(m_triggerValue) );
+
+    str.append( m_filter.getDescription() );
 
     return str;
 }
@@ -2,9 +2,12 @@
 #define CONDITIONVARIABLE_H
 
 #include "script/Condition.h"
-#include "script/VariableListener.h"
+#include "script/TriggerFilter.h"
+#include "util/Symbol.h"
 
-class ConditionVariable : public Condition, public VariableListener
+class Variable;
+
+class ConditionVariable : public Condition
 {
 public:
     enum Trigger
@@ -13,12 +16,17 @@ public:
         NoLongerEqual = 1,
         GreaterThan = 2,
         LessThan = 3,
+        Rising = 4,
+        Falling = 5,
+        Changed = 6,
         EINVALID
     };
 
     ConditionVariable();
-    static Condition* load(QDomElement* root);
+    static Condition* load(XmlElement* root);
     virtual QDomElement save(QDomElement* root, QDomDocument* document);
+    static Condition* loadBinary(QDataStream& in);
+    virtual void saveBinary(QDataStream& out);
 
     virtual void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                                  std::list<Rule::RequiredOutput>* listOutput,
@@ -26,28 +34,33 @@ public:
 
     void init(ConfigManager* config);
     void deinit();
+    bool dependsOn(const std::set<Symbol::Id>& names) const { return names.count(m_varId) != 0;}
 
-    void setVarName(std::string str) { m_varName = str;}
+    void setVarName(std::string str) { m_varName = str; m_varId = Symbol::intern(str);}
     std::string getVarName() const { return m_varName;}
 
-    bool isFulfilled() const { return m_isFulfilled;}
     Type getType() const { return Var;}
     std::string getDescription() const;
 
     Trigger getTrigger() const { return m_trigger;}
-    void setTrigger(Trigger trig) { m_isFulfilled = false; m_trigger = trig;}
+    void setTrigger(Trigger trig) { this->setFulfilled(false); m_trigger = trig;}
 
     int getTriggerValue() const { return m_triggerValue;}
     void setTriggerValue(int value) { m_triggerValue = value;}
 
-private:
-    void onVariableChanged(Variable *var);
+    TriggerFilter* getFilter() { return &m_filter;}
 
+    Variable* getVar() const { return m_var;}
+    void update(int value);
+    void recheck();
+
+private:
     Variable* m_var;
     Trigger m_trigger;
     int m_triggerValue;
+    TriggerFilter m_filter;
     std::string m_varName;
-    bool m_isFulfilled;
+    Symbol::Id m_varId;
 };
 
 #endif // CONDITIONVARIABLE_H
@@ -0,0 +1,455 @@
+
+#include "script/DispatchTable.h"
+#include "script/Rule.h"
+#include "script/Condition.h"
+#include "script/ConditionInputButton.h"
+#include "script/ConditionInputFader.h"
+#include "script/ConditionVariable.h"
+#include "script/ConditionExpression.h"
+#include "script/Variable.h"
+#include "script/RuleExecutor.h"
+#include "hw/HWInputButton.h"
+#include "hw/HWInputFader.h"
+#include "util/Debug.h"
+
+#include <algorithm>
+
+DispatchTable::DispatchTable()
+{
+    m_active = false;
+    m_executor = NULL;
+}
+
+DispatchTable::~DispatchTable()
+{
+    this->clear();
+}
+
+/**
+ * @brief DispatchTable::build collects the conditions of all rules per input and variable and registers itself
+ * as listener afterwards. The conditions must already be initialized.
+ * The initial state of the conditions is evaluated by the executor in the order of listRules, so callable rules should come first.
+ * @param listRules
+ * @param executor
+ */
+void DispatchTable::build(const std::vector<Rule*>& listRules, RuleExecutor* executor)
+{
+    pi_assert(executor != NULL);
+
+    this->clear();
+
+    m_executor = executor;
+
+    unsigned int numConditions = 0;
+
+    for(std::vector<Rule*>::const_iterator ruleIt = listRules.begin(); ruleIt != listRules.end(); ruleIt++)
+    {
+        numConditions += this->insertRule(*ruleIt);
+    }
+
+    m_listEvaluate = listRules;
+
+    // registering a listener calls it immediately, this is ignored as m_active is still false
+    this->registerListeners();
+
+    // every event posted from now on is processed after the initial evaluation
+    m_executor->post(RuleExecutor::Evaluate, this);
+
+    m_active = true;
+
+    LOG_DEBUG(Logger::Script, "Dispatch table built: %u inputs, %u variables, %u conditions",
+              (unsigned int)m_mapInput.size(), (unsigned int)m_mapVariable.size(), numConditions);
+}
+
+/**
+ * @brief DispatchTable::addRules adds the conditions of the given rules to an active table.
+ * The RuleExecutor must be suspended and the conditions must already be initialized.
+ * Only the conditions of the new rules are evaluated, after the executor has been resumed.
+ * @param listRules
+ */
+void DispatchTable::addRules(const std::vector<Rule*>& listRules)
+{
+    pi_assert(m_executor != NULL);
+
+    for(std::vector<Rule*>::const_iterator ruleIt = listRules.begin(); ruleIt != listRules.end(); ruleIt++)
+    {
+        this->insertRule(*ruleIt);
+        m_listEvaluate.push_back(*ruleIt);
+    }
+
+    this->registerListeners();
+
+    m_executor->post(RuleExecutor::Evaluate, this);
+}
+
+/**
+ * @brief DispatchTable::removeRules removes the conditions of the given rules from the table.
+ * The RuleExecutor must be suspended. Inputs and variables which are no longer used are unregistered,
+ * their entries are deleted by DispatchTable::release, after the executor has processed all events referencing them.
+ * @param listRules
+ */
+void DispatchTable::removeRules(const std::vector<Rule*>& listRules)
+{
+    for(std::vector<Rule*>::const_iterator ruleIt = listRules.begin(); ruleIt != listRules.end(); ruleIt++)
+    {
+        Rule* rule = *ruleIt;
+
+        for(std::vector<Condition*>::iterator it = rule->m_listConditions.begin(); it != rule->m_listConditions.end(); it++)
+        {
+            Condition* cond = *it;
+
+            for(std::map<HWInput*, InputDispatch*>::iterator dispIt = m_mapInput.begin(); dispIt != m_mapInput.end(); dispIt++)
+            {
+                InputDispatch* dispatch = dispIt->second;
+                dispatch->buttons.erase(std::remove(dispatch->buttons.begin(), dispatch->buttons.end(), cond), dispatch->buttons.end());
+                dispatch->faders.erase(std::remove(dispatch->faders.begin(), dispatch->faders.end(), cond), dispatch->faders.end());
+                dispatch->expressions.erase(std::remove(dispatch->expressions.begin(), dispatch->expressions.end(), cond), dispatch->expressions.end());
+            }
+
+            for(std::map<Variable*, VariableDispatch*>::iterator dispIt = m_mapVariable.begin(); dispIt != m_mapVariable.end(); dispIt++)
+            {
+                VariableDispatch* dispatch = dispIt->second;
+                dispatch->conditions.erase(std::remove(dispatch->conditions.begin(), dispatch->conditions.end(), cond), dispatch->conditions.end());
+                dispatch->expressions.erase(std::remove(dispatch->expressions.begin(), dispatch->expressions.end(), cond), dispatch->expressions.end());
+            }
+        }
+
+        m_listEvaluate.erase(std::remove(m_listEvaluate.begin(), m_listEvaluate.end(), rule), m_listEvaluate.end());
+    }
+
+    std::map<HWInput*, InputDispatch*>::iterator inputIt = m_mapInput.begin();
+    while(inputIt != m_mapInput.end())
+    {
+        InputDispatch* dispatch = inputIt->second;
+
+        if(dispatch->buttons.empty() && dispatch->faders.empty() && dispatch->expressions.empty())
+        {
+            inputIt->first->unregisterInputListener(dispatch);
+            m_listUnusedInput.push_back(dispatch);
+            m_mapInput.erase(inputIt++);
+        }
+        else
+        {
+            inputIt++;
+        }
+    }
+
+    std::map<Variable*, VariableDispatch*>::iterator varIt = m_mapVariable.begin();
+    while(varIt != m_mapVariable.end())
+    {
+        VariableDispatch* dispatch = varIt->second;
+
+        if(dispatch->conditions.empty() && dispatch->expressions.empty())
+        {
+            varIt->first->unregisterVariableListener(dispatch);
+            m_listUnusedVariable.push_back(dispatch);
+            m_mapVariable.erase(varIt++);
+        }
+        else
+        {
+            varIt++;
+        }
+    }
+}
+
+/**
+ * @brief DispatchTable::release deletes the entries removed by DispatchTable::removeRules.
+ * The executor must have processed all events which have been posted before, see RuleExecutor::flush
+ */
+void DispatchTable::release()
+{
+    for(std::vector<InputDispatch*>::iterator it = m_listUnusedInput.begin(); it != m_listUnusedInput.end(); it++)
+        delete (*it);
+    m_listUnusedInput.clear();
+
+    for(std::vector<VariableDispatch*>::iterator it = m_listUnusedVariable.begin(); it != m_listUnusedVariable.end(); it++)
+        delete (*it);
+    m_listUnusedVariable.clear();
+}
+
+/**
+ * @brief DispatchTable::insertRule adds the conditions of rule to the entries of their inputs and variables
+ * @param rule
+ * @return number of conditions which have been added
+ */
+unsigned int DispatchTable::insertRule(Rule* rule)
+{
+    unsigned int numConditions = 0;
+
+    for(std::vector<Condition*>::iterator it = rule->m_listConditions.begin(); it != rule->m_listConditions.end(); it++)
+    {
+        if((*it)->getType() == Condition::Input)
+        {
+            ConditionInput* cond = (ConditionInput*)(*it);
+            HWInput* hw = cond->getHW();
+
+            if(hw == NULL)
+                continue;
+
+            if(hw->getType() != cond->getInputType())
+            {
+                LOG_WARN(Logger::Script, "Rule %s: input %s has the wrong type, condition is ignored",
+                         rule->getName().c_str(), cond->getHWName().c_str());
+                continue;
+            }
+
+            InputDispatch* dispatch = this->getInputDispatch(hw);
+
+            if(hw->getType() == HWInput::Button)
+                dispatch->buttons.push_back((ConditionInputButton*)cond);
+            else
+                dispatch->faders.push_back((ConditionInputFader*)cond);
+
+            numConditions++;
+        }
+        else if((*it)->getType() == Condition::Var)
+        {
+            ConditionVariable* cond = (ConditionVariable*)(*it);
+            Variable* var = cond->getVar();
+
+            if(var == NULL)
+                continue;
+
+            this->getVariableDispatch(var)->conditions.push_back(cond);
+
+            numConditions++;
+        }
+        else if((*it)->getType() == Condition::Expr)
+        {
+            ConditionExpression* cond = (ConditionExpression*)(*it);
+
+            // an expression depends on all of its inputs and variables
+            std::vector<HWInput*> inputs = cond->getInputs();
+            for(std::vector<HWInput*>::iterator hwIt = inputs.begin(); hwIt != inputs.end(); hwIt++)
+            {
+                this->getInputDispatch(*hwIt)->expressions.push_back(cond);
+            }
+
+            std::vector<Variable*> vars = cond->getVariables();
+            for(std::vector<Variable*>::iterator varIt = vars.begin(); varIt != vars.end(); varIt++)
+            {
+                this->getVariableDispatch(*varIt)->expressions.push_back(cond);
+            }
+
+            numConditions++;
+        }
+    }
+
+    return numConditions;
+}
+
+/**
+ * @brief DispatchTable::registerListeners registers every entry which is not yet registered as listener.
+ * Registering calls the listener immediately, this call is ignored, as the conditions are evaluated by DispatchTable::evaluate anyway.
+ */
+void DispatchTable::registerListeners()
+{
+    for(std::map<HWInput*, InputDispatch*>::iterator it = m_mapInput.begin(); it != m_mapInput.end(); it++)
+    {
+        if(!it->second->active)
+        {
+            it->first->registerInputListener(it->second);
+            it->second->active = true;
+        }
+    }
+
+    for(std::map<Variable*, VariableDispatch*>::iterator it = m_mapVariable.begin(); it != m_mapVariable.end(); it++)
+    {
+        if(!it->second->active)
+        {
+            it->first->registerVariableListener(it->second);
+            it->second->active = true;
+        }
+    }
+}
+
+/**
+ * @brief DispatchTable::getInputDispatch returns the entry of the given input, a new one is created if necessary
+ * @param hw
+ * @return
+ */
+DispatchTable::InputDispatch* DispatchTable::getInputDispatch(HWInput* hw)
+{
+    std::map<HWInput*, InputDispatch*>::iterator it = m_mapInput.find(hw);
+    if(it != m_mapInput.end())
+        return it->second;
+
+    InputDispatch* dispatch = new InputDispatch();
+    dispatch->table = this;
+    dispatch->active = false;
+    dispatch->hw = hw;
+    dispatch->type = hw->getType();
+    dispatch->coalesced = false;
+    dispatch->latestValue = 0;
+    m_mapInput[hw] = dispatch;
+
+    return dispatch;
+}
+
+/**
+ * @brief DispatchTable::getVariableDispatch returns the entry of the given variable, a new one is created if necessary
+ * @param var
+ * @return
+ */
+DispatchTable::VariableDispatch* DispatchTable::getVariableDispatch(Variable* var)
+{
+    std::map<Variable*, VariableDispatch*>::iterator it = m_mapVariable.find(var);
+    if(it != m_mapVariable.end())
+        return it->second;
+
+    VariableDispatch* dispatch = new VariableDispatch();
+    dispatch->table = this;
+    dispatch->active = false;
+    m_mapVariable[var] = dispatch;
+
+    return dispatch;
+}
+
+/**
+ * @brief DispatchTable::evaluate sets the initial state of every condition which has not been evaluated yet, rule by rule.
+ * Called by the RuleExecutor.
+ */
+void DispatchTable::evaluate()
+{
+    for(std::vector<Rule*>::const_iterator ruleIt = m_listEvaluate.begin(); ruleIt != m_listEvaluate.end(); ruleIt++)
+    {
+        Rule* rule = *ruleIt;
+
+        for(std::vector<Condition*>::iterator it = rule->m_listConditions.begin(); it != rule->m_listConditions.end(); it++)
+        {
+            if((*it)->getType() == Condition::Input)
+            {
+                ConditionInput* cond = (ConditionInput*)(*it);
+                HWInput* hw = cond->getHW();
+
+                if(hw == NULL || hw->getType() != cond->getInputType())
+                    continue;
+
+                if(hw->getType() == HWInput::Button)
+                    ((ConditionInputButton*)cond)->update(((HWInputButton*)hw)->getValue());
+                else
+                    ((ConditionInputFader*)cond)->update(((HWInputFader*)hw)->getValue());
+            }
+            else if((*it)->getType() == Condition::Var)
+            {
+                ConditionVariable* cond = (ConditionVariable*)(*it);
+
+                if(cond->getVar() != NULL)
+                    cond->update(cond->getVar()->getValue());
+            }
+            else if((*it)->getType() == Condition::Expr)
+            {
+                ((ConditionExpression*)(*it))->update();
+            }
+        }
+    }
+
+    m_listEvaluate.clear();
+}
+
+/**
+ * @brief DispatchTable::clear unregisters all listeners and empties the table.
+ * The listeners are unregistered before the executor is flushed, so that no new event can be posted after the flush,
+ * the entries are only deleted afterwards.
+ */
+void DispatchTable::clear()
+{
+    m_active = false;
+
+    for(std::map<HWInput*, InputDispatch*>::iterator it = m_mapInput.begin(); it != m_mapInput.end(); it++)
+    {
+        it->first->unregisterInputListener(it->second);
+        it->second->active = false;
+    }
+
+    for(std::map<Variable*, VariableDispatch*>::iterator it = m_mapVariable.begin(); it != m_mapVariable.end(); it++)
+    {
+        it->first->unregisterVariableListener(it->second);
+        it->second->active = false;
+    }
+
+    // the executor may still have events for this table in its queue
+    if(m_executor != NULL)
+        m_executor->flush();
+
+    for(std::map<HWInput*, InputDispatch*>::iterator it = m_mapInput.begin(); it != m_mapInput.end(); it++)
+    {
+        delete it->second;
+    }
+    m_mapInput.clear();
+
+    for(std::map<Variable*, VariableDispatch*>::iterator it = m_mapVariable.begin(); it != m_mapVariable.end(); it++)
+    {
+        delete it->second;
+    }
+    m_mapVariable.clear();
+
+    m_listEvaluate.clear();
+
+    this->release();
+}
+
+/**
+ * @brief DispatchTable::InputDispatch::onInputChanged is called by the hardware threads and only posts the new value to the executor.
+ * The value is read here, so that no edge gets lost if the input changes again before the executor gets to it.
+ * @param hw
+ */
+void DispatchTable::InputDispatch::onInputChanged(HWInput* hw)
+{
+    if(!table->m_active || !active)
+        return;
+
+    int value;
+    if(type == HWInput::Button)
+        value = ((HWInputButton*)hw)->getValue();
+    else
+        value = ((HWInputFader*)hw)->getValue();
+
+    table->m_executor->post(RuleExecutor::InputChanged, this, value);
+}
+
+/**
+ * @brief DispatchTable::InputDispatch::dispatch updates all conditions of this input, called by the RuleExecutor
+ * @param value
+ */
+void DispatchTable::InputDispatch::dispatch(int value)
+{
+    for(std::vector<ConditionInputButton*>::iterator it = buttons.begin(); it != buttons.end(); it++)
+    {
+        (*it)->update(value != 0);
+    }
+
+    for(std::vector<ConditionInputFader*>::iterator it = faders.begin(); it != faders.end(); it++)
+    {
+        (*it)->update((unsigned int)value);
+    }
+
+    // the expressions use the queued value too, the input might already have changed again
+    for(std::vector<ConditionExpression*>::iterator it = expressions.begin(); it != expressions.end(); it++)
+    {
+        (*it)->update(hw, type == HWInput::Button ? value != 0 : value);
+    }
+}
+
+/**
+ * @brief DispatchTable::VariableDispatch::onVariableChanged updates all conditions of this variable.
+ * Variables are only modified by the RuleExecutor, so this is already running on its thread.
+ * @param var
+ */
+void DispatchTable::VariableDispatch::onVariableChanged(Variable* var)
+{
+    if(!table->m_active || !active)
+        return;
+
+    int value = var->getValue();
+
+    for(std::vector<ConditionVariable*>::iterator it = conditions.begin(); it != conditions.end(); it++)
+    {
+        (*it)->update(value);
+    }
+
+    for(std::vector<ConditionExpression*>::iterator it = expressions.begin(); it != expressions.end(); it++)
+    {
+        (*it)->update();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef DISPATCHTABLE_H
+#define DISPATCHTABLE_H
+
+#include "hw/HWInput.h"
+#include "hw/HWInputListener.h"
+#include "script/VariableListener.h"
+
+#include <vector>
+#include <map>
+#include <atomic>
+
+class Rule;
+class Variable;
+class RuleExecutor;
+class ConditionInputButton;
+class ConditionInputFader;
+class ConditionVariable;
+class ConditionExpression;
+
+/**
+ * @brief The DispatchTable class maps every input and variable to the conditions which depend on it.
+ * It is built once in Script::init and registers exactly one listener per input and variable,
+ * so that a change only visits the conditions which are interested in it.
+ * Input changes are only posted to the RuleExecutor, which then updates the conditions on its own thread.
+ * Rules can be added and removed while the table is active, as long as the RuleExecutor is suspended,
+ * the listeners of inputs and variables which are still used are kept then.
+ */
+class DispatchTable
+{
+public:
+    DispatchTable();
+    ~DispatchTable();
+
+    void build(const std::vector<Rule*>& listRules, RuleExecutor* executor);
+    void clear();
+
+    void addRules(const std::vector<Rule*>& listRules);
+    void removeRules(const std::vector<Rule*>& listRules);
+    void release();
+
+private:
+    class InputDispatch : public HWInputListener
+    {
+    public:
+        void onInputChanged(HWInput* hw);
+        void dispatch(int value);
+
+        DispatchTable* table;
+        std::atomic<bool> active; // false until the listener has been registered, read by the threads calling the listener
+        HWInput* hw;
+        HWInput::HWInputType type;
+
+        // used by the RuleExecutor if its queue is full, see RuleExecutor::post
+        std::atomic<bool> coalesced;
+        std::atomic<int> latestValue;
+
+        std::vector<ConditionInputButton*> buttons;
+        std::vector<ConditionInputFader*> faders;
+        std::vector<ConditionExpression*> expressions;
+    };
+
+    class VariableDispatch : public VariableListener
+    {
+    public:
+        void onVariableChanged(Variable* var);
+
+        DispatchTable* table;
+        std::atomic<bool> active; // false until the listener has been registered, read by the threads calling the listener
+        std::vector<ConditionVariable*> conditions;
+        std::vector<ConditionExpression*> expressions;
+    };
+
+    InputDispatch* getInputDispatch(HWInput* hw);
+    VariableDispatch* getVariableDispatch(Variable* var);
+
+    unsigned int insertRule(Rule* rule);
+    void registerListeners();
+
+    void evaluate();
+
+    // rules whose conditions have not been evaluated yet
+    std::vector<Rule*> m_listEvaluate;
+    RuleExecutor* m_executor;
+
+    std::map<HWInput*, InputDispatch*> m_mapInput;
+    std::map<Variable*, VariableDispatch*> m_mapVariable;
+
+    // entries which are no longer used, but may still be referenced by events in the queue of the executor
+    std::vector<InputDispatch*> m_listUnusedInput;
+    std::vector<VariableDispatch*> m_listUnusedVariable;
+
+    // events are ignored until the initial state of all conditions has been evaluated
+    std::atomic<bool> m_active;
+
+    friend class RuleExecutor;
+};
+
+#endif // DISPATCHTABLE_H
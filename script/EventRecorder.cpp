@@ -0,0 +1,283 @@
+
+#include "script/EventRecorder.h"
+#include "script/Variable.h"
+#include "hw/HWInput.h"
+#include "hw/HWOutput.h"
+#include "hw/HWOutputLED.h"
+#include "hw/HWOutputRelay.h"
+#include "hw/HWOutputGPO.h"
+#include "hw/HWOutputDCMotor.h"
+#include "hw/HWOutputStepper.h"
+#include "util/LatencyTrace.h"
+#include "util/Debug.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+// the log file is grown by this number of records at once
+#define EVENT_RECORDER_CHUNK 4096
+
+const char EventRecorder::Magic[EventRecord::TextSize] = {'R', 'A', 'S', 'P', 'E', 'V', 'E', 'N', 'T', 'L', 'O', 'G'};
+
+std::atomic<bool> EventRecorder::m_recording(false);
+std::mutex EventRecorder::m_mutex;
+int EventRecorder::m_fd = -1;
+EventRecord* EventRecorder::m_map = NULL;
+unsigned long long EventRecorder::m_size = 0;
+unsigned long long EventRecorder::m_count = 0;
+uint64_t EventRecorder::m_start = 0;
+std::map<std::string, uint32_t> EventRecorder::m_mapNames;
+
+/**
+ * @brief EventRecorder::start creates a new event log and starts recording into it. A recording which is still running is stopped first.
+ * @param filename
+ * @return false if the file could not be created
+ */
+bool EventRecorder::start(const std::string& filename)
+{
+    EventRecorder::stop();
+
+    m_mutex.lock();
+
+    m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(m_fd == -1)
+    {
+        m_mutex.unlock();
+
+        LOG_WARN(Logger::Script, "Could not create event log %s", filename.c_str());
+        return false;
+    }
+
+    m_map = NULL;
+    m_size = 0;
+    m_count = 0;
+    m_start = LatencyTrace::timestamp();
+    m_mapNames.clear();
+
+    EventRecord* header = EventRecorder::append();
+    if(header == NULL)
+    {
+        close(m_fd);
+        m_fd = -1;
+        m_mutex.unlock();
+
+        LOG_WARN(Logger::Script, "Could not write event log %s", filename.c_str());
+        return false;
+    }
+
+    header->type = EventRecord::Header;
+    header->value = Version;
+    memcpy(header->text, Magic, EventRecord::TextSize);
+
+    m_recording = true;
+
+    m_mutex.unlock();
+
+    LOG_DEBUG(Logger::Script, "Recording events to %s", filename.c_str());
+
+    return true;
+}
+
+/**
+ * @brief EventRecorder::stop stops the recording, the file is truncated to the records which have been written
+ */
+void EventRecorder::stop()
+{
+    m_mutex.lock();
+
+    m_recording = false;
+
+    if(m_fd != -1)
+    {
+        if(m_map != NULL)
+            munmap(m_map, m_size * sizeof(EventRecord));
+
+        if(ftruncate(m_fd, m_count * sizeof(EventRecord)) != 0)
+            LOG_WARN(Logger::Script, "Could not truncate event log");
+
+        close(m_fd);
+
+        LOG_DEBUG(Logger::Script, "Recorded %llu events", m_count);
+    }
+
+    m_fd = -1;
+    m_map = NULL;
+    m_size = 0;
+    m_count = 0;
+    m_mapNames.clear();
+
+    m_mutex.unlock();
+}
+
+/**
+ * @brief EventRecorder::input is called by the RuleExecutor for every input change it handles
+ * @param hw
+ * @param value
+ * @param origin time the change has been posted, see LatencyTrace
+ */
+void EventRecorder::input(HWInput* hw, int value, uint64_t origin)
+{
+    if(!EventRecorder::isRecording())
+        return;
+
+    EventRecorder::record(EventRecord::Input, hw->getName(), value, origin);
+}
+
+/**
+ * @brief EventRecorder::variableSet is called by the RuleExecutor if a variable is set from outside of the rules
+ * @param var
+ * @param value
+ */
+void EventRecorder::variableSet(Variable* var, int value)
+{
+    if(!EventRecorder::isRecording())
+        return;
+
+    EventRecorder::record(EventRecord::VariableSet, var->getName(), value, LatencyTrace::timestamp());
+}
+
+void EventRecorder::variableChanged(Variable* var)
+{
+    if(!EventRecorder::isRecording())
+        return;
+
+    EventRecorder::record(EventRecord::VariableChanged, var->getName(), var->getValue(), LatencyTrace::timestamp());
+}
+
+void EventRecorder::output(HWOutput* hw)
+{
+    if(!EventRecorder::isRecording())
+        return;
+
+    int value = 0;
+    switch(hw->getType())
+    {
+    case HWOutput::LED:
+        value = ((HWOutputLED*)hw)->getValue();
+        break;
+    case HWOutput::Relay:
+        value = ((HWOutputRelay*)hw)->getValue();
+        break;
+    case HWOutput::GPO:
+        value = ((HWOutputGPO*)hw)->getValue();
+        break;
+    case HWOutput::DCMotor:
+        // state in the upper half, speed in the lower half
+        value = (((HWOutputDCMotor*)hw)->getMotorState() << 16) | ((HWOutputDCMotor*)hw)->getSpeed();
+        break;
+    case HWOutput::Stepper:
+        value = ((HWOutputStepper*)hw)->getFullStatus().targetPosition;
+        break;
+    default:
+        break;
+    }
+
+    EventRecorder::record(EventRecord::Output, hw->getName(), value, LatencyTrace::timestamp());
+}
+
+void EventRecorder::record(EventRecord::Type type, const std::string& name, int value, uint64_t time)
+{
+    m_mutex.lock();
+
+    // the recording might have been stopped in the meantime
+    if(m_fd == -1)
+    {
+        m_mutex.unlock();
+        return;
+    }
+
+    uint32_t id = EventRecorder::defineName(name, time);
+
+    EventRecord* rec = EventRecorder::append();
+    if(rec != NULL)
+    {
+        rec->time = time > m_start ? time - m_start : 0;
+        rec->type = type;
+        rec->id = id;
+        rec->value = value;
+    }
+
+    m_mutex.unlock();
+}
+
+/**
+ * @brief EventRecorder::defineName returns the id of name in the log and writes its Name records if it is used for the first time.
+ * Must be called with m_mutex held
+ * @param name
+ * @param time
+ * @return
+ */
+uint32_t EventRecorder::defineName(const std::string& name, uint64_t time)
+{
+    std::map<std::string, uint32_t>::iterator it = m_mapNames.find(name);
+    if(it != m_mapNames.end())
+        return it->second;
+
+    uint32_t id = m_mapNames.size() + 1;
+    m_mapNames[name] = id;
+
+    unsigned int offset = 0;
+    do
+    {
+        EventRecord* rec = EventRecorder::append();
+        if(rec == NULL)
+            break;
+
+        unsigned int len = name.size() - offset;
+        if(len > EventRecord::TextSize)
+            len = EventRecord::TextSize;
+
+        rec->time = time > m_start ? time - m_start : 0;
+        rec->type = EventRecord::Name;
+        rec->id = id;
+        rec->value = name.size();
+        memcpy(rec->text, name.data() + offset, len);
+
+        offset += len;
+    } while(offset < name.size());
+
+    return id;
+}
+
+/**
+ * @brief EventRecorder::append returns the next free record of the log, the file is grown if necessary.
+ * Must be called with m_mutex held
+ * @return the zeroed record or NULL if the file could not be grown
+ */
+EventRecord* EventRecorder::append()
+{
+    if(m_count == m_size)
+    {
+        unsigned long long size = m_size + EVENT_RECORDER_CHUNK;
+
+        if(ftruncate(m_fd, size * sizeof(EventRecord)) != 0)
+        {
+            LOG_ERROR(Logger::Script, "Could not grow event log, recording stopped");
+            m_recording = false;
+            return NULL;
+        }
+
+        void* map;
+        if(m_map == NULL)
+            map = mmap(NULL, size * sizeof(EventRecord), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        else
+            map = mremap(m_map, m_size * sizeof(EventRecord), size * sizeof(EventRecord), MREMAP_MAYMOVE);
+
+        if(map == MAP_FAILED)
+        {
+            LOG_ERROR(Logger::Script, "Could not map event log, recording stopped");
+            m_recording = false;
+            return NULL;
+        }
+
+        m_map = (EventRecord*)map;
+        m_size = size;
+    }
+
+    EventRecord* rec = &m_map[m_count++];
+    memset(rec, 0, sizeof(EventRecord));
+
+    return rec;
+}
@@ -0,0 +1,79 @@
+#ifndef EVENTRECORDER_H
+#define EVENTRECORDER_H
+
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <string>
+#include <stdint.h>
+
+class HWInput;
+class HWOutput;
+class Variable;
+
+/**
+ * @brief The EventRecord struct is one fixed size record of an event log.
+ * The first record of every log is a Header record, names are defined by Name records before the first record which uses them.
+ * A name longer than the text of one record is continued in the following Name records with the same id.
+ */
+struct EventRecord
+{
+    enum Type
+    {
+        Header = 0, // value is the version, text the magic
+        Name = 1, // defines the name of id, text is a part of it
+        Input = 2, // input id has changed to value
+        VariableSet = 3, // variable id has been set to value by the user, e.g. in the GUI
+        VariableChanged = 4, // variable id has changed to value, no matter who has changed it
+        Output = 5, // output id has been changed to value
+    };
+
+    static const unsigned int TextSize = 12;
+
+    uint64_t time; // nanoseconds since the start of the recording
+    uint32_t type;
+    uint32_t id;
+    int32_t value;
+    char text[TextSize];
+};
+
+/**
+ * @brief The EventRecorder class writes every input change, variable change and output change of the running script into an event log.
+ * The log is an append only file of fixed size EventRecord, which is memory mapped and grown in large chunks,
+ * so writing a record is only a copy into the mapping. The EventReplay class can feed the inputs of a log into a script again.
+ * Inputs and variables are recorded by the RuleExecutor in the order it handles them, outputs by whoever changes them.
+ * As long as no recording is running, every hook only costs one atomic load.
+ */
+class EventRecorder
+{
+public:
+    static bool start(const std::string& filename);
+    static void stop();
+    static bool isRecording() { return m_recording.load(std::memory_order_relaxed);}
+
+    static void input(HWInput* hw, int value, uint64_t origin);
+    static void variableSet(Variable* var, int value);
+    static void variableChanged(Variable* var);
+    static void output(HWOutput* hw);
+
+    static const char Magic[EventRecord::TextSize];
+    static const int32_t Version = 1;
+
+private:
+    static void record(EventRecord::Type type, const std::string& name, int value, uint64_t time);
+    static uint32_t defineName(const std::string& name, uint64_t time);
+    static EventRecord* append();
+
+    static std::atomic<bool> m_recording;
+
+    // all protected by m_mutex
+    static std::mutex m_mutex;
+    static int m_fd;
+    static EventRecord* m_map;
+    static unsigned long long m_size; // number of records which fit into the mapping
+    static unsigned long long m_count; // number of records which have been written
+    static uint64_t m_start;
+    static std::map<std::string, uint32_t> m_mapNames;
+};
+
+#endif // EVENTRECORDER_H
@@ -0,0 +1,305 @@
+
+#include "script/EventReplay.h"
+#include "script/RuleTimerThread.h"
+#include "script/RuleExecutor.h"
+#include "script/Variable.h"
+#include "hw/HWInputButton.h"
+#include "hw/HWInputFader.h"
+#include "ConfigManager.h"
+#include "util/Debug.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+// longest time the replay thread sleeps at once, so that it can be stopped while it waits for the next record
+#define EVENT_REPLAY_MAX_SLEEP_NS 100000000ULL
+
+EventReplay::EventReplay(ConfigManager* config)
+{
+    m_config = config;
+    m_speed = RealTime;
+
+    m_thread = 0;
+    m_bStop = false;
+    m_bRunning = false;
+
+    m_map = NULL;
+    m_count = 0;
+
+    m_replayed = 0;
+    m_total = 0;
+}
+
+EventReplay::~EventReplay()
+{
+    this->kill();
+}
+
+/**
+ * @brief EventReplay::start replays the event log given by filename into the active script. A replay which is still running is stopped first.
+ * @param filename
+ * @param speed
+ * @return false if there is no running script or if the file is not a valid event log
+ */
+bool EventReplay::start(const std::string& filename, Speed speed)
+{
+    this->kill();
+
+    if(m_config->getActiveScriptState() != ConfigManager::Active)
+    {
+        LOG_WARN(Logger::Script, "Events can only be replayed into a running script");
+        return false;
+    }
+
+    if(!this->open(filename))
+        return false;
+
+    m_speed = speed;
+    m_bStop = false;
+    m_bRunning = true;
+
+    pthread_create(&m_thread, NULL, EventReplay::run_internal, (void*)this);
+
+    return true;
+}
+
+/**
+ * @brief EventReplay::kill stops the replay and waits for the thread to finish
+ */
+void EventReplay::kill()
+{
+    if(m_thread == 0)
+        return;
+
+    m_bStop = true;
+
+    pthread_join(m_thread, NULL);
+    m_thread = 0;
+}
+
+/**
+ * @brief EventReplay::open maps the event log and reads the names defined in it
+ * @param filename
+ * @return false if it is not a valid event log
+ */
+bool EventReplay::open(const std::string& filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+    {
+        LOG_WARN(Logger::Script, "Could not open event log %s", filename.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(EventRecord) || st.st_size % sizeof(EventRecord) != 0)
+    {
+        LOG_WARN(Logger::Script, "%s is not an event log", filename.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping stays valid after the file has been closed
+    ::close(fd);
+
+    if(map == MAP_FAILED)
+    {
+        LOG_WARN(Logger::Script, "Could not map event log %s", filename.c_str());
+        return false;
+    }
+
+    m_map = (const EventRecord*)map;
+    m_count = st.st_size / sizeof(EventRecord);
+
+    if(m_map[0].type != EventRecord::Header || m_map[0].value != EventRecorder::Version
+            || memcmp(m_map[0].text, EventRecorder::Magic, EventRecord::TextSize) != 0)
+    {
+        LOG_WARN(Logger::Script, "%s is not an event log or has an unsupported version", filename.c_str());
+        this->close();
+        return false;
+    }
+
+    m_mapNames.clear();
+    m_total = 0;
+    m_replayed = 0;
+
+    for(unsigned long long i = 1; i < m_count; i++)
+    {
+        const EventRecord* rec = &m_map[i];
+
+        if(rec->type == EventRecord::Name)
+        {
+            std::string& name = m_mapNames[rec->id];
+
+            unsigned int len = rec->value - name.size();
+            if(len > EventRecord::TextSize)
+                len = EventRecord::TextSize;
+
+            name.append(rec->text, len);
+        }
+        else if(rec->type == EventRecord::Input || rec->type == EventRecord::VariableSet)
+        {
+            m_total++;
+        }
+    }
+
+    return true;
+}
+
+void EventReplay::close()
+{
+    if(m_map != NULL)
+        munmap((void*)m_map, m_count * sizeof(EventRecord));
+
+    m_map = NULL;
+    m_count = 0;
+}
+
+/**
+ * @brief EventReplay::waitUntil sleeps until ns nanoseconds of CLOCK_MONOTONIC or until the replay is stopped
+ * @param ns
+ */
+void EventReplay::waitUntil(unsigned long long ns)
+{
+    while(!m_bStop)
+    {
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+        unsigned long long now = currentTime.tv_sec * 1000000000ULL + currentTime.tv_nsec;
+        if(now >= ns)
+            return;
+
+        unsigned long long wait = ns - now;
+        if(wait > EVENT_REPLAY_MAX_SLEEP_NS)
+            wait = EVENT_REPLAY_MAX_SLEEP_NS;
+
+        timespec sleep;
+        sleep.tv_sec = wait / 1000000000ULL;
+        sleep.tv_nsec = wait % 1000000000ULL;
+
+        nanosleep(&sleep, NULL);
+    }
+}
+
+/**
+ * @brief EventReplay::apply feeds one record into the script, records which are only results of the script are ignored
+ * @param rec
+ */
+void EventReplay::apply(const EventRecord* rec)
+{
+    std::map<uint32_t, std::string>::iterator it = m_mapNames.find(rec->id);
+    if(it == m_mapNames.end())
+        return;
+
+    if(rec->type == EventRecord::Input)
+    {
+        HWInput* hw = m_config->getInputByName(it->second);
+        if(hw == NULL)
+        {
+            LOG_DEBUG(Logger::Script, "Replay: input %s does not exist", it->second.c_str());
+            return;
+        }
+
+        if(!hw->getOverride())
+        {
+            hw->setOverride(true);
+            m_listOverridden.push_back(hw);
+        }
+
+        if(hw->getType() == HWInput::Button)
+            ((HWInputButton*)hw)->setOverrideValue(rec->value != 0);
+        else
+            ((HWInputFader*)hw)->setOverrideValue(rec->value);
+    }
+    else if(rec->type == EventRecord::VariableSet)
+    {
+        Variable* var = m_config->getVariableByName(it->second);
+        if(var == NULL)
+        {
+            LOG_DEBUG(Logger::Script, "Replay: variable %s does not exist", it->second.c_str());
+            return;
+        }
+
+        var->setValue(rec->value);
+    }
+}
+
+void EventReplay::run()
+{
+    RuleTimerThread* timer = m_config->getRuleTimerThread();
+    RuleExecutor* executor = m_config->getRuleExecutor();
+
+    LOG_DEBUG(Logger::Script, "Replaying %llu events", m_total);
+
+    timespec startTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    unsigned long long start = startTime.tv_sec * 1000000000ULL + startTime.tv_nsec;
+
+    unsigned long long clockBase = 0;
+    if(m_speed == Fast)
+    {
+        timer->setVirtualClock(true);
+        clockBase = timer->getClock();
+    }
+
+    // inputs are stamped when they are posted, so they might be slightly out of order in the log, time never goes backwards here
+    unsigned long long time = 0;
+
+    for(unsigned long long i = 1; i < m_count && !m_bStop; i++)
+    {
+        const EventRecord* rec = &m_map[i];
+
+        if(rec->type != EventRecord::Input && rec->type != EventRecord::VariableSet)
+            continue;
+
+        if(rec->time > time)
+            time = rec->time;
+
+        if(m_speed == Fast)
+            timer->advanceClock(clockBase + time / 1000000);
+        else
+            this->waitUntil(start + time);
+
+        if(m_bStop)
+            break;
+
+        this->apply(rec);
+
+        if(m_speed == Fast)
+            executor->flush();
+
+        m_replayed++;
+    }
+
+    if(m_speed == Fast)
+        timer->setVirtualClock(false);
+
+    // give the inputs back to the hardware
+    for(std::list<HWInput*>::iterator it = m_listOverridden.begin(); it != m_listOverridden.end(); it++)
+    {
+        (*it)->setOverride(false);
+    }
+    m_listOverridden.clear();
+
+    this->close();
+
+    LOG_DEBUG(Logger::Script, "Replay finished after %llu of %llu events", (unsigned long long)m_replayed, m_total);
+
+    m_bRunning = false;
+}
+
+void* EventReplay::run_internal(void* arg)
+{
+    EventReplay* thread = (EventReplay*)arg;
+    thread->run();
+
+    return NULL;
+}
@@ -0,0 +1,69 @@
+#ifndef EVENTREPLAY_H
+#define EVENTREPLAY_H
+
+#include "script/EventRecorder.h"
+
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <map>
+#include <list>
+
+class ConfigManager;
+class HWInput;
+
+/**
+ * @brief The EventReplay class feeds the input changes and variable changes of an event log into the active script.
+ * The inputs are overridden while the replay runs, so the script sees the recorded values instead of the hardware, like with dummy hardware.
+ * The replay either runs in real time or as fast as possible. In the latter case the RuleTimerThread is switched to its virtual clock,
+ * which is advanced to the time of every record, and the RuleExecutor is flushed after every record.
+ * Then the result of a replay does not depend on the speed of the machine, so two replays of the same log can be compared record by record.
+ */
+class EventReplay
+{
+public:
+    enum Speed
+    {
+        RealTime = 0,
+        Fast = 1
+    };
+
+    EventReplay(ConfigManager* config);
+    ~EventReplay();
+
+    bool start(const std::string& filename, Speed speed);
+    void kill();
+
+    bool isRunning() const { return m_bRunning;}
+    unsigned long long getReplayed() const { return m_replayed;}
+    unsigned long long getTotal() const { return m_total;}
+
+private:
+    static void* run_internal(void* arg);
+    void run();
+
+    bool open(const std::string& filename);
+    void close();
+
+    void apply(const EventRecord* rec);
+    void waitUntil(unsigned long long ns);
+
+    ConfigManager* m_config;
+    Speed m_speed;
+
+    pthread_t m_thread;
+    std::atomic<bool> m_bStop;
+    std::atomic<bool> m_bRunning;
+
+    // the event log is mapped read only
+    const EventRecord* m_map;
+    unsigned long long m_count;
+
+    std::map<uint32_t, std::string> m_mapNames;
+    std::list<HWInput*> m_listOverridden; // inputs whose override has been switched on by the replay
+
+    std::atomic<unsigned long long> m_replayed; // number of inputs and variables which have been replayed
+    unsigned long long m_total;
+};
+
+#endif // EVENTREPLAY_H
@@ -0,0 +1,567 @@
+
+#include "script/Expression.h"
+#include "script/Variable.h"
+#include "hw/HWInput.h"
+#include "hw/HWInputButton.h"
+#include "hw/HWInputFader.h"
+#include "ConfigManager.h"
+#include "util/Debug.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+
+Expression::Expression()
+{
+    m_pos = 0;
+    m_depth = 0;
+}
+
+/**
+ * @brief Expression::setString parses and compiles the given expression.
+ * Must not be called while the expression is initialized.
+ * @param str
+ * @return false if the expression is invalid, Expression::getError then describes the problem
+ */
+bool Expression::setString(std::string str)
+{
+    m_string = str;
+    m_error.clear();
+    m_code.clear();
+    m_slots.clear();
+    m_stack.clear();
+
+    m_pos = 0;
+    m_depth = 0;
+
+    bool ok = this->parseOr();
+
+    this->skipSpace();
+    if(ok && m_pos != m_string.length())
+        ok = this->fail("Unexpected character");
+
+    if(!ok)
+    {
+        m_code.clear();
+        m_slots.clear();
+        m_stack.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Expression::init resolves every name to a variable or an input
+ * @param config
+ */
+void Expression::init(ConfigManager* config)
+{
+    for(std::vector<Slot>::iterator it = m_slots.begin(); it != m_slots.end(); it++)
+    {
+        (*it).var = config->getVariable((*it).id);
+        (*it).hw = NULL;
+
+        if((*it).var == NULL)
+        {
+            (*it).hw = config->getInput((*it).id);
+
+            if((*it).hw != NULL && (*it).hw->getType() != HWInput::Button && (*it).hw->getType() != HWInput::Fader)
+                (*it).hw = NULL;
+        }
+
+        if((*it).var == NULL && (*it).hw == NULL)
+            LOG_WARN(Logger::Script, "Expression %s: %s is neither a variable nor an input, using 0", m_string.c_str(), (*it).name.c_str());
+    }
+}
+
+void Expression::deinit()
+{
+    for(std::vector<Slot>::iterator it = m_slots.begin(); it != m_slots.end(); it++)
+    {
+        (*it).var = NULL;
+        (*it).hw = NULL;
+    }
+}
+
+std::vector<Variable*> Expression::getVariables() const
+{
+    std::vector<Variable*> vec;
+
+    for(std::vector<Slot>::const_iterator it = m_slots.begin(); it != m_slots.end(); it++)
+    {
+        if((*it).var != NULL)
+            vec.push_back((*it).var);
+    }
+
+    return vec;
+}
+
+/**
+ * @brief Expression::dependsOn checks if any of the names used in this expression is in names
+ * @param names
+ * @return
+ */
+bool Expression::dependsOn(const std::set<Symbol::Id>& names) const
+{
+    for(std::vector<Slot>::const_iterator it = m_slots.begin(); it != m_slots.end(); it++)
+    {
+        if(names.count((*it).id) != 0)
+            return true;
+    }
+
+    return false;
+}
+
+std::vector<HWInput*> Expression::getInputs() const
+{
+    std::vector<HWInput*> vec;
+
+    for(std::vector<Slot>::const_iterator it = m_slots.begin(); it != m_slots.end(); it++)
+    {
+        if((*it).hw != NULL)
+            vec.push_back((*it).hw);
+    }
+
+    return vec;
+}
+
+/**
+ * @brief Expression::getNames returns every name used in the expression, whether it has been resolved or not
+ * @return
+ */
+std::vector<std::string> Expression::getNames() const
+{
+    std::vector<std::string> vec;
+
+    for(std::vector<Slot>::const_iterator it = m_slots.begin(); it != m_slots.end(); it++)
+    {
+        vec.push_back((*it).name);
+    }
+
+    return vec;
+}
+
+/**
+ * @brief clampInt saturates the result of an operation, which is calculated with 64 bits, to the range of int
+ * @param value
+ * @return
+ */
+static inline int clampInt(long long value)
+{
+    if(value > INT_MAX)
+        return INT_MAX;
+    if(value < INT_MIN)
+        return INT_MIN;
+
+    return (int)value;
+}
+
+/**
+ * @brief Expression::evaluate runs the bytecode. Division by zero results in 0.
+ * Arithmetic saturates at the limits of int instead of overflowing.
+ * Inputs are read when the expression is evaluated, except for changed. Its value is given by the caller,
+ * as the executor handles input changes one after another and the input might already have a newer value.
+ * @param changed input which has changed or NULL
+ * @param value value of changed
+ * @return the value of the expression, 0 if the expression is invalid
+ */
+int Expression::evaluate(const HWInput* changed, int value)
+{
+    if(m_code.empty())
+        return 0;
+
+    int* stack = &m_stack[0];
+    int top = -1;
+
+    for(std::vector<Instruction>::const_iterator it = m_code.begin(); it != m_code.end(); it++)
+    {
+        switch((*it).op)
+        {
+        case PushConst:
+            stack[++top] = (*it).arg;
+            break;
+        case PushSlot:
+        {
+            const Slot& slot = m_slots[(*it).arg];
+            int slotValue = 0;
+
+            if(slot.var != NULL)
+                slotValue = slot.var->getValue();
+            else if(slot.hw != NULL && slot.hw == changed)
+                slotValue = value;
+            else if(slot.hw != NULL && slot.hw->getType() == HWInput::Button)
+                slotValue = ((HWInputButton*)slot.hw)->getValue();
+            else if(slot.hw != NULL)
+                slotValue = ((HWInputFader*)slot.hw)->getValue();
+
+            stack[++top] = slotValue;
+            break;
+        }
+        case Neg:
+            stack[top] = clampInt(-(long long)stack[top]);
+            break;
+        case Not:
+            stack[top] = !stack[top];
+            break;
+        case Mul:
+            stack[top - 1] = clampInt((long long)stack[top - 1] * stack[top]);
+            top--;
+            break;
+        case Div:
+            // INT_MIN / -1 does not fit into an int and traps, so -1 is handled as negation
+            if(stack[top] == 0)
+                stack[top - 1] = 0;
+            else if(stack[top] == -1)
+                stack[top - 1] = clampInt(-(long long)stack[top - 1]);
+            else
+                stack[top - 1] = stack[top - 1] / stack[top];
+            top--;
+            break;
+        case Mod:
+            // the remainder of a division by -1 is always 0, INT_MIN % -1 traps as well
+            if(stack[top] == 0 || stack[top] == -1)
+                stack[top - 1] = 0;
+            else
+                stack[top - 1] = stack[top - 1] % stack[top];
+            top--;
+            break;
+        case Add:
+            stack[top - 1] = clampInt((long long)stack[top - 1] + stack[top]);
+            top--;
+            break;
+        case Sub:
+            stack[top - 1] = clampInt((long long)stack[top - 1] - stack[top]);
+            top--;
+            break;
+        case Less:
+            stack[top - 1] = stack[top - 1] < stack[top];
+            top--;
+            break;
+        case LessEqual:
+            stack[top - 1] = stack[top - 1] <= stack[top];
+            top--;
+            break;
+        case Greater:
+            stack[top - 1] = stack[top - 1] > stack[top];
+            top--;
+            break;
+        case GreaterEqual:
+            stack[top - 1] = stack[top - 1] >= stack[top];
+            top--;
+            break;
+        case Equal:
+            stack[top - 1] = stack[top - 1] == stack[top];
+            top--;
+            break;
+        case NotEqual:
+            stack[top - 1] = stack[top - 1] != stack[top];
+            top--;
+            break;
+        case And:
+            stack[top - 1] = stack[top - 1] && stack[top];
+            top--;
+            break;
+        case Or:
+            stack[top - 1] = stack[top - 1] || stack[top];
+            top--;
+            break;
+        }
+    }
+
+    return stack[0];
+}
+
+/**
+ * @brief Expression::emit appends an instruction and keeps track of the stack depth
+ * @param op
+ * @param arg
+ */
+void Expression::emit(OpCode op, int arg)
+{
+    Instruction instr;
+    instr.op = op;
+    instr.arg = arg;
+
+    m_code.push_back(instr);
+
+    if(op == PushConst || op == PushSlot)
+    {
+        m_depth++;
+        if(m_depth > m_stack.size())
+            m_stack.resize(m_depth);
+    }
+    else if(op != Neg && op != Not)
+    {
+        m_depth--; // binary operators take two values and push one
+    }
+}
+
+bool Expression::fail(std::string error)
+{
+    m_error = error.append(" at position ").append(std::to_string(m_pos + 1));
+    return false;
+}
+
+void Expression::skipSpace()
+{
+    while(m_pos < m_string.length() && isspace(m_string[m_pos]))
+        m_pos++;
+}
+
+/**
+ * @brief Expression::accept consumes token, if the remaining string starts with it
+ * @param token
+ * @return true if the token has been consumed
+ */
+bool Expression::accept(const char* token)
+{
+    this->skipSpace();
+
+    unsigned int len = strlen(token);
+    if(m_string.compare(m_pos, len, token) != 0)
+        return false;
+
+    // do not mistake a comparison for an assignment or negation, e.g. "<=" for "<"
+    if(len == 1 && (token[0] == '<' || token[0] == '>' || token[0] == '!')
+            && m_pos + 1 < m_string.length() && m_string[m_pos + 1] == '=')
+        return false;
+
+    m_pos += len;
+    return true;
+}
+
+bool Expression::parseOr()
+{
+    if(!this->parseAnd())
+        return false;
+
+    while(this->accept("||"))
+    {
+        if(!this->parseAnd())
+            return false;
+        this->emit(Or);
+    }
+
+    return true;
+}
+
+bool Expression::parseAnd()
+{
+    if(!this->parseEquality())
+        return false;
+
+    while(this->accept("&&"))
+    {
+        if(!this->parseEquality())
+            return false;
+        this->emit(And);
+    }
+
+    return true;
+}
+
+bool Expression::parseEquality()
+{
+    if(!this->parseRelational())
+        return false;
+
+    while(true)
+    {
+        OpCode op;
+        if(this->accept("=="))
+            op = Equal;
+        else if(this->accept("!="))
+            op = NotEqual;
+        else
+            break;
+
+        if(!this->parseRelational())
+            return false;
+        this->emit(op);
+    }
+
+    return true;
+}
+
+bool Expression::parseRelational()
+{
+    if(!this->parseAdditive())
+        return false;
+
+    while(true)
+    {
+        OpCode op;
+        if(this->accept("<="))
+            op = LessEqual;
+        else if(this->accept(">="))
+            op = GreaterEqual;
+        else if(this->accept("<"))
+            op = Less;
+        else if(this->accept(">"))
+            op = Greater;
+        else
+            break;
+
+        if(!this->parseAdditive())
+            return false;
+        this->emit(op);
+    }
+
+    return true;
+}
+
+bool Expression::parseAdditive()
+{
+    if(!this->parseMultiplicative())
+        return false;
+
+    while(true)
+    {
+        OpCode op;
+        if(this->accept("+"))
+            op = Add;
+        else if(this->accept("-"))
+            op = Sub;
+        else
+            break;
+
+        if(!this->parseMultiplicative())
+            return false;
+        this->emit(op);
+    }
+
+    return true;
+}
+
+bool Expression::parseMultiplicative()
+{
+    if(!this->parseUnary())
+        return false;
+
+    while(true)
+    {
+        OpCode op;
+        if(this->accept("*"))
+            op = Mul;
+        else if(this->accept("/"))
+            op = Div;
+        else if(this->accept("%"))
+            op = Mod;
+        else
+            break;
+
+        if(!this->parseUnary())
+            return false;
+        this->emit(op);
+    }
+
+    return true;
+}
+
+bool Expression::parseUnary()
+{
+    if(this->accept("-"))
+    {
+        if(!this->parseUnary())
+            return false;
+        this->emit(Neg);
+        return true;
+    }
+    else if(this->accept("!"))
+    {
+        if(!this->parseUnary())
+            return false;
+        this->emit(Not);
+        return true;
+    }
+
+    return this->parsePrimary();
+}
+
+bool Expression::parsePrimary()
+{
+    this->skipSpace();
+
+    if(m_pos >= m_string.length())
+        return this->fail("Unexpected end of expression");
+
+    char c = m_string[m_pos];
+
+    if(this->accept("("))
+    {
+        if(!this->parseOr())
+            return false;
+
+        if(!this->accept(")"))
+            return this->fail("Missing )");
+
+        return true;
+    }
+    else if(isdigit(c))
+    {
+        const char* start = m_string.c_str() + m_pos;
+        char* end;
+
+        errno = 0;
+        long value = strtol(start, &end, 10);
+
+        if(errno == ERANGE || value > INT_MAX)
+            return this->fail("Number out of range");
+
+        m_pos += end - start;
+        this->emit(PushConst, (int)value);
+
+        return true;
+    }
+    else if(isalpha(c) || c == '_' || c == '"')
+    {
+        std::string name;
+
+        if(c == '"')
+        {
+            size_t end = m_string.find('"', m_pos + 1);
+            if(end == std::string::npos)
+                return this->fail("Missing \"");
+
+            name = m_string.substr(m_pos + 1, end - m_pos - 1);
+            m_pos = end + 1;
+        }
+        else
+        {
+            unsigned int start = m_pos;
+            while(m_pos < m_string.length() && (isalnum(m_string[m_pos]) || m_string[m_pos] == '_'))
+                m_pos++;
+
+            name = m_string.substr(start, m_pos - start);
+        }
+
+        Symbol::Id id = Symbol::intern(name);
+
+        // every name gets only one slot, even if it is used several times
+        unsigned int slot;
+        for(slot = 0; slot < m_slots.size(); slot++)
+        {
+            if(m_slots[slot].id == id)
+                break;
+        }
+
+        if(slot == m_slots.size())
+        {
+            Slot newSlot;
+            newSlot.name = name;
+            newSlot.id = id;
+            newSlot.var = NULL;
+            newSlot.hw = NULL;
+            m_slots.push_back(newSlot);
+        }
+
+        this->emit(PushSlot, slot);
+
+        return true;
+    }
+
+    return this->fail("Unexpected character");
+}
@@ -0,0 +1,105 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "util/Symbol.h"
+
+#include <string>
+#include <vector>
+#include <set>
+
+class ConfigManager;
+class Variable;
+class HWInput;
+
+/**
+ * @brief The Expression class evaluates integer expressions like "fader1 * 2 / 3 + offset" or "a > b && c < 10".
+ * The expression is compiled once to a stack bytecode when it is set. Every name gets a slot,
+ * which is resolved to a variable or, if there is no variable with this name, to an input in Expression::init.
+ * Names containing spaces or operators can be written in double quotes.
+ * Evaluating does not allocate, but it uses an internal stack, so an expression must only be evaluated by one thread at a time.
+ */
+class Expression
+{
+public:
+    Expression();
+
+    bool setString(std::string str);
+    std::string getString() const { return m_string;}
+    std::string getError() const { return m_error;}
+    bool isValid() const { return !m_code.empty();}
+
+    void init(ConfigManager* config);
+    void deinit();
+
+    int evaluate(const HWInput* changed = NULL, int value = 0);
+
+    std::vector<Variable*> getVariables() const;
+    std::vector<HWInput*> getInputs() const;
+    std::vector<std::string> getNames() const;
+
+    bool dependsOn(const std::set<Symbol::Id>& names) const;
+
+private:
+    enum OpCode
+    {
+        PushConst,
+        PushSlot,
+        Neg,
+        Not,
+        Mul,
+        Div,
+        Mod,
+        Add,
+        Sub,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        And,
+        Or,
+    };
+
+    struct Instruction
+    {
+        OpCode op;
+        int arg; // constant or slot
+    };
+
+    struct Slot
+    {
+        std::string name;
+        Symbol::Id id;
+        Variable* var;
+        HWInput* hw;
+    };
+
+    // parser, every function compiles one level of precedence
+    bool parseOr();
+    bool parseAnd();
+    bool parseEquality();
+    bool parseRelational();
+    bool parseAdditive();
+    bool parseMultiplicative();
+    bool parseUnary();
+    bool parsePrimary();
+
+    void skipSpace();
+    bool accept(const char* token);
+    void emit(OpCode op, int arg = 0);
+    bool fail(std::string error);
+
+    std::string m_string;
+    std::string m_error;
+
+    // parser state
+    unsigned int m_pos;
+    unsigned int m_depth;
+
+    std::vector<Instruction> m_code;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_stack; // sized to the maximum depth of the bytecode
+};
+
+#endif // EXPRESSION_H
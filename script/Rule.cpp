@@ -2,13 +2,23 @@
 #include "script/Rule.h"
 #include "script/Action.h"
 #include "script/Condition.h"
+#include "script/RuleTimerThread.h"
+#include "ConfigManager.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
+
+#include <QXmlStreamReader>
 
 Rule::Rule()
 {
     m_type = Normal;
-    m_noConcurrent = false;
-    m_ruleRunning = false;
+    m_concurrency = Concurrent;
+    m_queueLimit = 1;
+    m_timerThread = NULL;
+    m_state = 0;
+    m_run = 0;
+    m_satisfiedCount = 0;
 }
 
 Rule::~Rule()
@@ -24,41 +34,74 @@ Rule::~Rule()
     }
 }
 
-Rule* Rule::load(QDomElement* root)
+/**
+ * @brief Rule::load reads the rule from reader, which must be positioned at the start element of the rule.
+ * Conditions and actions are read one after another, so the rule is never kept completely in memory as XML.
+ * @param reader
+ * @return
+ */
+Rule* Rule::load(QXmlStreamReader* reader)
 {
     Rule* rule = new Rule();
-    QDomElement elem = root->firstChildElement();
+    XmlElement elem;
+    Concurrency concurrency = CINVALID;
+    bool noConcurrent = false;
 
-    while(!elem.isNull())
+    while(reader->readNextStartElement())
     {
-        if(elem.tagName().toLower().compare("action") == 0)
+        XmlTag::Id tag = XmlTag::lookup(reader->name());
+
+        if(tag == XmlTag::Action)
         {
+            elem.read(reader);
+
             Action* action = Action::load(&elem);
             if(action != NULL)
                 rule->addAction(action);
         }
-        else if(elem.tagName().toLower().compare("condition") == 0)
+        else if(tag == XmlTag::Condition)
         {
+            elem.read(reader);
+
             Condition* condition = Condition::load(&elem);
             if(condition != NULL)
                 rule->addCondition(condition);
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
+        else if(tag == XmlTag::Name)
         {
-            rule->setName( elem.text().toStdString() );
+            rule->setName( XmlElement::readText(reader).toStdString() );
         }
-        else if(elem.tagName().toLower().compare("type") == 0)
+        else if(tag == XmlTag::Type)
         {
-            rule->setType( StringToType( elem.text().toStdString() ) );
+            rule->setType( StringToType( XmlElement::readText(reader).toStdString() ) );
         }
-        else if(elem.tagName().toLower().compare("noconcurrent") == 0)
+        else if(tag == XmlTag::NoConcurrent)
         {
-            rule->setNoConcurrent( elem.text().compare("true", Qt::CaseInsensitive) == 0 );
+            noConcurrent = XmlElement::readText(reader).compare("true", Qt::CaseInsensitive) == 0;
+        }
+        else if(tag == XmlTag::Concurrency)
+        {
+            concurrency = StringToConcurrency( XmlElement::readText(reader).toStdString() );
+        }
+        else if(tag == XmlTag::QueueLimit)
+        {
+            rule->setQueueLimit( XmlElement::readText(reader).toUInt() );
+        }
+        else
+        {
+            reader->skipCurrentElement();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
+    // scripts which have been saved before the concurrency could be chosen only know NoConcurrent
+    if(concurrency == CINVALID)
+        concurrency = noConcurrent ? Drop : Concurrent;
+
+    rule->setConcurrency(concurrency);
+
+    if(rule->getQueueLimit() == 0)
+        rule->setQueueLimit(1);
+
     return rule;
 }
 
@@ -90,20 +133,91 @@ void Rule::save(QDomElement* root, QDomDocument* document)
 
     rule.appendChild(type);
 
-    // save no concurrent
+    // save no concurrent, so that older versions still do not run the rule concurrently
     QDomElement noconcurrent = document->createElement("NoConcurrent");
-    QDomText noconcurrentText = document->createTextNode( m_noConcurrent ? "true" : "false" );
+    QDomText noconcurrentText = document->createTextNode( m_concurrency != Concurrent ? "true" : "false" );
     noconcurrent.appendChild(noconcurrentText);
 
     rule.appendChild(noconcurrent);
 
+    // save concurrency
+    QDomElement concurrency = document->createElement("concurrency");
+    QDomText concurrencyText = document->createTextNode( QString::fromStdString( ConcurrencyToString(m_concurrency) ) );
+    concurrency.appendChild(concurrencyText);
+
+    rule.appendChild(concurrency);
+
+    if(m_concurrency == QueueN)
+    {
+        QDomElement limit = document->createElement("queuelimit");
+        QDomText limitText = document->createTextNode( QString::number(m_queueLimit) );
+        limit.appendChild(limitText);
+
+        rule.appendChild(limit);
+    }
+
     root->appendChild(rule);
 }
 
+Rule* Rule::loadBinary(QDataStream& in)
+{
+    Rule* rule = new Rule();
+    std::string name;
+    quint8 type = 0;
+    quint8 concurrency = 0;
+    quint32 queueLimit = 0;
+    quint32 count = 0;
+
+    in >> name >> type >> concurrency >> queueLimit;
+
+    rule->setName(name);
+    rule->setType((Type)type);
+    rule->setConcurrency(concurrency < CINVALID ? (Concurrency)concurrency : Concurrent);
+    rule->setQueueLimit(queueLimit);
+
+    in >> count;
+    for(unsigned int i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        Condition* condition = Condition::loadBinary(in);
+        if(condition != NULL)
+            rule->addCondition(condition);
+    }
+
+    in >> count;
+    for(unsigned int i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        Action* action = Action::loadBinary(in);
+        if(action != NULL)
+            rule->addAction(action);
+    }
+
+    return rule;
+}
+
+void Rule::saveBinary(QDataStream& out)
+{
+    out << m_name << (quint8)m_type << (quint8)m_concurrency << (quint32)m_queueLimit;
+
+    out << (quint32)m_listConditions.size();
+    for(std::vector<Condition*>::iterator it = m_listConditions.begin(); it != m_listConditions.end(); it++)
+    {
+        (*it)->saveBinary(out);
+    }
+
+    out << (quint32)m_listActions.size();
+    for(std::vector<Action*>::iterator it = m_listActions.begin(); it != m_listActions.end(); it++)
+    {
+        (*it)->saveBinary(out);
+    }
+}
+
 void Rule::addCondition(Condition *cond, int index)
 {
     cond->setRule(this);
 
+    if(cond->isFulfilled())
+        m_satisfiedCount++;
+
     if(index == -1)
         m_listConditions.push_back(cond);
     else
@@ -118,6 +232,12 @@ void Rule::editCondition(Condition *oldCond, Condition *newCond)
     {
         if(*it == oldCond)
         {
+            if(oldCond->isFulfilled())
+                m_satisfiedCount--;
+            if(newCond->isFulfilled())
+                m_satisfiedCount++;
+
+            oldCond->setRule(NULL);
             *it = newCond;
             break;
         }
@@ -130,6 +250,10 @@ void Rule::removeCondition(Condition* cond)
     {
         if(*it == cond)
         {
+            if(cond->isFulfilled())
+                m_satisfiedCount--;
+
+            cond->setRule(NULL);
             m_listConditions.erase(it);
             break;
         }
@@ -180,43 +304,59 @@ void Rule::getRequiredList(std::list<RequiredInput>* listInput, std::list<Requir
     }
 }
 
+/**
+ * @brief Rule::dependsOn checks if any condition or action resolves one of the given variable or rule names in init.
+ * If one of these variables or rules is replaced, this rule has to be initialized again.
+ * @param names
+ * @return
+ */
+bool Rule::dependsOn(const std::set<Symbol::Id>& names) const
+{
+    for(std::vector<Condition*>::const_iterator it = m_listConditions.begin(); it != m_listConditions.end(); it++)
+    {
+        if((*it)->dependsOn(names))
+            return true;
+    }
+
+    for(std::vector<Action*>::const_iterator it = m_listActions.begin(); it != m_listActions.end(); it++)
+    {
+        if((*it)->dependsOn(names))
+            return true;
+    }
+
+    return false;
+}
+
 void Rule::conditionChanged(Condition *cond)
 {
+    m_profile.evaluated();
+
     // only if type is normal, we react on changed conditions directly
     if(m_type != Normal)
         return;
 
     if(this->conditionsTrue())
     {
-        if(m_noConcurrent)
-        {
-            m_mutexConcurrent.lock();
-            if( !m_ruleRunning )
-            {
-                m_ruleRunning = true;
-                m_mutexConcurrent.unlock();
-            }
-            else
-            {
-                m_mutexConcurrent.unlock();
-                return; // abort execution as the previous execution of this rule has not yet finished
-            }
-        }
-
-        this->executeActions();
+        m_profile.triggered();
+        this->start();
     }
 }
 
-bool Rule::conditionsTrue()
+/**
+ * @brief Rule::conditionFulfilledChanged is called by a condition of this rule every time its state changes
+ * @param fulfilled new state of the condition
+ */
+void Rule::conditionFulfilledChanged(bool fulfilled)
 {
-    bool ret = true;
-    for(std::vector<Condition*>::iterator it = m_listConditions.begin(); it != m_listConditions.end(); it++)
-    {
-        // maybe this can be optimized?
-        ret = ret && (*it)->isFulfilled();
-    }
+    if(fulfilled)
+        m_satisfiedCount++;
+    else
+        m_satisfiedCount--;
+}
 
-    return ret;
+bool Rule::conditionsTrue()
+{
+    return m_satisfiedCount == m_listConditions.size();
 }
 
 void Rule::initConditions(ConfigManager *config)
@@ -229,6 +369,9 @@ void Rule::initConditions(ConfigManager *config)
 
 void Rule::initActions(ConfigManager *config)
 {
+    m_profile.setActionCount(m_listActions.size());
+    m_timerThread = config->getRuleTimerThread();
+
     for(std::vector<Action*>::iterator it = m_listActions.begin(); it != m_listActions.end(); it++)
     {
         (*it)->init(config);
@@ -247,29 +390,152 @@ void Rule::deinit()
     {
         (*it)->deinit();
     }
+
+    m_timerThread = NULL;
+}
+
+/**
+ * @brief Rule::reset is called when all pending sleeps have been deleted, e.g. when the script has been stopped.
+ * The rule is not running anymore and queued executions are discarded.
+ */
+void Rule::reset()
+{
+    m_run++;
+    m_state = 0;
+}
+
+/**
+ * @brief Rule::start starts a new execution of the rule, if its concurrency allows it.
+ * The state of the rule is only changed with atomic operations, so that triggers never have to wait for each other.
+ */
+void Rule::start()
+{
+    if(m_concurrency == Concurrent)
+    {
+        this->executeActions();
+        return;
+    }
+
+    if(m_concurrency == Restart)
+    {
+        if(m_state.exchange(1) != 0)
+        {
+            // sleeps which have expired already might still wait in the queue of the executor, they are recognized by their run
+            m_run++;
+            if(m_timerThread != NULL)
+                m_timerThread->cancelRule(this, true);
+
+            m_profile.restarted();
+        }
+
+        this->executeActions();
+        return;
+    }
+
+    unsigned int limit = 0;
+    if(m_concurrency == QueueOne)
+        limit = 1;
+    else if(m_concurrency == QueueN)
+        limit = m_queueLimit;
+
+    unsigned int state = m_state.load();
+    do
+    {
+        // the first execution is running, every further one is queued
+        if(state != 0 && state - 1 >= limit)
+        {
+            m_profile.dropped();
+            return; // abort execution as the previous execution of this rule has not yet finished
+        }
+    } while(!m_state.compare_exchange_weak(state, state + 1));
+
+    if(state != 0)
+    {
+        m_profile.queued();
+        return; // started by Rule::finished
+    }
+
+    this->executeActions();
+}
+
+/**
+ * @brief Rule::finished is called every time an execution has executed its last action
+ * @return true if a queued execution has to be started now
+ */
+bool Rule::finished()
+{
+    if(m_concurrency == Concurrent)
+        return false;
+
+    unsigned int state = m_state.load();
+    do
+    {
+        // the concurrency might have been changed while the rule was running
+        if(state == 0)
+            return false;
+    } while(!m_state.compare_exchange_weak(state, state - 1));
+
+    return state > 1;
+}
+
+/**
+ * @brief Rule::continueActions continues an execution after a sleep has expired
+ * @param start first action to execute
+ * @param run run of the rule when the sleep was added, see Rule::getRun
+ */
+void Rule::continueActions(unsigned int start, unsigned int run)
+{
+    if(run != m_run.load())
+    {
+        LOG_DEBUG(Logger::Script, "Rule %s: sleep of a previous run is not continued", m_name.c_str());
+        return;
+    }
+
+    this->executeActions(start);
 }
 
 void Rule::executeActions(unsigned int start)
+{
+    // queued executions are started in a loop instead of recursively, so that a long queue cannot overflow the stack
+    while(this->runActions(start) && this->finished())
+    {
+        LOG_DEBUG(Logger::Script, "Rule %s: starting queued execution", m_name.c_str());
+        start = 0;
+    }
+}
+
+/**
+ * @brief Rule::runActions executes the actions beginning with start until the last one or until an action stops the execution, i.e. a sleep
+ * @param start
+ * @return true if the last action has been executed
+ */
+bool Rule::runActions(unsigned int start)
 {
     pi_assert(start <= m_listActions.size());
 
     LOG_DEBUG(Logger::Script, "Rule %s: executeActions beginning with nr %i", m_name.c_str(), start);
 
+    unsigned int first = start;
+    unsigned long long begin = RuleProfile::timestamp();
+    unsigned long long last = begin;
+
     // start executing at start-element
     for(; start < m_listActions.size(); start++)
     {
-        if( !(m_listActions.at(start)->execute(start) ) )
+        bool cont = m_listActions.at(start)->execute(start);
+
+        unsigned long long now = RuleProfile::timestamp();
+        m_profile.actionExecuted(start, now - last);
+        last = now;
+
+        if( !cont )
             break; // Action said we should stop executing other actions
     }
 
-    // as soon as every action in this rule was executed once,
-    // the rule has stopped running and a new rule can start (for non-concurrent rules)
-    if(m_noConcurrent && start == m_listActions.size())
-    {
-        m_mutexConcurrent.lock();
-        m_ruleRunning = false;
-        m_mutexConcurrent.unlock();
-    }
+    m_profile.executed(first, last - begin);
+
+    // as soon as every action in this rule was executed once, the execution has finished
+    return start == m_listActions.size();
 }
 
 /**     call is used by ActionCallRule to call another rule.
@@ -286,7 +552,10 @@ void Rule::call()
     LOG_DEBUG(Logger::Script, "Rule %s was called, evaluating conditions", m_name.c_str());
 
     if(this->conditionsTrue())
-        this->executeActions();
+    {
+        m_profile.triggered();
+        this->start();
+    }
 }
 
 Rule::Type Rule::StringToType(std::string str)
@@ -316,3 +585,46 @@ std::string Rule::TypeToString(Type type)
         break;
     }
 }
+
+Rule::Concurrency Rule::StringToConcurrency(std::string str)
+{
+    const char* cstr = str.c_str();
+    if( strcasecmp(cstr, "concurrent") == 0)
+        return Concurrent;
+    else if( strcasecmp(cstr, "drop") == 0)
+        return Drop;
+    else if( strcasecmp(cstr, "queueone") == 0)
+        return QueueOne;
+    else if( strcasecmp(cstr, "queuen") == 0)
+        return QueueN;
+    else if( strcasecmp(cstr, "restart") == 0)
+        return Restart;
+    else
+        return CINVALID;
+}
+
+std::string Rule::ConcurrencyToString(Concurrency concurrency)
+{
+    switch(concurrency)
+    {
+    case Concurrent:
+        return "Concurrent";
+        break;
+    case Drop:
+        return "Drop";
+        break;
+    case QueueOne:
+        return "QueueOne";
+        break;
+    case QueueN:
+        return "QueueN";
+        break;
+    case Restart:
+        return "Restart";
+        break;
+    default:
+        LOG_WARN(Logger::Script, "Invalid concurrency");
+        return "";
+        break;
+    }
+}
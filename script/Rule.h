@@ -3,14 +3,21 @@
 
 #include <QDomElement>
 #include <vector>
-#include <mutex>
+#include <set>
+#include <atomic>
 
 #include "hw/HWInput.h"
 #include "hw/HWOutput.h"
+#include "script/RuleProfile.h"
+#include "util/Symbol.h"
 
+class QDataStream;
+class QXmlStreamReader;
+class XmlElement;
 class Condition;
 class Action;
 class ConfigManager;
+class RuleTimerThread;
 
 /**
  * @brief The Rule class contains a list of conditions which all must be true,
@@ -28,10 +35,28 @@ public:
     static Type StringToType(std::string str);
     static std::string TypeToString(Type type);
 
+    /**
+     * @brief The Concurrency enum defines what happens if a rule is triggered again while a previous execution has not finished yet,
+     * i.e. while it is sleeping.
+     */
+    enum Concurrency
+    {
+        Concurrent = 0, // every trigger starts a new execution, executions interleave at their sleeps
+        Drop = 1, // triggers are ignored while the rule is running
+        QueueOne = 2, // all triggers while the rule is running are coalesced into a single execution, which starts when the running one has finished
+        QueueN = 3, // like QueueOne, but up to getQueueLimit() executions are queued
+        Restart = 4, // pending sleeps are cancelled and the rule starts again with its first action
+        CINVALID,
+    };
+    static Concurrency StringToConcurrency(std::string str);
+    static std::string ConcurrencyToString(Concurrency concurrency);
+
     /**
      * @brief The RequiredInput struct
      * This struct is used to get a list of required inputs from every Condition / Action.
      * Every input is specified using its name and its type. For correct operation both fields have to match the config.
+     * Names used in expressions are reported with type EINVALID, any input with this name matches them.
+     * Script::getRequiredList turns them into variables if the script has a variable with this name.
      */
     struct RequiredInput
     {
@@ -66,8 +91,10 @@ public:
     Rule();
     ~Rule();
 
-    static Rule* load(QDomElement* root);
+    static Rule* load(QXmlStreamReader* reader);
     void save(QDomElement* root, QDomDocument* document);
+    static Rule* loadBinary(QDataStream& in);
+    void saveBinary(QDataStream& out);
 
     // condition will be deleted by this class
     void addCondition(Condition* cond, int index = -1);
@@ -78,12 +105,15 @@ public:
     void editAction(Action* oldAction, Action* newAction);
 
     void getRequiredList(std::list<RequiredInput>* listInput, std::list<RequiredOutput>* listOutput, std::list<RequiredVariable>* listVariable);
+    bool dependsOn(const std::set<Symbol::Id>& names) const;
 
     void conditionChanged(Condition* cond);
+    void conditionFulfilledChanged(bool fulfilled);
 
     void initConditions(ConfigManager* config);
     void initActions(ConfigManager* config);
     void deinit();
+    void reset();
 
     std::string getName() const { return m_name;}
     void setName(std::string str) { m_name = str;}
@@ -91,30 +121,53 @@ public:
     void setType(Type type) { m_type = type;}
     Type getType() const { return m_type;}
 
-    void setNoConcurrent(bool b) { m_noConcurrent = b;}
-    bool getNoConcurrent() const { return m_noConcurrent;}
+    void setConcurrency(Concurrency concurrency) { m_concurrency = concurrency;}
+    Concurrency getConcurrency() const { return m_concurrency;}
+
+    void setQueueLimit(unsigned int limit) { m_queueLimit = limit;}
+    unsigned int getQueueLimit() const { return m_queueLimit;}
 
     void call();
 
-    // executeActions is used by RuleTimerThread, if one of the actions was Sleep
-    void executeActions(unsigned int start = 0);
+    RuleProfile* getProfile() { return &m_profile;}
+
+    // the run changes every time the rule is restarted, sleeps of an older run are not continued
+    unsigned int getRun() const { return m_run.load(std::memory_order_relaxed);}
+
+    // continueActions is used by RuleExecutor to continue a rule, if one of the actions was Sleep
+    void continueActions(unsigned int start, unsigned int run);
 
 private:
     Type m_type;
 
     // Concurrent handling
-    bool m_noConcurrent;
-    std::mutex m_mutexConcurrent;
-    bool m_ruleRunning;
+    Concurrency m_concurrency;
+    unsigned int m_queueLimit;
+    RuleTimerThread* m_timerThread;
+
+    // 0 if the rule is not running, otherwise 1 + the number of queued executions
+    std::atomic<unsigned int> m_state;
+    std::atomic<unsigned int> m_run;
 
     bool conditionsTrue();
 
+    void start();
+    void executeActions(unsigned int start = 0);
+    bool runActions(unsigned int start);
+    bool finished();
+
+    // number of conditions in m_listConditions which are currently fulfilled
+    std::atomic<unsigned int> m_satisfiedCount;
+
     std::vector<Condition*> m_listConditions;
     std::vector<Action*> m_listActions;
     std::string m_name;
 
+    RuleProfile m_profile;
+
     friend class ActionTableModel;
     friend class ConditionTableModel;
+    friend class DispatchTable;
 };
 
 #endif // RULE_H
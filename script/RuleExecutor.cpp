@@ -0,0 +1,303 @@
+
+#include "script/RuleExecutor.h"
+#include "script/DispatchTable.h"
+#include "script/Rule.h"
+#include "script/Condition.h"
+#include "script/Variable.h"
+#include "script/EventRecorder.h"
+#include "util/Debug.h"
+#include "util/LatencyTrace.h"
+
+#include <errno.h>
+#include <sched.h>
+
+// number of events which can be queued, must be a power of two
+#define EXECUTOR_QUEUE_SIZE 1024
+
+RuleExecutor::RuleExecutor() : m_queue(EXECUTOR_QUEUE_SIZE)
+{
+    m_thread = 0;
+    m_bStop = false;
+    m_overflowCount = 0;
+    m_coalesced = 0;
+    m_coalescedReported = 0;
+
+    sem_init(&m_sem, 0, 0);
+    sem_init(&m_semSuspended, 0, 0);
+    sem_init(&m_semResume, 0, 0);
+}
+
+RuleExecutor::~RuleExecutor()
+{
+    if(m_thread != 0)
+        this->kill();
+
+    sem_destroy(&m_sem);
+    sem_destroy(&m_semSuspended);
+    sem_destroy(&m_semResume);
+}
+
+/**
+ * @brief RuleExecutor::start starts this thread
+ */
+void RuleExecutor::start()
+{
+    pi_assert(m_thread == 0);
+
+    m_bStop = false;
+
+    pthread_create(&m_thread, NULL, RuleExecutor::run_internal, (void*)this);
+}
+
+/**
+ * @brief RuleExecutor::kill stops this thread. Events which have not yet been processed are discarded.
+ */
+void RuleExecutor::kill()
+{
+    if(m_thread == 0)
+        return;
+
+    m_bStop = true;
+    sem_post(&m_sem);
+
+    pthread_join(m_thread, NULL);
+    m_thread = 0;
+
+    this->clear();
+}
+
+/**
+ * @brief RuleExecutor::post queues an event for the executor thread. It can be called from any thread and no event is ever lost.
+ * Usually the event is written to the lock free queue without blocking. If the queue is full, it is appended to the overflow list,
+ * which is protected by a mutex and has no limit. Input changes are coalesced instead, so that a flood of input changes cannot
+ * grow the overflow list: only the latest value of the input is kept and there is at most one event per input in the list.
+ * Once the overflow list is in use, all events go there until it is empty again, so that the events of every thread stay in order.
+ * @param type
+ * @param target
+ * @param value
+ * @param run only used for Continue, see Rule::getRun
+ */
+void RuleExecutor::post(EventType type, void* target, int value, unsigned int run)
+{
+    Event event;
+    event.type = type;
+    event.target = target;
+    event.value = value;
+    event.run = run;
+    event.origin = type == InputChanged ? LatencyTrace::timestamp() : 0;
+
+    if(m_overflowCount.load() == 0 && m_queue.push(event))
+    {
+        sem_post(&m_sem);
+        return;
+    }
+
+    if(type == InputChanged)
+    {
+        DispatchTable::InputDispatch* dispatch = (DispatchTable::InputDispatch*)event.target;
+
+        // we must not log here, as this is called by the hardware threads, the executor thread reports it later
+        m_coalesced++;
+
+        // the value has to be stored before the flag is checked, the executor clears the flag before it reads the value
+        dispatch->latestValue.store(value);
+        if(dispatch->coalesced.exchange(true))
+            return; // the pending event picks up the new value
+
+        event.type = InputCoalesced;
+    }
+
+    m_mutexOverflow.lock();
+    m_listOverflow.push_back(event);
+    m_overflowCount++;
+    m_mutexOverflow.unlock();
+
+    sem_post(&m_sem);
+}
+
+/**
+ * @brief RuleExecutor::pop removes the oldest event, events in the lock free queue are always older than the ones in the overflow list
+ * @param event
+ * @return false if there is no event or it has not been written completely yet
+ */
+bool RuleExecutor::pop(Event* event)
+{
+    if(m_queue.pop(event))
+        return true;
+
+    if(m_overflowCount.load() == 0)
+        return false;
+
+    bool found = false;
+
+    m_mutexOverflow.lock();
+    if(!m_listOverflow.empty())
+    {
+        *event = m_listOverflow.front();
+        m_listOverflow.pop_front();
+        m_overflowCount--;
+        found = true;
+    }
+    m_mutexOverflow.unlock();
+
+    return found;
+}
+
+/**
+ * @brief RuleExecutor::flush waits until all events which have been posted before are processed.
+ * Must not be called by the executor thread itself.
+ */
+void RuleExecutor::flush()
+{
+    if(m_thread == 0)
+        return;
+
+    pi_assert(!this->isExecutorThread());
+
+    sem_t done;
+    sem_init(&done, 0, 0);
+
+    this->post(Flush, &done);
+    while(sem_wait(&done) == -1 && errno == EINTR);
+
+    sem_destroy(&done);
+}
+
+/**
+ * @brief RuleExecutor::suspend waits until all events which have been posted before are processed and stops the executor there.
+ * While the executor is suspended, rules and conditions can be modified safely by the calling thread.
+ * Events posted in the meantime are queued and processed after RuleExecutor::resume, input changes are coalesced if the queue overflows.
+ * Must not be called by the executor thread itself.
+ */
+void RuleExecutor::suspend()
+{
+    if(m_thread == 0)
+        return;
+
+    pi_assert(!this->isExecutorThread());
+
+    this->post(Suspend, NULL);
+
+    while(sem_wait(&m_semSuspended) == -1 && errno == EINTR);
+}
+
+/**
+ * @brief RuleExecutor::resume continues the executor after RuleExecutor::suspend
+ */
+void RuleExecutor::resume()
+{
+    if(m_thread == 0)
+        return;
+
+    sem_post(&m_semResume);
+}
+
+bool RuleExecutor::isExecutorThread() const
+{
+    return m_thread != 0 && pthread_equal(pthread_self(), m_thread);
+}
+
+/**
+ * @brief RuleExecutor::clear discards all queued events. The thread must be stopped to do this!
+ */
+void RuleExecutor::clear()
+{
+    pi_assert(m_thread == 0);
+
+    Event event;
+    while(this->pop(&event))
+    {
+        // nobody may wait forever for an event we are throwing away
+        if(event.type == Flush)
+            sem_post((sem_t*)event.target);
+        else if(event.type == Suspend)
+            sem_post(&m_semSuspended);
+    }
+
+    while(sem_trywait(&m_sem) == 0);
+}
+
+void RuleExecutor::handleEvent(const Event& event)
+{
+    switch(event.type)
+    {
+    case InputChanged:
+        this->dispatchInput((DispatchTable::InputDispatch*)event.target, event.value, event.origin);
+        break;
+    case InputCoalesced:
+    {
+        DispatchTable::InputDispatch* dispatch = (DispatchTable::InputDispatch*)event.target;
+
+        // changes posted from now on post a new event
+        dispatch->coalesced.store(false);
+        this->dispatchInput(dispatch, dispatch->latestValue.load(), event.origin);
+        break;
+    }
+    case VariableSet:
+        EventRecorder::variableSet((Variable*)event.target, event.value);
+        ((Variable*)event.target)->setValue(event.value);
+        break;
+    case Evaluate:
+        ((DispatchTable*)event.target)->evaluate();
+        break;
+    case Continue:
+        ((Rule*)event.target)->continueActions(event.value, event.run);
+        break;
+    case Recheck:
+        ((Condition*)event.target)->recheck();
+        break;
+    case Flush:
+        sem_post((sem_t*)event.target);
+        break;
+    case Suspend:
+        sem_post(&m_semSuspended);
+        while(sem_wait(&m_semResume) == -1 && errno == EINTR);
+        break;
+    }
+}
+
+void RuleExecutor::dispatchInput(DispatchTable::InputDispatch* dispatch, int value, unsigned long long origin)
+{
+    LatencyTrace::inputHandled(origin);
+    EventRecorder::input(dispatch->hw, value, origin);
+
+    // every output changed while dispatching is traced back to this input change
+    LatencyTrace::setOrigin(origin);
+    dispatch->dispatch(value);
+    LatencyTrace::setOrigin(0);
+}
+
+void RuleExecutor::run()
+{
+    while(true)
+    {
+        if(sem_wait(&m_sem) == -1)
+            continue; // interrupted by a signal
+
+        if(m_bStop)
+            break;
+
+        unsigned int coalesced = m_coalesced;
+        if(coalesced != m_coalescedReported)
+        {
+            LOG_WARN(Logger::Script, "Rule executor queue overflowed, %u input changes have been coalesced so far", coalesced);
+            m_coalescedReported = coalesced;
+        }
+
+        // the semaphore is only posted after the event has been written,
+        // but another producer may still be writing an older slot, so we wait for it
+        Event event;
+        while(!this->pop(&event))
+            sched_yield();
+
+        this->handleEvent(event);
+    }
+}
+
+void* RuleExecutor::run_internal(void* arg)
+{
+    RuleExecutor* thread = (RuleExecutor*)arg;
+    thread->run();
+
+    return NULL;
+}
@@ -0,0 +1,83 @@
+#ifndef RULEEXECUTOR_H
+#define RULEEXECUTOR_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <util/LockFreeQueue.h>
+
+#include "script/DispatchTable.h"
+
+/**
+ * @brief The RuleExecutor class is the only thread which evaluates conditions and executes rules.
+ * Hardware threads, the RuleTimerThread and the GUI only post events to its lock free queue and return immediately,
+ * so that a slow action can never stall the polling of a bus.
+ * All events are processed in the order they have been posted.
+ */
+class RuleExecutor
+{
+public:
+    enum EventType
+    {
+        InputChanged, // target is a DispatchTable::InputDispatch, value the new value of the input
+        InputCoalesced, // target is a DispatchTable::InputDispatch, the queue was full, so its latest value is read when the event is handled
+        VariableSet, // target is a Variable, value its new value
+        Evaluate, // target is a DispatchTable which should evaluate the initial state of all conditions
+        Continue, // target is a Rule, value the first action to execute, run the run of the rule when it started sleeping
+        Recheck, // target is a Condition which has to be evaluated again, see RuleTimerThread::addRecheck
+        Flush, // target is a semaphore which is posted as soon as the event is reached
+        Suspend, // the executor waits until RuleExecutor::resume is called
+    };
+
+    RuleExecutor();
+    ~RuleExecutor();
+
+    void start();
+    void kill();
+
+    void post(EventType type, void* target, int value = 0, unsigned int run = 0);
+    void flush();
+
+    void suspend();
+    void resume();
+
+    bool isExecutorThread() const;
+
+private:
+    struct Event
+    {
+        EventType type;
+        void* target;
+        int value;
+        unsigned int run;
+        unsigned long long origin; // time the event has been posted, only set for InputChanged
+    };
+
+    static void* run_internal(void* arg);
+    void run();
+
+    bool pop(Event* event);
+    void handleEvent(const Event& event);
+    void dispatchInput(DispatchTable::InputDispatch* dispatch, int value, unsigned long long origin);
+    void clear();
+
+    pthread_t m_thread;
+    std::atomic<bool> m_bStop;
+    sem_t m_sem; // counts the events in m_queue
+    sem_t m_semSuspended; // posted by the executor when it has reached a Suspend event
+    sem_t m_semResume;
+
+    LockFreeQueue<Event> m_queue;
+
+    // events which did not fit into m_queue
+    std::mutex m_mutexOverflow;
+    std::list<Event> m_listOverflow;
+    std::atomic<unsigned int> m_overflowCount; // size of m_listOverflow, can be read without the mutex
+
+    std::atomic<unsigned int> m_coalesced;
+    unsigned int m_coalescedReported;
+};
+
+#endif // RULEEXECUTOR_H
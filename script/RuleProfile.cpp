@@ -0,0 +1,192 @@
+
+#include "script/RuleProfile.h"
+
+#include <QDomDocument>
+
+#include <time.h>
+
+RuleProfile::RuleProfile()
+{
+    m_actions = NULL;
+    m_numActions = 0;
+
+    this->reset();
+}
+
+RuleProfile::~RuleProfile()
+{
+    delete[] m_actions;
+}
+
+/**
+ * @brief RuleProfile::setActionCount allocates the counters of every action.
+ * Must only be called while the rule is not executed, i.e. when it is initialized.
+ * The counters are kept if the number of actions did not change.
+ * @param count
+ */
+void RuleProfile::setActionCount(unsigned int count)
+{
+    if(count == m_numActions)
+        return;
+
+    delete[] m_actions;
+    m_actions = NULL;
+    m_numActions = 0;
+
+    if(count == 0)
+        return;
+
+    m_actions = new ActionCounter[count];
+    for(unsigned int i = 0; i < count; i++)
+    {
+        m_actions[i].executions = 0;
+        m_actions[i].timeNs = 0;
+        m_actions[i].maxNs = 0;
+    }
+
+    m_numActions = count;
+}
+
+/**
+ * @brief RuleProfile::actionExecuted is called after every action
+ * @param index index of the action in the rule
+ * @param ns time the action took
+ */
+void RuleProfile::actionExecuted(unsigned int index, unsigned long long ns)
+{
+    if(index >= m_numActions)
+        return;
+
+    ActionCounter* action = &m_actions[index];
+
+    increment(action->executions, 1);
+    increment(action->timeNs, ns);
+    maximum(action->maxNs, ns);
+}
+
+/**
+ * @brief RuleProfile::executed is called every time the rule has stopped executing actions, either because all actions are done or because of a sleep
+ * @param start first action which has been executed, 0 if the execution has just been started
+ * @param ns time spent in all actions
+ */
+void RuleProfile::executed(unsigned int start, unsigned long long ns)
+{
+    if(start == 0)
+        increment(m_executions, 1);
+    else
+        increment(m_continuations, 1);
+
+    increment(m_timeNs, ns);
+    maximum(m_maxNs, ns);
+}
+
+/**
+ * @brief RuleProfile::get returns the current state of all counters. The counters are read one after another,
+ * so they might not be consistent with each other if the rule is executed in the meantime.
+ * @return
+ */
+RuleProfile::Snapshot RuleProfile::get() const
+{
+    Snapshot snapshot;
+
+    snapshot.evaluations = m_evaluations.load(std::memory_order_relaxed);
+    snapshot.triggers = m_triggers.load(std::memory_order_relaxed);
+    snapshot.executions = m_executions.load(std::memory_order_relaxed);
+    snapshot.continuations = m_continuations.load(std::memory_order_relaxed);
+    snapshot.dropped = m_dropped.load(std::memory_order_relaxed);
+    snapshot.queued = m_queued.load(std::memory_order_relaxed);
+    snapshot.restarted = m_restarted.load(std::memory_order_relaxed);
+    snapshot.timeNs = m_timeNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    snapshot.sleeps = m_sleeps.load(std::memory_order_relaxed);
+    snapshot.sleepMs = m_sleepMs.load(std::memory_order_relaxed);
+
+    snapshot.actions = 0;
+    for(unsigned int i = 0; i < m_numActions; i++)
+    {
+        ActionSnapshot action;
+        action.executions = m_actions[i].executions.load(std::memory_order_relaxed);
+        action.timeNs = m_actions[i].timeNs.load(std::memory_order_relaxed);
+        action.maxNs = m_actions[i].maxNs.load(std::memory_order_relaxed);
+
+        snapshot.actions += action.executions;
+        snapshot.listActions.push_back(action);
+    }
+
+    return snapshot;
+}
+
+/**
+ * @brief RuleProfile::reset sets all counters to zero. An execution which is running at the same time might still be counted.
+ */
+void RuleProfile::reset()
+{
+    m_evaluations = 0;
+    m_triggers = 0;
+    m_executions = 0;
+    m_continuations = 0;
+    m_dropped = 0;
+    m_queued = 0;
+    m_restarted = 0;
+    m_timeNs = 0;
+    m_maxNs = 0;
+    m_sleeps = 0;
+    m_sleepMs = 0;
+
+    for(unsigned int i = 0; i < m_numActions; i++)
+    {
+        m_actions[i].executions = 0;
+        m_actions[i].timeNs = 0;
+        m_actions[i].maxNs = 0;
+    }
+}
+
+/**
+ * @brief RuleProfile::save appends all counters as XML to root, so that they can be processed by other tools.
+ * @param root
+ * @param document
+ */
+void RuleProfile::save(QDomElement* root, QDomDocument* document) const
+{
+    Snapshot snapshot = this->get();
+
+    QDomElement profile = document->createElement("profile");
+
+    profile.setAttribute("evaluations", QString::number(snapshot.evaluations));
+    profile.setAttribute("triggers", QString::number(snapshot.triggers));
+    profile.setAttribute("executions", QString::number(snapshot.executions));
+    profile.setAttribute("continuations", QString::number(snapshot.continuations));
+    profile.setAttribute("dropped", QString::number(snapshot.dropped));
+    profile.setAttribute("queued", QString::number(snapshot.queued));
+    profile.setAttribute("restarted", QString::number(snapshot.restarted));
+    profile.setAttribute("actions", QString::number(snapshot.actions));
+    profile.setAttribute("timeNs", QString::number(snapshot.timeNs));
+    profile.setAttribute("maxNs", QString::number(snapshot.maxNs));
+    profile.setAttribute("sleeps", QString::number(snapshot.sleeps));
+    profile.setAttribute("sleepMs", QString::number(snapshot.sleepMs));
+
+    for(unsigned int i = 0; i < snapshot.listActions.size(); i++)
+    {
+        QDomElement action = document->createElement("action");
+        action.setAttribute("index", i);
+        action.setAttribute("executions", QString::number(snapshot.listActions[i].executions));
+        action.setAttribute("timeNs", QString::number(snapshot.listActions[i].timeNs));
+        action.setAttribute("maxNs", QString::number(snapshot.listActions[i].maxNs));
+
+        profile.appendChild(action);
+    }
+
+    root->appendChild(profile);
+}
+
+/**
+ * @brief RuleProfile::timestamp returns the current time of CLOCK_MONOTONIC in nanoseconds
+ * @return
+ */
+unsigned long long RuleProfile::timestamp()
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return currentTime.tv_sec * 1000000000ULL + currentTime.tv_nsec;
+}
@@ -0,0 +1,106 @@
+#ifndef RULEPROFILE_H
+#define RULEPROFILE_H
+
+#include <atomic>
+#include <vector>
+
+class QDomElement;
+class QDomDocument;
+
+/**
+ * @brief The RuleProfile class counts how often a rule is evaluated and executed and how much time it spends doing so.
+ * Every counter has exactly one writer, either the RuleExecutor or the RuleTimerThread, so the counters are updated
+ * with relaxed loads and stores without any locking. RuleProfile::get adds them up when they are requested.
+ * Execution times include the time of rules called by ActionCallRule.
+ */
+class RuleProfile
+{
+public:
+    struct ActionSnapshot
+    {
+        unsigned long long executions;
+        unsigned long long timeNs;
+        unsigned long long maxNs;
+    };
+
+    struct Snapshot
+    {
+        unsigned long long evaluations; // a condition of the rule has changed
+        unsigned long long triggers; // all conditions were true when evaluated or called
+        unsigned long long executions; // executions started with the first action
+        unsigned long long continuations; // executions continued after a sleep
+        unsigned long long dropped; // triggers ignored, because the rule does not run concurrently and is still running
+        unsigned long long queued; // triggers queued until the running execution has finished
+        unsigned long long restarted; // triggers which have cancelled the running execution
+        unsigned long long actions; // executed actions
+        unsigned long long timeNs; // time spent executing actions
+        unsigned long long maxNs; // longest execution without interruption by a sleep
+        unsigned long long sleeps; // sleeps which have expired
+        unsigned long long sleepMs; // time parked in the RuleTimerThread
+
+        std::vector<ActionSnapshot> listActions;
+    };
+
+    RuleProfile();
+    ~RuleProfile();
+
+    void setActionCount(unsigned int count);
+
+    // called by the RuleExecutor
+    void evaluated() { increment(m_evaluations, 1);}
+    void triggered() { increment(m_triggers, 1);}
+    void dropped() { increment(m_dropped, 1);}
+    void queued() { increment(m_queued, 1);}
+    void restarted() { increment(m_restarted, 1);}
+    void actionExecuted(unsigned int index, unsigned long long ns);
+    void executed(unsigned int start, unsigned long long ns);
+
+    // called by the RuleTimerThread
+    void slept(unsigned long long ms) { increment(m_sleeps, 1); increment(m_sleepMs, ms);}
+
+    Snapshot get() const;
+    void reset();
+    void save(QDomElement* root, QDomDocument* document) const;
+
+    static unsigned long long timestamp();
+
+private:
+    struct ActionCounter
+    {
+        std::atomic<unsigned long long> executions;
+        std::atomic<unsigned long long> timeNs;
+        std::atomic<unsigned long long> maxNs;
+    };
+
+    // only valid if there is a single writer
+    static void increment(std::atomic<unsigned long long>& counter, unsigned long long value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void maximum(std::atomic<unsigned long long>& counter, unsigned long long value)
+    {
+        if(value > counter.load(std::memory_order_relaxed))
+            counter.store(value, std::memory_order_relaxed);
+    }
+
+    // written by the RuleExecutor
+    std::atomic<unsigned long long> m_evaluations;
+    std::atomic<unsigned long long> m_triggers;
+    std::atomic<unsigned long long> m_executions;
+    std::atomic<unsigned long long> m_continuations;
+    std::atomic<unsigned long long> m_dropped;
+    std::atomic<unsigned long long> m_queued;
+    std::atomic<unsigned long long> m_restarted;
+    std::atomic<unsigned long long> m_timeNs;
+    std::atomic<unsigned long long> m_maxNs;
+
+    ActionCounter* m_actions;
+    unsigned int m_numActions;
+
+    // written by the RuleTimerThread
+    std::atomic<unsigned long long> m_sleeps;
+    std::atomic<unsigned long long> m_sleepMs;
+};
+
+#endif // RULEPROFILE_H
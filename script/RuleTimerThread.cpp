@@ -1,34 +1,56 @@
 
 #include "script/RuleTimerThread.h"
 #include "script/Rule.h"
+#include "script/RuleExecutor.h"
 #include "util/Debug.h"
 
-#include <signal.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
 
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
 
-static void dummy_handler(int)
+RuleTimerThread::RuleTimerThread(RuleExecutor* executor)
 {
-    // nothing here
-}
+    m_executor = executor;
 
-RuleTimerThread::RuleTimerThread()
-{
     m_bStop = false;
     m_bPaused = false;
+    m_bVirtual = false;
+    m_virtualNow = 0;
     m_thread = 0;
 
-    // specify a dummy handler for SIGUSR1
-    struct sigaction sa;
-    sa.sa_flags = 0;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_handler = dummy_handler;
-    sigaction(SIGUSR1, &sa, NULL);
+    memset(m_wheel, 0, sizeof(m_wheel));
+    memset(m_occupied, 0, sizeof(m_occupied));
+    m_numTimers = 0;
+    m_tick = 0;
+    m_armedTick = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &m_base);
+
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if(m_timerFd == -1)
+        LOG_ERROR(Logger::Script, "timerfd_create has failed");
+
+    m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(m_eventFd == -1)
+        LOG_ERROR(Logger::Script, "eventfd has failed");
 }
 
 RuleTimerThread::~RuleTimerThread()
 {
     if(m_thread != 0)
         this->kill();
+
+    this->clear();
+
+    if(m_timerFd != -1)
+        close(m_timerFd);
+
+    if(m_eventFd != -1)
+        close(m_eventFd);
 }
 
 /**
@@ -46,6 +68,7 @@ void RuleTimerThread::start()
 
 /**
  * @brief RuleTimerThread::kill kills this thread. If this thread is deleted it is killed automatically.
+ * Pending sleeps are kept.
  */
 void RuleTimerThread::kill()
 {
@@ -58,24 +81,148 @@ void RuleTimerThread::kill()
     m_bStop = true;
     m_mutex.unlock();
 
-    // deliver signal to thread to wake it up
-    pthread_kill(m_thread, SIGUSR1);
+    this->wakeup();
 
     pthread_join(m_thread, NULL);
     m_thread = 0;
 }
 
+void RuleTimerThread::wakeup()
+{
+    if(eventfd_write(m_eventFd, 1) != 0)
+        LOG_ERROR(Logger::Script, "Could not wake up rule timer thread");
+}
+
 /**
- * @brief RuleTimerThread::clear is used to clear the queue of RuleTimerThread.
- * All queued operations are deleted immediatly. The thread must be stopped to do this!
+ * @brief RuleTimerThread::clear deletes all pending sleeps and continues the timer if it was paused.
+ * The thread does not have to be stopped to do this.
  */
 void RuleTimerThread::clear()
 {
-    pi_assert(m_thread == 0);
-
     m_mutex.lock();
-    while(!m_queue.empty()) m_queue.pop();
+
+    for(unsigned int slot = 0; slot < TIMER_WHEEL_SIZE; slot++)
+    {
+        Timer* timer = m_wheel[slot];
+        while(timer != NULL)
+        {
+            Timer* next = timer->slotNext;
+            delete timer;
+            timer = next;
+        }
+
+        m_wheel[slot] = NULL;
+    }
+
+    memset(m_occupied, 0, sizeof(m_occupied));
+    m_mapRule.clear();
+    m_numTimers = 0;
+
+    if(m_bPaused)
+    {
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+        m_base = timespecAdd(m_base, timespecSub(currentTime, m_pausedTime));
+        m_bPaused = false;
+    }
+
     m_mutex.unlock();
+
+    this->wakeup();
+}
+
+/**
+ * @brief RuleTimerThread::now returns the current time of the timer clock in miliseconds. Must be called with m_mutex held
+ * @return
+ */
+unsigned long long RuleTimerThread::now() const
+{
+    if(m_bVirtual)
+        return m_virtualNow;
+
+    timespec currentTime;
+
+    if(m_bPaused)
+        currentTime = m_pausedTime;
+    else
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    timespec diff = timespecSub(currentTime, m_base);
+
+    return diff.tv_sec * 1000ULL + diff.tv_nsec / 1000000;
+}
+
+/**
+ * @brief RuleTimerThread::link inserts timer into its slot and into the list of its rule. Must be called with m_mutex held
+ * @param timer
+ */
+void RuleTimerThread::link(Timer* timer)
+{
+    // timers which are already due are put into the next slot which is processed
+    unsigned long long tick = timer->expiry < m_tick ? m_tick : timer->expiry;
+    unsigned int slot = tick & TIMER_WHEEL_MASK;
+
+    timer->slot = slot;
+    timer->slotPrev = NULL;
+    timer->slotNext = m_wheel[slot];
+    if(timer->slotNext != NULL)
+        timer->slotNext->slotPrev = timer;
+    m_wheel[slot] = timer;
+    m_occupied[slot / 64] |= 1ULL << (slot % 64);
+
+    timer->rulePrev = NULL;
+    std::map<Rule*, Timer*>::iterator it = m_mapRule.find(timer->rule);
+    if(it != m_mapRule.end())
+    {
+        timer->ruleNext = it->second;
+        timer->ruleNext->rulePrev = timer;
+        it->second = timer;
+    }
+    else
+    {
+        timer->ruleNext = NULL;
+        m_mapRule[timer->rule] = timer;
+    }
+
+    m_numTimers++;
+}
+
+/**
+ * @brief RuleTimerThread::unlink removes timer from its slot and from the list of its rule. Must be called with m_mutex held
+ * @param timer
+ */
+void RuleTimerThread::unlink(Timer* timer)
+{
+    if(timer->slotPrev != NULL)
+    {
+        timer->slotPrev->slotNext = timer->slotNext;
+    }
+    else
+    {
+        m_wheel[timer->slot] = timer->slotNext;
+        if(timer->slotNext == NULL)
+            m_occupied[timer->slot / 64] &= ~(1ULL << (timer->slot % 64));
+    }
+
+    if(timer->slotNext != NULL)
+        timer->slotNext->slotPrev = timer->slotPrev;
+
+    if(timer->rulePrev != NULL)
+    {
+        timer->rulePrev->ruleNext = timer->ruleNext;
+    }
+    else
+    {
+        if(timer->ruleNext != NULL)
+            m_mapRule[timer->rule] = timer->ruleNext;
+        else
+            m_mapRule.erase(timer->rule);
+    }
+
+    if(timer->ruleNext != NULL)
+        timer->ruleNext->rulePrev = timer->rulePrev;
+
+    m_numTimers--;
 }
 
 /**
@@ -86,44 +233,106 @@ void RuleTimerThread::clear()
  */
 void RuleTimerThread::addRule(Rule* rule, unsigned int start, unsigned int waitMs)
 {
-    Element element;
-    element.rule = rule;
-    element.start = start;
+    Timer* timer = new Timer();
+    timer->rule = rule;
+    timer->condition = NULL;
+    timer->start = start;
+    timer->run = rule->getRun();
+
+    this->add(timer, waitMs);
+}
+
+/**
+ * @brief RuleTimerThread::addRecheck lets the executor evaluate condition again as soon as waitMs miliseconds have elapsed.
+ * It is used by conditions whose trigger has been suppressed by their minimum interval, see TriggerFilter::allowed.
+ * The recheck belongs to rule, so it is cancelled together with its sleeps.
+ * @param rule rule of condition
+ * @param condition
+ * @param waitMs
+ */
+void RuleTimerThread::addRecheck(Rule* rule, Condition* condition, unsigned int waitMs)
+{
+    Timer* timer = new Timer();
+    timer->rule = rule;
+    timer->condition = condition;
+    timer->start = 0;
+    timer->run = 0;
+
+    this->add(timer, waitMs);
+}
+
+void RuleTimerThread::add(Timer* timer, unsigned int waitMs)
+{
+    m_mutex.lock();
+
+    timer->added = this->now();
+    timer->expiry = timer->added + waitMs;
+    this->link(timer);
+
+    // only wake up the thread if the timerfd has to be armed earlier
+    bool wakeup = !m_bPaused && (m_armedTick == 0 || timer->expiry < m_armedTick);
+
+    m_mutex.unlock();
 
-    // set timer
-    clock_gettime(CLOCK_MONOTONIC, &element.time);
-    element.time = timspecAddMiliseconds(element.time, waitMs);
+    if(wakeup)
+        this->wakeup();
+}
+
+/**
+ * @brief RuleTimerThread::cancelRule deletes all pending sleeps and rechecks of the given rule
+ * @param rule
+ * @param sleepsOnly keep the rechecks of its conditions, used when only the actions of the rule are restarted
+ */
+void RuleTimerThread::cancelRule(Rule* rule, bool sleepsOnly)
+{
+    unsigned int count = 0;
 
-    // add element to queue
     m_mutex.lock();
-    m_queue.push(element);
+
+    std::map<Rule*, Timer*>::iterator it = m_mapRule.find(rule);
+    Timer* timer = it != m_mapRule.end() ? it->second : NULL;
+
+    while(timer != NULL)
+    {
+        Timer* next = timer->ruleNext;
+        if(!sleepsOnly || timer->condition == NULL)
+        {
+            this->unlink(timer);
+            delete timer;
+            count++;
+        }
+        timer = next;
+    }
+
     m_mutex.unlock();
 
-    // deliver signal to thread to wake it up
-    // funny to use kill to wake a thread :-D
-    pthread_kill(m_thread, SIGUSR1);
+    if(count != 0)
+        LOG_DEBUG(Logger::Script, "Cancelled %u pending sleeps of rule %s", count, rule->getName().c_str());
+
+    // the timerfd may now be armed too early, which is harmless
 }
 
 /**
  * @brief RuleTimerThread::continueTimer continues a timer which was paused by RuleTimerThread::pauseTimer before.
+ * The pending sleeps are shifted by the time the timer was paused.
  */
 void RuleTimerThread::continueTimer()
 {
+    m_mutex.lock();
+
     if(m_bPaused)
     {
-        timespec timeDiff;
-        clock_gettime(CLOCK_MONOTONIC, &timeDiff);
-        timeDiff = timespecSub(timeDiff, m_pausedTime);
-
-        for(PriorityQueue<Element>::iterator it = m_queue.begin(); it != m_queue.end(); it++)
-        {
-            // as an add does not modify the internal order of the heap, we do not have to rebuild the heap
-            (*it).time = timespecAdd((*it).time, timeDiff);
-        }
+        timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
 
-        this->start();
+        // the timer clock did not advance while we were paused
+        m_base = timespecAdd(m_base, timespecSub(currentTime, m_pausedTime));
         m_bPaused = false;
     }
+
+    m_mutex.unlock();
+
+    this->wakeup();
 }
 
 /**
@@ -131,83 +340,274 @@ void RuleTimerThread::continueTimer()
  */
 void RuleTimerThread::pauseTimer()
 {
+    m_mutex.lock();
+
     if(!m_bPaused)
     {
-        this->kill();
-
         m_bPaused = true;
         clock_gettime(CLOCK_MONOTONIC, &m_pausedTime);
     }
+
+    m_mutex.unlock();
+
+    this->wakeup();
 }
 
-void RuleTimerThread::run()
+bool RuleTimerThread::isPaused()
 {
-    timespec currentTime;
-    timespec waitTime;
-    while(true)
-    {
-        m_mutex.lock();
+    m_mutex.lock();
+    bool paused = m_bPaused;
+    m_mutex.unlock();
 
-        if(m_bStop)
+    return paused;
+}
+
+/**
+ * @brief RuleTimerThread::setVirtualClock switches between the real and the virtual timer clock.
+ * The virtual clock starts at the current time of the timer clock and switching back continues the real clock from the virtual time,
+ * so pending sleeps are kept in both directions.
+ * @param b
+ */
+void RuleTimerThread::setVirtualClock(bool b)
+{
+    m_mutex.lock();
+
+    if(b != m_bVirtual)
+    {
+        if(b)
         {
-            // we want to exit the while loop
-            m_mutex.unlock();
-            break;
+            m_virtualNow = this->now();
+            m_bVirtual = true;
         }
+        else
+        {
+            timespec currentTime;
+            if(m_bPaused)
+                currentTime = m_pausedTime;
+            else
+                clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+            // the real clock continues where the virtual clock stopped
+            timespec elapsed;
+            elapsed.tv_sec = m_virtualNow / 1000;
+            elapsed.tv_nsec = (m_virtualNow % 1000) * 1000000;
+            m_base = timespecSub(currentTime, elapsed);
+
+            m_bVirtual = false;
+        }
+    }
+
+    m_mutex.unlock();
+
+    this->wakeup();
+}
+
+/**
+ * @brief RuleTimerThread::advanceClock advances the virtual clock to ms and expires all sleeps which are due until then in order.
+ * After every step the executor is flushed, so that sleeps added by continued rules are expired too, if they are due before ms.
+ * This makes the execution independent of the real time, so a replay gives the same results at any speed.
+ * Must not be called by the executor thread.
+ * @param ms new time of the virtual clock, the clock never goes backwards
+ */
+void RuleTimerThread::advanceClock(unsigned long long ms)
+{
+    m_mutex.lock();
+
+    pi_assert(m_bVirtual);
 
-        // check if queue is empty, if yes then sleep
-        if( m_queue.empty() )
+    while(m_virtualNow < ms)
+    {
+        // jump to the next occupied slot, timers in there might belong to later rounds, then nothing expires and we continue
+        int distance = m_numTimers != 0 ? this->nextOccupied() : -1;
+
+        unsigned long long tick = ms;
+        if(distance >= 0 && m_tick + distance < ms)
+            tick = m_tick + distance;
+
+        if(tick < m_virtualNow)
+            tick = m_virtualNow;
+
+        m_virtualNow = tick;
+        unsigned int count = this->expire(tick);
+
+        if(count != 0)
         {
             m_mutex.unlock();
+            m_executor->flush();
+            m_mutex.lock();
+        }
+    }
 
-            // sleep for 100ms and wake up if we receive a signal
-            timespec sleep;
-            sleep.tv_sec = 0;
-            sleep.tv_nsec = 100000000;
+    m_mutex.unlock();
+}
 
-            if(nanosleep(&sleep, NULL)  == -1)
-            {
-                //LOG_WARN(Logger::Script, "Interrupted by signal");
-            }
-            continue;
+/**
+ * @brief RuleTimerThread::getClock returns the current time of the timer clock in miliseconds
+ * @return
+ */
+unsigned long long RuleTimerThread::getClock()
+{
+    m_mutex.lock();
+    unsigned long long ms = this->now();
+    m_mutex.unlock();
+
+    return ms;
+}
+
+/**
+ * @brief RuleTimerThread::nextOccupied searches the next slot which is not empty, beginning with the slot of m_tick.
+ * Must be called with m_mutex held
+ * @return distance of this slot to m_tick or -1 if the wheel is empty
+ */
+int RuleTimerThread::nextOccupied() const
+{
+    unsigned int first = m_tick & TIMER_WHEEL_MASK;
+
+    // we have to look at the first word twice, as we start in the middle of it
+    for(unsigned int i = 0; i <= TIMER_WHEEL_SIZE / 64; i++)
+    {
+        unsigned int word = (first / 64 + i) % (TIMER_WHEEL_SIZE / 64);
+        unsigned long long bits = m_occupied[word];
+
+        if(i == 0)
+            bits &= ~0ULL << (first % 64);
+
+        if(bits != 0)
+        {
+            unsigned int slot = word * 64 + __builtin_ctzll(bits);
+            return (slot - first) & TIMER_WHEEL_MASK;
         }
+    }
 
-        // get element from queue
-        Element element = m_queue.top();
+    return -1;
+}
 
-        m_mutex.unlock();
+/**
+ * @brief RuleTimerThread::expire hands all timers which are due back to the executor. Must be called with m_mutex held
+ * @param currentTick
+ * @return number of timers which have expired
+ */
+unsigned int RuleTimerThread::expire(unsigned long long currentTick)
+{
+    unsigned int count = 0;
 
+    if(currentTick < m_tick)
+        return count;
 
-        // get current time
-        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+    // every slot only has to be looked at once, even if we are late by more than one round
+    unsigned long long ticks = currentTick - m_tick + 1;
+    if(ticks > TIMER_WHEEL_SIZE)
+        ticks = TIMER_WHEEL_SIZE;
 
-        // if this is true we have to sleep first
-        if( timespecGreaterThan(element.time, currentTime) )
+    for(unsigned long long tick = m_tick; tick < m_tick + ticks; tick++)
+    {
+        Timer* timer = m_wheel[tick & TIMER_WHEEL_MASK];
+
+        while(timer != NULL)
         {
-            // calculate time difference for nanosleep
-            waitTime = timespecSub(element.time, currentTime);
+            Timer* next = timer->slotNext;
 
-            // check for signals during sleep
-            if( nanosleep(&waitTime, NULL) < 0)
+            // timers of later rounds stay in their slot
+            if(timer->expiry <= currentTick)
             {
-                // we have been interrupted by a signal, normally this happens to wake this thread
-                //LOG_WARN(Logger::Script, "Interrupted by signal");
-
-                // go back to start and check queue
-                continue;
+                this->unlink(timer);
+
+                // never fails, an event which does not fit into the queue of the executor goes to its overflow list
+                if(timer->condition != NULL)
+                {
+                    m_executor->post(RuleExecutor::Recheck, timer->condition);
+                }
+                else
+                {
+                    timer->rule->getProfile()->slept(currentTick - timer->added);
+                    m_executor->post(RuleExecutor::Continue, timer->rule, timer->start, timer->run);
+                }
+
+                delete timer;
+                count++;
             }
+
+            timer = next;
         }
+    }
+
+    m_tick = currentTick + 1;
+
+    return count;
+}
+
+/**
+ * @brief RuleTimerThread::arm arms the timerfd for the next occupied slot, or disarms it. Must be called with m_mutex held
+ */
+void RuleTimerThread::arm()
+{
+    itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    int distance = -1;
+    if(!m_bPaused && !m_bVirtual && m_numTimers != 0)
+        distance = this->nextOccupied();
 
-        // now we should do something as the timer has expired
-        element.rule->executeActions(element.start);
+    if(distance >= 0)
+    {
+        m_armedTick = m_tick + distance;
+        spec.it_value = m_base;
+        spec.it_value.tv_sec += m_armedTick / 1000;
+        spec.it_value = timspecAddMiliseconds(spec.it_value, m_armedTick % 1000);
+    }
+    else
+    {
+        m_armedTick = 0;
+    }
 
+    // a zero it_value disarms the timer
+    if(timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, NULL) != 0)
+        LOG_ERROR(Logger::Script, "timerfd_settime has failed");
+}
+
+void RuleTimerThread::run()
+{
+    pollfd fds[2];
+    fds[0].fd = m_timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_eventFd;
+    fds[1].events = POLLIN;
 
+    while(true)
+    {
         m_mutex.lock();
 
-        // now we have to remove the current element from the heap
-        m_queue.pop();
+        if(m_bStop)
+        {
+            // we want to exit the while loop
+            m_mutex.unlock();
+            break;
+        }
+
+        if(!m_bPaused && !m_bVirtual)
+            this->expire(this->now());
+
+        this->arm();
 
         m_mutex.unlock();
+
+        if(poll(fds, 2, -1) < 0)
+            continue; // interrupted by a signal
+
+        if(fds[0].revents & POLLIN)
+        {
+            uint64_t expirations;
+            if(read(m_timerFd, &expirations, sizeof(expirations)) < 0)
+            {
+                // nothing to do, the timer has been rearmed in the meantime
+            }
+        }
+
+        if(fds[1].revents & POLLIN)
+        {
+            eventfd_t value;
+            eventfd_read(m_eventFd, &value);
+        }
     }
 }
 
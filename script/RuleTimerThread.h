@@ -3,20 +3,29 @@
 
 #include <pthread.h>
 #include <mutex>
+#include <map>
 #include <util/Time.h>
-#include <util/PriorityQueue.h>
 
 class Rule;
+class Condition;
+class RuleExecutor;
+
+// the wheel has one slot per milisecond, timers further away wrap around and stay in their slot for more rounds
+#define TIMER_WHEEL_BITS 10
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
 
 /**
  * @brief The RuleTimerThread class is used to execute rules which contain a sleep action.
  * As threads should not be blocked by a sleep action, they add the rule conaining the sleep action to this thread,
- * which continues to execute them as soon as the time given by the sleep action has elapsed.
+ * which hands them back to the RuleExecutor as soon as the time given by the sleep action has elapsed.
+ * Pending sleeps are kept in a hashed timer wheel, so adding and cancelling them does not depend on the number of sleeps.
+ * The thread only wakes up when the timerfd expires for the next occupied slot.
+ * For replaying recorded events the timer clock can be switched to a virtual clock, which is only advanced by RuleTimerThread::advanceClock.
  */
 class RuleTimerThread
 {
 public:
-    RuleTimerThread();
+    RuleTimerThread(RuleExecutor* executor);
     ~RuleTimerThread();
 
     void start();
@@ -25,39 +34,75 @@ public:
     void clear();
 
     void addRule(Rule* rule, unsigned int start, unsigned int waitMs);
+    void addRecheck(Rule* rule, Condition* condition, unsigned int waitMs);
+    void cancelRule(Rule* rule, bool sleepsOnly = false);
 
     void pauseTimer();
     void continueTimer();
+    bool isPaused();
+
+    void setVirtualClock(bool b);
+    void advanceClock(unsigned long long ms);
+    unsigned long long getClock();
 
 private:
-    struct Element
+    struct Timer
     {
         Rule* rule;
+        Condition* condition; // NULL for a sleep, otherwise the condition of rule which has to be evaluated again
         unsigned int start;
-        timespec time;
-
-        bool operator< (const Element& rhs)
-        {
-            return timespecGreaterThan(this->time, rhs.time);
-        }
-
-        bool operator == (const Element& rhs)
-        {
-            // return true if rule objects match
-            // this is the case if lhs and rhs are actually the same polling object
-            return this->rule == rhs.rule;
-        }
+        unsigned int run; // the sleep is only continued if the rule has not been restarted in the meantime
+        unsigned long long expiry; // in miliseconds of the timer clock
+        unsigned long long added; // for the RuleProfile
+        unsigned int slot;
+
+        // all timers in the same slot
+        Timer* slotPrev;
+        Timer* slotNext;
+
+        // all timers of the same rule
+        Timer* rulePrev;
+        Timer* ruleNext;
     };
 
     static void* run_internal(void* arg);
     void run();
 
+    void wakeup();
+    void add(Timer* timer, unsigned int waitMs);
+
+    unsigned long long now() const;
+    void link(Timer* timer);
+    void unlink(Timer* timer);
+    unsigned int expire(unsigned long long currentTick);
+    void arm();
+    int nextOccupied() const;
+
+    RuleExecutor* m_executor;
+
     pthread_t m_thread;
     std::mutex m_mutex;
     bool m_bStop;
-    PriorityQueue<Element> m_queue;
+
+    int m_timerFd;
+    int m_eventFd; // wakes the thread up to rearm the timerfd or to stop
+
+    // all protected by m_mutex
+    Timer* m_wheel[TIMER_WHEEL_SIZE];
+    unsigned long long m_occupied[TIMER_WHEEL_SIZE / 64]; // one bit per slot which is not empty
+    std::map<Rule*, Timer*> m_mapRule; // first timer of every rule with pending sleeps
+    unsigned int m_numTimers;
+    unsigned long long m_tick; // next tick of the wheel which has to be processed
+    unsigned long long m_armedTick; // tick for which the timerfd is armed, 0 if disarmed
+
+    // the timer clock counts miliseconds since m_base and stands still while the timer is paused
+    timespec m_base;
     bool m_bPaused;
     timespec m_pausedTime;
+
+    // if m_bVirtual is set, the timer clock is m_virtualNow and the thread itself never expires timers
+    bool m_bVirtual;
+    unsigned long long m_virtualNow;
 };
 
 #endif // RULETIMEMANAGER_H
@@ -1,10 +1,19 @@
 
 #include "script/Script.h"
 #include "util/Debug.h"
+#include "script/ScriptCache.h"
 #include "ConfigManager.h"
+#include "script/RuleExecutor.h"
+#include "script/RuleTimerThread.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 #include <QDomDocument>
 #include <QFile>
+#include <QXmlStreamReader>
+#include <QDataStream>
+
+#include <algorithm>
 
 Script::Script()
 {
@@ -27,20 +36,31 @@ Script* Script::load(std::string name)
     filename.append(name);
     filename.append(".xml");
 
-    QFile file(filename.c_str());
-    if(!file.open(QIODevice::ReadOnly))
+    QByteArray data;
+
+    // use the compiled version of the script if it is up to date
+    Script* cached = ScriptCache::load(name, filename, &data);
+    if(cached != NULL)
+        return cached;
+
+    // the cache might have read the XML file already
+    if(data.isEmpty())
     {
-        LOG_ERROR(Logger::Script, "Could not open file %s", filename.c_str());
-        return NULL;
-    }
+        QFile file(filename.c_str());
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            LOG_ERROR(Logger::Script, "Could not open file %s", filename.c_str());
+            return NULL;
+        }
 
-    QDomDocument document;
-    document.setContent(&file);
+        data = file.readAll();
+        file.close();
+    }
 
-    QDomElement docElem = document.documentElement();
+    QXmlStreamReader reader(data);
 
     // check if this is a valid script file
-    if(docElem.tagName().toLower().compare("script") != 0)
+    if(!reader.readNextStartElement() || XmlTag::lookup(reader.name()) != XmlTag::Script)
     {
         LOG_ERROR(Logger::Script, "Invalid script file %s: tag \"script\" is missing", filename.c_str());
         return NULL;
@@ -50,39 +70,100 @@ Script* Script::load(std::string name)
 
     script->m_name = name;
 
-    QDomElement elem = docElem.firstChildElement();
+    XmlElement elem;
 
-    while(!elem.isNull())
+    while(reader.readNextStartElement())
     {
-        if(elem.tagName().toLower().compare("rule") == 0)
+        XmlTag::Id tag = XmlTag::lookup(reader.name());
+
+        if(tag == XmlTag::Rule)
         {
-            Rule* rule = Rule::load(&elem);
+            Rule* rule = Rule::load(&reader);
             if(rule != NULL)
             {
                 script->addRule(rule);
             }
         }
-        else if(elem.tagName().toLower().compare("variable") == 0)
+        else if(tag == XmlTag::Variable)
         {
+            elem.read(&reader);
+
             Variable* variable = Variable::load(&elem);
             if(variable != NULL)
             {
                 script->addVariable(variable);
             }
         }
-        else if(elem.tagName().toLower().compare("description") == 0)
+        else if(tag == XmlTag::Description)
+        {
+            script->m_desc = XmlElement::readText(&reader).toStdString();
+        }
+        else
         {
-            script->m_desc = elem.text().toStdString();
+            reader.skipCurrentElement();
         }
+    }
 
-        elem = elem.nextSiblingElement();
+    if(reader.hasError())
+    {
+        LOG_ERROR(Logger::Script, "Invalid script file %s: %s in line %lld", filename.c_str(),
+                  reader.errorString().toStdString().c_str(), reader.lineNumber());
+        delete script;
+        return NULL;
     }
 
-    file.close();
+    ScriptCache::save(script, filename, data);
+
+    return script;
+}
+
+/**
+ * @brief Script::loadBinary is the counterpart of Script::saveBinary, it is used by the ScriptCache
+ * @param in
+ * @param name
+ * @return
+ */
+Script* Script::loadBinary(QDataStream& in, std::string name)
+{
+    Script* script = new Script();
+    quint32 count = 0;
+
+    script->m_name = name;
+
+    in >> script->m_desc;
+
+    in >> count;
+    for(unsigned int i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        script->addRule( Rule::loadBinary(in) );
+    }
+
+    in >> count;
+    for(unsigned int i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        script->addVariable( Variable::loadBinary(in) );
+    }
 
     return script;
 }
 
+void Script::saveBinary(QDataStream& out)
+{
+    out << m_desc;
+
+    out << (quint32)m_listRules.size();
+    for(std::vector<Rule*>::iterator ruleIt = m_listRules.begin(); ruleIt != m_listRules.end(); ruleIt++)
+    {
+        (*ruleIt)->saveBinary(out);
+    }
+
+    out << (quint32)m_listVars.size();
+    for(std::list<Variable*>::iterator it = m_listVars.begin(); it != m_listVars.end(); it++)
+    {
+        (*it)->saveBinary(out);
+    }
+}
+
 bool Script::save()
 {
     std::string filename = "scripts/";
@@ -123,16 +204,24 @@ bool Script::save()
     script.appendChild(desc);
 
 
-    file.write(document.toByteArray(4));
+    QByteArray data = document.toByteArray(4);
+    file.write(data);
 
     file.close();
 
+    ScriptCache::save(this, filename, data);
+
     return true;
 }
 
-int RequiredInputCmp(const Rule::RequiredInput& lhs, const Rule::RequiredInput& rhs)
+bool RequiredInputCmp(const Rule::RequiredInput& lhs, const Rule::RequiredInput& rhs)
 {
-    return lhs.name.compare(rhs.name);
+    int cmp = lhs.name.compare(rhs.name);
+    if(cmp != 0)
+        return cmp < 0;
+
+    // EINVALID is the last type, so names used in expressions follow the typed inputs with the same name
+    return lhs.type < rhs.type;
 }
 
 bool RequiredInputEq(const Rule::RequiredInput& lhs, const Rule::RequiredInput& rhs)
@@ -140,9 +229,13 @@ bool RequiredInputEq(const Rule::RequiredInput& lhs, const Rule::RequiredInput&
     return lhs.name.compare(rhs.name) == 0 && lhs.type == rhs.type;
 }
 
-int RequiredOutputCmp(const Rule::RequiredOutput& lhs, const Rule::RequiredOutput& rhs)
+bool RequiredOutputCmp(const Rule::RequiredOutput& lhs, const Rule::RequiredOutput& rhs)
 {
-    return lhs.name.compare(rhs.name);
+    int cmp = lhs.name.compare(rhs.name);
+    if(cmp != 0)
+        return cmp < 0;
+
+    return lhs.type < rhs.type;
 }
 
 bool RequiredOutputEq(const Rule::RequiredOutput& lhs, const Rule::RequiredOutput& rhs)
@@ -150,9 +243,9 @@ bool RequiredOutputEq(const Rule::RequiredOutput& lhs, const Rule::RequiredOutpu
     return lhs.name.compare(rhs.name) == 0 && lhs.type == rhs.type;
 }
 
-int RequiredVariableCmp(const Rule::RequiredVariable& lhs, const Rule::RequiredVariable& rhs)
+bool RequiredVariableCmp(const Rule::RequiredVariable& lhs, const Rule::RequiredVariable& rhs)
 {
-    return lhs.name.compare(rhs.name);
+    return lhs.name.compare(rhs.name) < 0;
 }
 
 bool RequiredVariableEq(const Rule::RequiredVariable& lhs, const Rule::RequiredVariable& rhs)
@@ -163,6 +256,7 @@ bool RequiredVariableEq(const Rule::RequiredVariable& lhs, const Rule::RequiredV
 /**
  * @brief Script::getRequiredList This method fills the given lists with all inputs, outputs and variables which are required by this script.
  * This method also removes duplicates which are introduced as an input/output/variable can be used several times.
+ * Names used in expressions are resolved like Expression::init does it: to a variable of this script if there is one, otherwise to an input of any type.
  * For variables it checks, if they exist and sets the correspoding field to true.
  * @param listInput
  * @param listOutput
@@ -172,18 +266,56 @@ void Script::getRequiredList(std::list<Rule::RequiredInput>* listInput,
                              std::list<Rule::RequiredOutput>* listOutput,
                              std::list<Rule::RequiredVariable>* listVariable)
 {
+    // names used in expressions are reported as inputs, so we always need both lists to sort them out
+    std::list<Rule::RequiredInput> inputs;
+    std::list<Rule::RequiredVariable> variables;
+
     for(std::vector<Rule*>::iterator ruleIt = m_listRules.begin(); ruleIt != m_listRules.end(); ruleIt++)
     {
-        (*ruleIt)->getRequiredList(listInput, listOutput, listVariable);
+        (*ruleIt)->getRequiredList(&inputs, listOutput, &variables);
+    }
+
+    std::list<Rule::RequiredInput>::iterator inputIt = inputs.begin();
+    while(inputIt != inputs.end())
+    {
+        if((*inputIt).type == HWInput::EINVALID && this->getVariableByName((*inputIt).name) != NULL)
+        {
+            Rule::RequiredVariable req;
+            req.name = (*inputIt).name;
+            req.exists = false;
+
+            variables.push_back(req);
+            inputIt = inputs.erase(inputIt);
+        }
+        else
+        {
+            inputIt++;
+        }
     }
 
     // we have the lists, now we have to remove all duplicates in the list
-    if(listInput != NULL)
+    inputs.sort( RequiredInputCmp );
+    inputs.unique( RequiredInputEq );
+
+    // a name used in an expression is already covered by a typed input with the same name
+    std::list<Rule::RequiredInput>::iterator prevIt = inputs.end();
+    inputIt = inputs.begin();
+    while(inputIt != inputs.end())
     {
-        listInput->sort( RequiredInputCmp );
-        listInput->unique( RequiredInputEq );
+        if((*inputIt).type == HWInput::EINVALID && prevIt != inputs.end() && (*prevIt).name.compare((*inputIt).name) == 0)
+        {
+            inputIt = inputs.erase(inputIt);
+        }
+        else
+        {
+            prevIt = inputIt;
+            inputIt++;
+        }
     }
 
+    if(listInput != NULL)
+        listInput->splice(listInput->end(), inputs);
+
     if(listOutput != NULL)
     {
         listOutput->sort( RequiredOutputCmp );
@@ -192,21 +324,16 @@ void Script::getRequiredList(std::list<Rule::RequiredInput>* listInput,
 
     if(listVariable != NULL)
     {
-        listVariable->sort( RequiredVariableCmp );
-        listVariable->unique( RequiredVariableEq );
+        variables.sort( RequiredVariableCmp );
+        variables.unique( RequiredVariableEq );
 
         // Check if variables exist and set exist to true if they do
-        for(std::list<Rule::RequiredVariable>::iterator it = listVariable->begin(); it != listVariable->end(); it++)
+        for(std::list<Rule::RequiredVariable>::iterator it = variables.begin(); it != variables.end(); it++)
         {
-            for(std::list<Variable*>::iterator varIt = m_listVars.begin(); varIt != m_listVars.end(); varIt++)
-            {
-                if( (*it).name.compare( (*varIt)->getName() ) == 0 )
-                {
-                    it->exists = true;
-                    break;
-                }
-            }
+            it->exists = this->getVariableByName((*it).name) != NULL;
         }
+
+        listVariable->splice(listVariable->end(), variables);
     }
 }
 
@@ -220,6 +347,17 @@ void Script::addVariable(Variable *var)
     m_listVars.push_back(var);
 }
 
+Variable* Script::getVariableByName(const std::string& name) const
+{
+    for(std::list<Variable*>::const_iterator it = m_listVars.begin(); it != m_listVars.end(); it++)
+    {
+        if( name.compare( (*it)->getName() ) == 0 )
+            return *it;
+    }
+
+    return NULL;
+}
+
 /**
  * @brief Script::clearVariables This method deletes all variables in this script
  */
@@ -248,6 +386,13 @@ void Script::init(ConfigManager *config)
     // the conditions of the callable rule are already true
     std::sort(m_listRules.begin(), m_listRules.end(), cmpCallable);
 
+    // the names of the rules might have been changed since the last init
+    m_mapRules.clear();
+    for(std::vector<Rule*>::iterator ruleIt = m_listRules.begin(); ruleIt != m_listRules.end(); ruleIt++)
+    {
+        m_mapRules.insert(Symbol::intern((*ruleIt)->getName()), *ruleIt);
+    }
+
     // Actions and therefore Outputs have to be initialized before the conditions, because the inputs can fire as soon as they are initialized
     for(std::vector<Rule*>::iterator ruleIt = m_listRules.begin(); ruleIt != m_listRules.end(); ruleIt++)
     {
@@ -258,14 +403,324 @@ void Script::init(ConfigManager *config)
     {
         (*ruleIt)->initConditions(config);
     }
+
+    // the inputs and variables are only connected to the conditions now, after every condition is ready
+    m_dispatchTable.build(m_listRules, config->getRuleExecutor());
 }
 
 void Script::deinit()
 {
+    m_dispatchTable.clear();
+
     for(std::vector<Rule*>::iterator ruleIt = m_listRules.begin(); ruleIt != m_listRules.end(); ruleIt++)
     {
         (*ruleIt)->deinit();
     }
+
+    m_mapRules.clear();
+}
+
+/**
+ * @brief serializeRule returns the binary representation of rule, two rules are identical if their representations are equal
+ * @param rule
+ * @return
+ */
+static QByteArray serializeRule(Rule* rule)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+
+    rule->saveBinary(out);
+
+    return data;
+}
+
+/**
+ * @brief usesVariable checks if one of the variables required by rule resolves to one of the given variables in config.
+ * Names used in expressions are reported as inputs of type EINVALID, see Rule::RequiredInput, so they are checked as well.
+ * @param rule
+ * @param config
+ * @param listVars
+ * @return
+ */
+static bool usesVariable(Rule* rule, ConfigManager* config, const std::list<Variable*>& listVars)
+{
+    std::list<Rule::RequiredInput> listInput;
+    std::list<Rule::RequiredVariable> listRequired;
+    rule->getRequiredList(&listInput, NULL, &listRequired);
+
+    for(std::list<Rule::RequiredInput>::iterator it = listInput.begin(); it != listInput.end(); it++)
+    {
+        if(it->type != HWInput::EINVALID)
+            continue;
+
+        Rule::RequiredVariable req;
+        req.name = it->name;
+        req.exists = false;
+
+        listRequired.push_back(req);
+    }
+
+    for(std::list<Rule::RequiredVariable>::iterator it = listRequired.begin(); it != listRequired.end(); it++)
+    {
+        Variable* var = config->getVariableByName(it->name);
+        if(var != NULL && std::find(listVars.begin(), listVars.end(), var) != listVars.end())
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief hasDuplicateRuleNames checks if two rules have the same name, Script::update matches rules by name and cannot handle this
+ * @param listRules
+ * @return
+ */
+static bool hasDuplicateRuleNames(const std::vector<Rule*>& listRules)
+{
+    std::set<Symbol::Id> names;
+
+    for(std::vector<Rule*>::const_iterator it = listRules.begin(); it != listRules.end(); it++)
+    {
+        if(!names.insert(Symbol::intern((*it)->getName())).second)
+        {
+            LOG_WARN(Logger::Script, "There is more than one rule with the name %s", (*it)->getName().c_str());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Script::update replaces the rules and variables of this script by the ones of script, which is deleted afterwards.
+ * This script must be the active script of config. Rules which did not change are kept as they are,
+ * only rules which have been added, removed or changed are deinitialized and initialized,
+ * as well as rules which use an added or removed variable or call an added or removed rule.
+ * Variables which exist in both scripts keep their current value, only the default value is updated.
+ * The executor is suspended while the rules are exchanged, inputs arriving in the meantime are processed afterwards.
+ * Rules are matched by name, so if a name is used by more than one rule in either version nothing is changed.
+ * @param script the edited version of this script, it is deleted if the update succeeds
+ * @param config
+ * @return false if the script cannot be updated, the caller has to restart it then, see ConfigManager::updateActiveScript
+ */
+bool Script::update(Script* script, ConfigManager* config)
+{
+    pi_assert(config->getActiveScript() == this);
+
+    if(hasDuplicateRuleNames(m_listRules) || hasDuplicateRuleNames(script->m_listRules))
+        return false;
+
+    bool initialized = config->getActiveScriptState() == ConfigManager::Active;
+
+    // names of variables and rules which are added or removed, rules which depend on them have to be initialized again
+    std::set<Symbol::Id> changedNames;
+
+    // variables
+    SymbolMap<Variable> mapOldVars;
+    for(std::list<Variable*>::iterator it = m_listVars.begin(); it != m_listVars.end(); it++)
+    {
+        mapOldVars.insert(Symbol::intern((*it)->getName()), *it);
+    }
+
+    std::list<Variable*> listVars;
+    std::list<Variable*> listAddedVars;
+    for(std::list<Variable*>::iterator it = script->m_listVars.begin(); it != script->m_listVars.end(); it++)
+    {
+        Symbol::Id id = Symbol::intern((*it)->getName());
+        Variable* old = mapOldVars.get(id);
+
+        if(old != NULL)
+        {
+            old->setDefaultValue((*it)->getDefaultValue());
+            listVars.push_back(old);
+            mapOldVars.remove(id, old);
+            delete (*it);
+        }
+        else
+        {
+            (*it)->setToDefault();
+            listVars.push_back(*it);
+            listAddedVars.push_back(*it);
+            changedNames.insert(id);
+        }
+    }
+    script->m_listVars.clear();
+
+    // every variable which is still in mapOldVars does no longer exist
+    std::list<Variable*> listRemovedVars;
+    for(std::list<Variable*>::iterator it = m_listVars.begin(); it != m_listVars.end(); it++)
+    {
+        Symbol::Id id = Symbol::intern((*it)->getName());
+        if(mapOldVars.get(id) == (*it))
+        {
+            listRemovedVars.push_back(*it);
+            changedNames.insert(id);
+        }
+    }
+
+    // rules
+    SymbolMap<Rule> mapOldRules;
+    for(std::vector<Rule*>::iterator it = m_listRules.begin(); it != m_listRules.end(); it++)
+    {
+        mapOldRules.insert(Symbol::intern((*it)->getName()), *it);
+    }
+
+    std::vector<Rule*> listRules;
+    std::vector<Rule*> listAddedRules;
+    std::vector<Rule*> listKeptRules;
+    for(std::vector<Rule*>::iterator it = script->m_listRules.begin(); it != script->m_listRules.end(); it++)
+    {
+        Symbol::Id id = Symbol::intern((*it)->getName());
+        Rule* old = mapOldRules.get(id);
+
+        if(old != NULL && serializeRule(old) == serializeRule(*it))
+        {
+            listRules.push_back(old);
+            listKeptRules.push_back(old);
+            mapOldRules.remove(id, old);
+            delete (*it);
+        }
+        else
+        {
+            listRules.push_back(*it);
+            listAddedRules.push_back(*it);
+            changedNames.insert(id);
+        }
+    }
+    script->m_listRules.clear();
+
+    std::vector<Rule*> listRemovedRules;
+    for(std::vector<Rule*>::iterator it = m_listRules.begin(); it != m_listRules.end(); it++)
+    {
+        Symbol::Id id = Symbol::intern((*it)->getName());
+        if(mapOldRules.get(id) == (*it))
+        {
+            listRemovedRules.push_back(*it);
+            changedNames.insert(id);
+        }
+    }
+
+    // kept rules are initialized again if they use something which has been replaced, the rule itself stays the same object
+    std::vector<Rule*> listReinitRules;
+    for(std::vector<Rule*>::iterator it = listKeptRules.begin(); it != listKeptRules.end(); it++)
+    {
+        if((*it)->dependsOn(changedNames))
+            listReinitRules.push_back(*it);
+    }
+
+    m_desc = script->m_desc;
+    delete script;
+
+    LOG_DEBUG(Logger::Script, "Updating script %s: %u rules added, %u removed, %u reinitialized, %u kept",
+              m_name.c_str(), (unsigned int)listAddedRules.size(), (unsigned int)listRemovedRules.size(),
+              (unsigned int)listReinitRules.size(), (unsigned int)(listKeptRules.size() - listReinitRules.size()));
+
+    // see Script::init
+    std::sort(listRules.begin(), listRules.end(), cmpCallable);
+    std::sort(listAddedRules.begin(), listAddedRules.end(), cmpCallable);
+
+    // new variables have to exist before new rules are initialized
+    for(std::list<Variable*>::iterator it = listAddedVars.begin(); it != listAddedVars.end(); it++)
+    {
+        config->addVariable(*it);
+    }
+
+    // removed variables must be gone from the config before any rule is initialized again, otherwise it would resolve them.
+    // They are only deleted after the executor has been flushed, as removed rules and queued events might still use them.
+    // ConfigManager::removeVariable flushes the executor itself, so this cannot be done while it is suspended
+    for(std::list<Variable*>::iterator it = listRemovedVars.begin(); it != listRemovedVars.end(); it++)
+    {
+        config->removeVariable(*it);
+    }
+
+    RuleExecutor* executor = config->getRuleExecutor();
+    RuleTimerThread* timer = config->getRuleTimerThread();
+
+    // no sleep may expire for a rule which is about to be removed, a paused script has stopped the timer already
+    if(initialized)
+        timer->pauseTimer();
+
+    if(initialized)
+    {
+        // new rules are not known to the executor yet, so they can be initialized while it is still running
+        m_mapRules.clear();
+        for(std::vector<Rule*>::iterator it = listRules.begin(); it != listRules.end(); it++)
+        {
+            m_mapRules.insert(Symbol::intern((*it)->getName()), *it);
+        }
+
+        for(std::vector<Rule*>::iterator it = listAddedRules.begin(); it != listAddedRules.end(); it++)
+        {
+            (*it)->initActions(config);
+        }
+
+        for(std::vector<Rule*>::iterator it = listAddedRules.begin(); it != listAddedRules.end(); it++)
+        {
+            (*it)->initConditions(config);
+        }
+
+        executor->suspend();
+
+        std::vector<Rule*> listRemove = listRemovedRules;
+        listRemove.insert(listRemove.end(), listReinitRules.begin(), listReinitRules.end());
+
+        m_dispatchTable.removeRules(listRemove);
+
+        for(std::vector<Rule*>::iterator it = listRemove.begin(); it != listRemove.end(); it++)
+        {
+            (*it)->deinit();
+        }
+
+        for(std::vector<Rule*>::iterator it = listReinitRules.begin(); it != listReinitRules.end(); it++)
+        {
+            (*it)->initActions(config);
+            (*it)->initConditions(config);
+
+            if(usesVariable(*it, config, listRemovedVars))
+                LOG_ERROR(Logger::Script, "Rule %s resolved a variable which is being removed", (*it)->getName().c_str());
+        }
+
+        std::vector<Rule*> listAdd = listAddedRules;
+        listAdd.insert(listAdd.end(), listReinitRules.begin(), listReinitRules.end());
+        std::sort(listAdd.begin(), listAdd.end(), cmpCallable);
+
+        m_dispatchTable.addRules(listAdd);
+
+        m_listRules = listRules;
+
+        executor->resume();
+    }
+    else
+    {
+        m_listRules = listRules;
+    }
+
+    for(std::vector<Rule*>::iterator it = listRemovedRules.begin(); it != listRemovedRules.end(); it++)
+    {
+        timer->cancelRule(*it);
+    }
+
+    if(initialized)
+        timer->continueTimer();
+
+    // wait until no event references a removed rule or dispatch entry anymore
+    executor->flush();
+    m_dispatchTable.release();
+
+    for(std::vector<Rule*>::iterator it = listRemovedRules.begin(); it != listRemovedRules.end(); it++)
+    {
+        delete (*it);
+    }
+
+    for(std::list<Variable*>::iterator it = listRemovedVars.begin(); it != listRemovedVars.end(); it++)
+    {
+        delete (*it);
+    }
+
+    m_listVars = listVars;
+
+    return true;
 }
 
 void Script::setConfig(ConfigManager *config)
@@ -306,7 +761,13 @@ std::vector<Rule*> Script::getRuleList() const
     return m_listRules;
 }
 
-Rule* Script::getRuleByName(std::string name) const
+/**
+ * @brief Script::getRuleByName returns the rule with this name, used while the script is edited.
+ * An initialized script resolves its rules with Script::getRule instead.
+ * @param name
+ * @return NULL if there is no such rule
+ */
+Rule* Script::getRuleByName(const std::string& name) const
 {
     const char* cstr = name.c_str();
     for(unsigned int i = 0; i < m_listRules.size(); i++)
@@ -3,9 +3,12 @@
 
 #include "script/Rule.h"
 #include "script/Variable.h"
+#include "script/DispatchTable.h"
+#include "util/Symbol.h"
 
 #include <vector>
 
+class QDataStream;
 class HWInput;
 class HWOutput;
 class ConfigManager;
@@ -23,6 +26,9 @@ public:
     static Script* load(std::string name);
     bool save();
 
+    static Script* loadBinary(QDataStream& in, std::string name);
+    void saveBinary(QDataStream& out);
+
     void getRequiredList(std::list<Rule::RequiredInput>* listInput,
                          std::list<Rule::RequiredOutput>* listOutput,
                          std::list<Rule::RequiredVariable>* listVariable);
@@ -39,18 +45,24 @@ public:
     void setConfig(ConfigManager* config); // used for Input and Output List
     std::list<HWInput*> getInputList() const;
     std::list<Variable*> getVariableList() const;
+    Variable* getVariableByName(const std::string& name) const;
     std::list<HWOutput*> getOutputList() const;
 
     std::vector<Rule*> getRuleList() const;
-    Rule* getRuleByName(std::string name) const;
+    Rule* getRuleByName(const std::string& name) const;
+    Rule* getRule(Symbol::Id id) const { return m_mapRules.get(id);}
 
     void init(ConfigManager* config);
     void deinit();
+    bool update(Script* script, ConfigManager* config);
 
 private:
     std::vector<Rule*> m_listRules;
+    SymbolMap<Rule> m_mapRules; // only filled while the script is initialized
     std::list<Variable*> m_listVars;
 
+    DispatchTable m_dispatchTable;
+
     std::string m_name;
     std::string m_desc;
 
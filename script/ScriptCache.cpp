@@ -0,0 +1,284 @@
+
+#include "script/ScriptCache.h"
+#include "script/Script.h"
+#include "script/ScriptLibrary.h"
+#include "util/Debug.h"
+#include "util/DataStream.h"
+
+#include <QFile>
+#include <QDataStream>
+
+#include <sys/stat.h>
+#include <stdio.h>
+
+#define SCRIPT_CACHE_MAGIC 0x52535043 // "RSPC"
+// has to be increased every time the binary format of any class changes, old caches are ignored then
+#define SCRIPT_CACHE_VERSION 4
+#define SCRIPT_CACHE_STREAM_VERSION QDataStream::Qt_4_6
+
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+/**
+ * @brief The CacheHeader struct is stored at the beginning of every cache file and identifies the XML file it has been built from
+ */
+struct CacheHeader
+{
+    quint32 magic;
+    quint32 version;
+    qint64 mtime; // nanoseconds since epoch
+    qint64 size;
+    quint32 hash;
+};
+
+static QDataStream& operator<<(QDataStream& out, const CacheHeader& header)
+{
+    out << header.magic << header.version << header.mtime << header.size << header.hash;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream& in, CacheHeader& header)
+{
+    in >> header.magic >> header.version >> header.mtime >> header.size >> header.hash;
+    return in;
+}
+
+/**
+ * @brief readInfo reads the ScriptInfo which follows the header, name, mtime and hash are not part of it
+ * @param in
+ * @param info
+ */
+static void readInfo(QDataStream& in, ScriptInfo* info)
+{
+    quint32 numInputs = 0;
+    quint32 numOutputs = 0;
+    quint32 numVariables = 0;
+
+    in >> info->description >> numInputs >> numOutputs >> numVariables;
+
+    info->numInputs = numInputs;
+    info->numOutputs = numOutputs;
+    info->numVariables = numVariables;
+}
+
+static void writeInfo(QDataStream& out, const ScriptInfo& info)
+{
+    out << info.description << (quint32)info.numInputs << (quint32)info.numOutputs << (quint32)info.numVariables;
+}
+
+/**
+ * @brief statFile reads modification time and size of a file
+ * @param filename
+ * @param header mtime and size are filled in
+ * @return false if the file does not exist
+ */
+static bool statFile(const std::string& filename, CacheHeader* header)
+{
+    struct stat st;
+    if(stat(filename.c_str(), &st) != 0)
+        return false;
+
+    header->mtime = (qint64)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    header->size = st.st_size;
+
+    return true;
+}
+
+std::string ScriptCache::cacheFilename(const std::string& xmlFilename)
+{
+    return xmlFilename + ".cache";
+}
+
+/**
+ * @brief ScriptCache::hash calculates the 32 bit FNV-1a hash of data
+ * @param data
+ * @return
+ */
+unsigned int ScriptCache::hash(const QByteArray& data)
+{
+    unsigned int h = FNV_OFFSET_BASIS;
+    const unsigned char* ptr = (const unsigned char*)data.constData();
+
+    for(int i = 0; i < data.size(); i++)
+    {
+        h ^= ptr[i];
+        h *= FNV_PRIME;
+    }
+
+    return h;
+}
+
+/**
+ * @brief ScriptCache::load loads the script from its cache file, if the cache belongs to the current XML file.
+ * If modification time or size of the XML file do not match, the XML file has to be read to compare its hash.
+ * In this case the XML data is returned in xmlData, so that the caller does not have to read it again.
+ * If the hash matches, the cache is rewritten with the new modification time.
+ * @param name name of the script
+ * @param xmlFilename
+ * @param xmlData filled with the content of the XML file if it had to be read
+ * @return the script or NULL if the cache is missing, stale or broken
+ */
+Script* ScriptCache::load(std::string name, const std::string& xmlFilename, QByteArray* xmlData)
+{
+    CacheHeader source;
+    if(!statFile(xmlFilename, &source))
+        return NULL;
+
+    std::string filename = ScriptCache::cacheFilename(xmlFilename);
+
+    QFile file(filename.c_str());
+    if(!file.open(QIODevice::ReadOnly))
+        return NULL;
+
+    qint64 fileSize = file.size();
+    uchar* map = file.map(0, fileSize);
+    if(map == NULL)
+        return NULL;
+
+    // the data is not copied, the stream reads directly from the mapped file
+    QByteArray data = QByteArray::fromRawData((const char*)map, fileSize);
+    QDataStream in(data);
+    in.setVersion(SCRIPT_CACHE_STREAM_VERSION);
+
+    CacheHeader header;
+    in >> header;
+
+    if(in.status() != QDataStream::Ok || header.magic != SCRIPT_CACHE_MAGIC || header.version != SCRIPT_CACHE_VERSION)
+    {
+        LOG_DEBUG(Logger::Script, "Ignoring cache %s: invalid header or old version", filename.c_str());
+        return NULL;
+    }
+
+    bool rewrite = false;
+    if(header.mtime != source.mtime || header.size != source.size)
+    {
+        // the file might have been touched without changing it, so we compare the content
+        QFile xmlFile(xmlFilename.c_str());
+        if(!xmlFile.open(QIODevice::ReadOnly))
+            return NULL;
+
+        *xmlData = xmlFile.readAll();
+        xmlFile.close();
+
+        if(xmlData->size() != header.size || ScriptCache::hash(*xmlData) != header.hash)
+            return NULL;
+
+        rewrite = true;
+    }
+
+    // skip the info, everything in it is part of the script too
+    ScriptInfo info;
+    readInfo(in, &info);
+
+    Script* script = Script::loadBinary(in, name);
+
+    if(in.status() != QDataStream::Ok || !in.atEnd())
+    {
+        LOG_WARN(Logger::Script, "Cache %s is corrupted, falling back to XML", filename.c_str());
+        delete script;
+        return NULL;
+    }
+
+    file.unmap(map);
+    file.close();
+
+    if(rewrite)
+        ScriptCache::save(script, xmlFilename, *xmlData);
+
+    return script;
+}
+
+/**
+ * @brief ScriptCache::save writes the cache for script, xmlData has to be the current content of the XML file
+ * @param script
+ * @param xmlFilename
+ * @param xmlData
+ * @return
+ */
+bool ScriptCache::save(Script* script, const std::string& xmlFilename, const QByteArray& xmlData)
+{
+    CacheHeader header;
+    if(!statFile(xmlFilename, &header))
+        return false;
+
+    // the XML file has been changed since it has been read, the cache would be stale
+    if(header.size != xmlData.size())
+        return false;
+
+    header.magic = SCRIPT_CACHE_MAGIC;
+    header.version = SCRIPT_CACHE_VERSION;
+    header.hash = ScriptCache::hash(xmlData);
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(SCRIPT_CACHE_STREAM_VERSION);
+
+    out << header;
+    writeInfo(out, ScriptLibrary::describe(script));
+    script->saveBinary(out);
+
+    std::string filename = ScriptCache::cacheFilename(xmlFilename);
+    std::string tmpFilename = filename + ".tmp";
+
+    QFile file(tmpFilename.c_str());
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        LOG_DEBUG(Logger::Script, "Could not write cache %s", tmpFilename.c_str());
+        return false;
+    }
+
+    bool success = file.write(data) == data.size() && file.flush();
+    file.close();
+
+    // rename replaces the old cache atomically, so readers either see the old or the new cache
+    if(!success || rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+        LOG_WARN(Logger::Script, "Could not write cache %s", filename.c_str());
+        QFile::remove(tmpFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief ScriptCache::loadInfo reads only the header and the ScriptInfo of the cache of the given XML file.
+ * Unlike ScriptCache::load the content of the XML file is never compared, if the modification time or the size do not match, the cache is not used.
+ * @param xmlFilename
+ * @param info description, summary, mtime and hash are filled in
+ * @return false if there is no up to date cache
+ */
+bool ScriptCache::loadInfo(const std::string& xmlFilename, ScriptInfo* info)
+{
+    CacheHeader source;
+    if(!statFile(xmlFilename, &source))
+        return false;
+
+    std::string filename = ScriptCache::cacheFilename(xmlFilename);
+
+    QFile file(filename.c_str());
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(SCRIPT_CACHE_STREAM_VERSION);
+
+    CacheHeader header;
+    in >> header;
+
+    if(in.status() != QDataStream::Ok || header.magic != SCRIPT_CACHE_MAGIC || header.version != SCRIPT_CACHE_VERSION
+            || header.mtime != source.mtime || header.size != source.size)
+    {
+        return false;
+    }
+
+    readInfo(in, info);
+
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    info->mtime = header.mtime;
+    info->hash = header.hash;
+
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include <QByteArray>
+#include <string>
+
+class Script;
+struct ScriptInfo;
+
+/**
+ * @brief The ScriptCache class stores a compiled binary version of a script next to its XML file (scripts/<name>.xml.cache).
+ * The cache is keyed by the modification time, the size and a hash of the XML file and is only used if it matches the XML file,
+ * otherwise the XML file is parsed and the cache is written again.
+ * Right after the header a ScriptInfo is stored, so that the ScriptLibrary can be built without loading the scripts.
+ * Cache files are mapped into memory for reading and replaced atomically when writing, so a crash never leaves a half written cache behind.
+ */
+class ScriptCache
+{
+public:
+    static Script* load(std::string name, const std::string& xmlFilename, QByteArray* xmlData);
+    static bool save(Script* script, const std::string& xmlFilename, const QByteArray& xmlData);
+
+    static bool loadInfo(const std::string& xmlFilename, ScriptInfo* info);
+
+    static std::string cacheFilename(const std::string& xmlFilename);
+    static unsigned int hash(const QByteArray& data);
+};
+
+#endif // SCRIPTCACHE_H
@@ -0,0 +1,246 @@
+
+#include "script/ScriptLibrary.h"
+#include "script/ScriptCache.h"
+#include "script/Script.h"
+#include "util/Debug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+
+#define SCRIPT_LIBRARY_DIR "scripts/"
+// number of scripts which are kept in memory
+#define SCRIPT_LIBRARY_LRU_SIZE 8
+
+static std::string xmlFilename(const std::string& name)
+{
+    std::string filename = SCRIPT_LIBRARY_DIR;
+    filename.append(name);
+    filename.append(".xml");
+
+    return filename;
+}
+
+ScriptLibrary::ScriptLibrary()
+{
+}
+
+ScriptLibrary::~ScriptLibrary()
+{
+    for(std::vector<Entry*>::iterator it = m_entries.begin(); it != m_entries.end(); it++)
+    {
+        delete (*it)->script;
+        delete (*it);
+    }
+}
+
+/**
+ * @brief ScriptLibrary::scan reads the info of every script in the scripts directory.
+ * Only scripts without an up to date cache are loaded, this also writes their cache, so that they do not have to be loaded next time.
+ */
+void ScriptLibrary::scan()
+{
+    QDir directory = QDir(SCRIPT_LIBRARY_DIR);
+    QStringList files = directory.entryList(QStringList("*.xml"));
+
+    for(QStringList::iterator it = files.begin(); it != files.end(); it++)
+    {
+        QString name = (*it);
+
+        // remove ".xml" ending
+        name.chop(4);
+
+        Entry* entry = new Entry();
+        entry->script = NULL;
+
+        if(!ScriptCache::loadInfo(xmlFilename(name.toStdString()), &entry->info))
+        {
+            entry->script = Script::load( name.toStdString() );
+
+            // if script is NULL, then the script could not be loaded. This means its either invalid or could not be opened
+            if(entry->script == NULL)
+            {
+                delete entry;
+                continue;
+            }
+
+            if(!ScriptCache::loadInfo(xmlFilename(name.toStdString()), &entry->info))
+                entry->info = ScriptLibrary::describe(entry->script);
+        }
+
+        entry->info.name = name.toStdString();
+
+        m_entries.push_back(entry);
+
+        if(entry->script != NULL)
+            this->touch(entry, NULL);
+    }
+}
+
+const ScriptInfo& ScriptLibrary::getInfo(unsigned int index) const
+{
+    return m_entries.at(index)->info;
+}
+
+/**
+ * @brief ScriptLibrary::getScript returns the script at index and loads it if necessary.
+ * Loading a script might unload the least recently used script, so pointers returned earlier may become invalid.
+ * @param index
+ * @param keep this script is never unloaded, e.g. the active script
+ * @return the script or NULL if it could not be loaded
+ */
+Script* ScriptLibrary::getScript(unsigned int index, const Script* keep)
+{
+    Entry* entry = m_entries.at(index);
+
+    if(entry->script == NULL)
+    {
+        entry->script = Script::load(entry->info.name);
+
+        if(entry->script == NULL)
+        {
+            LOG_WARN(Logger::Script, "Could not load script %s", entry->info.name.c_str());
+            return NULL;
+        }
+
+        // the file might have been changed since we have read the info
+        if(!ScriptCache::loadInfo(xmlFilename(entry->info.name), &entry->info))
+            entry->info = ScriptLibrary::describe(entry->script);
+    }
+
+    this->touch(entry, keep);
+
+    return entry->script;
+}
+
+/**
+ * @brief ScriptLibrary::getLoadedScript returns the script at index only if it is in memory
+ * @param index
+ * @return
+ */
+Script* ScriptLibrary::getLoadedScript(unsigned int index) const
+{
+    return m_entries.at(index)->script;
+}
+
+/**
+ * @brief ScriptLibrary::add adds a new script, it must already have been saved
+ * @param script
+ * @param keep this script is never unloaded, e.g. the active script
+ */
+void ScriptLibrary::add(Script* script, const Script* keep)
+{
+    Entry* entry = new Entry();
+    entry->script = script;
+
+    if(!ScriptCache::loadInfo(xmlFilename(script->getName()), &entry->info))
+        entry->info = ScriptLibrary::describe(script);
+
+    entry->info.name = script->getName();
+
+    m_entries.push_back(entry);
+
+    this->touch(entry, keep);
+}
+
+/**
+ * @brief ScriptLibrary::remove deletes the script at index, including its files
+ * @param index
+ */
+void ScriptLibrary::remove(unsigned int index)
+{
+    Entry* entry = m_entries.at(index);
+
+    std::string filename = xmlFilename(entry->info.name);
+
+    // delete the actual file
+    QFile::remove(filename.c_str());
+    QFile::remove(ScriptCache::cacheFilename(filename).c_str());
+
+    m_listLRU.remove(entry);
+    m_entries.erase(m_entries.begin() + index);
+
+    delete entry->script;
+    delete entry;
+}
+
+/**
+ * @brief ScriptLibrary::replace sets the script at index to script, the old one is deleted if it is not the same.
+ * This is used after a script has been edited.
+ * @param index
+ * @param script may be NULL, the script is loaded again when needed then
+ * @param keep this script is never unloaded, e.g. the active script
+ */
+void ScriptLibrary::replace(unsigned int index, Script* script, const Script* keep)
+{
+    Entry* entry = m_entries.at(index);
+
+    if(entry->script != script)
+        delete entry->script;
+
+    m_listLRU.remove(entry);
+    entry->script = script;
+
+    if(script == NULL)
+        return;
+
+    if(!ScriptCache::loadInfo(xmlFilename(script->getName()), &entry->info))
+        entry->info = ScriptLibrary::describe(script);
+
+    entry->info.name = script->getName();
+
+    this->touch(entry, keep);
+}
+
+/**
+ * @brief ScriptLibrary::describe creates the info of script, mtime and hash are not known and set to 0
+ * @param script
+ * @return
+ */
+ScriptInfo ScriptLibrary::describe(Script* script)
+{
+    std::list<Rule::RequiredInput> listInput;
+    std::list<Rule::RequiredOutput> listOutput;
+    std::list<Rule::RequiredVariable> listVariable;
+
+    script->getRequiredList(&listInput, &listOutput, &listVariable);
+
+    ScriptInfo info;
+    info.name = script->getName();
+    info.description = script->getDescription();
+    info.numInputs = listInput.size();
+    info.numOutputs = listOutput.size();
+    info.numVariables = listVariable.size();
+    info.mtime = 0;
+    info.hash = 0;
+
+    return info;
+}
+
+/**
+ * @brief ScriptLibrary::touch marks entry as most recently used and unloads the least recently used scripts,
+ * if there are more than SCRIPT_LIBRARY_LRU_SIZE scripts in memory
+ * @param entry
+ * @param keep this script is never unloaded
+ */
+void ScriptLibrary::touch(Entry* entry, const Script* keep)
+{
+    m_listLRU.remove(entry);
+    m_listLRU.push_front(entry);
+
+    std::list<Entry*>::iterator it = m_listLRU.end();
+    while(m_listLRU.size() > SCRIPT_LIBRARY_LRU_SIZE && it != m_listLRU.begin())
+    {
+        it--;
+
+        if((*it) == entry || (*it)->script == keep)
+            continue;
+
+        LOG_DEBUG(Logger::Script, "Unloading script %s", (*it)->info.name.c_str());
+
+        delete (*it)->script;
+        (*it)->script = NULL;
+
+        it = m_listLRU.erase(it);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef SCRIPTLIBRARY_H
+#define SCRIPTLIBRARY_H
+
+#include <string>
+#include <vector>
+#include <list>
+
+class Script;
+
+/**
+ * @brief The ScriptInfo struct is everything the script library knows about a script which is not loaded
+ */
+struct ScriptInfo
+{
+    std::string name;
+    std::string description;
+
+    // summary of the required inputs, outputs and variables
+    unsigned int numInputs;
+    unsigned int numOutputs;
+    unsigned int numVariables;
+
+    // identify the XML file the information has been read from
+    long long mtime;
+    unsigned int hash;
+};
+
+/**
+ * @brief The ScriptLibrary class is an index of all scripts in the scripts directory.
+ * At startup only the ScriptInfo of every script is read from its ScriptCache, the script itself is loaded when it is requested.
+ * Only the most recently used scripts are kept in memory, so memory usage depends on the scripts which are used and not on all scripts on disk.
+ */
+class ScriptLibrary
+{
+public:
+    ScriptLibrary();
+    ~ScriptLibrary();
+
+    void scan();
+
+    unsigned int size() const { return m_entries.size();}
+    const ScriptInfo& getInfo(unsigned int index) const;
+
+    Script* getScript(unsigned int index, const Script* keep = NULL);
+    Script* getLoadedScript(unsigned int index) const;
+
+    void add(Script* script, const Script* keep = NULL);
+    void remove(unsigned int index);
+    void replace(unsigned int index, Script* script, const Script* keep = NULL);
+
+    static ScriptInfo describe(Script* script);
+
+private:
+    struct Entry
+    {
+        ScriptInfo info;
+        Script* script; // NULL if not loaded
+    };
+
+    void touch(Entry* entry, const Script* keep);
+
+    std::vector<Entry*> m_entries;
+
+    // loaded scripts, most recently used first
+    std::list<Entry*> m_listLRU;
+};
+
+#endif // SCRIPTLIBRARY_H
@@ -0,0 +1,249 @@
+
+#include "script/TriggerFilter.h"
+#include "script/RuleTimerThread.h"
+#include "script/Condition.h"
+#include "ConfigManager.h"
+#include "util/DataStream.h"
+
+#include <QDomDocument>
+
+TriggerFilter::TriggerFilter()
+{
+    m_hysteresis = 0;
+    m_minIntervalMs = 0;
+    m_timerThread = NULL;
+
+    m_hasPrevious = false;
+    m_previous = 0;
+    m_above = false;
+
+    m_hasTriggered = false;
+    m_lastTrigger = 0;
+    m_recheckPending = false;
+}
+
+/**
+ * @brief TriggerFilter::load reads one child of the condition, if it belongs to the filter
+ * @param elem
+ * @return true if the child has been used
+ */
+bool TriggerFilter::load(const XmlElement::Child& elem)
+{
+    if(elem.tag == XmlTag::Hysteresis)
+    {
+        m_hysteresis = elem.text.toUInt();
+        return true;
+    }
+    else if(elem.tag == XmlTag::MinIntervalMs)
+    {
+        m_minIntervalMs = elem.text.toUInt();
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief TriggerFilter::save appends the settings to the element of the condition, nothing is written for an unfiltered condition
+ * @param condition
+ * @param document
+ */
+void TriggerFilter::save(QDomElement* condition, QDomDocument* document) const
+{
+    if(m_hysteresis != 0)
+    {
+        QDomElement hysteresis = document->createElement("hysteresis");
+        QDomText hysteresisText = document->createTextNode( QString::number(m_hysteresis) );
+        hysteresis.appendChild(hysteresisText);
+
+        condition->appendChild(hysteresis);
+    }
+
+    if(m_minIntervalMs != 0)
+    {
+        QDomElement interval = document->createElement("minintervalms");
+        QDomText intervalText = document->createTextNode( QString::number(m_minIntervalMs) );
+        interval.appendChild(intervalText);
+
+        condition->appendChild(interval);
+    }
+}
+
+void TriggerFilter::loadBinary(QDataStream& in)
+{
+    quint32 hysteresis = 0;
+    quint32 minIntervalMs = 0;
+    in >> hysteresis >> minIntervalMs;
+
+    m_hysteresis = hysteresis;
+    m_minIntervalMs = minIntervalMs;
+}
+
+void TriggerFilter::saveBinary(QDataStream& out) const
+{
+    out << (quint32)m_hysteresis << (quint32)m_minIntervalMs;
+}
+
+void TriggerFilter::init(ConfigManager* config)
+{
+    m_timerThread = config->getRuleTimerThread();
+}
+
+/**
+ * @brief TriggerFilter::deinit forgets the previous value and the last trigger
+ */
+void TriggerFilter::deinit()
+{
+    m_timerThread = NULL;
+    m_hasPrevious = false;
+    m_hasTriggered = false;
+    m_recheckPending = false;
+}
+
+/**
+ * @brief TriggerFilter::greaterThan is fulfilled as soon as value is greater than triggerValue
+ * and is released when it is not greater than triggerValue - hysteresis anymore
+ * @param fulfilled current state of the condition
+ * @param value
+ * @param triggerValue
+ * @return new state of the condition
+ */
+bool TriggerFilter::greaterThan(bool fulfilled, int value, int triggerValue) const
+{
+    if(fulfilled)
+        return value > triggerValue - (int)m_hysteresis;
+
+    return value > triggerValue;
+}
+
+/**
+ * @brief TriggerFilter::lessThan is fulfilled as soon as value is less than triggerValue
+ * and is released when it is not less than triggerValue + hysteresis anymore
+ * @param fulfilled current state of the condition
+ * @param value
+ * @param triggerValue
+ * @return new state of the condition
+ */
+bool TriggerFilter::lessThan(bool fulfilled, int value, int triggerValue) const
+{
+    if(fulfilled)
+        return value < triggerValue + (int)m_hysteresis;
+
+    return value < triggerValue;
+}
+
+/**
+ * @brief TriggerFilter::equal is fulfilled as soon as value is equal to triggerValue
+ * and is released when it differs from triggerValue by more than the hysteresis
+ * @param fulfilled current state of the condition
+ * @param value
+ * @param triggerValue
+ * @return new state of the condition
+ */
+bool TriggerFilter::equal(bool fulfilled, int value, int triggerValue) const
+{
+    if(fulfilled)
+        return value >= triggerValue - (int)m_hysteresis && value <= triggerValue + (int)m_hysteresis;
+
+    return value == triggerValue;
+}
+
+/**
+ * @brief TriggerFilter::changed compares value with the value at the last change
+ * @param value
+ * @return true if value differs from it by more than the hysteresis
+ */
+bool TriggerFilter::changed(int value)
+{
+    if(!m_hasPrevious)
+    {
+        m_hasPrevious = true;
+        m_previous = value;
+        return false;
+    }
+
+    int diff = value - m_previous;
+    if(diff < 0)
+        diff = -diff;
+
+    if(diff <= (int)m_hysteresis)
+        return false;
+
+    m_previous = value;
+    return true;
+}
+
+/**
+ * @brief TriggerFilter::edge detects if value has crossed triggerValue.
+ * The value rises when it gets greater than triggerValue and falls when it is not greater than triggerValue - hysteresis anymore.
+ * @param value
+ * @param triggerValue
+ * @return
+ */
+TriggerFilter::Edge TriggerFilter::edge(int value, int triggerValue)
+{
+    bool above = this->greaterThan(m_above, value, triggerValue);
+
+    if(!m_hasPrevious)
+    {
+        m_hasPrevious = true;
+        m_above = above;
+        return None;
+    }
+
+    if(above == m_above)
+        return None;
+
+    m_above = above;
+
+    return above ? Rising : Falling;
+}
+
+/**
+ * @brief TriggerFilter::allowed is called every time the condition would trigger its rule
+ * @param recheck condition which is evaluated again when the interval has expired, if the trigger is suppressed, NULL for edge triggers
+ * @return false if the last trigger is less than the minimum interval ago
+ */
+bool TriggerFilter::allowed(Condition* recheck)
+{
+    if(m_minIntervalMs == 0 || m_timerThread == NULL)
+        return true;
+
+    unsigned long long now = m_timerThread->getClock();
+
+    if(m_hasTriggered && now - m_lastTrigger < m_minIntervalMs)
+    {
+        if(recheck != NULL && !m_recheckPending)
+        {
+            m_recheckPending = true;
+            m_timerThread->addRecheck(recheck->getRule(), recheck, m_lastTrigger + m_minIntervalMs - now);
+        }
+
+        return false;
+    }
+
+    m_hasTriggered = true;
+    m_lastTrigger = now;
+
+    return true;
+}
+
+std::string TriggerFilter::getDescription() const
+{
+    std::string str;
+
+    if(m_hysteresis != 0)
+    {
+        str.append(" with hysteresis ");
+        str.append( std::to_string(m_hysteresis) );
+    }
+
+    if(m_minIntervalMs != 0)
+    {
+        str.append(", at most every ");
+        str.append( std::to_string(m_minIntervalMs) );
+        str.append(" ms");
+    }
+
+    return str;
+}
@@ -0,0 +1,76 @@
+#ifndef TRIGGERFILTER_H
+#define TRIGGERFILTER_H
+
+#include <QDomElement>
+
+#include "util/XmlElement.h"
+
+class QDataStream;
+class ConfigManager;
+class RuleTimerThread;
+class Condition;
+
+/**
+ * @brief The TriggerFilter class keeps noisy values, e.g. of an ADC, from triggering a rule again and again.
+ * It is used by conditions which compare a value with a trigger value.
+ * Level triggers get a hysteresis band: once fulfilled, they are only released after the value has left the band around the trigger value.
+ * Edge triggers remember the previous value, so that they only fire when the value actually crosses the trigger value or moves by more than the hysteresis.
+ * In addition a minimum interval between two triggers can be set. The interval is measured with the clock of the RuleTimerThread,
+ * so that replays of recorded events behave the same at any speed. A level trigger which is suppressed stays unfulfilled
+ * and is evaluated again by the RuleTimerThread as soon as the interval has expired, so it is only delayed and never lost.
+ */
+class TriggerFilter
+{
+public:
+    enum Edge
+    {
+        None = 0,
+        Rising = 1,
+        Falling = 2,
+    };
+
+    TriggerFilter();
+
+    bool load(const XmlElement::Child& elem);
+    void save(QDomElement* condition, QDomDocument* document) const;
+    void loadBinary(QDataStream& in);
+    void saveBinary(QDataStream& out) const;
+
+    void init(ConfigManager* config);
+    void deinit();
+
+    void setHysteresis(unsigned int hysteresis) { m_hysteresis = hysteresis;}
+    unsigned int getHysteresis() const { return m_hysteresis;}
+
+    void setMinIntervalMs(unsigned int ms) { m_minIntervalMs = ms;}
+    unsigned int getMinIntervalMs() const { return m_minIntervalMs;}
+
+    bool greaterThan(bool fulfilled, int value, int triggerValue) const;
+    bool lessThan(bool fulfilled, int value, int triggerValue) const;
+    bool equal(bool fulfilled, int value, int triggerValue) const;
+
+    bool changed(int value);
+    Edge edge(int value, int triggerValue);
+
+    bool allowed(Condition* recheck = NULL);
+    void rechecked() { m_recheckPending = false;}
+
+    std::string getDescription() const;
+
+private:
+    unsigned int m_hysteresis;
+    unsigned int m_minIntervalMs;
+
+    RuleTimerThread* m_timerThread;
+
+    // state of the edge triggers, the first value after init never fires
+    bool m_hasPrevious;
+    int m_previous; // value at the last change for changed
+    bool m_above; // value is above the trigger value for edge
+
+    bool m_hasTriggered;
+    unsigned long long m_lastTrigger; // in miliseconds of the timer clock
+    bool m_recheckPending;
+};
+
+#endif // TRIGGERFILTER_H
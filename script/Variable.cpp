@@ -1,12 +1,17 @@
 
 #include "script/Variable.h"
 #include "script/VariableListener.h"
+#include "script/RuleExecutor.h"
+#include "script/EventRecorder.h"
 #include "util/Debug.h"
+#include "util/DataStream.h"
+#include "util/XmlElement.h"
 
 Variable::Variable()
 {
     m_value = 0;
     m_defaultValue = 0;
+    m_executor = NULL;
 }
 
 /**
@@ -19,30 +24,27 @@ Variable* Variable::clone()
 
     Variable* var = new Variable();
     var->m_name = m_name;
-    var->m_value = m_value;
+    var->m_value = m_value.load();
     var->m_defaultValue = m_defaultValue;
 
     return var;
 }
 
-Variable* Variable::load(QDomElement* root)
+Variable* Variable::load(XmlElement* root)
 {
     Variable* variable = new Variable();
-    QDomElement elem = root->firstChildElement();
 
-    while(!elem.isNull())
+    for(XmlElement::Iterator elem = root->begin(); elem != root->end(); elem++)
     {
-        if(elem.tagName().toLower().compare("defaultvalue") == 0)
+        if(elem->tag == XmlTag::DefaultValue)
         {
-            variable->m_defaultValue = elem.text().toInt();
+            variable->m_defaultValue = elem->text.toInt();
             variable->setValue( variable->m_defaultValue );
         }
-        else if(elem.tagName().toLower().compare("name") == 0)
+        else if(elem->tag == XmlTag::Name)
         {
-            variable->m_name = elem.text().toStdString();
+            variable->m_name = elem->text.toStdString();
         }
-
-        elem = elem.nextSiblingElement();
     }
 
     return variable;
@@ -67,11 +69,37 @@ void Variable::save(QDomElement* root, QDomDocument* document)
     root->appendChild(var);
 }
 
+Variable* Variable::loadBinary(QDataStream& in)
+{
+    Variable* variable = new Variable();
+    qint32 defaultValue = 0;
+
+    in >> variable->m_name >> defaultValue;
+
+    variable->m_defaultValue = defaultValue;
+    variable->setValue( variable->m_defaultValue );
+
+    return variable;
+}
+
+void Variable::saveBinary(QDataStream& out)
+{
+    out << m_name << (qint32)m_defaultValue;
+}
+
 void Variable::setValue(int value)
 {
+    // the conditions depending on this variable must only be evaluated by the executor
+    if(m_executor != NULL && !m_executor->isExecutorThread())
+    {
+        m_executor->post(RuleExecutor::VariableSet, this, value);
+        return;
+    }
+
     if(value != m_value)
     {
         m_value = value;
+        EventRecorder::variableChanged(this);
         this->variableChanged();
     }
 }
@@ -4,12 +4,17 @@
 #include <QDomElement>
 #include <string>
 #include <list>
+#include <atomic>
 
+class QDataStream;
+class XmlElement;
 class VariableListener;
+class RuleExecutor;
 
 /**
  * @brief The Variable class is special type of input and output, as it can be used as both.
  * A variable has an integer value which can be manipulated by actions and used as conditions.
+ * While a script is active, the value is only changed by the RuleExecutor, values set by other threads are posted to it.
  */
 class Variable
 {
@@ -18,8 +23,10 @@ public:
 
     Variable* clone();
 
-    static Variable* load(QDomElement* root);
+    static Variable* load(XmlElement* root);
     void save(QDomElement* root, QDomDocument* document);
+    static Variable* loadBinary(QDataStream& in);
+    void saveBinary(QDataStream& out);
 
     std::string getName() const { return m_name;}
     void setName(std::string str) { m_name = str;}
@@ -30,14 +37,17 @@ public:
     int getValue() const { return m_value;}
     void setValue(int value);
 
+    void setExecutor(RuleExecutor* executor) { m_executor = executor;}
+
     void registerVariableListener(VariableListener* listener);
     void unregisterVariableListener(VariableListener* listener);
 private:
     void variableChanged();
 
     std::string m_name;
-    int m_value;
+    std::atomic<int> m_value;
     int m_defaultValue;
+    RuleExecutor* m_executor;
     std::list<VariableListener*> m_listListeners;
 };
 
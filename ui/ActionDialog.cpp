@@ -20,6 +20,7 @@
 #include "util/Debug.h"
 
 #include <QFileDialog>
+#include <QMessageBox>
 
 ActionDialog::ActionDialog(QWidget *parent, Script *script) :
     QDialog(parent),
@@ -1045,6 +1046,7 @@ ActionVariableWidget::ActionVariableWidget(QWidget* parent, Script *script) : IA
     m_comboOperator->addItem("=");
     m_comboOperator->addItem("+=");
     m_comboOperator->addItem("-=");
+    m_comboOperator->addItem("= expression");
 
     m_labelOperator = new QLabel("Set variable", this);
 
@@ -1052,6 +1054,9 @@ ActionVariableWidget::ActionVariableWidget(QWidget* parent, Script *script) : IA
     m_spinOperand->setMinimum(-100);
     m_spinOperand->setMaximum(100);
 
+    m_editExpression = new QLineEdit(this);
+    m_editExpression->setPlaceholderText("e.g. fader1 * 2 / 3 + offset");
+
 
     m_layout = new QGridLayout(this);
 
@@ -1064,8 +1069,23 @@ ActionVariableWidget::ActionVariableWidget(QWidget* parent, Script *script) : IA
     m_layout->addWidget(m_labelOperator, 1, 0);
     m_layout->addWidget(m_comboOperator, 1, 1);
     m_layout->addWidget(m_spinOperand, 1, 2);
+    m_layout->addWidget(m_editExpression, 2, 1, 1, 2);
 
     this->setLayout(m_layout);
+
+    // connect all signals - slots
+    connect(m_comboOperator, SIGNAL(currentIndexChanged(int)), this, SLOT(operatorChanged(int)));
+
+    // default values
+    this->operatorChanged( m_comboOperator->currentIndex() );
+}
+
+void ActionVariableWidget::operatorChanged(int index)
+{
+    bool expression = (ActionVariable::Operator)index == ActionVariable::Expr;
+
+    m_spinOperand->setVisible( !expression );
+    m_editExpression->setVisible( expression );
 }
 
 void ActionVariableWidget::edit(Action* act)
@@ -1085,6 +1105,7 @@ void ActionVariableWidget::edit(Action* act)
 
     m_comboOperator->setCurrentIndex( action->getOperator() );
     m_spinOperand->setValue( action->getOperand() );
+    m_editExpression->setText( QString::fromStdString( action->getExpression() ) );
 }
 
 Action* ActionVariableWidget::assemble()
@@ -1095,6 +1116,18 @@ Action* ActionVariableWidget::assemble()
     action->setOperator( (ActionVariable::Operator)m_comboOperator->currentIndex() );
     action->setOperand( m_spinOperand->value() );
 
+    if(action->getOperator() == ActionVariable::Expr && !action->setExpression( m_editExpression->text().toStdString() ))
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Warning",
+                    QString("Invalid expression: ").append( QString::fromStdString( action->getExpressionError() ) ),
+                    QMessageBox::Ok,
+                    this).exec();
+
+        delete action;
+        return NULL;
+    }
+
     return action;
 }
 
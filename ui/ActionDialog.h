@@ -10,6 +10,7 @@
 #include <QGridLayout>
 #include <QSpinBox>
 #include <QPushButton>
+#include <QLineEdit>
 
 namespace Ui {
     class ActionDialog;
@@ -271,6 +272,9 @@ public:
     void edit(Action* action);
     Action* assemble();
 
+private slots:
+    void operatorChanged(int index);
+
 private:
     QGridLayout* m_layout;
     QComboBox* m_combo;
@@ -278,6 +282,7 @@ private:
     QComboBox* m_comboOperator;
     QLabel* m_labelOperator;
     QSpinBox* m_spinOperand;
+    QLineEdit* m_editExpression;
 };
 
 // Sleep Stuff
@@ -0,0 +1,163 @@
+
+#include "ui/BTTelemetryTableModel.h"
+#include "hw/BTThread.h"
+#include "ConfigManager.h"
+
+#include <algorithm>
+
+BTTelemetryTableModel::BTTelemetryTableModel(QObject* parent, ConfigManager* config) : QAbstractTableModel(parent)
+{
+    m_config = config;
+}
+
+int BTTelemetryTableModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_vec.size();
+}
+
+int BTTelemetryTableModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return 13;
+}
+
+/**
+ * @brief averageRtt calculates the average round trip time over all request types
+ * @param telemetry
+ * @return average round trip time in miliseconds
+ */
+static double averageRtt(const BTTelemetry::Snapshot& telemetry)
+{
+    unsigned long long sumUs = 0;
+    unsigned int count = 0;
+
+    for(unsigned int type = 0; type < BTTelemetry::RequestTypeCount; type++)
+    {
+        sumUs += telemetry.rttSumUs[type];
+
+        for(unsigned int bucket = 0; bucket < BTTelemetry::RttBucketCount; bucket++)
+            count += telemetry.rttHistogram[type][bucket];
+    }
+
+    if(count == 0)
+        return 0;
+
+    return sumUs / 1000.0 / count;
+}
+
+QVariant BTTelemetryTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid())
+        return QVariant();
+
+    if(index.row() >= m_vec.size() || index.row() < 0)
+        return QVariant();
+
+    if(role == Qt::DisplayRole)
+    {
+        const Row& row = m_vec.at(index.row());
+        const BTTelemetry::Snapshot& telemetry = row.telemetry;
+
+        switch(index.column())
+        {
+        case 0:
+            return QString::fromStdString( row.name );
+        case 1:
+            return QString::fromStdString( row.state );
+        case 2:
+            return QString::number(averageRtt(telemetry), 'f', 1);
+        case 3:
+            return std::max(telemetry.rttMaxMs[BTTelemetry::I2CWrite], telemetry.rttMaxMs[BTTelemetry::I2CRead]);
+        case 4:
+            return telemetry.matched;
+        case 5:
+            return telemetry.orphaned;
+        case 6:
+            return telemetry.lost;
+        case 7:
+            return telemetry.reconnects;
+        case 8:
+            return QString::number(telemetry.outstanding) + " / " + QString::number(telemetry.outstandingHighWater);
+        case 9:
+            return QString::number(telemetry.outputQueueHighWater) + " / " + QString::number(telemetry.outputsDropped);
+        case 10:
+            return telemetry.bytesPerSecond;
+        case 11:
+            return QString::number(telemetry.inputsValidMs) + " / " + QString::number(telemetry.inputsValidMaxMs);
+        case 12:
+            return telemetry.gpCorrections;
+        default:
+            return QVariant();
+        }
+    }
+
+    return QVariant();
+}
+
+QVariant BTTelemetryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role != Qt::DisplayRole)
+        return QVariant();
+
+    if(orientation == Qt::Horizontal)
+    {
+        switch (section)
+        {
+        case 0:
+            return tr("Name");
+        case 1:
+            return tr("State");
+        case 2:
+            return tr("Avg RTT [ms]");
+        case 3:
+            return tr("Max RTT [ms]");
+        case 4:
+            return tr("Matched");
+        case 5:
+            return tr("Orphaned");
+        case 6:
+            return tr("Lost");
+        case 7:
+            return tr("Reconnects");
+        case 8:
+            return tr("Window / Max");
+        case 9:
+            return tr("Queue Max / Dropped");
+        case 10:
+            return tr("Bytes/s");
+        case 11:
+            return tr("Inputs Valid [ms] / Max");
+        case 12:
+            return tr("GP Corrections");
+        default:
+            return QVariant();
+        }
+    }
+
+    return QVariant();
+}
+
+/**
+ * @brief BTTelemetryTableModel::refresh reads the current statistics of all bluetooth boards.
+ */
+void BTTelemetryTableModel::refresh()
+{
+    std::list<BTThread*> listBTThread = m_config->getBTThreadList();
+
+    emit layoutAboutToBeChanged();
+
+    m_vec.clear();
+
+    for(std::list<BTThread*>::iterator it = listBTThread.begin(); it != listBTThread.end(); it++)
+    {
+        Row row;
+        row.name = (*it)->getName();
+        row.state = BTThread::ConnectionStateToString( (*it)->getConnectionState() );
+        row.telemetry = (*it)->getTelemetry()->get();
+
+        m_vec.push_back(row);
+    }
+
+    emit layoutChanged();
+}
@@ -0,0 +1,41 @@
+#ifndef BTTELEMETRYTABLEMODEL_H
+#define BTTELEMETRYTABLEMODEL_H
+
+#include "hw/BTTelemetry.h"
+
+#include <QAbstractTableModel>
+#include <vector>
+#include <string>
+
+class ConfigManager;
+
+/**
+ * @brief The BTTelemetryTableModel class shows the link statistics of all bluetooth boards of the current config.
+ * The statistics are only read on BTTelemetryTableModel::refresh, which should be called periodically.
+ */
+class BTTelemetryTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    BTTelemetryTableModel(QObject *parent, ConfigManager* config);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+
+    void refresh();
+
+private:
+    struct Row
+    {
+        std::string name;
+        std::string state;
+        BTTelemetry::Snapshot telemetry;
+    };
+
+    ConfigManager* m_config;
+    std::vector<Row> m_vec;
+};
+
+#endif // BTTELEMETRYTABLEMODEL_H
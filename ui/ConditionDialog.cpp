@@ -5,6 +5,7 @@
 #include "script/ConditionInputButton.h"
 #include "script/ConditionInputFader.h"
 #include "script/ConditionVariable.h"
+#include "script/ConditionExpression.h"
 
 #include "script/Script.h"
 
@@ -13,6 +14,8 @@
 
 #include "util/Debug.h"
 
+#include <QMessageBox>
+
 ConditionDialog::ConditionDialog(QWidget *parent, Script *script) :
     QDialog(parent),
     ui(new Ui::ConditionDialog)
@@ -56,6 +59,11 @@ void ConditionDialog::conditionChanged(int index)
         m_baseWidget = new ConditionVariableWidget(this, m_script);
         ui->frameGrid->addWidget(m_baseWidget, 1, 0, 1, 2);
         break;
+
+    case Condition::Expr:
+        m_baseWidget = new ConditionExpressionWidget(this);
+        ui->frameGrid->addWidget(m_baseWidget, 1, 0, 1, 2);
+        break;
     }
 }
 
@@ -235,12 +243,21 @@ ConditionInputFaderWidget::ConditionInputFaderWidget(QWidget* parent) : IConditi
     m_combo->addItem("is less than");
     m_combo->addItem("is equal to");
     m_combo->addItem("has changed");
+    m_combo->addItem("rises above");
+    m_combo->addItem("falls to or below");
 
     m_label = new QLabel("If value", this);
 
     m_spinBox = new QSpinBox(this);
     m_spinBox->setMaximum(100);
 
+    m_spinHysteresis = new QSpinBox(this);
+    m_spinHysteresis->setMaximum(100);
+
+    m_spinInterval = new QSpinBox(this);
+    m_spinInterval->setMaximum(3600000);
+    m_spinInterval->setSuffix(" ms");
+
     QGridLayout* layout = new QGridLayout(this);
 
     // remove spacing around widget, it looks kind of odd otherwise
@@ -250,6 +267,10 @@ ConditionInputFaderWidget::ConditionInputFaderWidget(QWidget* parent) : IConditi
     layout->addWidget(m_label, 0, 0);
     layout->addWidget(m_combo, 0, 1);
     layout->addWidget(m_spinBox, 0, 2);
+    layout->addWidget(new QLabel("Hysteresis", this), 1, 0);
+    layout->addWidget(m_spinHysteresis, 1, 1, 1, 2);
+    layout->addWidget(new QLabel("Min. interval", this), 2, 0);
+    layout->addWidget(m_spinInterval, 2, 1, 1, 2);
 
     this->setLayout(layout);
 
@@ -273,6 +294,9 @@ Condition* ConditionInputFaderWidget::assemble()
 
     condition->setTriggerValue( m_spinBox->text().toInt() );
 
+    condition->getFilter()->setHysteresis( m_spinHysteresis->value() );
+    condition->getFilter()->setMinIntervalMs( m_spinInterval->value() );
+
     return condition;
 }
 
@@ -281,6 +305,8 @@ void ConditionInputFaderWidget::edit(Condition *cond)
     ConditionInputFader* condition = (ConditionInputFader*)cond;
     m_combo->setCurrentIndex(condition->getTrigger());
     m_spinBox->setValue( condition->getTriggerValue() );
+    m_spinHysteresis->setValue( condition->getFilter()->getHysteresis() );
+    m_spinInterval->setValue( condition->getFilter()->getMinIntervalMs() );
 }
 
 
@@ -301,12 +327,22 @@ ConditionVariableWidget::ConditionVariableWidget(QWidget* parent, Script *script
     m_comboTrigger->addItem("no longer equal to");
     m_comboTrigger->addItem("greater than to");
     m_comboTrigger->addItem("Less than to");
+    m_comboTrigger->addItem("rising above");
+    m_comboTrigger->addItem("falling to or below");
+    m_comboTrigger->addItem("changed");
 
     m_labelTrigger = new QLabel("If value is ", this);
 
     m_spinValue = new QSpinBox(this);
     m_spinValue->setMaximum(100);
 
+    m_spinHysteresis = new QSpinBox(this);
+    m_spinHysteresis->setMaximum(100);
+
+    m_spinInterval = new QSpinBox(this);
+    m_spinInterval->setMaximum(3600000);
+    m_spinInterval->setSuffix(" ms");
+
 
     m_layout = new QGridLayout(this);
 
@@ -319,8 +355,22 @@ ConditionVariableWidget::ConditionVariableWidget(QWidget* parent, Script *script
     m_layout->addWidget(m_labelTrigger, 1, 0);
     m_layout->addWidget(m_comboTrigger, 1, 1);
     m_layout->addWidget(m_spinValue, 1, 2);
+    m_layout->addWidget(new QLabel("Hysteresis", this), 2, 0);
+    m_layout->addWidget(m_spinHysteresis, 2, 1, 1, 2);
+    m_layout->addWidget(new QLabel("Min. interval", this), 3, 0);
+    m_layout->addWidget(m_spinInterval, 3, 1, 1, 2);
 
     this->setLayout(m_layout);
+
+    connect(m_comboTrigger, SIGNAL(currentIndexChanged(int)), this, SLOT(comboTriggerChanged(int)));
+}
+
+void ConditionVariableWidget::comboTriggerChanged(int index)
+{
+    if( index == ConditionVariable::Changed )
+        m_spinValue->hide();
+    else
+        m_spinValue->show();
 }
 
 void ConditionVariableWidget::edit(Condition* cond)
@@ -340,6 +390,8 @@ void ConditionVariableWidget::edit(Condition* cond)
 
     m_comboTrigger->setCurrentIndex( condition->getTrigger() );
     m_spinValue->setValue( condition->getTriggerValue() );
+    m_spinHysteresis->setValue( condition->getFilter()->getHysteresis() );
+    m_spinInterval->setValue( condition->getFilter()->getMinIntervalMs() );
 }
 
 Condition* ConditionVariableWidget::assemble()
@@ -350,5 +402,54 @@ Condition* ConditionVariableWidget::assemble()
     condition->setTrigger( (ConditionVariable::Trigger)m_comboTrigger->currentIndex() );
     condition->setTriggerValue( m_spinValue->value() );
 
+    condition->getFilter()->setHysteresis( m_spinHysteresis->value() );
+    condition->getFilter()->setMinIntervalMs( m_spinInterval->value() );
+
+    return condition;
+}
+
+
+ConditionExpressionWidget::ConditionExpressionWidget(QWidget* parent) : IConditionWidget(parent)
+{
+    m_label = new QLabel("If expression is true", this);
+
+    m_editExpression = new QLineEdit(this);
+    m_editExpression->setPlaceholderText("e.g. a > b && c < 10");
+
+    m_layout = new QGridLayout(this);
+
+    // remove spacing around widget, it looks kind of odd otherwise
+    m_layout->setContentsMargins(0, 0, 0, 0);
+
+    // add our widgets to the layout
+    m_layout->addWidget(m_label, 0, 0);
+    m_layout->addWidget(m_editExpression, 0, 1);
+
+    this->setLayout(m_layout);
+}
+
+void ConditionExpressionWidget::edit(Condition* cond)
+{
+    ConditionExpression* condition = (ConditionExpression*)cond;
+
+    m_editExpression->setText( QString::fromStdString( condition->getExpression() ) );
+}
+
+Condition* ConditionExpressionWidget::assemble()
+{
+    ConditionExpression* condition = new ConditionExpression();
+
+    if( !condition->setExpression( m_editExpression->text().toStdString() ) )
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Warning",
+                    QString("Invalid expression: ").append( QString::fromStdString( condition->getError() ) ),
+                    QMessageBox::Ok,
+                    this).exec();
+
+        delete condition;
+        return NULL;
+    }
+
     return condition;
 }
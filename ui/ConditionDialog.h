@@ -6,6 +6,7 @@
 #include <QLabel>
 #include <QGridLayout>
 #include <QSpinBox>
+#include <QLineEdit>
 
 #include "script/Rule.h"
 #include "script/Condition.h"
@@ -99,6 +100,8 @@ private:
     QComboBox* m_combo;
     QLabel* m_label;
     QSpinBox* m_spinBox;
+    QSpinBox* m_spinHysteresis;
+    QSpinBox* m_spinInterval;
 };
 
 // Variable Stuff
@@ -112,6 +115,8 @@ public:
 
     Condition* assemble();
 
+private slots:
+    void comboTriggerChanged(int index);
 private:
     QGridLayout* m_layout;
     QComboBox* m_combo;
@@ -119,6 +124,25 @@ private:
     QComboBox* m_comboTrigger;
     QLabel* m_labelTrigger;
     QSpinBox* m_spinValue;
+    QSpinBox* m_spinHysteresis;
+    QSpinBox* m_spinInterval;
+};
+
+// Expression Stuff
+
+class ConditionExpressionWidget : public IConditionWidget
+{
+    Q_OBJECT
+public:
+    ConditionExpressionWidget(QWidget* parent);
+    void edit(Condition* condition);
+
+    Condition* assemble();
+
+private:
+    QGridLayout* m_layout;
+    QLabel* m_label;
+    QLineEdit* m_editExpression;
 };
 
 #endif // ADDCONDITIONDIALOG_H
@@ -15,17 +15,29 @@
 #include "ui/ScriptDialog.h"
 #include "ui/ConfigDialog.h"
 
+#include "Defaults.h"
+
+#include "hw/BTThread.h"
 #include "util/Debug.h"
+#include "util/LatencyTrace.h"
+#include "script/EventRecorder.h"
 
 #include <QMessageBox>
 #include <QDomDocument>
 #include <QFile>
 #include <QStringListModel>
+#include <QTimer>
+#include <QFileDialog>
+#include <QDateTime>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
-    m_config(this)
+    m_scriptsModel(this, &m_config),
+    m_btTelemetryModel(this, &m_config),
+    m_ruleProfileModel(this, &m_config),
+    m_config(this),
+    m_eventReplay(&m_config)
 {
     ui->setupUi(this);
 
@@ -98,98 +110,81 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->listFacilities->selectionModel(), SIGNAL(selectionChanged(QItemSelection, QItemSelection)), this, SLOT(updateErrorFacilities()));
     connect(ui->listLevels->selectionModel(), SIGNAL(selectionChanged(QItemSelection, QItemSelection)), this, SLOT(updateErrorLevels()));
 
+    // bluetooth telemetry, the table is updated once per second
+    ui->tableBluetooth->setModel(&m_btTelemetryModel);
+    ui->tableBluetooth->horizontalHeader()->setStretchLastSection(true);
+
+    connect(ui->buttonDumpTelemetry, SIGNAL(clicked()), this, SLOT(dumpTelemetry()));
+
+    QTimer* telemetryTimer = new QTimer(this);
+    connect(telemetryTimer, SIGNAL(timeout()), this, SLOT(refreshTelemetry()));
+
+    // rule profiles, they are refreshed together with the telemetry
+    ui->tableRuleProfile->setModel(&m_ruleProfileModel);
+    ui->tableRuleProfile->setSortingEnabled(true);
+    ui->tableRuleProfile->horizontalHeader()->setStretchLastSection(true);
+
+    connect(ui->buttonResetProfile, SIGNAL(clicked()), this, SLOT(resetProfile()));
+    connect(ui->buttonDumpProfile, SIGNAL(clicked()), this, SLOT(dumpProfile()));
+    connect(ui->buttonRecord, SIGNAL(toggled(bool)), this, SLOT(recordEvents(bool)));
+    connect(ui->buttonReplay, SIGNAL(clicked()), this, SLOT(replayEvents()));
+    connect(telemetryTimer, SIGNAL(timeout()), this, SLOT(refreshProfile()));
+
+    telemetryTimer->start(1000);
+
 
     // load last settings
-    QFile file( "defaults.xml" );
-    if(!file.open(QIODevice::ReadOnly))
-    {
-        LOG_WARN(Logger::UI, "Could not open defaults file. Does it exist?");
+    Defaults defaults;
+    if(!defaults.load("defaults.xml"))
         return;
-    }
 
-    QDomDocument document;
-    document.setContent(&file);
+    // only try to load new config if this string is not empty, otherwise this call would fail anyway
+    if(!defaults.config.empty())
+    {
+        QString config = QString::fromStdString(defaults.config);
 
-    QDomElement docElem = document.documentElement();
+        // try to load the configuration
+        m_config.load( defaults.config );
 
-    // check if this is a valid defaults file
-    if(docElem.tagName().toLower().compare("default") != 0)
-    {
-        LOG_WARN(Logger::UI, "Invalid defaults file: tag \"default\" is missing");
-        return;
+        // and select it in the startup config combo box
+        int index = ui->comboStartupConfig->findText(config);
+        ui->comboStartupConfig->setCurrentIndex(index);
+
+        ui->checkStartupConfig->setChecked(true);
     }
 
-    QString defaultScript;
+    QString defaultScript = QString::fromStdString(defaults.script);
 
-    QDomElement elem = docElem.firstChildElement();
-    while(!elem.isNull())
+    if(defaults.hasLogSettings)
     {
-        if(elem.tagName().toLower().compare("config") == 0)
-        {
-            // only try to load new config if this string is not empty, otherwise this call would fail anyway
-            if(!elem.text().isEmpty())
-            {
-                // try to load the configuration
-                m_config.load( elem.text().toStdString() );
+        // the selection models update the Logger
+        QItemSelectionModel* facilitySelModel = ui->listFacilities->selectionModel();
+        QItemSelectionModel* errorLevelSelModel = ui->listLevels->selectionModel();
 
-                // and select it in the startup config combo box
-                int index = ui->comboStartupConfig->findText(elem.text());
-                ui->comboStartupConfig->setCurrentIndex(index);
+        // Facilities and error levels
+        facilitySelModel->reset();
+        errorLevelSelModel->reset();
 
-                ui->checkStartupConfig->setChecked(true);
-            }
-        }
-        else if(elem.tagName().toLower().compare("script") == 0)
+        for(unsigned int facility = 0; facility < Logger::N_FACILITIES; facility++)
         {
-            defaultScript = elem.text();
+            if(defaults.logFacility[facility])
+            {
+                facilitySelModel->select(QItemSelection( ui->listFacilities->model()->index(facility, 0), ui->listFacilities->model()->index(facility, 0) ),
+                                         QItemSelectionModel::Select);
+            }
         }
-        else if(elem.tagName().toLower().compare("error") == 0)
-        {
-            // parse all information related to error handling here
-            QItemSelectionModel* facilitySelModel = ui->listFacilities->selectionModel();
-            QItemSelectionModel* errorLevelSelModel = ui->listLevels->selectionModel();
-
-            // Facilities and error levels
-            facilitySelModel->reset();
-            errorLevelSelModel->reset();
 
-            QDomElement errorEl = elem.firstChildElement();
-            while(!errorEl.isNull())
+        bool levels[3] = {defaults.logDebug, defaults.logWarn, defaults.logError};
+        for(unsigned int level = 0; level < 3; level++)
+        {
+            if(levels[level])
             {
-                if(errorEl.tagName().toLower().compare("facility") == 0)
-                {
-                    Logger::Facility facility = Logger::StringToFacility(errorEl.text().toStdString());
-                    if( facility < Logger::N_FACILITIES )
-                    {
-                        facilitySelModel->select(QItemSelection( ui->listFacilities->model()->index(facility, 0), ui->listFacilities->model()->index(facility, 0) ),
-                                                 QItemSelectionModel::Select);
-                    }
-                }
-                else if(errorEl.tagName().toLower().compare("level") == 0)
-                {
-                    QString level = errorEl.text().toLower();
-
-                    if(level.compare("debug") == 0)
-                        errorLevelSelModel->select(QItemSelection( ui->listFacilities->model()->index(0, 0),
-                                                                   ui->listFacilities->model()->index(0, 0) ),
-                                                   QItemSelectionModel::Select);
-                    else if(level.compare("warn") == 0)
-                        errorLevelSelModel->select(QItemSelection( ui->listFacilities->model()->index(1, 0),
-                                                                   ui->listFacilities->model()->index(1, 0) ),
-                                                   QItemSelectionModel::Select);
-                    else if(level.compare("error") == 0)
-                        errorLevelSelModel->select(QItemSelection( ui->listFacilities->model()->index(2, 0),
-                                                                   ui->listFacilities->model()->index(2, 0) ),
-                                                   QItemSelectionModel::Select);
-                }
-                errorEl = errorEl.nextSiblingElement();
+                errorLevelSelModel->select(QItemSelection( ui->listLevels->model()->index(level, 0), ui->listLevels->model()->index(level, 0) ),
+                                           QItemSelectionModel::Select);
             }
         }
-        elem = elem.nextSiblingElement();
     }
 
-    file.close();
-
     m_config.init();
 
     ui->labelConfig->setText( QString::fromStdString( m_config.getName() ) );
@@ -289,6 +284,9 @@ MainWindow::~MainWindow()
         LOG_WARN(Logger::UI, "Could not open defaults file. Do you have read-write permissions to ./defaults.xml?");
     }
 
+    m_eventReplay.kill();
+    EventRecorder::stop();
+
     m_config.deinit();
     m_config.clear(); // has to be cleared before ui is deleted, otherwise ui widgets are no longer available and this would lead to a segfault
 
@@ -345,17 +343,30 @@ void MainWindow::editScript()
 
         Script* script = m_scriptsModel.getScript(row);
 
-        // check if script is selected, if yes, then display a warning and don't do anything
-        if(script == m_config.getActiveScript())
-        {
-            QMessageBox(QMessageBox::Warning, "Warning", "Cannot edit script because it is selected.\nPlease stop the script first", QMessageBox::Ok, this).exec();
+        if(script == NULL)
             return;
+
+        // the active script keeps running while it is edited, so the dialog works on a copy, which is applied when it is accepted
+        bool active = script == m_config.getActiveScript();
+        if(active)
+        {
+            script = Script::load(script->getName());
+
+            if(script == NULL)
+            {
+                QMessageBox(QMessageBox::Warning, "Warning", "Cannot edit script because it could not be loaded", QMessageBox::Ok, this).exec();
+                return;
+            }
         }
 
         // check if all required stuff exists
         // if not and the user decides that this is not acceptable, we stop immediately
         if( !this->checkScript(script) )
+        {
+            if(active)
+                delete script;
             return;
+        }
 
         // now we can create the dialog an start editing this script
         ScriptDialog* dialog = new ScriptDialog(this, script, &m_config);
@@ -365,12 +376,25 @@ void MainWindow::editScript()
             // save script to filesystem
             script->save();
 
+            // only the rules which have been changed are restarted, the copy is deleted.
+            // If the script had to be restarted instead, the copy is the active script and the library deletes the old one
+            if(active)
+            {
+                m_config.updateActiveScript(script);
+                script = m_config.getActiveScript();
+            }
+
             // this updates the description (and name) of a script in the ui
             m_scriptsModel.modifyRow(row, script);
 
             // this updates the displayed configuration
             this->updateScriptConfig();
         }
+        else if(active)
+        {
+            // the active script has not been touched
+            delete script;
+        }
         else
         {
             // Modified script was not accepted. As we do not want to have an invalid script (as it may be modified), we reload it
@@ -388,7 +412,7 @@ void MainWindow::deleteScript()
     if(indices.size() != 0)
     {
         // check if script is selected, if yes, then display a warning and don't do anything
-        if(m_config.getActiveScript() == m_scriptsModel.getScript(indices.front().row()))
+        if(m_scriptsModel.isActiveScript(indices.front().row()))
         {
             QMessageBox(QMessageBox::Warning, "Warning", "Cannot delete script because it is selected.\nPlease stop the script first", QMessageBox::Ok, this).exec();
             return;
@@ -411,6 +435,9 @@ void MainWindow::selectScript()
         if( !this->checkScript(script) )
             return;
 
+        // a replay must not continue into another script
+        m_eventReplay.kill();
+
         m_config.setActiveScript( script );
 
         this->updateScriptState();
@@ -419,6 +446,7 @@ void MainWindow::selectScript()
 
 void MainWindow::stopScript()
 {
+    m_eventReplay.kill();
     m_config.stopActiveScript();
 
     this->updateScriptState();
@@ -485,8 +513,12 @@ bool MainWindow::checkScript(Script *script)
         {
             strDep.append( "Input ");
             strDep.append( QString::fromStdString((*it).name) );
-            strDep.append( " with type ");
-            strDep.append( QString::fromStdString( HWInput::HWInputTypeToString((*it).type) ) );
+            // names used in expressions can be satisfied by any type of input
+            if((*it).type != HWInput::EINVALID)
+            {
+                strDep.append( " with type ");
+                strDep.append( QString::fromStdString( HWInput::HWInputTypeToString((*it).type) ) );
+            }
             strDep.append( "\n" );
         }
     }
@@ -551,7 +583,7 @@ void MainWindow::getRequiredList(std::list<Rule::RequiredInput>* listInput,
     for(std::list<Rule::RequiredInput>::iterator it = listInput->begin(); it != listInput->end(); it++)
     {
         HWInput* input = m_config.getInputByName((*it).name);
-        if(input != NULL && input->getType() == (*it).type)
+        if(input != NULL && ((*it).type == HWInput::EINVALID || input->getType() == (*it).type))
             it->exists = true;
         else
             it->exists = false;
@@ -568,11 +600,11 @@ void MainWindow::getRequiredList(std::list<Rule::RequiredInput>* listInput,
 }
 
 /**
- * @brief MainWindow::addInput adds the input given by hw to the GUI,
+ * @brief MainWindow::onInputAdded adds the input given by hw to the GUI,
  * displays a frame containing infos about it in the overview tab and registers the GUI element on the input to receive updates.
  * @param hw the HWInput object to display in the GUI
  */
-void MainWindow::addInput(HWInput* hw)
+void MainWindow::onInputAdded(HWInput* hw)
 {
     InputFrame* frame = NULL;
     switch(hw->getType())
@@ -599,11 +631,11 @@ void MainWindow::addInput(HWInput* hw)
 }
 
 /**
- * @brief MainWindow::addOutput adds the output given by hw to the GUI,
+ * @brief MainWindow::onOutputAdded adds the output given by hw to the GUI,
  * displays a frame containing infos about it in the overview tab and registers the GUI element on the output to receive updates.
  * @param hw the HWOutput object to display in the GUI
  */
-void MainWindow::addOutput(HWOutput* hw)
+void MainWindow::onOutputAdded(HWOutput* hw)
 {
     OutputFrame* frame = NULL;
 
@@ -637,11 +669,11 @@ void MainWindow::addOutput(HWOutput* hw)
 }
 
 /**
- * @brief MainWindow::addVariable adds the variable given by var to the GUI,
+ * @brief MainWindow::onVariableAdded adds the variable given by var to the GUI,
  * displays a frame containing infos about it in the overview tab and registers the GUI element on the variable to receive updates.
  * @param var the Variable object to display in the GUI
  */
-void MainWindow::addVariable(Variable* var)
+void MainWindow::onVariableAdded(Variable* var)
 {
     VariableFrame* frame = new VariableFrame(var);
     ui->layoutVariable->addWidget(frame);
@@ -649,10 +681,10 @@ void MainWindow::addVariable(Variable* var)
 }
 
 /**
- * @brief MainWindow::removeInput unregisters the GUI element from the object and removes the input object from the GUI.
+ * @brief MainWindow::onInputRemoved unregisters the GUI element from the object and removes the input object from the GUI.
  * @param hw the object to be removed from the GUI
  */
-void MainWindow::removeInput(HWInput* hw)
+void MainWindow::onInputRemoved(HWInput* hw)
 {
     for(std::list<InputFrame*>::iterator it = m_listInputFrame.begin(); it != m_listInputFrame.end(); it++)
     {
@@ -666,10 +698,10 @@ void MainWindow::removeInput(HWInput* hw)
 }
 
 /**
- * @brief MainWindow::removeOutput unregisters the GUI element from the object and removes the output object from the GUI.
+ * @brief MainWindow::onOutputRemoved unregisters the GUI element from the object and removes the output object from the GUI.
  * @param hw the object to be removed from the GUI
  */
-void MainWindow::removeOutput(HWOutput* hw)
+void MainWindow::onOutputRemoved(HWOutput* hw)
 {
     for(std::list<OutputFrame*>::iterator it = m_listOutputFrame.begin(); it != m_listOutputFrame.end(); it++)
     {
@@ -683,10 +715,10 @@ void MainWindow::removeOutput(HWOutput* hw)
 }
 
 /**
- * @brief MainWindow::removeVariable unregisters the GUI element from the object and removes the variable object from the GUI.
+ * @brief MainWindow::onVariableRemoved unregisters the GUI element from the object and removes the variable object from the GUI.
  * @param var the object to be removed from the GUI
  */
-void MainWindow::removeVariable(Variable* var)
+void MainWindow::onVariableRemoved(Variable* var)
 {
     for(std::list<VariableFrame*>::iterator it = m_listVarFrame.begin(); it != m_listVarFrame.end(); it++)
     {
@@ -777,7 +809,7 @@ void MainWindow::deleteConfig()
     if(indices.size() != 0)
     {
         // check if config is selected, if yes, then display a warning and don't do anything
-        if(m_config.getActiveScript() == m_scriptsModel.getScript(indices.front().row()))
+        if(m_scriptsModel.isActiveScript(indices.front().row()))
         {
             QMessageBox(QMessageBox::Warning, "Warning", "Cannot delete config because it is selected.\nPlease select a different config first", QMessageBox::Ok, this).exec();
             return;
@@ -807,3 +839,218 @@ MainWindow::updateErrorLevels()
     Logger::logWarn(model->isRowSelected(1, QModelIndex()));
     Logger::logError(model->isRowSelected(2, QModelIndex()));
 }
+
+void
+MainWindow::refreshTelemetry()
+{
+    m_btTelemetryModel.refresh();
+}
+
+/**
+ * @brief MainWindow::dumpTelemetry writes the link statistics of all bluetooth boards to bt_telemetry.xml, so that they can be processed by other tools
+ */
+void
+MainWindow::dumpTelemetry()
+{
+    QFile file( "bt_telemetry.xml" );
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Telemetry",
+                    "Could not open bt_telemetry.xml for writing",
+                    QMessageBox::Ok,
+                    this).exec();
+        return;
+    }
+
+    QDomDocument document;
+
+    QDomElement root = document.createElement("telemetry-dump");
+    document.appendChild(root);
+
+    std::list<BTThread*> listBTThread = m_config.getBTThreadList();
+    for(std::list<BTThread*>::iterator it = listBTThread.begin(); it != listBTThread.end(); it++)
+    {
+        QDomElement bt = document.createElement("bluetooth");
+        bt.setAttribute("name", QString::fromStdString( (*it)->getName() ));
+        bt.setAttribute("address", QString::fromStdString( (*it)->getBTAddr() ));
+        bt.setAttribute("state", QString::fromStdString( BTThread::ConnectionStateToString( (*it)->getConnectionState() ) ));
+
+        (*it)->getTelemetry()->save(&bt, &document);
+
+        root.appendChild(bt);
+    }
+
+    file.write(document.toByteArray(4));
+    file.close();
+}
+
+void
+MainWindow::refreshProfile()
+{
+    m_ruleProfileModel.refresh();
+
+    if(m_eventReplay.isRunning())
+        ui->buttonReplay->setText(QString("Stop replay (%1/%2)").arg(m_eventReplay.getReplayed()).arg(m_eventReplay.getTotal()));
+    else
+        ui->buttonReplay->setText("Replay events...");
+
+    // latency from an input change until the output has been written
+    LatencyTrace::Snapshot latency = LatencyTrace::get();
+    const LatencyTrace::StageSnapshot& bus = latency.stages[LatencyTrace::Bus];
+    const LatencyTrace::StageSnapshot& output = latency.stages[LatencyTrace::Output];
+
+    if(latency.inputs == 0)
+    {
+        ui->labelLatency->setText("No input changes yet");
+        return;
+    }
+
+    ui->labelLatency->setText(QString("Input to output: p50 %1 us, p99 %2 us, p99.9 %3 us, max %4 us (%5 changes) | "
+                                      "Input to bus: p50 %6 us, p99 %7 us, p99.9 %8 us, max %9 us (%10 writes) | "
+                                      "Peak rate: %11 inputs/s")
+                              .arg(output.p50Us).arg(output.p99Us).arg(output.p999Us).arg(output.maxUs).arg(output.count)
+                              .arg(bus.p50Us).arg(bus.p99Us).arg(bus.p999Us).arg(bus.maxUs).arg(bus.count)
+                              .arg(latency.peakRate));
+}
+
+/**
+ * @brief MainWindow::resetProfile sets the profiles of all rules of the active script and the latency histograms back to zero
+ */
+void
+MainWindow::resetProfile()
+{
+    LatencyTrace::reset();
+
+    Script* script = m_config.getActiveScript();
+    if(script == NULL)
+        return;
+
+    std::vector<Rule*> listRules = script->getRuleList();
+    for(std::vector<Rule*>::iterator it = listRules.begin(); it != listRules.end(); it++)
+    {
+        (*it)->getProfile()->reset();
+    }
+
+    m_ruleProfileModel.refresh();
+}
+
+/**
+ * @brief MainWindow::dumpProfile writes the profiles of all rules of the active script and the input to output latencies to rule_profile.xml
+ */
+void
+MainWindow::dumpProfile()
+{
+    Script* script = m_config.getActiveScript();
+    if(script == NULL)
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Profile",
+                    "There is no active script",
+                    QMessageBox::Ok,
+                    this).exec();
+        return;
+    }
+
+    QFile file( "rule_profile.xml" );
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Profile",
+                    "Could not open rule_profile.xml for writing",
+                    QMessageBox::Ok,
+                    this).exec();
+        return;
+    }
+
+    QDomDocument document;
+
+    QDomElement root = document.createElement("profile-dump");
+    root.setAttribute("script", QString::fromStdString( script->getName() ));
+    document.appendChild(root);
+
+    LatencyTrace::save(&root, &document);
+
+    std::vector<Rule*> listRules = script->getRuleList();
+    for(std::vector<Rule*>::iterator it = listRules.begin(); it != listRules.end(); it++)
+    {
+        QDomElement rule = document.createElement("rule");
+        rule.setAttribute("name", QString::fromStdString( (*it)->getName() ));
+
+        (*it)->getProfile()->save(&rule, &document);
+
+        root.appendChild(rule);
+    }
+
+    file.write(document.toByteArray(4));
+    file.close();
+}
+
+/**
+ * @brief MainWindow::recordEvents starts or stops recording all input, variable and output changes into an event log
+ * @param b
+ */
+void
+MainWindow::recordEvents(bool b)
+{
+    if(!b)
+    {
+        EventRecorder::stop();
+        return;
+    }
+
+    QString filename = QString("events_%1.rec").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+
+    if(!EventRecorder::start(filename.toStdString()))
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Record",
+                    "Could not create " + filename,
+                    QMessageBox::Ok,
+                    this).exec();
+
+        ui->buttonRecord->setChecked(false);
+    }
+}
+
+/**
+ * @brief MainWindow::replayEvents replays an event log into the active script, or stops the replay if it is running
+ */
+void
+MainWindow::replayEvents()
+{
+    if(m_eventReplay.isRunning())
+    {
+        m_eventReplay.kill();
+        ui->buttonReplay->setText("Replay events...");
+        return;
+    }
+
+    if(m_config.getActiveScriptState() != ConfigManager::Active)
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Replay",
+                    "Events can only be replayed into a running script",
+                    QMessageBox::Ok,
+                    this).exec();
+        return;
+    }
+
+    QFileDialog dialog;
+
+    dialog.setNameFilter("*.rec");
+
+    if( dialog.exec() != QDialog::Accepted )
+        return;
+
+    EventReplay::Speed speed = ui->checkReplayFast->isChecked() ? EventReplay::Fast : EventReplay::RealTime;
+
+    if(!m_eventReplay.start(dialog.selectedFiles().front().toStdString(), speed))
+    {
+        QMessageBox(QMessageBox::Warning,
+                    "Replay",
+                    "Could not replay " + dialog.selectedFiles().front() + ", it is not a valid event log",
+                    QMessageBox::Ok,
+                    this).exec();
+    }
+}
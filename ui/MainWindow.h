@@ -8,6 +8,7 @@
 #include "hw/HWOutput.h"
 #include "script/Variable.h"
 #include "ConfigManager.h"
+#include "ConfigListener.h"
 
 #include "ui/InputFrame.h"
 #include "ui/OutputFrame.h"
@@ -15,6 +16,9 @@
 #include "ui/ScriptsTableModel.h"
 #include "ui/ScriptConfigTableModel.h"
 #include "ui/ConfigTableModel.h"
+#include "ui/BTTelemetryTableModel.h"
+#include "ui/RuleProfileTableModel.h"
+#include "script/EventReplay.h"
 
 namespace Ui {
     class MainWindow;
@@ -24,18 +28,18 @@ namespace Ui {
  * @brief The MainWindow class opens a window containing all relevant information for RASP,
  * like a live overview, script selecting and editing and config.
  */
-class MainWindow : public QMainWindow {
+class MainWindow : public QMainWindow, public ConfigListener {
     Q_OBJECT
 public:
     MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
-    void addInput(HWInput* hw);
-    void addOutput(HWOutput* hw);
-    void addVariable(Variable* var);
-    void removeInput(HWInput* hw);
-    void removeOutput(HWOutput* hw);
-    void removeVariable(Variable* var);
+    void onInputAdded(HWInput* hw);
+    void onOutputAdded(HWOutput* hw);
+    void onVariableAdded(Variable* var);
+    void onInputRemoved(HWInput* hw);
+    void onOutputRemoved(HWOutput* hw);
+    void onVariableRemoved(Variable* var);
 
 private slots:
     void updateScriptConfig();
@@ -56,6 +60,16 @@ private slots:
     void updateErrorFacilities();
     void updateErrorLevels();
 
+    void refreshTelemetry();
+    void dumpTelemetry();
+
+    void refreshProfile();
+    void resetProfile();
+    void dumpProfile();
+
+    void recordEvents(bool b);
+    void replayEvents();
+
 private:
     void updateScriptState();
     bool checkScript(Script* script);
@@ -73,8 +87,11 @@ private:
     QStringListModel m_listFacilityModel;
 
     ConfigTableModel m_configTableModel;
+    BTTelemetryTableModel m_btTelemetryModel;
+    RuleProfileTableModel m_ruleProfileModel;
 
     ConfigManager m_config;
+    EventReplay m_eventReplay;
 
     std::list<InputFrame*> m_listInputFrame;
     std::list<OutputFrame*> m_listOutputFrame;
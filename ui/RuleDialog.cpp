@@ -18,7 +18,9 @@ RuleDialog::RuleDialog(QWidget *parent, Rule* rule, Script *script) :
 
     ui->editName->setText( QString::fromStdString( m_rule->getName() ) );
     ui->comboType->setCurrentIndex( m_rule->getType() );
-    ui->checkConcurrent->setChecked( !m_rule->getNoConcurrent() );
+    ui->comboConcurrency->setCurrentIndex( m_rule->getConcurrency() );
+    ui->spinQueueLimit->setValue( m_rule->getQueueLimit() );
+    this->concurrencyChanged( m_rule->getConcurrency() );
 
     ui->listActions->setModel(&m_actionModel);
 
@@ -35,6 +37,8 @@ RuleDialog::RuleDialog(QWidget *parent, Rule* rule, Script *script) :
     connect(ui->buttonUp, SIGNAL(clicked()), this, SLOT(actionUp()));
     connect(ui->buttonDown, SIGNAL(clicked()), this, SLOT(actionDown()));
 
+    connect(ui->comboConcurrency, SIGNAL(currentIndexChanged(int)), this, SLOT(concurrencyChanged(int)));
+
     connect(ui->buttonClose, SIGNAL(clicked()), this, SLOT(closePressed()));
 }
 
@@ -181,6 +185,14 @@ void RuleDialog::deleteCondition()
     }
 }
 
+/**
+ * @brief RuleDialog::concurrencyChanged enables the queue limit only if it is used by the selected concurrency
+ * @param index
+ */
+void RuleDialog::concurrencyChanged(int index)
+{
+    ui->spinQueueLimit->setEnabled( index == Rule::QueueN );
+}
 
 void RuleDialog::closePressed()
 {
@@ -209,7 +221,8 @@ void RuleDialog::closePressed()
 
     m_rule->setName( ui->editName->text().toStdString() );
     m_rule->setType( (Rule::Type)ui->comboType->currentIndex() );
-    m_rule->setNoConcurrent( !ui->checkConcurrent->isChecked() );
+    m_rule->setConcurrency( (Rule::Concurrency)ui->comboConcurrency->currentIndex() );
+    m_rule->setQueueLimit( ui->spinQueueLimit->value() );
 
     this->done(Accepted);
 }
@@ -30,6 +30,8 @@ private slots:
     void actionUp();
     void actionDown();
 
+    void concurrencyChanged(int index);
+
     void closePressed();
 
 private:
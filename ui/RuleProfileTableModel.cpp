@@ -0,0 +1,204 @@
+#include "ui/RuleProfileTableModel.h"
+#include "script/Script.h"
+#include "ConfigManager.h"
+
+RuleProfileTableModel::RuleProfileTableModel(QObject* parent, ConfigManager* config) : QAbstractTableModel(parent)
+{
+    m_config = config;
+
+    m_sortColumn = -1;
+    m_sortOrder = Qt::AscendingOrder;
+}
+
+int RuleProfileTableModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_vec.size();
+}
+
+int RuleProfileTableModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return 13;
+}
+
+/**
+ * @brief RuleProfileTableModel::value returns the content of a cell as number, so that it can be used for sorting too
+ * @param row
+ * @param column
+ * @return
+ */
+QVariant RuleProfileTableModel::value(const Row& row, int column)
+{
+    const RuleProfile::Snapshot& profile = row.profile;
+    unsigned long long runs = profile.executions + profile.continuations;
+
+    switch(column)
+    {
+    case 0:
+        return QString::fromStdString( row.name );
+    case 1:
+        return profile.evaluations;
+    case 2:
+        return profile.triggers;
+    case 3:
+        return profile.executions;
+    case 4:
+        return profile.dropped;
+    case 5:
+        return profile.queued;
+    case 6:
+        return profile.restarted;
+    case 7:
+        return profile.actions;
+    case 8:
+        return profile.timeNs / 1000000.0;
+    case 9:
+        return runs == 0 ? 0.0 : profile.timeNs / 1000.0 / runs;
+    case 10:
+        return profile.maxNs / 1000.0;
+    case 11:
+        return profile.sleeps;
+    case 12:
+        return profile.sleepMs;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant RuleProfileTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid())
+        return QVariant();
+
+    if(index.row() >= m_vec.size() || index.row() < 0)
+        return QVariant();
+
+    if(role == Qt::DisplayRole)
+    {
+        QVariant var = value(m_vec.at(index.row()), index.column());
+
+        // times are shown with one decimal place
+        if(index.column() >= 8 && index.column() <= 10)
+            return QString::number(var.toDouble(), 'f', 1);
+
+        return var;
+    }
+
+    return QVariant();
+}
+
+QVariant RuleProfileTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role != Qt::DisplayRole)
+        return QVariant();
+
+    if(orientation == Qt::Horizontal)
+    {
+        switch (section)
+        {
+        case 0:
+            return tr("Rule");
+        case 1:
+            return tr("Evaluations");
+        case 2:
+            return tr("Triggers");
+        case 3:
+            return tr("Executions");
+        case 4:
+            return tr("Dropped");
+        case 5:
+            return tr("Queued");
+        case 6:
+            return tr("Restarts");
+        case 7:
+            return tr("Actions");
+        case 8:
+            return tr("Time [ms]");
+        case 9:
+            return tr("Avg [us]");
+        case 10:
+            return tr("Max [us]");
+        case 11:
+            return tr("Sleeps");
+        case 12:
+            return tr("Sleeping [ms]");
+        default:
+            return QVariant();
+        }
+    }
+
+    return QVariant();
+}
+
+bool RuleProfileTableModel::lessThan(const Row& lhs, const Row& rhs, int column)
+{
+    if(column == 0)
+        return lhs.name < rhs.name;
+
+    return value(lhs, column).toDouble() < value(rhs, column).toDouble();
+}
+
+/**
+ * @brief RuleProfileTableModel::sort sorts the rows by column, the order is kept when the table is refreshed
+ * @param column
+ * @param order
+ */
+void RuleProfileTableModel::sort(int column, Qt::SortOrder order)
+{
+    m_sortColumn = column;
+    m_sortOrder = order;
+
+    if(m_sortColumn < 0 || m_sortColumn >= this->columnCount())
+        return;
+
+    emit layoutAboutToBeChanged();
+
+    // insertion sort, there are only a few rules and they are mostly sorted already when the table is refreshed
+    for(unsigned int i = 1; i < m_vec.size(); i++)
+    {
+        Row row = m_vec[i];
+        unsigned int j = i;
+
+        while(j > 0 && (m_sortOrder == Qt::AscendingOrder ? lessThan(row, m_vec[j - 1], m_sortColumn)
+                                                           : lessThan(m_vec[j - 1], row, m_sortColumn)))
+        {
+            m_vec[j] = m_vec[j - 1];
+            j--;
+        }
+
+        m_vec[j] = row;
+    }
+
+    emit layoutChanged();
+}
+
+/**
+ * @brief RuleProfileTableModel::refresh reads the current profiles of all rules of the active script.
+ */
+void RuleProfileTableModel::refresh()
+{
+    Script* script = m_config->getActiveScript();
+
+    emit layoutAboutToBeChanged();
+
+    m_vec.clear();
+
+    if(script != NULL)
+    {
+        std::vector<Rule*> listRules = script->getRuleList();
+
+        for(std::vector<Rule*>::iterator it = listRules.begin(); it != listRules.end(); it++)
+        {
+            Row row;
+            row.name = (*it)->getName();
+            row.profile = (*it)->getProfile()->get();
+
+            m_vec.push_back(row);
+        }
+    }
+
+    emit layoutChanged();
+
+    this->sort(m_sortColumn, m_sortOrder);
+}
@@ -0,0 +1,48 @@
+#ifndef RULEPROFILETABLEMODEL_H
+#define RULEPROFILETABLEMODEL_H
+
+#include "script/RuleProfile.h"
+
+#include <QAbstractTableModel>
+#include <vector>
+#include <string>
+
+class ConfigManager;
+
+/**
+ * @brief The RuleProfileTableModel class shows the profile of every rule of the active script.
+ * The profiles are only read on RuleProfileTableModel::refresh, which should be called periodically.
+ * The table can be sorted by every column, so that the rules which take most of the time can be found easily.
+ */
+class RuleProfileTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    RuleProfileTableModel(QObject *parent, ConfigManager* config);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+    void refresh();
+
+private:
+    struct Row
+    {
+        std::string name;
+        RuleProfile::Snapshot profile;
+    };
+
+    static QVariant value(const Row& row, int column);
+    static bool lessThan(const Row& lhs, const Row& rhs, int column);
+
+    ConfigManager* m_config;
+    std::vector<Row> m_vec;
+
+    int m_sortColumn;
+    Qt::SortOrder m_sortOrder;
+};
+
+#endif // RULEPROFILETABLEMODEL_H
@@ -28,6 +28,8 @@ QVariant ScriptInputTableModel::data(const QModelIndex &index, int role) const
 
         if(index.column() == 0)
             return QString::fromStdString( req.name );
+        else if(req.type == HWInput::EINVALID)
+            return QString("Any");
         else
             return QString::fromStdString( HWInput::HWInputTypeToString(req.type) );
     }
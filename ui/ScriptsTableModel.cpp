@@ -1,41 +1,24 @@
 
 #include "ui/ScriptsTableModel.h"
+#include "ConfigManager.h"
 
-#include <qdir.h>
+#include <QFile>
 
-
-ScriptsTableModel::ScriptsTableModel(QObject* parent) : QAbstractTableModel(parent)
+ScriptsTableModel::ScriptsTableModel(QObject* parent, ConfigManager* config) : QAbstractTableModel(parent)
 {
-    QDir directory = QDir("scripts/");
-    QStringList entries = directory.entryList(QStringList("*.xml"));
-
-    for(QStringList::iterator it = entries.begin(); it != entries.end(); it++)
-    {
-        QString name = (*it);
-
-        // remove ".xml" ending
-        name.chop(4);
-
-        Script* script = Script::load( name.toStdString() );
+    m_config = config;
 
-        // if script is NULL, then the script could not be loaded. This means its either invalid or could not be opened
-        if(script != NULL)
-            m_vecScripts.push_back(script);
-    }
+    m_library.scan();
 }
 
 ScriptsTableModel::~ScriptsTableModel()
 {
-    for(std::vector<Script*>::iterator it = m_vecScripts.begin(); it != m_vecScripts.end(); it++)
-    {
-        delete (*it);
-    }
 }
 
 int ScriptsTableModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return m_vecScripts.size();
+    return m_library.size();
 }
 
 int ScriptsTableModel::columnCount(const QModelIndex &parent) const
@@ -49,17 +32,21 @@ QVariant ScriptsTableModel::data(const QModelIndex &index, int role) const
      if (!index.isValid())
          return QVariant();
 
-     if (index.row() >= this->m_vecScripts.size() || index.row() < 0)
+     if (index.row() >= m_library.size() || index.row() < 0)
          return QVariant();
 
+     const ScriptInfo& info = m_library.getInfo(index.row());
+
      if (role == Qt::DisplayRole)
      {
-         Script* script = this->m_vecScripts.at(index.row());
-
          if (index.column() == 0)
-             return QString::fromStdString( script->getName() );
+             return QString::fromStdString( info.name );
          else if (index.column() == 1)
-             return QString::fromStdString( script->getDescription() );
+             return QString::fromStdString( info.description );
+     }
+     else if (role == Qt::ToolTipRole)
+     {
+         return QString("%1 inputs, %2 outputs, %3 variables").arg(info.numInputs).arg(info.numOutputs).arg(info.numVariables);
      }
      return QVariant();
 }
@@ -86,19 +73,48 @@ QVariant ScriptsTableModel::headerData(int section, Qt::Orientation orientation,
      return QVariant();
 }
 
-Script* ScriptsTableModel::getScript(unsigned int row) const
+/**
+ * @brief ScriptsTableModel::getScript returns the script in row and loads it if necessary.
+ * As this might unload other scripts, the returned pointer must not be stored.
+ * @param row
+ * @return NULL if the script could not be loaded
+ */
+Script* ScriptsTableModel::getScript(unsigned int row)
+{
+    if(row >= m_library.size())
+        return NULL;
+
+    bool loaded = m_library.getLoadedScript(row) != NULL;
+
+    Script* script = m_library.getScript(row, m_config->getActiveScript());
+
+    // loading refreshes the info, the file might have been changed
+    if(!loaded && script != NULL)
+        emit dataChanged(this->index(row, 0), this->index(row, this->columnCount() - 1));
+
+    return script;
+}
+
+/**
+ * @brief ScriptsTableModel::isActiveScript checks if the script in row is the active script without loading it
+ * @param row
+ * @return
+ */
+bool ScriptsTableModel::isActiveScript(unsigned int row) const
 {
-    if(row <= m_vecScripts.size())
-        return m_vecScripts.at(row);
+    if(row >= m_library.size())
+        return false;
+
+    Script* script = m_library.getLoadedScript(row);
 
-    return NULL;
+    return script != NULL && script == m_config->getActiveScript();
 }
 
 void ScriptsTableModel::addScript(Script* script)
 {
     beginInsertRows(QModelIndex(), this->rowCount(QModelIndex()), this->rowCount(QModelIndex()));
 
-    m_vecScripts.push_back(script);
+    m_library.add(script, m_config->getActiveScript());
 
     endInsertRows();
 }
@@ -107,16 +123,10 @@ bool ScriptsTableModel::removeRow(int row, const QModelIndex &parent)
 {
     Q_UNUSED(parent);
 
-    QString filename = "scripts/";
-    filename.append( m_vecScripts.at(row)->getName().c_str() );
-    filename.append(".xml");
-
-    // delete the actual file
-    QFile::remove(filename);
-
     beginRemoveRows(QModelIndex(), row, row);
 
-    m_vecScripts.erase(m_vecScripts.begin() + row);
+    // this also deletes the actual file
+    m_library.remove(row);
 
     endRemoveRows();
 
@@ -133,12 +143,7 @@ bool ScriptsTableModel::removeRow(int row, const QModelIndex &parent)
  */
 void ScriptsTableModel::modifyRow(int row, Script *script)
 {
-    Script* oldScript = m_vecScripts.at(row);
-
-    if(oldScript != script)
-        delete oldScript;
-
-    m_vecScripts[row] = script;
+    m_library.replace(row, script, m_config->getActiveScript());
 
     emit dataChanged(this->index(row, 0), this->index(row, this->columnCount()));
 }
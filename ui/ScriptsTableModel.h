@@ -5,12 +5,19 @@
 #include <vector>
 
 #include "script/Script.h"
+#include "script/ScriptLibrary.h"
 
+class ConfigManager;
+
+/**
+ * @brief The ScriptsTableModel class shows all scripts of the ScriptLibrary.
+ * Scripts are only loaded when they are requested with ScriptsTableModel::getScript, the active script is never unloaded.
+ */
 class ScriptsTableModel : public QAbstractTableModel
 {
     Q_OBJECT
 public:
-    ScriptsTableModel(QObject *parent=0);
+    ScriptsTableModel(QObject *parent, ConfigManager* config);
     ~ScriptsTableModel();
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -18,12 +25,14 @@ public:
     QVariant data(const QModelIndex &index, int role) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
 
-    Script* getScript(unsigned int row) const;
+    Script* getScript(unsigned int row);
+    bool isActiveScript(unsigned int row) const;
     void addScript(Script* script);
     bool removeRow(int row, const QModelIndex &parent = QModelIndex());
     void modifyRow(int row, Script* script);
 private:
-    std::vector<Script*> m_vecScripts;
+    ConfigManager* m_config;
+    ScriptLibrary m_library;
 };
 
 #endif // SCRIPTSTABLEMODEL_H
@@ -7,12 +7,14 @@
 
 #define RASPBERRY_PI
 #define USE_GPIO
+#define USE_GPIO_CHARDEV
 #define USE_I2C
 
 #else
 
 #undef RASPBERRY_PI
 #undef USE_GPIO
+#undef USE_GPIO_CHARDEV
 #undef USE_I2C
 
 #endif
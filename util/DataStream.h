@@ -0,0 +1,45 @@
+#ifndef DATASTREAM_H
+#define DATASTREAM_H
+
+#include <QDataStream>
+#include <QByteArray>
+#include <string>
+
+// std::string is stored as UTF-8 byte array, prefixed by its length
+
+inline QDataStream&
+operator<<(QDataStream& out, const std::string& str)
+{
+    out.writeBytes(str.data(), str.size());
+    return out;
+}
+
+inline QDataStream&
+operator>>(QDataStream& in, std::string& str)
+{
+    quint32 len = 0;
+    in >> len;
+
+    str.clear();
+
+    if(in.status() != QDataStream::Ok)
+        return in;
+
+    // do not trust the length, the data might be corrupted
+    if(len > (quint32)(in.device()->bytesAvailable()))
+    {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+
+    str.resize(len);
+    if(len > 0 && in.readRawData(&str[0], len) != (int)len)
+    {
+        str.clear();
+        in.setStatus(QDataStream::ReadPastEnd);
+    }
+
+    return in;
+}
+
+#endif // DATASTREAM_H
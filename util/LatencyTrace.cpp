@@ -0,0 +1,244 @@
+
+#include "util/LatencyTrace.h"
+#include "util/Debug.h"
+
+#include <QDomDocument>
+
+#include <algorithm>
+#include <time.h>
+
+// length of the window in which input changes are counted for the peak rate
+#define LATENCY_RATE_WINDOW_NS 1000000000ULL
+
+// the Bus stage is written by several hardware threads, so all counters are updated with atomic additions
+static std::atomic<unsigned long long> g_histogram[LatencyTrace::StageCount][LatencyTrace::BucketCount];
+static std::atomic<unsigned long long> g_sumUs[LatencyTrace::StageCount];
+static std::atomic<unsigned long long> g_maxUs[LatencyTrace::StageCount];
+
+static std::atomic<unsigned long long> g_inputs;
+static std::atomic<unsigned long long> g_peakRate;
+
+// only used by the executor thread
+static unsigned long long g_rateStart = 0;
+static unsigned long long g_rateCount = 0;
+
+// origin of the event the current thread is working on, 0 if it is not caused by an input change
+static __thread unsigned long long t_origin = 0;
+
+std::string LatencyTrace::StageToString(Stage stage)
+{
+    switch(stage)
+    {
+    case Dispatch:
+        return "Dispatch";
+    case Output:
+        return "Output";
+    case Bus:
+        return "Bus";
+    default:
+        LOG_WARN(Logger::Misc, "Invalid stage");
+        return "";
+    }
+}
+
+/**
+ * @brief LatencyTrace::setOrigin sets the origin for the calling thread, every output changed by this thread is traced back to it
+ * @param origin timestamp of the input change or 0 to stop tracing
+ */
+void LatencyTrace::setOrigin(unsigned long long origin)
+{
+    t_origin = origin;
+}
+
+unsigned long long LatencyTrace::getOrigin()
+{
+    return t_origin;
+}
+
+/**
+ * @brief LatencyTrace::record adds the time since origin to the histogram of stage. Can be called by any thread.
+ * @param stage
+ * @param origin timestamp of the input change, nothing is recorded if it is 0
+ */
+void LatencyTrace::record(Stage stage, unsigned long long origin)
+{
+    if(origin == 0)
+        return;
+
+    unsigned long long now = LatencyTrace::timestamp();
+    unsigned long long us = now > origin ? (now - origin) / 1000 : 0;
+
+    g_histogram[stage][LatencyTrace::bucket(us)].fetch_add(1, std::memory_order_relaxed);
+    g_sumUs[stage].fetch_add(us, std::memory_order_relaxed);
+
+    unsigned long long max = g_maxUs[stage].load(std::memory_order_relaxed);
+    while(us > max && !g_maxUs[stage].compare_exchange_weak(max, us, std::memory_order_relaxed));
+}
+
+/**
+ * @brief LatencyTrace::inputHandled is called by the executor for every input change it handles.
+ * Besides recording the Dispatch stage it counts the input changes per second, the highest rate shows how many changes the executor keeps up with.
+ * @param origin
+ */
+void LatencyTrace::inputHandled(unsigned long long origin)
+{
+    LatencyTrace::record(Dispatch, origin);
+
+    g_inputs.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned long long now = LatencyTrace::timestamp();
+    if(now - g_rateStart >= LATENCY_RATE_WINDOW_NS)
+    {
+        g_rateStart = now;
+        g_rateCount = 0;
+    }
+
+    g_rateCount++;
+
+    if(g_rateCount > g_peakRate.load(std::memory_order_relaxed))
+        g_peakRate.store(g_rateCount, std::memory_order_relaxed);
+}
+
+LatencyTrace::Snapshot LatencyTrace::get()
+{
+    Snapshot snapshot;
+
+    for(unsigned int stage = 0; stage < StageCount; stage++)
+    {
+        unsigned long long histogram[BucketCount];
+        unsigned long long count = 0;
+
+        // the count is calculated from the histogram, so that the percentiles are consistent even if it is updated meanwhile
+        for(unsigned int i = 0; i < BucketCount; i++)
+        {
+            histogram[i] = g_histogram[stage][i].load(std::memory_order_relaxed);
+            count += histogram[i];
+        }
+
+        StageSnapshot* s = &snapshot.stages[stage];
+        s->count = count;
+        s->sumUs = g_sumUs[stage].load(std::memory_order_relaxed);
+        s->maxUs = g_maxUs[stage].load(std::memory_order_relaxed);
+        s->p50Us = std::min(LatencyTrace::percentile(histogram, count, 0.5), s->maxUs);
+        s->p99Us = std::min(LatencyTrace::percentile(histogram, count, 0.99), s->maxUs);
+        s->p999Us = std::min(LatencyTrace::percentile(histogram, count, 0.999), s->maxUs);
+    }
+
+    snapshot.inputs = g_inputs.load(std::memory_order_relaxed);
+    snapshot.peakRate = g_peakRate.load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+/**
+ * @brief LatencyTrace::reset sets all histograms back to zero.
+ * Latencies which are recorded at the same time might be lost or partly counted.
+ */
+void LatencyTrace::reset()
+{
+    for(unsigned int stage = 0; stage < StageCount; stage++)
+    {
+        for(unsigned int i = 0; i < BucketCount; i++)
+            g_histogram[stage][i] = 0;
+
+        g_sumUs[stage] = 0;
+        g_maxUs[stage] = 0;
+    }
+
+    g_inputs = 0;
+    g_peakRate = 0;
+}
+
+void LatencyTrace::save(QDomElement* root, QDomDocument* document)
+{
+    Snapshot snapshot = LatencyTrace::get();
+
+    QDomElement latency = document->createElement("latency");
+    latency.setAttribute("inputs", QString::number(snapshot.inputs));
+    latency.setAttribute("peakRate", QString::number(snapshot.peakRate));
+
+    for(unsigned int stage = 0; stage < StageCount; stage++)
+    {
+        const StageSnapshot& s = snapshot.stages[stage];
+
+        QDomElement elem = document->createElement("stage");
+        elem.setAttribute("name", QString::fromStdString( LatencyTrace::StageToString((Stage)stage) ));
+        elem.setAttribute("count", QString::number(s.count));
+        elem.setAttribute("avgUs", QString::number(s.count == 0 ? 0 : s.sumUs / s.count));
+        elem.setAttribute("p50Us", QString::number(s.p50Us));
+        elem.setAttribute("p99Us", QString::number(s.p99Us));
+        elem.setAttribute("p999Us", QString::number(s.p999Us));
+        elem.setAttribute("maxUs", QString::number(s.maxUs));
+
+        latency.appendChild(elem);
+    }
+
+    root->appendChild(latency);
+}
+
+/**
+ * @brief LatencyTrace::timestamp returns the current time of CLOCK_MONOTONIC in nanoseconds, it is never 0
+ * @return
+ */
+unsigned long long LatencyTrace::timestamp()
+{
+    timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return currentTime.tv_sec * 1000000000ULL + currentTime.tv_nsec + 1;
+}
+
+unsigned int LatencyTrace::bucket(unsigned long long us)
+{
+    if(us < 4)
+        return us;
+
+    unsigned int exponent = 63 - __builtin_clzll(us);
+    unsigned int sub = (us >> (exponent - 2)) & 3;
+    unsigned int index = 4 * (exponent - 1) + sub;
+
+    return index < BucketCount ? index : BucketCount - 1;
+}
+
+/**
+ * @brief LatencyTrace::bucketLimit returns the largest latency which falls into bucket
+ * @param bucket
+ * @return
+ */
+unsigned long long LatencyTrace::bucketLimit(unsigned int bucket)
+{
+    if(bucket < 4)
+        return bucket;
+
+    unsigned int exponent = bucket / 4 + 1;
+    unsigned long long lower = (4ULL + bucket % 4) << (exponent - 2);
+
+    return lower + (1ULL << (exponent - 2)) - 1;
+}
+
+/**
+ * @brief LatencyTrace::percentile returns the upper limit of the bucket which contains the given fraction of all latencies
+ * @param histogram
+ * @param count sum of the histogram
+ * @param fraction e.g. 0.99 for the 99th percentile
+ * @return
+ */
+unsigned long long LatencyTrace::percentile(const unsigned long long* histogram, unsigned long long count, double fraction)
+{
+    if(count == 0)
+        return 0;
+
+    unsigned long long target = (unsigned long long)(count * fraction);
+    if(target < count * fraction || target == 0)
+        target++;
+
+    unsigned long long sum = 0;
+    for(unsigned int i = 0; i < BucketCount; i++)
+    {
+        sum += histogram[i];
+        if(sum >= target)
+            return LatencyTrace::bucketLimit(i);
+    }
+
+    return LatencyTrace::bucketLimit(BucketCount - 1);
+}
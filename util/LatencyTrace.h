@@ -0,0 +1,69 @@
+#ifndef LATENCYTRACE_H
+#define LATENCYTRACE_H
+
+#include <atomic>
+#include <string>
+
+class QDomElement;
+class QDomDocument;
+
+/**
+ * @brief The LatencyTrace class measures the time from an input change until the resulting output has been written.
+ * When an input change is posted to the RuleExecutor it is stamped with the current time, the origin.
+ * While the executor handles this event, the origin is set for the executor thread, so every output which is changed
+ * by the rules records the latency from the origin. Outputs pass the origin on to the queue of their hardware thread,
+ * which records the latency again after the function has been executed, i.e. after the write to the bus.
+ * Latencies are collected in histograms with logarithmic buckets, so percentiles can be calculated with an error of at most 25%.
+ */
+class LatencyTrace
+{
+public:
+    enum Stage
+    {
+        Dispatch = 0, // input change posted -> event handled by the executor
+        Output = 1, // input change posted -> output changed by an action
+        Bus = 2, // input change posted -> output written by the hardware thread
+        StageCount = 3
+    };
+    static std::string StageToString(Stage stage);
+
+    // buckets 0-3 are 0-3 us, after that every power of two is divided into 4 buckets
+    static const unsigned int BucketCount = 128;
+
+    struct StageSnapshot
+    {
+        unsigned long long count;
+        unsigned long long sumUs;
+        unsigned long long maxUs;
+        unsigned long long p50Us;
+        unsigned long long p99Us;
+        unsigned long long p999Us;
+    };
+
+    struct Snapshot
+    {
+        StageSnapshot stages[StageCount];
+
+        unsigned long long inputs; // input changes handled by the executor
+        unsigned long long peakRate; // most input changes handled within one second
+    };
+
+    static void setOrigin(unsigned long long origin);
+    static unsigned long long getOrigin();
+
+    static void record(Stage stage, unsigned long long origin);
+    static void inputHandled(unsigned long long origin);
+
+    static Snapshot get();
+    static void reset();
+    static void save(QDomElement* root, QDomDocument* document);
+
+    static unsigned long long timestamp();
+
+private:
+    static unsigned int bucket(unsigned long long us);
+    static unsigned long long bucketLimit(unsigned int bucket);
+    static unsigned long long percentile(const unsigned long long* histogram, unsigned long long count, double fraction);
+};
+
+#endif // LATENCYTRACE_H
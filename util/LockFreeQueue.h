@@ -0,0 +1,121 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+/**
+ * @brief The LockFreeQueue class is a bounded queue which can be used by several producer and consumer threads without any locks.
+ * Every slot carries a sequence number which tells whether it is ready to be written or read for the current round.
+ * The size must be a power of two.
+ */
+template <class T>
+class LockFreeQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    Cell* m_buffer;
+    size_t m_mask;
+
+    std::atomic<size_t> m_enqueuePos;
+    std::atomic<size_t> m_dequeuePos;
+
+public:
+    LockFreeQueue(size_t size)
+    {
+        m_buffer = new Cell[size];
+        m_mask = size - 1;
+
+        for(size_t i = 0; i < size; i++)
+            m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    ~LockFreeQueue()
+    {
+        delete[] m_buffer;
+    }
+
+    /**
+     * @brief push appends x to the queue
+     * @param x
+     * @return false if the queue is full
+     */
+    bool push(const T& x)
+    {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            cell = &m_buffer[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+            if(diff == 0)
+            {
+                if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                return false; // queue is full
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = x;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief pop removes the oldest element from the queue and stores it in x
+     * @param x
+     * @return false if the queue is empty or the oldest element has not yet been completely written by its producer
+     */
+    bool pop(T* x)
+    {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            cell = &m_buffer[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+            if(diff == 0)
+            {
+                if(m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                return false; // queue is empty
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        *x = cell->data;
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+        return true;
+    }
+};
+
+#endif // LOCKFREEQUEUE_H
@@ -2,6 +2,7 @@
 #define PRIORITYQUEUE_H
 
 #include <list>
+#include <vector>
 #include <algorithm>
 
 template <class T>
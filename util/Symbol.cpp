@@ -0,0 +1,116 @@
+
+#include "util/Symbol.h"
+
+#include <unordered_map>
+#include <pthread.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+/**
+ * @brief The CaseInsensitiveHash struct is the FNV-1a hash of the lower case name, without creating a lower case copy
+ */
+struct CaseInsensitiveHash
+{
+    size_t operator()(const std::string& str) const
+    {
+        unsigned int h = FNV_OFFSET_BASIS;
+
+        for(std::string::const_iterator it = str.begin(); it != str.end(); it++)
+        {
+            h ^= (unsigned char)tolower((unsigned char)(*it));
+            h *= FNV_PRIME;
+        }
+
+        return h;
+    }
+};
+
+struct CaseInsensitiveEqual
+{
+    bool operator()(const std::string& lhs, const std::string& rhs) const
+    {
+        return lhs.size() == rhs.size() && strcasecmp(lhs.c_str(), rhs.c_str()) == 0;
+    }
+};
+
+typedef std::unordered_map<std::string, Symbol::Id, CaseInsensitiveHash, CaseInsensitiveEqual> SymbolTable;
+
+// scripts can be loaded while the executor resolves names, so the table is protected by a mutex
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static SymbolTable g_table;
+// name of every id, the empty name is Symbol::Invalid
+static std::vector<std::string> g_names(1, std::string());
+
+/**
+ * @brief Symbol::intern returns the id of name and creates a new one if name has not been interned yet
+ * @param name
+ * @return Symbol::Invalid for the empty name
+ */
+Symbol::Id Symbol::intern(const std::string& name)
+{
+    if(name.empty())
+        return Symbol::Invalid;
+
+    pthread_mutex_lock(&g_mutex);
+
+    Symbol::Id id;
+    SymbolTable::iterator it = g_table.find(name);
+    if(it != g_table.end())
+    {
+        id = it->second;
+    }
+    else
+    {
+        id = g_names.size();
+        g_names.push_back(name);
+        g_table.insert(SymbolTable::value_type(name, id));
+    }
+
+    pthread_mutex_unlock(&g_mutex);
+
+    return id;
+}
+
+/**
+ * @brief Symbol::lookup returns the id of name without interning it
+ * @param name
+ * @return Symbol::Invalid if name has never been interned, so it cannot be in any SymbolMap
+ */
+Symbol::Id Symbol::lookup(const std::string& name)
+{
+    if(name.empty())
+        return Symbol::Invalid;
+
+    pthread_mutex_lock(&g_mutex);
+
+    Symbol::Id id = Symbol::Invalid;
+    SymbolTable::iterator it = g_table.find(name);
+    if(it != g_table.end())
+        id = it->second;
+
+    pthread_mutex_unlock(&g_mutex);
+
+    return id;
+}
+
+/**
+ * @brief Symbol::getName returns the name id has been interned with first
+ * @param id
+ * @return
+ */
+std::string Symbol::getName(Symbol::Id id)
+{
+    std::string name;
+
+    pthread_mutex_lock(&g_mutex);
+
+    if(id < g_names.size())
+        name = g_names[id];
+
+    pthread_mutex_unlock(&g_mutex);
+
+    return name;
+}
@@ -0,0 +1,74 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+/**
+ * @brief The Symbol class interns the names of inputs, outputs, variables, rules and bluetooth boards to integer ids.
+ * Names are compared case insensitive, like everywhere else, so "Button1" and "button1" get the same id.
+ * Ids are never released, the same name always has the same id as long as the process runs.
+ * Scripts intern their names when they are loaded, so resolving them in init is only an array access.
+ */
+class Symbol
+{
+public:
+    typedef unsigned int Id;
+
+    // id of the empty name, it is never found in any SymbolMap
+    static const Id Invalid = 0;
+
+    static Id intern(const std::string& name);
+    static Id lookup(const std::string& name);
+    static std::string getName(Id id);
+};
+
+/**
+ * @brief The SymbolMap class maps symbol ids to objects.
+ * As ids are handed out consecutively, the objects are simply stored in a vector indexed by the id.
+ */
+template<class T>
+class SymbolMap
+{
+public:
+    /**
+     * @brief insert maps id to obj, if id is already mapped to an object, the first object is kept
+     * @return false if id is invalid or already mapped
+     */
+    bool insert(Symbol::Id id, T* obj)
+    {
+        if(id == Symbol::Invalid)
+            return false;
+
+        if(id >= m_vec.size())
+            m_vec.resize(id + 1, NULL);
+
+        if(m_vec[id] != NULL)
+            return false;
+
+        m_vec[id] = obj;
+        return true;
+    }
+
+    void remove(Symbol::Id id, T* obj)
+    {
+        if(id < m_vec.size() && m_vec[id] == obj)
+            m_vec[id] = NULL;
+    }
+
+    T* get(Symbol::Id id) const
+    {
+        if(id < m_vec.size())
+            return m_vec[id];
+
+        return NULL;
+    }
+
+    void clear() { m_vec.clear();}
+
+private:
+    std::vector<T*> m_vec;
+};
+
+#endif // SYMBOL_H
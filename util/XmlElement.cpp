@@ -0,0 +1,148 @@
+
+#include "util/XmlElement.h"
+
+#include <QXmlStreamReader>
+#include <QLatin1String>
+
+struct TagName
+{
+    const char* name;
+    XmlTag::Id id;
+};
+
+// sorted by name, XmlTag::lookup relies on this
+static const TagName tagNames[] =
+{
+    {"absolutthreshold", XmlTag::AbsolutThreshold},
+    {"acc", XmlTag::Acc},
+    {"accshape", XmlTag::AccShape},
+    {"action", XmlTag::Action},
+    {"aggregate", XmlTag::Aggregate},
+    {"bluetooth", XmlTag::Bluetooth},
+    {"btaddress", XmlTag::BTAddress},
+    {"btboard", XmlTag::BTBoard},
+    {"channel", XmlTag::Channel},
+    {"concurrency", XmlTag::Concurrency},
+    {"condition", XmlTag::Condition},
+    {"config", XmlTag::Config},
+    {"cpu", XmlTag::CPU},
+    {"dc100stallenable", XmlTag::DC100StallEnable},
+    {"debounce", XmlTag::Debounce},
+    {"defaultvalue", XmlTag::DefaultValue},
+    {"deltathreshold", XmlTag::DeltaThreshold},
+    {"description", XmlTag::Description},
+    {"expression", XmlTag::Expression},
+    {"filename", XmlTag::Filename},
+    {"fs2stallenabled", XmlTag::FS2StallEnabled},
+    {"gpio", XmlTag::GPIO},
+    {"gpiopin", XmlTag::GPIOPin},
+    {"hwtype", XmlTag::HWType},
+    {"hysteresis", XmlTag::Hysteresis},
+    {"ihold", XmlTag::IHold},
+    {"input", XmlTag::Input},
+    {"inputname", XmlTag::InputName},
+    {"irun", XmlTag::IRun},
+    {"lowenergy", XmlTag::LowEnergy},
+    {"minintervalms", XmlTag::MinIntervalMs},
+    {"minsamples", XmlTag::MinSamples},
+    {"musicaction", XmlTag::MusicAction},
+    {"name", XmlTag::Name},
+    {"noconcurrent", XmlTag::NoConcurrent},
+    {"operand", XmlTag::Operand},
+    {"operator", XmlTag::Operator},
+    {"output", XmlTag::Output},
+    {"pin", XmlTag::Pin},
+    {"pingroup", XmlTag::PinGroup},
+    {"port", XmlTag::Port},
+    {"position", XmlTag::Position},
+    {"position2", XmlTag::Position2},
+    {"positioningtype", XmlTag::PositioningType},
+    {"priority", XmlTag::Priority},
+    {"pwmfreq", XmlTag::PWMFreq},
+    {"pwmjitterenable", XmlTag::PWMJitterEnable},
+    {"queuelimit", XmlTag::QueueLimit},
+    {"rule", XmlTag::Rule},
+    {"script", XmlTag::Script},
+    {"secureposition", XmlTag::SecurePosition},
+    {"shaft", XmlTag::Shaft},
+    {"slaveaddress", XmlTag::SlaveAddress},
+    {"speed", XmlTag::Speed},
+    {"state", XmlTag::State},
+    {"stepmode", XmlTag::StepMode},
+    {"steppertype", XmlTag::StepperType},
+    {"subtype", XmlTag::Subtype},
+    {"trigger", XmlTag::Trigger},
+    {"triggervalue", XmlTag::TriggerValue},
+    {"type", XmlTag::Type},
+    {"value", XmlTag::Value},
+    {"variable", XmlTag::Variable},
+    {"vmax", XmlTag::VMax},
+    {"vmin", XmlTag::VMin},
+    {"waitms", XmlTag::WaitMs}
+};
+
+/**
+ * @brief XmlTag::lookup returns the id of the tag given by name, the comparison is case insensitive.
+ * @param name
+ * @return the id or XmlTag::Unknown if the tag is not used by any loader
+ */
+XmlTag::Id XmlTag::lookup(const QStringRef& name)
+{
+    int lower = 0;
+    int upper = sizeof(tagNames) / sizeof(tagNames[0]) - 1;
+
+    while(lower <= upper)
+    {
+        int mid = (lower + upper) / 2;
+        int cmp = name.compare(QLatin1String(tagNames[mid].name), Qt::CaseInsensitive);
+
+        if(cmp == 0)
+            return tagNames[mid].id;
+        else if(cmp < 0)
+            upper = mid - 1;
+        else
+            lower = mid + 1;
+    }
+
+    return Unknown;
+}
+
+/**
+ * @brief XmlElement::read reads all children of the current element, the reader must be positioned at its start element.
+ * Afterwards the reader is positioned at the end element. Children with unknown tags are skipped.
+ * @param reader
+ * @return false if the document is not well-formed
+ */
+bool XmlElement::read(QXmlStreamReader* reader)
+{
+    m_children.clear();
+
+    while(reader->readNextStartElement())
+    {
+        XmlTag::Id tag = XmlTag::lookup(reader->name());
+
+        if(tag == XmlTag::Unknown)
+        {
+            reader->skipCurrentElement();
+            continue;
+        }
+
+        Child child;
+        child.tag = tag;
+        child.text = XmlElement::readText(reader);
+
+        m_children.push_back(child);
+    }
+
+    return !reader->hasError();
+}
+
+/**
+ * @brief XmlElement::readText returns the text of the current element and positions the reader at its end element
+ * @param reader
+ * @return
+ */
+QString XmlElement::readText(QXmlStreamReader* reader)
+{
+    return reader->readElementText(QXmlStreamReader::SkipChildElements);
+}
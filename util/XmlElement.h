@@ -0,0 +1,117 @@
+#ifndef XMLELEMENT_H
+#define XMLELEMENT_H
+
+#include <QString>
+#include <QStringRef>
+#include <vector>
+
+class QXmlStreamReader;
+
+/**
+ * @brief The XmlTag class interns the names of all tags used in scripts and configurations.
+ * Loaders compare the ids instead of the names, so that no lower case copies of the tag names have to be made.
+ */
+class XmlTag
+{
+public:
+    enum Id
+    {
+        Unknown = 0,
+        AbsolutThreshold,
+        Acc,
+        AccShape,
+        Action,
+        Aggregate,
+        Bluetooth,
+        BTAddress,
+        BTBoard,
+        Channel,
+        Concurrency,
+        Condition,
+        Config,
+        CPU,
+        DC100StallEnable,
+        Debounce,
+        DefaultValue,
+        DeltaThreshold,
+        Description,
+        Expression,
+        Filename,
+        FS2StallEnabled,
+        GPIO,
+        GPIOPin,
+        HWType,
+        Hysteresis,
+        IHold,
+        Input,
+        InputName,
+        IRun,
+        LowEnergy,
+        MinIntervalMs,
+        MinSamples,
+        MusicAction,
+        Name,
+        NoConcurrent,
+        Operand,
+        Operator,
+        Output,
+        Pin,
+        PinGroup,
+        Port,
+        Position,
+        Position2,
+        PositioningType,
+        Priority,
+        PWMFreq,
+        PWMJitterEnable,
+        QueueLimit,
+        Rule,
+        Script,
+        SecurePosition,
+        Shaft,
+        SlaveAddress,
+        Speed,
+        State,
+        StepMode,
+        StepperType,
+        Subtype,
+        Trigger,
+        TriggerValue,
+        Type,
+        Value,
+        Variable,
+        VMax,
+        VMin,
+        WaitMs,
+    };
+
+    static Id lookup(const QStringRef& name);
+};
+
+/**
+ * @brief The XmlElement class contains the direct children of one element read by a QXmlStreamReader,
+ * i.e. the tag id and the text of every child. This is all conditions, actions, inputs and outputs consist of.
+ * Unlike a DOM tree, only the element which is loaded right now is kept in memory.
+ */
+class XmlElement
+{
+public:
+    struct Child
+    {
+        XmlTag::Id tag;
+        QString text;
+    };
+
+    typedef std::vector<Child>::const_iterator Iterator;
+
+    bool read(QXmlStreamReader* reader);
+    static QString readText(QXmlStreamReader* reader);
+
+    Iterator begin() const { return m_children.begin();}
+    Iterator end() const { return m_children.end();}
+
+private:
+    std::vector<Child> m_children;
+};
+
+#endif // XMLELEMENT_H